@@ -0,0 +1,58 @@
+#!/bin/bash
+
+# Set variables
+LIB="libtdsim.a"
+EXEC="td-sim"
+BALANCE_EXEC="td-balance"
+CALIBRATE_EXEC="td-calibrate"
+ENV_EXEC="td-env"
+TOURNAMENT_EXEC="td-tournament"
+VERIFY_EXEC="td-verify"
+GENERATE_EXEC="td-generate"
+ARCHER_BOT="archer_bot.so"
+
+# Create bin directory if it doesn't exist
+mkdir -p bin
+
+# Compiling the simulation library (no SDL needed)
+gcc -std=c17 -Wall -Wextra -O2 -pthread -c src/sim.c -o bin/sim.o
+ar rcs bin/$LIB bin/sim.o
+rm bin/sim.o
+
+# Compiling the command line simulator against the library
+gcc -std=c17 -Wall -Wextra -O2 -pthread src/cli/td_sim.c src/cli/bot.c -Lbin -ltdsim -ldl -o bin/$EXEC
+
+# Compiling the multi-threaded balance runner against the library
+gcc -std=c17 -Wall -Wextra -O2 -pthread src/cli/td_balance.c src/cli/bot.c -Lbin -ltdsim -ldl -o bin/$BALANCE_EXEC
+
+# Compiling the survival difficulty calibrator against the library
+gcc -std=c17 -Wall -Wextra -O2 -pthread src/cli/td_calibrate.c src/cli/bot.c -Lbin -ltdsim -ldl -o bin/$CALIBRATE_EXEC
+
+# Compiling the strategy tournament (every strategy on every level file and survival seeds, then a ranking)
+gcc -std=c17 -Wall -Wextra -O2 -pthread src/cli/td_tournament.c src/cli/bot.c -Lbin -ltdsim -ldl -lm -o bin/$TOURNAMENT_EXEC
+
+# Compiling the level solvability verifier (cheapest towers clearing each wave with the funds given)
+gcc -std=c17 -Wall -Wextra -O2 -pthread src/cli/td_verify.c -Lbin -ltdsim -o bin/$VERIFY_EXEC
+
+# Compiling the procedural level generator (waves searched to reach a difficulty against reference strategies)
+gcc -std=c17 -Wall -Wextra -O2 -pthread src/cli/td_generate.c src/cli/bot.c -Lbin -ltdsim -ldl -lm -o bin/$GENERATE_EXEC
+
+# Compiling the shared memory environment server for training processes
+gcc -std=c17 -Wall -Wextra -O2 -pthread src/cli/td_env.c -Lbin -ltdsim -lrt -o bin/$ENV_EXEC
+
+# Compiling the example bot plugin (strategy loaded by td-sim and td-balance in place of a build order file)
+gcc -std=c17 -Wall -Wextra -O2 -shared -fPIC src/bots/archer_bot.c -o bin/$ARCHER_BOT
+
+# Usage (from the bin directory): ./td-sim <level|survival> [build order file|auto|bot plugin (.so)] [max waves] [seed] [auto-build time budget in ms]
+#                                 ./td-sim replay <replay name> [start turn]
+#                                 ./td-sim verify <replay name>
+#                                 ./td-sim trace <replay name>
+#                                 ./td-sim batch <level|survival> <nb games> [build order file] [max waves] [threads]
+#                                 ./td-sim record <replay name> <level|survival> [build order file|auto|bot plugin (.so)] [max waves] [seed] [auto-build time budget in ms]
+#                                 ./td-balance <level|survival> <nb seeds> <output prefix> <build order file|bot plugin (.so)> [build order file|bot plugin...]
+#                                 ./td-tournament <nb survival seeds> <cache file> <output csv> <build order file|bot plugin (.so)> [build order file|bot plugin...]
+#                                 ./td-verify <level> [witness build order file] [time budget per wave in s] [seed]
+#                                 ./td-generate <level name> <target difficulty (0 to 1)> <nb waves> <build order file|bot plugin (.so)> [build order file|bot plugin...] [--time=<s>] [--seed=<seed>]
+#                                 ./td-env serve <name> <level|survival> <nb environments> [nb threads]
+#                                 ./td-env random <name> <nb steps> [stop]
+#                                 ./td-calibrate <nb seeds> <target survival rates, e.g. 0.95,0.8,0.6> <build order file> [build order file...]
@@ -0,0 +1,44 @@
+#!/bin/bash
+
+# Set variables
+EXEC="td-sim"
+NB_BATCH_GAMES=8  # Seeds played by each batch check
+FAILED=0
+
+# Compiling the simulation tools
+bash build_sim_Linux.sh || exit 1
+
+# Change to the bin directory
+cd bin
+
+# Replay every recorded game on both turn resolvers (game and board)
+for REPLAY in ../assets/replays/*.rpl; do
+    NAME=$(basename "$REPLAY" .rpl)
+    if ./$EXEC verify "$NAME" > /dev/null; then
+        echo "verify $NAME: OK"
+    else
+        echo "verify $NAME: MISMATCH"
+        FAILED=1
+    fi
+done
+
+# Play every level one game at a time and on a board batch, both must give the same results
+for LEVEL in ../assets/lvl/*.txt; do
+    NAME=$(basename "$LEVEL" .txt)
+    if ./$EXEC batch "$NAME" $NB_BATCH_GAMES | grep -q "IDENTICAL"; then
+        echo "batch $NAME: OK"
+    else
+        echo "batch $NAME: MISMATCH"
+        FAILED=1
+    fi
+done
+if ./$EXEC batch survival $NB_BATCH_GAMES | grep -q "IDENTICAL"; then
+    echo "batch survival: OK"
+else
+    echo "batch survival: MISMATCH"
+    FAILED=1
+fi
+
+# Change back to the original directory
+cd ..
+exit $FAILED
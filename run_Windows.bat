@@ -6,18 +6,13 @@ set CFLAGS=-Iinclude\SDL2
 set LDFLAGS=-Llib\SDL2 -Llib\SDL2_ttf -lmingw32 -lSDL2main -lSDL2
 
 set SRC=src\*.c
-set OBJ=main.o
 set EXEC=game.exe
 
 rem Create bin directory if it doesn't exist
 if not exist bin mkdir bin
 
-rem Compile source files into object files
-%CC% -std=c17 -Wall -Wextra %CFLAGS% -c %SRC% -o bin\%OBJ%
-rem Link object files into the executable
-%CC% -o bin\%EXEC% bin\%OBJ% %LDFLAGS%
-rem Remove the object file
-del bin\%OBJ%
+rem Compile source files (game and simulation) into the executable
+%CC% -std=c17 -pthread -Wall -Wextra %CFLAGS% %SRC% -o bin\%EXEC% %LDFLAGS%
 
 rem Change to the bin directory
 cd bin
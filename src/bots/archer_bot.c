@@ -0,0 +1,55 @@
+#include <stddef.h>
+#include "../cli/bot.h"
+
+/* Example strategy plugin: archer towers on the rows the upcoming wave comes through, as close to the castle as possible */
+/* Build it with: gcc -std=c17 -O2 -shared -fPIC src/bots/archer_bot.c -o bin/archer_bot.so */
+/* Then play it with: ./td-sim <level> archer_bot.so (from the bin directory) */
+
+#define ENEMIES_PER_ARCHER 1  // An archer is added on a row for each this many enemies coming through it
+
+
+
+
+/* Header */
+int buildArchers(void *state, const BotView *view, BotCommand *commands, int max_commands);
+const BotInterface *getBotInterface(void);
+
+
+
+/* Buy archers while funds last, on the row with the most enemies per archer first */
+int buildArchers(void *state, const BotView *view, BotCommand *commands, int max_commands) {
+    (void) state;
+    int nb_enemies[BOT_NB_ROWS] = {0}, nb_archers[BOT_NB_ROWS] = {0}, nb_commands = 0, funds = view->funds, cost = view->tower_cost['A'];
+    unsigned char occupied[BOT_NB_ROWS][BOT_NB_COLLUMNS] = {{0}};
+    for (int i = 0; i < view->nb_enemies; i++) nb_enemies[view->enemies[i].row-1]++;
+    /* Nothing is known of the waves to come (first survival wave): every row is defended the same */
+    if (!view->nb_enemies) for (int row = 1; row <= BOT_NB_ROWS; row++) nb_enemies[row-1] = BOT_NB_COLLUMNS;
+    for (int i = 0; i < view->nb_towers; i++) {
+        occupied[view->towers[i].row-1][view->towers[i].collumn-1] = 1;
+        if (view->towers[i].type == 'A') nb_archers[view->towers[i].row-1]++;
+    }
+    while (nb_commands < max_commands && cost > 0 && funds >= cost) {
+        /* Row still lacking the most archers */
+        int best_row = -1, best_need = 0;
+        for (int row = 1; row <= BOT_NB_ROWS; row++) {
+            int need = nb_enemies[row-1] - ENEMIES_PER_ARCHER * nb_archers[row-1];
+            if (need > best_need) best_row = row, best_need = need;
+        }
+        if (best_row < 0) break;
+        /* Closest free tile to the castle on that row */
+        int collumn = 1;
+        while (collumn < BOT_NB_COLLUMNS && (occupied[best_row-1][collumn-1] || view->blocked[best_row-1][collumn-1])) collumn++;
+        nb_archers[best_row-1]++;
+        if (collumn >= BOT_NB_COLLUMNS) continue;
+        occupied[best_row-1][collumn-1] = 1;
+        commands[nb_commands++] = (BotCommand) {BOT_BUY_COMMAND, 'A', collumn, best_row};
+        funds -= cost;
+    }
+    return nb_commands;
+}
+
+/* Entry point of the plugin */
+const BotInterface *getBotInterface(void) {
+    static const BotInterface interface = {BOT_ABI_VERSION, "archers", NULL, buildArchers, NULL};
+    return &interface;
+}
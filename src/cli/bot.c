@@ -0,0 +1,173 @@
+#include "../sim.h"
+#include "bot.h"
+#include <dlfcn.h>
+
+_Static_assert(BOT_NB_ROWS == NB_ROWS && BOT_NB_COLLUMNS == NB_COLLUMNS, "The bot interface must describe the same map as the simulation");
+
+
+
+
+/* Return if a strategy given on the command line is a plugin (a shared library) rather than a build order file */
+bool isBotPath(const char *path) {
+    size_t length = strlen(path);
+    return length > 3 && !strcmp(path + length - 3, ".so");
+}
+
+/* Load a strategy plugin, return NULL if it cannot be loaded or was built for another version of the interface */
+Bot *loadBot(const char *path) {
+    /* A path without directory would be searched among the system libraries */
+    char *full_path = strchr(path, '/') ? duplicateString(path) : concatString("./", path);
+    void *library = dlopen(full_path, RTLD_NOW | RTLD_LOCAL);
+    free(full_path);
+    if (!library) {
+        printf("[ERROR]    Could not load bot \"%s\": %s\n", path, dlerror());
+        return NULL;
+    }
+    /* Function pointers cannot be cast from void * in ISO C, the symbol is copied instead */
+    GetBotInterface getBotInterface; void *symbol = dlsym(library, BOT_ENTRY_POINT);
+    memcpy(&getBotInterface, &symbol, sizeof(symbol));
+    const BotInterface *interface = symbol ? getBotInterface() : NULL;
+    if (!interface || !interface->build) {
+        printf("[ERROR]    \"%s\" does not export a bot interface (%s)\n", path, BOT_ENTRY_POINT);
+        dlclose(library);
+        return NULL;
+    }
+    if (interface->abi_version != BOT_ABI_VERSION) {
+        printf("[ERROR]    Bot \"%s\" was built for interface version %d instead of %d\n", path, interface->abi_version, BOT_ABI_VERSION);
+        dlclose(library);
+        return NULL;
+    }
+    Bot *bot = malloc(sizeof(Bot));
+    bot->library = library;
+    bot->interface = interface;
+    return bot;
+}
+
+void destroyBot(Bot *bot) {
+    if (!bot) return;
+    dlclose(bot->library);
+    free(bot);
+}
+
+/* Copy what a player can see of a game before a wave into the view given to a plugin */
+void fillBotView(BotView *view, Game *game, int nb_rejected_commands) {
+    int max_life_points, cost, base_attack_cooldown;
+    view->abi_version = BOT_ABI_VERSION;
+    view->level_name = game->level_name;
+    view->seed = game->seed;
+    view->wave_nb = game->current_wave_nb;
+    view->nb_waves = game->nb_waves;
+    view->funds = game->funds;
+    view->score = game->score;
+    view->nb_rejected_commands = nb_rejected_commands;
+    /* Towers built since the last turn are not in the flow field of the game yet */
+    FlowField flow_field = *game->flow_field;
+    updateFlowField(&flow_field, game->tower_list);
+    for (int row = 1; row <= NB_ROWS; row++) for (int collumn = 1; collumn <= NB_COLLUMNS; collumn++) {
+        view->blocked[row-1][collumn-1] = isTileBlocked(&flow_field, collumn, row);
+        view->path_cost[row-1][collumn-1] = getPathCost(&flow_field, collumn, row);
+    }
+    /* Base towers can be bought, and some of them upgraded into another type */
+    const char tower_types[] = {ARCHER_TOWER, WALL_TOWER, CANON_TOWER, SORCERER_TOWER}, upgrade_types[] = {BARRACK_TOWER, 0, DESTROYER_TOWER, MAGE_TOWER};
+    memset(view->tower_cost, 0, sizeof(view->tower_cost));
+    memset(view->upgrade_cost, 0, sizeof(view->upgrade_cost));
+    for (unsigned long i = 0; i < sizeof(tower_types); i++) {
+        getTowerStats(tower_types[i], &max_life_points, &view->tower_cost[(int) tower_types[i]], &base_attack_cooldown);
+        if (upgrade_types[i]) getTowerStats(upgrade_types[i], &max_life_points, &view->upgrade_cost[(int) tower_types[i]], &base_attack_cooldown);
+    }
+    view->nb_towers = 0;
+    for (Tower *tower = game->tower_list; tower && view->nb_towers < BOT_MAX_TOWERS; tower = tower->next) {
+        getTowerStats(tower->type, &max_life_points, &cost, &base_attack_cooldown);
+        view->towers[view->nb_towers++] = (BotTower) {tower->type, tower->collumn, tower->row, tower->life_points, max_life_points};
+    }
+    view->nb_enemies = 0;
+    for (Enemy *enemy = game->enemy_list; enemy && view->nb_enemies < BOT_MAX_ENEMIES; enemy = enemy->next)
+        view->enemies[view->nb_enemies++] = (BotEnemy) {enemy->type, enemy->collumn, enemy->row, enemy->life_points, 0};
+    SpawnQueue *spawn_queue = game->spawn_queue;
+    int nb_waiting = 0, base_speed, score_on_kill;
+    for (int i = spawn_queue->head; i < spawn_queue->nb_entries && nb_waiting < BOT_MAX_SPAWNS; i++, nb_waiting++) {
+        SpawnEntry *entry = &spawn_queue->entries[i];
+        getEnemyStats(entry->type, &max_life_points, &base_speed, &score_on_kill);
+        view->enemies[view->nb_enemies++] = (BotEnemy) {entry->type, NB_COLLUMNS, entry->row, max_life_points, entry->turn};
+    }
+}
+
+/* Create the state of a plugin for a new game */
+BotPlayer *newBotPlayer(Bot *bot, Game *game) {
+    BotPlayer *player = malloc(sizeof(BotPlayer));
+    player->bot = bot;
+    player->view = malloc(sizeof(BotView));
+    player->nb_rejected_commands = 0;
+    fillBotView(player->view, game, 0);
+    player->state = bot->interface->create ? bot->interface->create(player->view) : NULL;
+    return player;
+}
+
+void destroyBotPlayer(BotPlayer *player) {
+    if (!player) return;
+    if (player->bot->interface->destroy) player->bot->interface->destroy(player->state);
+    free(player->view);
+    free(player);
+}
+
+/* Let a plugin choose the towers to build, upgrade or sell before a wave, return the number of commands done */
+int playBotBuildPhase(BotPlayer *player, Game *game) {
+    BotCommand commands[BOT_MAX_COMMANDS];
+    Tower *tower;
+    fillBotView(player->view, game, player->nb_rejected_commands);
+    int nb_commands = player->bot->interface->build(player->state, player->view, commands, BOT_MAX_COMMANDS), nb_done = 0;
+    nb_commands = min(max(nb_commands, 0), BOT_MAX_COMMANDS);
+    for (int i = 0; i < nb_commands; i++) {
+        /* Commands are checked before being done, as the game expects actions that the interface allows */
+        tower = NULL;
+        if (doesTileExist(commands[i].collumn, commands[i].row)) getEnemyAndTowerAt(NULL, game->tower_list, commands[i].collumn, commands[i].row, NULL, &tower);
+        bool valid = doesTileExist(commands[i].collumn, commands[i].row) && commands[i].collumn < NB_COLLUMNS;
+        switch (commands[i].type) {
+            case BOT_BUY_COMMAND:     valid = valid && !tower && player->view->tower_cost[commands[i].tower_type & 127]; break;
+            case BOT_UPGRADE_COMMAND: valid = valid && tower && player->view->upgrade_cost[tower->type & 127]; break;
+            case BOT_SELL_COMMAND:    valid = valid && tower; break;
+            default:                  valid = false;
+        }
+        if (valid && applyAction(game, (Action) {commands[i].type, commands[i].tower_type, commands[i].collumn, commands[i].row, 0})) nb_done++;
+    }
+    player->nb_rejected_commands = nb_commands - nb_done;
+    return nb_done;
+}
+
+
+
+
+/* Name of a strategy in outputs, the name of its build order or plugin file */
+const char *strategyName(const char *path) {
+    const char *name = strrchr(path, '/');
+    return name ? name + 1 : path;
+}
+
+/* Play a game to the end without display with a build order (NULL for none) and a plugin (NULL for none), return its outcome */
+/* Survival waves start right after the previous one without a pre-wave phase, so their build phase is the first turn of each wave */
+/* A game still going once more than max_waves waves have started is stopped (-1 for no limit) */
+char playStrategy(Game *game, BuildStep *build_order, int nb_steps, Bot *bot, int max_waves) {
+    BotPlayer *bot_player = bot ? newBotPlayer(bot, game) : NULL;
+    char outcome = 0; int built_wave = game->current_wave_nb - 1; bool pre_wave;
+    while (game->game_phase != VICTORY_PHASE && game->game_phase != DEFEAT_PHASE) {
+        if (max_waves >= 0 && game->current_wave_nb > max_waves) {
+            outcome = SURVIVED_OUTCOME;
+            break;
+        }
+        pre_wave = (game->game_phase == PRE_WAVE_PHASE || game->game_phase == WAITING_FOR_USER_PHASE);
+        if (pre_wave || (game->game_phase == WAVE_PHASE && game->turn_nb == 0 && game->current_wave_nb != built_wave)) {
+            built_wave = game->current_wave_nb;
+            applyBuildOrder(game, build_order, nb_steps, false);
+            if (bot_player) playBotBuildPhase(bot_player, game);
+            if (pre_wave) applyAction(game, (Action) {START_WAVE_ACTION, 0, 0, 0, 0});
+        }
+        updateGame(game, NULL);
+        if (game->turn_nb > MAX_TURNS_PER_WAVE) {
+            outcome = STUCK_OUTCOME;
+            break;
+        }
+    }
+    if (!outcome) outcome = (game->game_phase == VICTORY_PHASE) ? VICTORY_OUTCOME : DEFEAT_OUTCOME;
+    destroyBotPlayer(bot_player);
+    return outcome;
+}
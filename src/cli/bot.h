@@ -0,0 +1,120 @@
+#ifndef BOT_H
+#define BOT_H
+
+/* Interface between the headless simulators and strategy plugins (shared libraries loaded with dlopen) */
+/* A plugin only includes this file: it sees plain copies of the game, never the structures of the simulation */
+/* The interface is stable: fields are only ever added at the end of the structures, and BOT_ABI_VERSION changes on any other change */
+/* Build a plugin with: gcc -std=c17 -O2 -shared -fPIC my_bot.c -o my_bot.so */
+
+#define BOT_ABI_VERSION 1
+#define BOT_ENTRY_POINT "getBotInterface"  // Name of the function every plugin exports (see GetBotInterface)
+
+#define BOT_NB_ROWS 7           // Number of rows of the map
+#define BOT_NB_COLLUMNS 15      // Number of collumns of the map (collumn 0 is the castle)
+#define BOT_MAX_TOWERS 128      // Towers beyond this are left out of the view
+#define BOT_MAX_ENEMIES 128     // Same for enemies already on the map
+#define BOT_MAX_SPAWNS 512      // Same for enemies of the upcoming wave
+#define BOT_MAX_COMMANDS 64     // Maximum number of commands returned for a build phase
+
+/* Commands (same letters as the actions of the player) */
+#define BOT_BUY_COMMAND 'B'
+#define BOT_UPGRADE_COMMAND 'U'
+#define BOT_SELL_COMMAND 'S'
+
+
+
+
+/* Tower on the map */
+typedef struct {
+    char type;            // Tower type (same letters as the game, 'A' for an archer tower...)
+    int collumn;          // Collumn of the tower
+    int row;              // Row of the tower
+    int life_points;      // Life points left
+    int max_life_points;  // Life points of a new tower of this type
+} BotTower;
+
+/* Enemy on the map, or waiting to enter it */
+typedef struct {
+    char type;        // Enemy type (same letters as the game, 'S' for a slime...)
+    int collumn;      // Collumn of the enemy (NB_COLLUMNS for the ones still waiting)
+    int row;          // Row of the enemy
+    int life_points;  // Life points of the enemy
+    int turn;         // Turn on which a waiting enemy enters the map (0 for enemies already on it)
+} BotEnemy;
+
+/* Read-only copy of a game before a wave, given to the plugin at each build phase */
+typedef struct {
+    int abi_version;                                      // BOT_ABI_VERSION of the simulator
+    const char *level_name;                               // Name of the played level
+    unsigned long long seed;                              // Seed the game was created with
+    int wave_nb;                                          // Number of the upcoming wave
+    int nb_waves;                                         // Number of waves of the level (-1 for the survival mode)
+    int funds;                                            // Funds available to build towers
+    int score;                                            // Player score
+    int nb_rejected_commands;                             // Number of commands of the previous build phase that could not be done
+    unsigned char blocked[BOT_NB_ROWS][BOT_NB_COLLUMNS];  // Terrain tiles that cannot be walked on nor built on, indexed by [row-1][collumn-1]
+    int path_cost[BOT_NB_ROWS][BOT_NB_COLLUMNS];          // Path cost from each tile to the castle for the enemies, with the current towers
+    int tower_cost[128];                                  // Cost of each tower type, indexed by its letter (0 for types that cannot be built)
+    int upgrade_cost[128];                                // Cost of upgrading each tower type, indexed by its letter (0 for types that cannot be upgraded)
+    BotTower towers[BOT_MAX_TOWERS];                      // Towers, in order of creation
+    int nb_towers;                                        // Number of towers
+    BotEnemy enemies[BOT_MAX_ENEMIES + BOT_MAX_SPAWNS];   // Enemies on the map, then enemies of the upcoming wave in order of apparition
+    int nb_enemies;                                       // Number of enemies
+} BotView;
+
+/* Command returned by the plugin, done right after the build phase in the returned order */
+typedef struct {
+    char type;        // Command type (BOT_BUY_COMMAND...)
+    char tower_type;  // Type of the tower bought
+    int collumn;      // Collumn of the tower concerned (1 to BOT_NB_COLLUMNS-1)
+    int row;          // Row of the tower concerned (1 to BOT_NB_ROWS)
+} BotCommand;
+
+/* Functions of a plugin, the simulator may play several games at once on different threads (one state per game) */
+typedef struct {
+    int abi_version;                                                                          // BOT_ABI_VERSION the plugin was built with
+    const char *name;                                                                         // Name of the strategy
+    void *(*create)(const BotView *view);                                                     // Create the state of the plugin for a new game (may be NULL)
+    int (*build)(void *state, const BotView *view, BotCommand *commands, int max_commands);  // Fill the commands of a build phase, return their number
+    void (*destroy)(void *state);                                                             // Free the state of a game (may be NULL)
+} BotInterface;
+
+/* Type of the function exported by every plugin under the name BOT_ENTRY_POINT */
+typedef const BotInterface *(*GetBotInterface)(void);
+
+
+#ifdef SIM_H
+#define MAX_TURNS_PER_WAVE 1000  // A wave still running after this many turns is considered stuck and the game is stopped
+/* Game outcomes of the headless runners */
+#define VICTORY_OUTCOME 'V'
+#define DEFEAT_OUTCOME 'D'
+#define STUCK_OUTCOME 'S'
+#define SURVIVED_OUTCOME 'C'  // Still going once the wave limit was reached
+
+/* Plugin loaded by a simulator */
+typedef struct {
+    void *library;                  // Handle of the shared library
+    const BotInterface *interface;  // Functions of the plugin
+} Bot;
+
+/* Plugin playing a game */
+typedef struct {
+    Bot *bot;                  // Plugin
+    void *state;               // State of the plugin for this game
+    BotView *view;             // Copy of the game given to the plugin (kept to avoid an allocation per build phase)
+    int nb_rejected_commands;  // Number of commands of the last build phase that could not be done
+} BotPlayer;
+
+/* Header (simulator side) */
+bool isBotPath(const char *path);
+Bot *loadBot(const char *path);
+void destroyBot(Bot *bot);
+void fillBotView(BotView *view, Game *game, int nb_rejected_commands);
+BotPlayer *newBotPlayer(Bot *bot, Game *game);
+void destroyBotPlayer(BotPlayer *player);
+int playBotBuildPhase(BotPlayer *player, Game *game);
+const char *strategyName(const char *path);
+char playStrategy(Game *game, BuildStep *build_order, int nb_steps, Bot *bot, int max_waves);
+#endif
+
+#endif
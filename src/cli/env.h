@@ -0,0 +1,94 @@
+#ifndef ENV_H
+#define ENV_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+/* Layout of the shared memory through which td-env serves environments to a training process on the same machine */
+/* The trainer maps the segment ENV_SHM_PREFIX<name> (shm_open), pushes requests in the ring and reads observations in place */
+/* Every integer has a fixed size and atomics are plain integers of the same size, so that any language can map the segment */
+/*
+    Protocol:
+    - Wait for ready to be set, then check magic and abi_version.
+    - Push a request: claim a cell at ring_tail (see pushEnvRequest in td_env.c), fill it, publish its sequence,
+      then increase request_futex and wake it (FUTEX_WAKE) if nb_sleeping_workers is not 0.
+    - The observation of the environment is rewritten in place, then its sequence is increased by one.
+      To wait for it, read completion_futex, check the sequence again and sleep on completion_futex (FUTEX_WAIT) if it has not changed,
+      increasing nb_sleeping_trainers around the wait.
+    - Only one request per environment may be waiting at once (requests of different environments are served in parallel).
+*/
+
+#define ENV_ABI_VERSION 1
+#define ENV_MAGIC 0x56454454u        // "TDEV"
+#define ENV_SHM_PREFIX "/td-env-"    // Shared memory name of a server, followed by its name
+#define ENV_RING_CAPACITY 4096       // Number of cells of the request ring (a power of two)
+#define ENV_MAX_ENVS 4096            // Maximum number of environments of a server
+#define ENV_NB_ROWS 7                // Number of rows of the map
+#define ENV_NB_COLLUMNS 15           // Number of collumns of the map (collumn 0 is the castle)
+
+/* Actions (same letters as the actions of the player) */
+#define ENV_RESET_ACTION 'R'       // Start a new game with the seed of the request
+#define ENV_BUY_ACTION 'B'
+#define ENV_UPGRADE_ACTION 'U'
+#define ENV_SELL_ACTION 'S'
+#define ENV_START_WAVE_ACTION 'W'  // Play the whole upcoming wave, the reward being the score earned (survival waves stop on the first turn of the next one)
+#define ENV_SHUTDOWN_ACTION 'Q'    // Stop the server (environment index ignored)
+
+
+
+
+/* Action requested for an environment */
+typedef struct {
+    int32_t env;         // Index of the environment
+    int32_t type;        // Action type
+    int32_t tower_type;  // Type of the tower bought
+    int32_t collumn;     // Collumn of the tower concerned
+    int32_t row;         // Row of the tower concerned
+    uint32_t seed;       // Seed of the new game for resets
+} EnvRequest;
+
+/* Cell of the request ring (bounded multi-producer multi-consumer queue) */
+typedef struct {
+    _Atomic uint64_t sequence;  // Position the cell is waiting to be written at, plus one once written (see pushEnvRequest)
+    EnvRequest request;         // Request stored
+} EnvCell;
+
+/* What a player sees of an environment, rewritten after each request */
+typedef struct {
+    _Atomic uint32_t sequence;                                // Increased by one each time the observation is rewritten
+    int32_t action_done;                                      // Was the last action possible (1) or rejected (0)
+    int32_t reward;                                           // Score earned by the last action
+    int32_t done;                                             // Is the game over (won, lost, stuck or never reset)
+    int32_t phase;                                            // Game phase (0 before a wave and on the first turn of a survival wave, 4 won, 5 lost)
+    int32_t wave_nb;                                          // Number of the upcoming wave
+    int32_t nb_waves;                                         // Number of waves of the level (-1 for the survival mode)
+    int32_t funds;                                            // Funds available to build towers
+    int32_t score;                                            // Player score
+    int32_t total_turns;                                      // Number of turns played since the game started
+    uint8_t blocked[ENV_NB_ROWS][ENV_NB_COLLUMNS];            // Terrain tiles that cannot be walked on nor built on, indexed by [row-1][collumn-1]
+    uint8_t tower_type[ENV_NB_ROWS][ENV_NB_COLLUMNS];         // Type of the tower on each tile (0 for none)
+    int16_t tower_life_points[ENV_NB_ROWS][ENV_NB_COLLUMNS];  // Life points of the tower on each tile
+    uint8_t enemy_type[ENV_NB_ROWS][ENV_NB_COLLUMNS + 1];     // Type of the enemy on each tile, indexed by [row-1][collumn] (castle collumn included)
+    int16_t enemy_life_points[ENV_NB_ROWS][ENV_NB_COLLUMNS + 1];  // Life points of the enemy on each tile
+    int16_t nb_spawns[ENV_NB_ROWS];                           // Number of enemies of the upcoming wave entering the map on each row
+} EnvObservation;
+
+/* Whole shared memory segment */
+typedef struct {
+    uint32_t magic;                           // ENV_MAGIC once the server is initialised
+    uint32_t abi_version;                     // ENV_ABI_VERSION of the server
+    uint32_t nb_envs;                         // Number of environments
+    uint32_t ring_capacity;                   // ENV_RING_CAPACITY
+    _Atomic uint32_t ready;                   // Set once everything else is initialised
+    _Atomic uint32_t shutdown;                // Set once the server is stopping
+    _Atomic uint32_t request_futex;           // Increased after each request pushed (the server workers sleep on it)
+    _Atomic uint32_t completion_futex;        // Increased after each observation rewritten (the trainers sleep on it)
+    _Atomic uint32_t nb_sleeping_workers;     // Number of server workers sleeping on request_futex
+    _Atomic uint32_t nb_sleeping_trainers;    // Number of trainer threads sleeping on completion_futex
+    _Atomic uint64_t ring_head;               // Position of the next request to pop
+    _Atomic uint64_t ring_tail;               // Position of the next request to push
+    EnvCell ring[ENV_RING_CAPACITY];          // Request ring
+    EnvObservation observations[];            // Observation of each environment
+} EnvSharedMemory;
+
+#endif
@@ -0,0 +1,215 @@
+#define _POSIX_C_SOURCE 200809L  // sysconf
+#include "../sim.h"
+#include "bot.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define MAX_SURVIVAL_WAVES 50    // Survival runs still alive after this many waves are stopped (and counted as wins)
+#define SURVIVAL_LEVEL_NAME "survival"
+
+
+
+
+/* Result of a single game */
+typedef struct {
+    char outcome;     // Run outcome (VICTORY_OUTCOME...)
+    int wave_nb;      // Wave reached
+    int total_turns;  // Number of turns survived
+    int score;        // Final score
+} RunResult;
+
+/* Every run to simulate (each build order played once per seed), shared by all workers */
+typedef struct {
+    char *level_name;          // Name of the played level
+    bool survival;             // Is the level the survival mode
+    BuildStep **build_orders;  // Strategies played
+    int *nb_steps;             // Number of steps of each build order
+    Bot **bots;                // Plugin playing each strategy (NULL for build orders)
+    int nb_strategies;         // Number of build orders
+    int nb_seeds;              // Number of seeds played per strategy (seeds 0 to nb_seeds-1)
+    atomic_int next_run;       // Index of the next run to simulate (run i plays strategy i/nb_seeds on seed i%nb_seeds)
+    RunResult *results;        // Result of each run
+} Batch;
+
+/* Thread simulating runs until none is left */
+typedef struct {
+    pthread_t thread;     // Thread of the worker
+    Batch *batch;         // Runs to simulate
+    CombatStats *stats;   // Damage statistics summed over the runs of each strategy
+} Worker;
+
+
+/* Header */
+void playRun(Batch *batch, int strategy, unsigned long long seed, RunResult *result, CombatStats *stats);
+void *workerMain(void *arg);
+void addCombatStats(CombatStats *stats, CombatStats *other);
+int compareInts(const void *a, const void *b);
+bool writeSummary(const char *path, Batch *batch, char **paths);
+bool writeUnitStats(const char *path, Batch *batch, char **paths, CombatStats *stats);
+
+
+
+/* Play a build order (or a bot plugin) on a seed without display, adding its damage statistics to stats */
+void playRun(Batch *batch, int strategy, unsigned long long seed, RunResult *result, CombatStats *stats) {
+    Game *game = createNewGame(batch->survival ? SURVIVAL_MODE : batch->level_name, seed);
+    destroyEventLog(game->event_log);
+    game->event_log = NULL;
+    game->combat_stats = calloc(1, sizeof(CombatStats));
+    result->outcome = playStrategy(game, batch->build_orders[strategy], batch->nb_steps[strategy], batch->bots[strategy], batch->survival ? MAX_SURVIVAL_WAVES : -1);
+    result->wave_nb = game->current_wave_nb;
+    result->total_turns = game->total_turns;
+    result->score = game->score;
+    addCombatStats(stats, game->combat_stats);
+    destroyGame(game);
+}
+
+/* Simulate runs of the batch until every run has been taken by a worker */
+void *workerMain(void *arg) {
+    Worker *worker = arg;
+    Batch *batch = worker->batch;
+    int nb_runs = batch->nb_strategies * batch->nb_seeds, run;
+    while ((run = atomic_fetch_add(&batch->next_run, 1)) < nb_runs)
+        playRun(batch, run / batch->nb_seeds, run % batch->nb_seeds, &batch->results[run], &worker->stats[run / batch->nb_seeds]);
+    return NULL;
+}
+
+/* Add the damage statistics of other to stats */
+void addCombatStats(CombatStats *stats, CombatStats *other) {
+    for (int i = 0; i < 128; i++) {
+        stats->tower_damage_dealt[i] += other->tower_damage_dealt[i];
+        stats->tower_damage_taken[i] += other->tower_damage_taken[i];
+        stats->nb_towers_destroyed[i] += other->nb_towers_destroyed[i];
+        stats->enemy_damage_dealt[i] += other->enemy_damage_dealt[i];
+        stats->enemy_damage_taken[i] += other->enemy_damage_taken[i];
+        stats->nb_enemies_killed[i] += other->nb_enemies_killed[i];
+    }
+}
+
+/* Compare two integers (for qsort) */
+int compareInts(const void *a, const void *b) {
+    return (*(int *) a > *(int *) b) - (*(int *) a < *(int *) b);
+}
+
+/* Write the outcome of each strategy in a CSV file: win rate, waves and turns survived, score distribution */
+bool writeSummary(const char *path, Batch *batch, char **paths) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        printf("[ERROR]    Unable to write file at \"%s\"\n", path);
+        return false;
+    }
+    fprintf(file, "strategy,runs,wins,defeats,stuck,win_rate,mean_wave,mean_turns,mean_score,min_score,p10_score,p25_score,median_score,p75_score,p90_score,max_score\n");
+    int *scores = malloc(batch->nb_seeds * sizeof(int)), nb_wins, nb_defeats, nb_stuck; double total_waves, total_turns, total_score; RunResult *result;
+    for (int s = 0; s < batch->nb_strategies; s++) {
+        nb_wins = nb_defeats = nb_stuck = 0; total_waves = total_turns = total_score = 0.0;
+        for (int i = 0; i < batch->nb_seeds; i++) {
+            result = &batch->results[s * batch->nb_seeds + i];
+            nb_wins += (result->outcome == VICTORY_OUTCOME || result->outcome == SURVIVED_OUTCOME);
+            nb_defeats += (result->outcome == DEFEAT_OUTCOME);
+            nb_stuck += (result->outcome == STUCK_OUTCOME);
+            total_waves += result->wave_nb; total_turns += result->total_turns; total_score += result->score;
+            scores[i] = result->score;
+        }
+        qsort(scores, batch->nb_seeds, sizeof(int), compareInts);
+        fprintf(file, "%s,%d,%d,%d,%d,%.4f,%.2f,%.2f,%.2f,%d,%d,%d,%d,%d,%d,%d\n", strategyName(paths[s]), batch->nb_seeds, nb_wins, nb_defeats, nb_stuck,
+            (double) nb_wins / batch->nb_seeds, total_waves / batch->nb_seeds, total_turns / batch->nb_seeds, total_score / batch->nb_seeds,
+            scores[0], scores[batch->nb_seeds / 10], scores[batch->nb_seeds / 4], scores[batch->nb_seeds / 2], scores[batch->nb_seeds * 3 / 4], scores[batch->nb_seeds * 9 / 10], scores[batch->nb_seeds - 1]);
+    }
+    free(scores);
+    fclose(file);
+    return true;
+}
+
+/* Write the damage statistics of each unit type in a CSV file, averaged per run (unit types that never fought are skipped) */
+bool writeUnitStats(const char *path, Batch *batch, char **paths, CombatStats *stats) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        printf("[ERROR]    Unable to write file at \"%s\"\n", path);
+        return false;
+    }
+    fprintf(file, "strategy,side,unit,damage_dealt,damage_taken,lost\n");
+    double n = batch->nb_seeds;
+    for (int s = 0; s < batch->nb_strategies; s++) for (int i = 0; i < 128; i++) {
+        if (stats[s].tower_damage_dealt[i] || stats[s].tower_damage_taken[i] || stats[s].nb_towers_destroyed[i])
+            fprintf(file, "%s,tower,%c,%.2f,%.2f,%.3f\n", strategyName(paths[s]), i, stats[s].tower_damage_dealt[i] / n, stats[s].tower_damage_taken[i] / n, stats[s].nb_towers_destroyed[i] / n);
+        if (stats[s].enemy_damage_dealt[i] || stats[s].enemy_damage_taken[i] || stats[s].nb_enemies_killed[i])
+            fprintf(file, "%s,enemy,%c,%.2f,%.2f,%.3f\n", strategyName(paths[s]), i, stats[s].enemy_damage_dealt[i] / n, stats[s].enemy_damage_taken[i] / n, stats[s].nb_enemies_killed[i] / n);
+    }
+    fclose(file);
+    return true;
+}
+
+
+
+
+/* Play every build order on many seeds using all processor cores, then write the results in two CSV files */
+/* Usage: td-balance <level|survival> <nb seeds> <output prefix> <build order file|bot plugin (.so)> [build order file|bot plugin...] */
+/* Files written: <output prefix>_summary.csv and <output prefix>_units.csv */
+int main(int argc, char *argv[]) {
+    if (argc < 5) {
+        printf("Usage: %s <level|survival> <nb seeds> <output prefix> <build order file|bot plugin (.so)> [build order file|bot plugin...]\n", argv[0]);
+        return 1;
+    }
+    Batch batch;
+    batch.level_name = argv[1];
+    batch.survival = !strcmp(argv[1], SURVIVAL_LEVEL_NAME);
+    batch.nb_seeds = max(stringToInt(argv[2]), 1);
+    batch.nb_strategies = argc - 4;
+    batch.build_orders = malloc(batch.nb_strategies * sizeof(BuildStep *));
+    batch.nb_steps = malloc(batch.nb_strategies * sizeof(int));
+    batch.bots = calloc(batch.nb_strategies, sizeof(Bot *));
+    for (int i = 0; i < batch.nb_strategies; i++) {
+        batch.build_orders[i] = NULL;
+        batch.nb_steps[i] = 0;
+        if (isBotPath(argv[i+4]) ? !(batch.bots[i] = loadBot(argv[i+4])) : !(batch.build_orders[i] = loadBuildOrder(argv[i+4], &batch.nb_steps[i]))) return 1;
+    }
+    /* Check that the level exists before starting */
+    Game *game = createNewGame(batch.survival ? SURVIVAL_MODE : batch.level_name, 0);
+    bool level_found = game->nb_waves;
+    destroyGame(game);
+    if (!level_found) return 1;
+
+    /* Every worker takes the next run left until all are done */
+    int nb_runs = batch.nb_strategies * batch.nb_seeds;
+    int nb_workers = min(max((int) sysconf(_SC_NPROCESSORS_ONLN), 1), nb_runs);
+    batch.results = malloc(nb_runs * sizeof(RunResult));
+    atomic_init(&batch.next_run, 0);
+    Worker *workers = malloc(nb_workers * sizeof(Worker));
+    double start = getTimeMs();
+    for (int i = 0; i < nb_workers; i++) {
+        workers[i].batch = &batch;
+        workers[i].stats = calloc(batch.nb_strategies, sizeof(CombatStats));
+        pthread_create(&workers[i].thread, NULL, workerMain, &workers[i]);
+    }
+    CombatStats *stats = calloc(batch.nb_strategies, sizeof(CombatStats));
+    for (int i = 0; i < nb_workers; i++) {
+        pthread_join(workers[i].thread, NULL);
+        for (int s = 0; s < batch.nb_strategies; s++) addCombatStats(&stats[s], &workers[i].stats[s]);
+        free(workers[i].stats);
+    }
+    double sim_time = getTimeMs() - start;
+
+    /* Write results */
+    char path[256];
+    snprintf(path, sizeof(path), "%s_summary.csv", argv[3]);
+    bool written = writeSummary(path, &batch, argv + 4);
+    snprintf(path, sizeof(path), "%s_units.csv", argv[3]);
+    written = writeUnitStats(path, &batch, argv + 4, stats) && written;
+    printf("Level:        %s\n", argv[1]);
+    printf("Runs:         %d (%d strategies x %d seeds)\n", nb_runs, batch.nb_strategies, batch.nb_seeds);
+    printf("Threads:      %d\n", nb_workers);
+    printf("Sim time:     %.3f ms (%.0f runs/s)\n", sim_time, (sim_time > 0.0) ? nb_runs * 1000.0 / sim_time : 0.0);
+
+    /* Free memory */
+    for (int i = 0; i < batch.nb_strategies; i++) {
+        free(batch.build_orders[i]);
+        destroyBot(batch.bots[i]);
+    }
+    free(batch.build_orders);
+    free(batch.bots);
+    free(batch.nb_steps);
+    free(batch.results);
+    free(workers);
+    free(stats);
+    return !written;
+}
@@ -0,0 +1,184 @@
+#define _POSIX_C_SOURCE 200809L  // sysconf
+#include "../sim.h"
+#include "bot.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define MAX_TARGET_WAVES 64      // Maximum number of waves with a target survival rate
+#define NB_CURVE_PARAMETERS 7    // Number of values of a survival curve
+#define INITIAL_STEP 1.5         // First scale factor tried on each value
+#define MIN_STEP 1.02            // The search stops once the scale factor is below this
+#define MAX_EVALUATIONS 200      // The search also stops after this many evaluated curves
+
+
+
+
+/* Survival runs played for a curve, shared by all workers */
+typedef struct {
+    SurvivalCurve curve;       // Curve evaluated
+    BuildStep **build_orders;  // Reference strategies played
+    int *nb_steps;             // Number of steps of each build order
+    int nb_strategies;         // Number of build orders
+    int nb_seeds;              // Number of seeds played per strategy (the same seeds for every curve)
+    int nb_waves;              // Runs are stopped once they survived this many waves
+    atomic_int next_run;       // Index of the next run to simulate (run i plays strategy i/nb_seeds on seed i%nb_seeds)
+    int *waves_survived;       // Number of waves survived by each run
+} Calibration;
+
+
+/* Header */
+int playSurvivalRun(Calibration *calibration, int strategy, unsigned long long seed);
+void *calibrationWorker(void *arg);
+double evaluateCurve(Calibration *calibration, SurvivalCurve curve, double *targets, double *rates, int nb_threads);
+int *curveParameter(SurvivalCurve *curve, int i);
+int parseTargets(const char *str, double *targets);
+
+
+
+/* Play a reference strategy on a survival seed without display, return the number of waves survived */
+int playSurvivalRun(Calibration *calibration, int strategy, unsigned long long seed) {
+    Game *game = createNewGame(SURVIVAL_MODE, seed);
+    destroyEventLog(game->event_log);
+    game->event_log = NULL;
+    /* Every wave is generated after the game is created, so they all follow the evaluated curve */
+    game->survival_curve = calibration->curve;
+    playStrategy(game, calibration->build_orders[strategy], calibration->nb_steps[strategy], NULL, calibration->nb_waves);
+    /* The wave being played was not survived */
+    int waves_survived = min(game->current_wave_nb - 1, calibration->nb_waves);
+    destroyGame(game);
+    return max(waves_survived, 0);
+}
+
+/* Simulate runs of the calibration until every run has been taken by a worker */
+void *calibrationWorker(void *arg) {
+    Calibration *calibration = arg;
+    int nb_runs = calibration->nb_strategies * calibration->nb_seeds, run;
+    while ((run = atomic_fetch_add(&calibration->next_run, 1)) < nb_runs)
+        calibration->waves_survived[run] = playSurvivalRun(calibration, run / calibration->nb_seeds, run % calibration->nb_seeds);
+    return NULL;
+}
+
+/* Play every run with a curve, fill the survival rate of each wave and return the squared error to the targets */
+double evaluateCurve(Calibration *calibration, SurvivalCurve curve, double *targets, double *rates, int nb_threads) {
+    calibration->curve = curve;
+    atomic_store(&calibration->next_run, 0);
+    pthread_t *threads = malloc(nb_threads * sizeof(pthread_t));
+    for (int i = 0; i < nb_threads; i++) pthread_create(&threads[i], NULL, calibrationWorker, calibration);
+    for (int i = 0; i < nb_threads; i++) pthread_join(threads[i], NULL);
+    free(threads);
+    /* Rate of runs still alive after each wave */
+    int nb_runs = calibration->nb_strategies * calibration->nb_seeds;
+    double error = 0.0;
+    for (int wave = 0; wave < calibration->nb_waves; wave++) {
+        int nb_alive = 0;
+        for (int run = 0; run < nb_runs; run++) nb_alive += (calibration->waves_survived[run] > wave);
+        rates[wave] = (double) nb_alive / nb_runs;
+        error += (rates[wave] - targets[wave]) * (rates[wave] - targets[wave]);
+    }
+    return error;
+}
+
+/* Return the address of the i-th value of a survival curve */
+int *curveParameter(SurvivalCurve *curve, int i) {
+    switch (i) {
+        case 0: return &curve->base_power;
+        case 1: return &curve->power_per_wave;
+        case 2: return &curve->necromancer;
+        case 3: return &curve->orc;
+        case 4: return &curve->witch;
+        case 5: return &curve->goblin;
+        default: return &curve->gelly;
+    }
+}
+
+/* Read comma separated survival rates (one per wave), return how many were read */
+int parseTargets(const char *str, double *targets) {
+    int nb_targets = 0; char *end;
+    while (*str && nb_targets < MAX_TARGET_WAVES) {
+        targets[nb_targets] = strtod(str, &end);
+        if (end == str || targets[nb_targets] < 0.0 || targets[nb_targets] > 1.0) return 0;
+        nb_targets++;
+        str = (*end == ',') ? end + 1 : end;
+    }
+    return nb_targets;
+}
+
+
+
+
+/* Fit the survival mode difficulty so that the reference strategies survive each wave at the target rates */
+/* Usage: td-calibrate <nb seeds> <target survival rates, e.g. 0.95,0.8,0.6> <build order file> [build order file...] */
+/* The fitted curve is written to the file loaded by the game (SURVIVAL_CURVE_PATH) */
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        printf("Usage: %s <nb seeds> <target survival rates, e.g. 0.95,0.8,0.6> <build order file> [build order file...]\n", argv[0]);
+        return 1;
+    }
+    double targets[MAX_TARGET_WAVES], rates[MAX_TARGET_WAVES], best_rates[MAX_TARGET_WAVES];
+    Calibration calibration;
+    calibration.nb_seeds = max(stringToInt(argv[1]), 1);
+    if (!(calibration.nb_waves = parseTargets(argv[2], targets))) {
+        printf("[ERROR]    Invalid target survival rates \"%s\"\n", argv[2]);
+        return 1;
+    }
+    calibration.nb_strategies = argc - 3;
+    calibration.build_orders = malloc(calibration.nb_strategies * sizeof(BuildStep *));
+    calibration.nb_steps = malloc(calibration.nb_strategies * sizeof(int));
+    for (int i = 0; i < calibration.nb_strategies; i++) if (!(calibration.build_orders[i] = loadBuildOrder(argv[i+3], &calibration.nb_steps[i]))) return 1;
+    int nb_runs = calibration.nb_strategies * calibration.nb_seeds;
+    int nb_threads = min(max((int) sysconf(_SC_NPROCESSORS_ONLN), 1), nb_runs);
+    calibration.waves_survived = malloc(nb_runs * sizeof(int));
+    atomic_init(&calibration.next_run, 0);
+
+    /* Start from the curve currently used by the game */
+    SurvivalCurve best = defaultSurvivalCurve(), curve;
+    loadSurvivalCurve(SURVIVAL_CURVE_PATH, &best);
+    double start = getTimeMs();
+    double best_error = evaluateCurve(&calibration, best, targets, best_rates, nb_threads), error;
+    int nb_evaluations = 1;
+    printf("Initial error: %.5f\n", best_error);
+
+    /* Pattern search: scale each value up and down, and only narrow the scale once no value improves anymore */
+    /* Every curve is played on the same seeds, so that differences come from the curve and not from luck */
+    double step = INITIAL_STEP;
+    while (step >= MIN_STEP && nb_evaluations < MAX_EVALUATIONS) {
+        bool improved = false;
+        for (int i = 0; i < NB_CURVE_PARAMETERS && nb_evaluations < MAX_EVALUATIONS; i++) {
+            for (int direction = 0; direction < 2 && nb_evaluations < MAX_EVALUATIONS; direction++) {
+                curve = best;
+                int *value = curveParameter(&curve, i);
+                *value = max((int) (direction ? *value / step : *value * step + 0.5), 1);
+                if (*value == *curveParameter(&best, i)) continue;
+                error = evaluateCurve(&calibration, curve, targets, rates, nb_threads);
+                nb_evaluations++;
+                if (error < best_error) {
+                    best = curve; best_error = error; improved = true;
+                    memcpy(best_rates, rates, calibration.nb_waves * sizeof(double));
+                    printf("Evaluation %3d: error %.5f (base %d, per wave %d, thresholds %d %d %d %d %d)\n", nb_evaluations, best_error,
+                        best.base_power, best.power_per_wave, best.necromancer, best.orc, best.witch, best.goblin, best.gelly);
+                    break;
+                }
+            }
+        }
+        if (!improved) step = 1.0 + (step - 1.0) / 2.0;
+    }
+    double calibration_time = getTimeMs() - start;
+
+    /* Write the fitted curve */
+    bool written = saveSurvivalCurve(SURVIVAL_CURVE_PATH, &best);
+    printf("Runs:         %d per curve (%d strategies x %d seeds)\n", nb_runs, calibration.nb_strategies, calibration.nb_seeds);
+    printf("Curves:       %d evaluated on %d threads in %.3f ms (%.0f runs/s)\n", nb_evaluations, nb_threads, calibration_time,
+        (calibration_time > 0.0) ? (double) nb_evaluations * nb_runs * 1000.0 / calibration_time : 0.0);
+    printf("Error:        %.5f\n", best_error);
+    printf("Wave  Target  Survival\n");
+    for (int wave = 0; wave < calibration.nb_waves; wave++) printf("%4d  %6.3f  %8.3f\n", wave + 1, targets[wave], best_rates[wave]);
+    if (written) printf("Curve written to \"%s\"\n", SURVIVAL_CURVE_PATH);
+
+    /* Free memory */
+    for (int i = 0; i < calibration.nb_strategies; i++) free(calibration.build_orders[i]);
+    free(calibration.build_orders);
+    free(calibration.nb_steps);
+    free(calibration.waves_survived);
+    return !written;
+}
@@ -0,0 +1,403 @@
+#define _GNU_SOURCE  // syscall (futex), shm_open and sysconf
+#include "../sim.h"
+#include "env.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <unistd.h>
+
+_Static_assert(ENV_NB_ROWS == NB_ROWS && ENV_NB_COLLUMNS == NB_COLLUMNS, "The environment interface must describe the same map as the simulation");
+
+#define MAX_TURNS_PER_WAVE 1000  // A wave still running after this many turns is considered stuck and the game is over
+#define WORKER_SPIN 1024         // Number of times a worker finds the ring empty before going to sleep
+#define SURVIVAL_LEVEL_NAME "survival"
+#define SERVE_MODE "serve"
+#define RANDOM_MODE "random"  // Trainer playing random actions, to check a server and measure its throughput
+#define STOP_ARGUMENT "stop"  // Ask the server to stop once the random trainer is done
+
+
+
+
+/* Environments served, shared by all workers */
+typedef struct {
+    EnvSharedMemory *memory;  // Shared memory segment
+    Game **games;             // Game of each environment (NULL until it is reset)
+    pthread_mutex_t *locks;   // Lock of each environment, in case a trainer sends a request before the previous one was served
+    char *level_name;         // Level played by every environment
+    atomic_llong nb_requests; // Number of requests served
+} Server;
+
+
+/* Header */
+long futexWait(_Atomic uint32_t *word, uint32_t value);
+long futexWake(_Atomic uint32_t *word);
+size_t getEnvMemorySize(int nb_envs);
+bool pushEnvRequest(EnvSharedMemory *memory, EnvRequest request);
+bool popEnvRequest(EnvSharedMemory *memory, EnvRequest *request);
+void submitEnvRequest(EnvSharedMemory *memory, EnvRequest request);
+void writeEnvObservation(EnvObservation *observation, Game *game);
+bool isEnvGameOver(Game *game);
+bool isEnvBuildPhase(Game *game);
+void serveEnvRequest(Server *server, EnvRequest *request);
+void *serverWorker(void *arg);
+int runServer(const char *name, char *level_name, int nb_envs, int nb_threads);
+EnvSharedMemory *connectToServer(const char *name, size_t *size);
+int runRandomTrainer(const char *name, long long nb_steps, bool stop);
+
+
+
+/* Sleep while a shared futex word holds a value (returns right away if it does not anymore) */
+long futexWait(_Atomic uint32_t *word, uint32_t value) {
+    return syscall(SYS_futex, word, FUTEX_WAIT, value, NULL, NULL, 0);
+}
+
+/* Wake every thread (of any process) sleeping on a shared futex word */
+long futexWake(_Atomic uint32_t *word) {
+    return syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+/* Return the size of the shared memory segment for a number of environments */
+size_t getEnvMemorySize(int nb_envs) {
+    return sizeof(EnvSharedMemory) + nb_envs * sizeof(EnvObservation);
+}
+
+/* Push a request in the ring, return false if it is full (any number of threads may push and pop at once) */
+/* Each cell holds the position it may be written at next: pushers claim the tail once the cell is free, then publish the cell with position+1 */
+bool pushEnvRequest(EnvSharedMemory *memory, EnvRequest request) {
+    uint64_t position = atomic_load_explicit(&memory->ring_tail, memory_order_relaxed);
+    while (true) {
+        EnvCell *cell = &memory->ring[position & (ENV_RING_CAPACITY - 1)];
+        int64_t difference = (int64_t) (atomic_load_explicit(&cell->sequence, memory_order_acquire) - position);
+        if (!difference) {
+            if (atomic_compare_exchange_weak_explicit(&memory->ring_tail, &position, position + 1, memory_order_relaxed, memory_order_relaxed)) {
+                cell->request = request;
+                atomic_store_explicit(&cell->sequence, position + 1, memory_order_release);
+                return true;
+            }
+        }
+        else if (difference < 0) return false;
+        else position = atomic_load_explicit(&memory->ring_tail, memory_order_relaxed);
+    }
+}
+
+/* Pop the oldest request of the ring, return false if it is empty (the cell is then freed for the next lap) */
+bool popEnvRequest(EnvSharedMemory *memory, EnvRequest *request) {
+    uint64_t position = atomic_load_explicit(&memory->ring_head, memory_order_relaxed);
+    while (true) {
+        EnvCell *cell = &memory->ring[position & (ENV_RING_CAPACITY - 1)];
+        int64_t difference = (int64_t) (atomic_load_explicit(&cell->sequence, memory_order_acquire) - (position + 1));
+        if (!difference) {
+            if (atomic_compare_exchange_weak_explicit(&memory->ring_head, &position, position + 1, memory_order_relaxed, memory_order_relaxed)) {
+                *request = cell->request;
+                atomic_store_explicit(&cell->sequence, position + ENV_RING_CAPACITY, memory_order_release);
+                return true;
+            }
+        }
+        else if (difference < 0) return false;
+        else position = atomic_load_explicit(&memory->ring_head, memory_order_relaxed);
+    }
+}
+
+/* Push a request (waiting for room if the ring is full) and wake a sleeping worker */
+void submitEnvRequest(EnvSharedMemory *memory, EnvRequest request) {
+    while (!pushEnvRequest(memory, request)) sched_yield();
+    atomic_fetch_add(&memory->request_futex, 1);
+    if (atomic_load(&memory->nb_sleeping_workers)) futexWake(&memory->request_futex);
+}
+
+/* Copy what a player sees of a game into an observation (reward, action and sequence excepted) */
+void writeEnvObservation(EnvObservation *observation, Game *game) {
+    observation->done = !game || isEnvGameOver(game);
+    memset(observation->tower_type, 0, sizeof(observation->tower_type));
+    memset(observation->tower_life_points, 0, sizeof(observation->tower_life_points));
+    memset(observation->enemy_type, 0, sizeof(observation->enemy_type));
+    memset(observation->enemy_life_points, 0, sizeof(observation->enemy_life_points));
+    memset(observation->nb_spawns, 0, sizeof(observation->nb_spawns));
+    if (!game) return;
+    observation->phase = (game->game_phase == WAVE_PHASE && isEnvBuildPhase(game)) ? PRE_WAVE_PHASE : game->game_phase;
+    observation->wave_nb = game->current_wave_nb;
+    observation->nb_waves = game->nb_waves;
+    observation->funds = game->funds;
+    observation->score = game->score;
+    observation->total_turns = game->total_turns;
+    for (int row = 1; row <= NB_ROWS; row++) for (int collumn = 1; collumn <= NB_COLLUMNS; collumn++)
+        observation->blocked[row-1][collumn-1] = isTileBlocked(game->flow_field, collumn, row);
+    for (Tower *tower = game->tower_list; tower; tower = tower->next) if (doesTileExist(tower->collumn, tower->row)) {
+        observation->tower_type[tower->row-1][tower->collumn-1] = tower->type;
+        observation->tower_life_points[tower->row-1][tower->collumn-1] = tower->life_points;
+    }
+    for (Enemy *enemy = game->enemy_list; enemy; enemy = enemy->next) if (enemy->row >= 1 && enemy->row <= NB_ROWS && enemy->collumn >= 0 && enemy->collumn <= NB_COLLUMNS) {
+        observation->enemy_type[enemy->row-1][enemy->collumn] = enemy->type;
+        observation->enemy_life_points[enemy->row-1][enemy->collumn] = enemy->life_points;
+    }
+    SpawnQueue *spawn_queue = game->spawn_queue;
+    for (int i = spawn_queue->head; i < spawn_queue->nb_entries; i++) observation->nb_spawns[spawn_queue->entries[i].row-1]++;
+}
+
+/* Return if a game is over: won, lost, or stuck in a wave */
+bool isEnvGameOver(Game *game) {
+    return game->game_phase == VICTORY_PHASE || game->game_phase == DEFEAT_PHASE || game->turn_nb > MAX_TURNS_PER_WAVE;
+}
+
+/* Return if towers can be built: before a wave, or on the first turn of a survival wave (they start right after the previous one) */
+bool isEnvBuildPhase(Game *game) {
+    return !isEnvGameOver(game) && (game->game_phase == PRE_WAVE_PHASE || game->game_phase == WAITING_FOR_USER_PHASE || (game->game_phase == WAVE_PHASE && !game->turn_nb));
+}
+
+/* Do the action of a request on its environment, then publish the new observation */
+void serveEnvRequest(Server *server, EnvRequest *request) {
+    EnvSharedMemory *memory = server->memory;
+    EnvObservation *observation = &memory->observations[request->env];
+    pthread_mutex_lock(&server->locks[request->env]);
+    Game *game = server->games[request->env];
+    Tower *tower = NULL;
+    bool done = false, building = game && isEnvBuildPhase(game);
+    int score = game ? game->score : 0, wave_nb;
+    switch (request->type) {
+        case ENV_RESET_ACTION:
+            if (game) destroyGame(game);
+            game = server->games[request->env] = createNewGame(strcmp(server->level_name, SURVIVAL_LEVEL_NAME) ? server->level_name : SURVIVAL_MODE, request->seed);
+            destroyEventLog(game->event_log);
+            game->event_log = NULL;
+            score = game->score;
+            done = true;
+            break;
+        case ENV_BUY_ACTION:
+        case ENV_SELL_ACTION:
+            done = building && doesTileExist(request->collumn, request->row) && applyAction(game, (Action) {request->type, request->tower_type, request->collumn, request->row, 0});
+            break;
+        case ENV_UPGRADE_ACTION:
+            /* Only towers with an upgrade are tried, the game complains about the others */
+            if (building && doesTileExist(request->collumn, request->row)) getEnemyAndTowerAt(NULL, game->tower_list, request->collumn, request->row, NULL, &tower);
+            done = tower && (tower->type == WALL_TOWER || tower->type == SORCERER_TOWER || tower->type == CANON_TOWER) && applyAction(game, (Action) {UPGRADE_ACTION, 0, request->collumn, request->row, 0});
+            break;
+        case ENV_START_WAVE_ACTION:
+            /* The whole wave is played, until the next build phase (the first turn of the next survival wave) or the end of the game */
+            if ((done = building && (game->game_phase == WAVE_PHASE || applyAction(game, (Action) {START_WAVE_ACTION, 0, 0, 0, 0})))) {
+                wave_nb = game->current_wave_nb;
+                while (game->game_phase == WAVE_PHASE && game->current_wave_nb == wave_nb && game->turn_nb <= MAX_TURNS_PER_WAVE) updateGame(game, NULL);
+            }
+            break;
+    }
+    observation->action_done = done;
+    observation->reward = game ? game->score - score : 0;
+    writeEnvObservation(observation, game);
+    pthread_mutex_unlock(&server->locks[request->env]);
+    /* Publish the observation, then wake the trainer if it sleeps */
+    atomic_fetch_add_explicit(&observation->sequence, 1, memory_order_release);
+    atomic_fetch_add(&memory->completion_futex, 1);
+    if (atomic_load(&memory->nb_sleeping_trainers)) futexWake(&memory->completion_futex);
+    atomic_fetch_add_explicit(&server->nb_requests, 1, memory_order_relaxed);
+}
+
+/* Thread of the server, serve requests until the server is shut down (spinning a little, then sleeping on the request futex) */
+void *serverWorker(void *arg) {
+    Server *server = arg;
+    EnvSharedMemory *memory = server->memory;
+    EnvRequest request;
+    int nb_empty = 0;
+    while (!atomic_load(&memory->shutdown)) {
+        uint32_t seen = atomic_load(&memory->request_futex);
+        if (popEnvRequest(memory, &request)) {
+            nb_empty = 0;
+            if (request.type == ENV_SHUTDOWN_ACTION) {
+                atomic_store(&memory->shutdown, 1);
+                /* Futex words are changed so that a thread about to sleep (shutdown read just before) returns right away */
+                atomic_fetch_add(&memory->request_futex, 1);
+                atomic_fetch_add(&memory->completion_futex, 1);
+                futexWake(&memory->request_futex);
+                futexWake(&memory->completion_futex);
+            }
+            else if (request.env >= 0 && request.env < (int) memory->nb_envs) serveEnvRequest(server, &request);
+            continue;
+        }
+        if (++nb_empty < WORKER_SPIN) continue;
+        /* A request pushed after seen was read changed the futex word, so the wait returns right away */
+        atomic_fetch_add(&memory->nb_sleeping_workers, 1);
+        if (!atomic_load(&memory->shutdown)) futexWait(&memory->request_futex, seen);
+        atomic_fetch_sub(&memory->nb_sleeping_workers, 1);
+    }
+    return NULL;
+}
+
+/* Create the shared memory of a server and serve its environments until a shutdown request */
+int runServer(const char *name, char *level_name, int nb_envs, int nb_threads) {
+    /* Check that the level exists before starting */
+    Game *game = createNewGame(strcmp(level_name, SURVIVAL_LEVEL_NAME) ? level_name : SURVIVAL_MODE, 0);
+    bool level_found = game->nb_waves;
+    destroyGame(game);
+    if (!level_found) return 1;
+    char *shm_name = concatString(ENV_SHM_PREFIX, name);
+    size_t size = getEnvMemorySize(nb_envs);
+    shm_unlink(shm_name);
+    int fd = shm_open(shm_name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 || ftruncate(fd, size) < 0) {
+        printf("[ERROR]    Could not create shared memory \"%s\"\n", shm_name);
+        if (fd >= 0) close(fd);
+        free(shm_name);
+        return 1;
+    }
+    EnvSharedMemory *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        printf("[ERROR]    Could not map shared memory \"%s\"\n", shm_name);
+        shm_unlink(shm_name);
+        free(shm_name);
+        return 1;
+    }
+
+    /* The segment starts zeroed: every environment is over until reset */
+    memory->abi_version = ENV_ABI_VERSION;
+    memory->nb_envs = nb_envs;
+    memory->ring_capacity = ENV_RING_CAPACITY;
+    for (uint64_t i = 0; i < ENV_RING_CAPACITY; i++) atomic_store(&memory->ring[i].sequence, i);
+    for (int i = 0; i < nb_envs; i++) memory->observations[i].done = 1;
+    Server server;
+    server.memory = memory;
+    server.level_name = level_name;
+    server.games = calloc(nb_envs, sizeof(Game *));
+    server.locks = malloc(nb_envs * sizeof(pthread_mutex_t));
+    for (int i = 0; i < nb_envs; i++) pthread_mutex_init(&server.locks[i], NULL);
+    atomic_init(&server.nb_requests, 0);
+    memory->magic = ENV_MAGIC;
+    atomic_store(&memory->ready, 1);
+    printf("Serving %d environments of %s on %s with %d threads\n", nb_envs, level_name, shm_name, nb_threads);
+    fflush(stdout);
+
+    double start = getTimeMs();
+    pthread_t *threads = malloc(nb_threads * sizeof(pthread_t));
+    for (int i = 0; i < nb_threads; i++) pthread_create(&threads[i], NULL, serverWorker, &server);
+    for (int i = 0; i < nb_threads; i++) pthread_join(threads[i], NULL);
+    double serve_time = getTimeMs() - start;
+    long long nb_requests = atomic_load(&server.nb_requests);
+    printf("Requests:     %lld in %.3f ms\n", nb_requests, serve_time);
+
+    /* Free memory */
+    for (int i = 0; i < nb_envs; i++) {
+        if (server.games[i]) destroyGame(server.games[i]);
+        pthread_mutex_destroy(&server.locks[i]);
+    }
+    free(server.games);
+    free(server.locks);
+    free(threads);
+    munmap(memory, size);
+    shm_unlink(shm_name);
+    free(shm_name);
+    return 0;
+}
+
+/* Map the shared memory of a running server, waiting for it to be ready (NULL if there is none) */
+EnvSharedMemory *connectToServer(const char *name, size_t *size) {
+    char *shm_name = concatString(ENV_SHM_PREFIX, name);
+    int fd = shm_open(shm_name, O_RDWR, 0600);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) < 0 || (size_t) info.st_size < sizeof(EnvSharedMemory)) {
+        printf("[ERROR]    No environment server on \"%s\"\n", shm_name);
+        if (fd >= 0) close(fd);
+        free(shm_name);
+        return NULL;
+    }
+    free(shm_name);
+    *size = info.st_size;
+    EnvSharedMemory *memory = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) return NULL;
+    for (int i = 0; i < 5000 && !atomic_load(&memory->ready); i++) usleep(1000);
+    if (!atomic_load(&memory->ready) || memory->magic != ENV_MAGIC || memory->abi_version != ENV_ABI_VERSION || *size < getEnvMemorySize(memory->nb_envs)) {
+        printf("[ERROR]    Environment server \"%s\" is not ready or has another version\n", name);
+        munmap(memory, *size);
+        return NULL;
+    }
+    return memory;
+}
+
+/* Play random actions on every environment of a server at once, and measure how many steps are served per second */
+int runRandomTrainer(const char *name, long long nb_steps, bool stop) {
+    size_t size;
+    EnvSharedMemory *memory = connectToServer(name, &size);
+    if (!memory) return 1;
+    int nb_envs = memory->nb_envs;
+    uint32_t *expected = malloc(nb_envs * sizeof(uint32_t));  // Sequence of the observation answering the request sent to each environment
+    Rng rng;
+    seedRng(&rng, time(NULL), 0);
+    const char tower_types[] = {ARCHER_TOWER, WALL_TOWER, CANON_TOWER, SORCERER_TOWER};
+    long long nb_done = 0, nb_sent = 0, nb_waves = 0, nb_games = 0, nb_wins = 0, total_reward = 0;
+    uint32_t next_seed = 0;
+    double start = getTimeMs();
+    /* Every environment starts a new game */
+    for (int i = 0; i < nb_envs; i++) {
+        expected[i] = atomic_load_explicit(&memory->observations[i].sequence, memory_order_acquire) + 1;
+        submitEnvRequest(memory, (EnvRequest) {i, ENV_RESET_ACTION, 0, 0, 0, next_seed++});
+        nb_sent++;
+    }
+    while (nb_done < nb_sent) {
+        uint32_t seen = atomic_load(&memory->completion_futex);
+        bool found = false;
+        for (int i = 0; i < nb_envs; i++) {
+            EnvObservation *observation = &memory->observations[i];
+            if (atomic_load_explicit(&observation->sequence, memory_order_acquire) != expected[i]) continue;
+            found = true;
+            nb_done++;
+            expected[i]++;
+            total_reward += observation->reward;
+            /* Environments are left idle once enough steps were sent (their sequence never reaches expected again) */
+            if (nb_sent >= nb_steps) {
+                expected[i] = UINT32_MAX;
+                continue;
+            }
+            /* Next action: new game once over, otherwise mostly building before starting the wave */
+            EnvRequest request = {i, ENV_START_WAVE_ACTION, 0, randrange(&rng, 1, NB_COLLUMNS - 1), randrange(&rng, 1, NB_ROWS), 0};
+            int choice = randrange(&rng, 0, 9);
+            if (observation->done) {
+                nb_games++;
+                nb_wins += (observation->phase == VICTORY_PHASE);
+                request.type = ENV_RESET_ACTION;
+                request.seed = next_seed++;
+            }
+            else if (choice < 6) {
+                request.type = ENV_BUY_ACTION;
+                request.tower_type = tower_types[randrange(&rng, 0, 3)];
+            }
+            else if (choice < 7) request.type = ENV_UPGRADE_ACTION;
+            else nb_waves++;
+            submitEnvRequest(memory, request);
+            nb_sent++;
+        }
+        if (found || nb_done >= nb_sent) continue;
+        /* An observation published after seen was read changed the futex word, so the wait returns right away */
+        atomic_fetch_add(&memory->nb_sleeping_trainers, 1);
+        if (!atomic_load(&memory->shutdown)) futexWait(&memory->completion_futex, seen);
+        atomic_fetch_sub(&memory->nb_sleeping_trainers, 1);
+        if (atomic_load(&memory->shutdown)) break;
+    }
+    double train_time = getTimeMs() - start;
+    if (stop) submitEnvRequest(memory, (EnvRequest) {-1, ENV_SHUTDOWN_ACTION, 0, 0, 0, 0});
+    printf("Environments: %d\n", nb_envs);
+    printf("Steps:        %lld (%lld waves played, %lld games over, %lld won)\n", nb_done, nb_waves, nb_games, nb_wins);
+    printf("Reward:       %lld\n", total_reward);
+    printf("Time:         %.3f ms (%.0f steps/s)\n", train_time, (train_time > 0.0) ? nb_done * 1000.0 / train_time : 0.0);
+    free(expected);
+    munmap(memory, size);
+    return 0;
+}
+
+
+
+
+/* Serve environments to training processes through shared memory, or play random actions against a server */
+/* Usage: td-env serve <name> <level|survival> <nb environments> [nb threads] */
+/*        td-env random <name> <nb steps> [stop] */
+int main(int argc, char *argv[]) {
+    if (argc >= 5 && !strcmp(argv[1], SERVE_MODE)) {
+        int nb_envs = min(max(stringToInt(argv[4]), 1), ENV_MAX_ENVS);
+        int nb_threads = (argc > 5) ? max(stringToInt(argv[5]), 1) : max((int) sysconf(_SC_NPROCESSORS_ONLN), 1);
+        return runServer(argv[2], argv[3], nb_envs, nb_threads);
+    }
+    if (argc >= 4 && !strcmp(argv[1], RANDOM_MODE)) return runRandomTrainer(argv[2], atoll(argv[3]), argc > 4 && !strcmp(argv[4], STOP_ARGUMENT));
+    printf("Usage: %s serve <name> <level|survival> <nb environments> [nb threads]\n", argv[0]);
+    printf("       %s random <name> <nb steps> [stop]\n", argv[0]);
+    return 1;
+}
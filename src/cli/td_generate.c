@@ -0,0 +1,243 @@
+#define _POSIX_C_SOURCE 200809L  // sysconf
+#include "../sim.h"
+#include "bot.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define MAX_GENERATED_WAVES 32     // Maximum number of waves of a generated level
+#define MAX_WAVE_ENEMIES 96        // Maximum number of enemies of a generated wave
+#define MIN_INCOME 100             // Income of a generated wave never goes below this
+#define INITIAL_INCOME 1500        // Income of the first wave of the initial candidate (the next ones get a third of it)
+#define NB_OFFSPRING 32            // Number of candidates mutated from the current one at each generation
+#define MAX_MUTATIONS 3            // Maximum number of mutations giving a candidate
+#define GENERATE_TOLERANCE 0.02    // The search stops once the difficulty is this close to the target
+#define GENERATE_TIME_BUDGET 60    // Time (in s) the search may spend by default
+#define GENERATED_LEVEL_NAME "generated"  // Name of the games played to evaluate candidates
+#define GENERATOR_STREAM 3         // Random stream of the search (apart from the streams of the games)
+
+
+
+
+/* Level being generated: the income and enemies of each wave */
+typedef struct {
+    int nb_waves;                                             // Number of waves
+    int income[MAX_GENERATED_WAVES];                          // Income of each wave
+    SpawnEntry enemies[MAX_GENERATED_WAVES][MAX_WAVE_ENEMIES];  // Enemies of each wave (their turn being their spawn delay)
+    int nb_enemies[MAX_GENERATED_WAVES];                      // Number of enemies of each wave
+    double difficulty;                                        // Share of the enemies the reference strategies fail to kill (0 when they all win)
+} Candidate;
+
+/* Candidates evaluated in parallel by the workers of a generation */
+typedef struct {
+    BuildStep **build_orders;  // Reference strategies
+    int *nb_steps;             // Number of steps of each build order
+    Bot **bots;                // Plugin playing each strategy (NULL for build orders)
+    int nb_strategies;         // Number of strategies
+    Candidate *candidates;     // Candidates to evaluate
+    int nb_candidates;         // Number of candidates
+    atomic_int next_candidate; // Index of the next candidate to evaluate
+} Generation;
+
+
+/* Header */
+Wave **buildCandidateWaves(Candidate *candidate);
+double playCandidate(Generation *generation, Candidate *candidate, int strategy);
+void *generationWorker(void *arg);
+void evaluateGeneration(Generation *generation, int nb_threads);
+bool isSpawnTaken(Candidate *candidate, int wave, int turn, int row);
+void initCandidate(Candidate *candidate, int nb_waves, Rng *rng);
+void mutateCandidate(Candidate *candidate, Rng *rng);
+
+
+
+/* Create the waves of a candidate, as loadLevel would from its level file */
+Wave **buildCandidateWaves(Candidate *candidate) {
+    Wave **waves = malloc(max(candidate->nb_waves, 1) * sizeof(Wave *));
+    for (int i = 0; i < candidate->nb_waves; i++) {
+        waves[i] = newWave(candidate->income[i]);
+        for (int j = 0; j < candidate->nb_enemies[i]; j++) queueEnemy(waves[i]->spawn_queue, candidate->enemies[i][j].type, candidate->enemies[i][j].row, candidate->enemies[i][j].turn);
+    }
+    return waves;
+}
+
+/* Play a reference strategy on a candidate without display, return the share of its enemies killed (1 for a victory) */
+double playCandidate(Generation *generation, Candidate *candidate, int strategy) {
+    Game *game = createGameFromWaves(GENERATED_LEVEL_NAME, buildCandidateWaves(candidate), candidate->nb_waves, NULL, 0);
+    destroyEventLog(game->event_log);
+    game->event_log = NULL;
+    game->combat_stats = calloc(1, sizeof(CombatStats));
+    playStrategy(game, generation->build_orders[strategy], generation->nb_steps[strategy], generation->bots[strategy], -1);
+    /* Enemies summoned during the waves are killed as well, hence the cap */
+    int nb_enemies = 0, nb_killed = 0;
+    for (int i = 0; i < candidate->nb_waves; i++) nb_enemies += candidate->nb_enemies[i];
+    for (int i = 0; i < 128; i++) nb_killed += game->combat_stats->nb_enemies_killed[i];
+    double progress = (game->game_phase == VICTORY_PHASE) ? 1.0 : fmin((double) nb_killed / max(nb_enemies, 1), 1.0);
+    destroyGame(game);
+    return progress;
+}
+
+/* Evaluate candidates of the generation until every one has been taken by a worker */
+void *generationWorker(void *arg) {
+    Generation *generation = arg;
+    int i;
+    double progress;
+    while ((i = atomic_fetch_add(&generation->next_candidate, 1)) < generation->nb_candidates) {
+        progress = 0.0;
+        for (int s = 0; s < generation->nb_strategies; s++) progress += playCandidate(generation, &generation->candidates[i], s) / generation->nb_strategies;
+        generation->candidates[i].difficulty = 1.0 - progress;
+    }
+    return NULL;
+}
+
+/* Evaluate every candidate of a generation on several threads */
+void evaluateGeneration(Generation *generation, int nb_threads) {
+    atomic_init(&generation->next_candidate, 0);
+    nb_threads = min(max(nb_threads, 1), max(generation->nb_candidates, 1));
+    pthread_t *threads = malloc(nb_threads * sizeof(pthread_t));
+    for (int i = 0; i < nb_threads; i++) pthread_create(&threads[i], NULL, generationWorker, generation);
+    for (int i = 0; i < nb_threads; i++) pthread_join(threads[i], NULL);
+    free(threads);
+}
+
+/* Return if an enemy of a wave already enters the map on a row at a turn (the spawn queue keeps one per tile and turn) */
+bool isSpawnTaken(Candidate *candidate, int wave, int turn, int row) {
+    for (int i = 0; i < candidate->nb_enemies[wave]; i++) if (candidate->enemies[wave][i].turn == turn && candidate->enemies[wave][i].row == row) return true;
+    return false;
+}
+
+/* Start from slimes and goblins, a few more on each wave, entering on random rows */
+void initCandidate(Candidate *candidate, int nb_waves, Rng *rng) {
+    candidate->nb_waves = nb_waves;
+    for (int i = 0; i < nb_waves; i++) {
+        candidate->income[i] = i ? INITIAL_INCOME / 3 : INITIAL_INCOME;
+        candidate->nb_enemies[i] = 0;
+        for (int j = 0; j < 4 + 4 * i && candidate->nb_enemies[i] < MAX_WAVE_ENEMIES; j++) {
+            int turn = randrange(rng, 1, 2 + j / 2), row = randrange(rng, 1, NB_ROWS);
+            if (!isSpawnTaken(candidate, i, turn, row)) candidate->enemies[i][candidate->nb_enemies[i]++] = (SpawnEntry) {randrange(rng, 0, 1) ? SLIME_ENEMY : GOBLIN_ENEMY, row, turn};
+        }
+    }
+}
+
+/* Change a candidate a little: add, remove, retype or move an enemy, or change the income of a wave */
+void mutateCandidate(Candidate *candidate, Rng *rng) {
+    const char enemy_types[] = {SLIME_ENEMY, GELLY_ENEMY, GOBLIN_ENEMY, ORC_ENEMY, NECROMANCER_ENEMY, WITCH_ENEMY};
+    int wave = randrange(rng, 0, candidate->nb_waves - 1), nb_enemies = candidate->nb_enemies[wave], i, turn, row, last_turn = 0;
+    for (i = 0; i < nb_enemies; i++) last_turn = max(last_turn, candidate->enemies[wave][i].turn);
+    switch (randrange(rng, 0, 5)) {
+        /* Add an enemy, at most a few turns after the last one */
+        case 0:
+        case 1:
+            turn = randrange(rng, 1, last_turn + 3); row = randrange(rng, 1, NB_ROWS);
+            if (nb_enemies < MAX_WAVE_ENEMIES && !isSpawnTaken(candidate, wave, turn, row))
+                candidate->enemies[wave][candidate->nb_enemies[wave]++] = (SpawnEntry) {enemy_types[randrange(rng, 0, sizeof(enemy_types) - 1)], row, turn};
+            break;
+        /* Remove an enemy (a wave keeps at least one) */
+        case 2:
+            if (nb_enemies > 1) candidate->enemies[wave][randrange(rng, 0, nb_enemies - 1)] = candidate->enemies[wave][--candidate->nb_enemies[wave]];
+            break;
+        /* Change the type of an enemy */
+        case 3:
+            if (nb_enemies) candidate->enemies[wave][randrange(rng, 0, nb_enemies - 1)].type = enemy_types[randrange(rng, 0, sizeof(enemy_types) - 1)];
+            break;
+        /* Move an enemy to another row or turn */
+        case 4:
+            if (!nb_enemies) break;
+            i = randrange(rng, 0, nb_enemies - 1);
+            turn = max(candidate->enemies[wave][i].turn + randrange(rng, -2, 2), 1); row = randrange(rng, 1, NB_ROWS);
+            if (!isSpawnTaken(candidate, wave, turn, row)) candidate->enemies[wave][i].turn = turn, candidate->enemies[wave][i].row = row;
+            break;
+        /* Change the income of the wave by up to 20%, in steps of 10 */
+        case 5:
+            candidate->income[wave] = max(candidate->income[wave] * randrange(rng, 80, 120) / 1000 * 10, MIN_INCOME);
+            break;
+    }
+}
+
+
+
+
+/* Generate a level whose difficulty for reference strategies is close to a target, then write it in assets/lvl */
+/* Difficulty is the share of the enemies of the level the strategies fail to kill on average (0 when they all win it) */
+/* Search: at each generation the current level is mutated into NB_OFFSPRING candidates played on every core, the closest to the target replacing it */
+/* Usage: td-generate <level name> <target difficulty (0 to 1)> <nb waves> <build order file|bot plugin (.so)> [build order file|bot plugin...] */
+/*        The time budget (in s, GENERATE_TIME_BUDGET by default) and the seed of the search can be given with --time=<s> and --seed=<seed> */
+int main(int argc, char *argv[]) {
+    if (argc < 5) {
+        printf("Usage: %s <level name> <target difficulty (0 to 1)> <nb waves> <build order file|bot plugin (.so)> [build order file|bot plugin...] [--time=<s>] [--seed=<seed>]\n", argv[0]);
+        return 1;
+    }
+    double target = atof(argv[2]), time_budget = GENERATE_TIME_BUDGET * 1000.0;
+    int nb_waves = min(max(stringToInt(argv[3]), 1), MAX_GENERATED_WAVES);
+    unsigned long long seed = time(NULL);
+    Generation generation;
+    generation.nb_strategies = 0;
+    generation.build_orders = calloc(argc, sizeof(BuildStep *));
+    generation.nb_steps = calloc(argc, sizeof(int));
+    generation.bots = calloc(argc, sizeof(Bot *));
+    for (int i = 4; i < argc; i++) {
+        if (!strncmp(argv[i], "--time=", 7)) time_budget = atof(argv[i] + 7) * 1000.0;
+        else if (!strncmp(argv[i], "--seed=", 7)) seed = strtoull(argv[i] + 7, NULL, 10);
+        else {
+            int s = generation.nb_strategies++;
+            if (isBotPath(argv[i]) ? !(generation.bots[s] = loadBot(argv[i])) : !(generation.build_orders[s] = loadBuildOrder(argv[i], &generation.nb_steps[s]))) return 1;
+        }
+    }
+    if (!generation.nb_strategies) {
+        printf("[ERROR]    No reference strategy given\n");
+        return 1;
+    }
+    int nb_threads = max((int) sysconf(_SC_NPROCESSORS_ONLN), 1);
+    Rng rng;
+    seedRng(&rng, seed, GENERATOR_STREAM);
+
+    /* Evolve the level until its difficulty is close enough to the target or the time is over */
+    Candidate *current = malloc(sizeof(Candidate));
+    generation.candidates = malloc(NB_OFFSPRING * sizeof(Candidate));
+    initCandidate(current, nb_waves, &rng);
+    generation.candidates[0] = *current;
+    generation.nb_candidates = 1;
+    evaluateGeneration(&generation, nb_threads);
+    *current = generation.candidates[0];
+    long long nb_evaluations = 1;
+    int nb_generations = 0;
+    double start = getTimeMs();
+    while (fabs(current->difficulty - target) > GENERATE_TOLERANCE && getTimeMs() - start < time_budget) {
+        for (int i = 0; i < NB_OFFSPRING; i++) {
+            generation.candidates[i] = *current;
+            for (int j = randrange(&rng, 1, MAX_MUTATIONS); j > 0; j--) mutateCandidate(&generation.candidates[i], &rng);
+        }
+        generation.nb_candidates = NB_OFFSPRING;
+        evaluateGeneration(&generation, nb_threads);
+        nb_evaluations += NB_OFFSPRING;
+        nb_generations++;
+        /* Ties go to the offspring, so that the search keeps moving on flat ground */
+        for (int i = 0; i < NB_OFFSPRING; i++) if (fabs(generation.candidates[i].difficulty - target) <= fabs(current->difficulty - target)) *current = generation.candidates[i];
+    }
+    double search_time = getTimeMs() - start;
+
+    /* Write the level */
+    Wave **waves = buildCandidateWaves(current);
+    bool written = saveLevel(argv[1], waves, current->nb_waves, NULL);
+    destroyWaveList(waves, current->nb_waves);
+    int nb_enemies = 0;
+    for (int i = 0; i < current->nb_waves; i++) nb_enemies += current->nb_enemies[i];
+    printf("Level:        %s (%d waves, %d enemies)\n", argv[1], current->nb_waves, nb_enemies);
+    printf("Seed:         %llu\n", seed);
+    printf("Difficulty:   %.3f (target %.3f, %s)\n", current->difficulty, target, (fabs(current->difficulty - target) <= GENERATE_TOLERANCE) ? "reached" : "closest found");
+    printf("Search:       %lld candidates in %d generations on %d threads\n", nb_evaluations, nb_generations, nb_threads);
+    printf("Search time:  %.3f ms (%.0f candidates/min)\n", search_time, (search_time > 0.0) ? nb_evaluations * 60000.0 / search_time : 0.0);
+
+    /* Free memory */
+    for (int i = 0; i < generation.nb_strategies; i++) {
+        free(generation.build_orders[i]);
+        destroyBot(generation.bots[i]);
+    }
+    free(generation.build_orders);
+    free(generation.nb_steps);
+    free(generation.bots);
+    free(generation.candidates);
+    free(current);
+    return !written;
+}
@@ -0,0 +1,375 @@
+#define _POSIX_C_SOURCE 200809L  // sysconf
+#include "../sim.h"
+#include "bot.h"
+#include <unistd.h>
+
+#define SURVIVAL_LEVEL_NAME "survival"
+#define REPLAY_LEVEL_NAME "replay"
+#define VERIFY_LEVEL_NAME "verify"  // Plays a replay on both turn resolvers (game and board) and checks that they never differ
+#define TRACE_LEVEL_NAME "trace"    // Plays a replay and prints the hash of the game after each turn (to find where two builds diverge)
+#define BATCH_LEVEL_NAME "batch"    // Plays many seeds of a level in lockstep on a board batch, and one at a time to compare
+#define RECORD_LEVEL_NAME "record"  // Plays a level as usual and saves the game as a replay
+#define AUTO_BUILD_NAME "auto"  // Used instead of a build order file, towers are chosen by the auto-build search before each wave
+
+
+
+
+/* Header */
+int verifyReplay(const char *name);
+int traceReplay(const char *name);
+double playGamesOneByOne(Game **games, int nb_games, BuildStep *build_order, int nb_steps, int max_waves, bool *stuck);
+double playGamesInBatch(Game **games, int nb_games, BuildStep *build_order, int nb_steps, int max_waves, int nb_threads, bool *stuck, int *nb_fallbacks);
+int benchmarkBatch(char *level, int nb_games, const char *build_order_file, int max_waves, int nb_threads);
+
+
+
+/* Play a replay while resolving each wave turn on a board as well, return the number of turns that differ (0 or 1 as it stops there) */
+int verifyReplay(const char *name) {
+    Replay *replay = loadReplay(name);
+    if (!replay) return 1;
+    Game *game = createReplayGame(replay);
+    destroyEventLog(game->event_log);
+    game->event_log = NULL;
+    Board *board = newBoard();
+    bool board_loaded = false;
+    int wave_nb = game->current_wave_nb, nb_checked = 0, nb_skipped = 0, nb_mismatches = 0, total_turns;
+    double game_time = 0.0, board_time = 0.0, start;
+    while (game->game_phase != VICTORY_PHASE && game->game_phase != DEFEAT_PHASE && !nb_mismatches) {
+        playReplay(game, replay);
+        /* The replay is over once the player stopped starting waves */
+        if (game->game_phase == PRE_WAVE_PHASE || game->game_phase == WAITING_FOR_USER_PHASE) break;
+        /* Each wave is loaded on the board once, then both resolvers go on their own */
+        if (wave_nb != game->current_wave_nb) board_loaded = false;
+        wave_nb = game->current_wave_nb;
+        if (!board_loaded && game->game_phase == WAVE_PHASE) board_loaded = loadBoard(board, game);
+        total_turns = game->total_turns;
+        start = getTimeMs();
+        updateGame(game, NULL);
+        game_time += getTimeMs() - start;
+        if (game->total_turns == total_turns) continue;
+        if (!board_loaded) {
+            nb_skipped++;
+            continue;
+        }
+        start = getTimeMs();
+        resolveBoardTurn(board);
+        board_time += getTimeMs() - start;
+        nb_checked++;
+        if (!compareBoardToGame(board, game, true)) nb_mismatches++;
+        if (game->game_phase != WAVE_PHASE) board_loaded = false;
+    }
+    printf("Replay:       %s\n", name);
+    printf("Outcome:      %s\n", nb_mismatches ? "MISMATCH" : "IDENTICAL");
+    printf("Turns:        %d checked, %d skipped (wave too large for a board)\n", nb_checked, nb_skipped);
+    printf("Game time:    %.3f ms (%.0f turns/s)\n", game_time, (game_time > 0.0) ? (nb_checked + nb_skipped) * 1000.0 / game_time : 0.0);
+    printf("Board time:   %.3f ms (%.0f turns/s)\n", board_time, (board_time > 0.0) ? nb_checked * 1000.0 / board_time : 0.0);
+    destroyBoard(board);
+    destroyGame(game);
+    destroyReplay(replay);
+    return nb_mismatches;
+}
+
+/* Play a replay and print the hash of the whole game after each turn, one "<turn> <hash>" line per turn */
+int traceReplay(const char *name) {
+    Replay *replay = loadReplay(name);
+    if (!replay) return 1;
+    Game *game = createReplayGame(replay);
+    destroyEventLog(game->event_log);
+    game->event_log = NULL;
+    int total_turns;
+    printf("%d %016llx\n", game->total_turns, (unsigned long long) hashGame(game));
+    while (game->game_phase != VICTORY_PHASE && game->game_phase != DEFEAT_PHASE) {
+        playReplay(game, replay);
+        /* The replay is over once the player stopped starting waves */
+        if (game->game_phase == PRE_WAVE_PHASE || game->game_phase == WAITING_FOR_USER_PHASE) break;
+        total_turns = game->total_turns;
+        updateGame(game, NULL);
+        if (game->total_turns != total_turns) printf("%d %016llx\n", game->total_turns, (unsigned long long) hashGame(game));
+    }
+    destroyGame(game);
+    destroyReplay(replay);
+    return 0;
+}
+
+/* Play games to the end one after the other on the game resolver, return the time spent in ms */
+double playGamesOneByOne(Game **games, int nb_games, BuildStep *build_order, int nb_steps, int max_waves, bool *stuck) {
+    double start = getTimeMs();
+    for (int i = 0; i < nb_games; i++) {
+        Game *game = games[i];
+        stuck[i] = false;
+        while (game->game_phase != VICTORY_PHASE && game->game_phase != DEFEAT_PHASE) {
+            /* Survival waves follow each other without a pre-wave phase, so the wave limit is checked on every turn */
+            if (max_waves >= 0 && game->current_wave_nb > max_waves) break;
+            if (game->game_phase == PRE_WAVE_PHASE || game->game_phase == WAITING_FOR_USER_PHASE) {
+                applyBuildOrder(game, build_order, nb_steps, false);
+                applyAction(game, (Action) {START_WAVE_ACTION, 0, 0, 0, 0});
+            }
+            updateGame(game, NULL);
+            /* Same limit as the board batch, so that both stop stuck waves on the same turn */
+            if (game->game_phase == WAVE_PHASE && game->turn_nb >= MAX_PREDICTED_TURNS) {
+                stuck[i] = true;
+                break;
+            }
+        }
+    }
+    return getTimeMs() - start;
+}
+
+/* Play games to the end with every wave resolved on a board batch, all the games advancing by one turn per step, return the time spent in ms */
+/* Build phases stay on the games, and a wave too large for a board is played on its game right away (counted in nb_fallbacks) */
+double playGamesInBatch(Game **games, int nb_games, BuildStep *build_order, int nb_steps, int max_waves, int nb_threads, bool *stuck, int *nb_fallbacks) {
+    double start = getTimeMs();
+    BoardBatch *batch = newBoardBatch(nb_games, nb_threads);
+    bool *playing = malloc(max(nb_games, 1) * sizeof(bool)), *loaded = malloc(max(nb_games, 1) * sizeof(bool));
+    int nb_playing = nb_games;
+    *nb_fallbacks = 0;
+    for (int i = 0; i < nb_games; i++) playing[i] = true, stuck[i] = false;
+    while (nb_playing) {
+        /* Build phase and start of the next wave of every game still playing */
+        for (int i = 0; i < nb_games; i++) {
+            loaded[i] = false;
+            if (!playing[i]) continue;
+            Game *game = games[i];
+            if (max_waves >= 0 && game->current_wave_nb > max_waves) {
+                playing[i] = false;
+                nb_playing--;
+                continue;
+            }
+            /* Same phase guard as one game at a time (survival waves start right after the previous one) */
+            if (game->game_phase == PRE_WAVE_PHASE || game->game_phase == WAITING_FOR_USER_PHASE) {
+                applyBuildOrder(game, build_order, nb_steps, false);
+                applyAction(game, (Action) {START_WAVE_ACTION, 0, 0, 0, 0});
+            }
+            if ((loaded[i] = loadBoardBatch(batch, i, game))) continue;
+            (*nb_fallbacks)++;
+            while (game->game_phase == WAVE_PHASE && (game->enemy_list || !isSpawnQueueEmpty(game->spawn_queue)) && game->turn_nb < MAX_PREDICTED_TURNS) updateGame(game, NULL);
+        }
+        /* The waves, in lockstep */
+        while (stepBoardBatch(batch));
+        /* End of the waves */
+        for (int i = 0; i < nb_games; i++) if (playing[i]) {
+            Game *game = games[i];
+            if (loaded[i]) storeBoard(&batch->boards[i], game);
+            if (game->game_phase == WAVE_PHASE && game->turn_nb >= MAX_PREDICTED_TURNS && (game->enemy_list || !isSpawnQueueEmpty(game->spawn_queue))) stuck[i] = true;
+            else updateGame(game, NULL);
+            if (stuck[i] || game->game_phase == VICTORY_PHASE || game->game_phase == DEFEAT_PHASE) {
+                playing[i] = false;
+                nb_playing--;
+            }
+        }
+    }
+    free(playing);
+    free(loaded);
+    destroyBoardBatch(batch);
+    return getTimeMs() - start;
+}
+
+/* Play the same seeds of a level one game at a time, then on a board batch with one and several threads, return the number of games whose outcome differs */
+int benchmarkBatch(char *level, int nb_games, const char *build_order_file, int max_waves, int nb_threads) {
+    int nb_steps = 0;
+    BuildStep *build_order = NULL;
+    if (build_order_file && !(build_order = loadBuildOrder(build_order_file, &nb_steps))) return 1;
+    nb_games = max(nb_games, 1);
+    /* One set of games per run, seeded 1 to nb_games */
+    Game **games[3];
+    bool *stuck[3];
+    for (int run = 0; run < 3; run++) {
+        games[run] = malloc(nb_games * sizeof(Game *));
+        stuck[run] = malloc(nb_games * sizeof(bool));
+        for (int i = 0; i < nb_games; i++) {
+            games[run][i] = createNewGame(level, i + 1);
+            destroyEventLog(games[run][i]->event_log);
+            games[run][i]->event_log = NULL;
+        }
+    }
+    int nb_mismatches = 0, nb_fallbacks;
+    if (!games[0][0]->nb_waves) nb_mismatches = nb_games;
+    else {
+        double game_time = playGamesOneByOne(games[0], nb_games, build_order, nb_steps, max_waves, stuck[0]);
+        double batch_time = playGamesInBatch(games[1], nb_games, build_order, nb_steps, max_waves, 1, stuck[1], &nb_fallbacks);
+        double threads_time = playGamesInBatch(games[2], nb_games, build_order, nb_steps, max_waves, nb_threads, stuck[2], &nb_fallbacks);
+        long long nb_turns = 0;
+        int nb_victories = 0, nb_stuck = 0;
+        for (int i = 0; i < nb_games; i++) {
+            nb_turns += games[0][i]->total_turns;
+            nb_victories += (games[0][i]->game_phase == VICTORY_PHASE);
+            nb_stuck += stuck[0][i];
+            for (int run = 1; run < 3; run++) if (games[run][i]->score != games[0][i]->score || games[run][i]->total_turns != games[0][i]->total_turns
+                || games[run][i]->game_phase != games[0][i]->game_phase || games[run][i]->current_wave_nb != games[0][i]->current_wave_nb || stuck[run][i] != stuck[0][i]) {
+                if (!nb_mismatches) printf("[ERROR]    Seed %d: the batch run ends with score %d on turn %d instead of score %d on turn %d\n", i + 1,
+                    games[run][i]->score, games[run][i]->total_turns, games[0][i]->score, games[0][i]->total_turns);
+                nb_mismatches++;
+                break;
+            }
+        }
+        printf("Level:        %s\n", strcmp(level, SURVIVAL_MODE) ? level : SURVIVAL_LEVEL_NAME);
+        printf("Games:        %d (seeds 1 to %d, %d won, %d stuck)\n", nb_games, nb_games, nb_victories, nb_stuck);
+        printf("Outcome:      %s\n", nb_mismatches ? "MISMATCH" : "IDENTICAL");
+        printf("Turns:        %lld (%d waves too large for a board)\n", nb_turns, nb_fallbacks);
+        printf("Game time:    %.3f ms (%.0f turns/s, one game at a time)\n", game_time, (game_time > 0.0) ? nb_turns * 1000.0 / game_time : 0.0);
+        printf("Batch time:   %.3f ms (%.0f turns/s, 1 thread)\n", batch_time, (batch_time > 0.0) ? nb_turns * 1000.0 / batch_time : 0.0);
+        printf("              %.3f ms (%.0f turns/s, %d threads)\n", threads_time, (threads_time > 0.0) ? nb_turns * 1000.0 / threads_time : 0.0, nb_threads);
+    }
+    for (int run = 0; run < 3; run++) {
+        for (int i = 0; i < nb_games; i++) destroyGame(games[run][i]);
+        free(games[run]);
+        free(stuck[run]);
+    }
+    free(build_order);
+    return nb_mismatches;
+}
+
+
+
+
+/* Play a level without display, following a scripted build order or the actions of a replay */
+/* Usage: td-sim <level|survival> [build order file|auto|bot plugin (.so)] [max waves] [seed] [auto-build time budget in ms] */
+/*        td-sim replay <replay name> [start turn] */
+/*        td-sim verify <replay name> */
+/*        td-sim trace <replay name> */
+/*        td-sim batch <level|survival> <nb games> [build order file] [max waves] [threads] */
+/*        td-sim record <replay name> <level|survival> [build order file|auto|bot plugin (.so)] [max waves] [seed] [auto-build time budget in ms] */
+int main(int argc, char *argv[]) {
+    if (argc < 2 || ((!strcmp(argv[1], REPLAY_LEVEL_NAME) || !strcmp(argv[1], VERIFY_LEVEL_NAME) || !strcmp(argv[1], TRACE_LEVEL_NAME)) && argc < 3)
+        || ((!strcmp(argv[1], BATCH_LEVEL_NAME) || !strcmp(argv[1], RECORD_LEVEL_NAME)) && argc < 4)) {
+        printf("Usage: %s <level|survival> [build order file|auto|bot plugin (.so)] [max waves] [seed] [auto-build time budget in ms]\n", argv[0]);
+        printf("       %s replay <replay name> [start turn]\n", argv[0]);
+        printf("       %s verify <replay name>\n", argv[0]);
+        printf("       %s trace <replay name>\n", argv[0]);
+        printf("       %s batch <level|survival> <nb games> [build order file] [max waves] [threads]\n", argv[0]);
+        printf("       %s record <replay name> <level|survival> [build order file|auto|bot plugin (.so)] [max waves] [seed] [auto-build time budget in ms]\n", argv[0]);
+        return 1;
+    }
+    if (!strcmp(argv[1], VERIFY_LEVEL_NAME)) return verifyReplay(argv[2]);
+    if (!strcmp(argv[1], TRACE_LEVEL_NAME)) return traceReplay(argv[2]);
+    if (!strcmp(argv[1], BATCH_LEVEL_NAME)) return benchmarkBatch(strcmp(argv[2], SURVIVAL_LEVEL_NAME) ? argv[2] : SURVIVAL_MODE, stringToInt(argv[3]), (argc > 4) ? argv[4] : NULL,
+        (argc > 5) ? stringToInt(argv[5]) : -1, (argc > 6) ? stringToInt(argv[6]) : max((int) sysconf(_SC_NPROCESSORS_ONLN), 1));
+    /* The arguments after the replay name are the ones of a normal game */
+    const char *record_name = NULL;
+    if (!strcmp(argv[1], RECORD_LEVEL_NAME)) {
+        record_name = argv[2];
+        argv += 2;
+        argc -= 2;
+    }
+    bool survival = !strcmp(argv[1], SURVIVAL_LEVEL_NAME);
+    int max_waves = -1, nb_steps = 0, start_turn = 0;
+    unsigned long long seed = time(NULL);
+    BuildStep *build_order = NULL;
+    bool auto_build = false;
+    double time_budget = AUTO_BUILD_TIME_BUDGET;
+    Replay *replay = NULL;
+    Bot *bot = NULL;
+    if (!strcmp(argv[1], REPLAY_LEVEL_NAME)) {
+        if (!(replay = loadReplay(argv[2]))) return 1;
+        seed = replay->seed;
+        if (argc > 3) start_turn = stringToInt(argv[3]);
+    }
+    else {
+        if (argc > 3) max_waves = stringToInt(argv[3]);
+        if (argc > 4) seed = strtoull(argv[4], NULL, 10);
+        if (argc > 5) time_budget = stringToInt(argv[5]);
+        if (argc > 2 && !strcmp(argv[2], AUTO_BUILD_NAME)) auto_build = true;
+        else if (argc > 2 && isBotPath(argv[2])) {
+            if (!(bot = loadBot(argv[2]))) return 1;
+        }
+        else if (argc > 2 && !(build_order = loadBuildOrder(argv[2], &nb_steps))) return 1;
+    }
+
+    /* Load the level, nothing is logged as nothing is animated */
+    double start = getTimeMs();
+    Game *game = (replay ? createReplayGame(replay) : createNewGame(survival ? SURVIVAL_MODE : argv[1], seed));
+    destroyEventLog(game->event_log);
+    game->event_log = NULL;
+    double load_time = getTimeMs() - start;
+    if (record_name) game->replay = newReplay(game->level_name, seed);
+    /* Jump to the start turn of the replay */
+    double seek_time = 0.0;
+    if (replay && start_turn > 0) {
+        destroyGame(game);
+        start = getTimeMs();
+        game = seekReplay(replay, start_turn);
+        destroyEventLog(game->event_log);
+        game->event_log = NULL;
+        seek_time = getTimeMs() - start;
+    }
+    if (!game->nb_waves) {
+        destroyGame(game);
+        destroyReplay(replay);
+        destroyBot(bot);
+        free(build_order);
+        return 1;
+    }
+    BotPlayer *bot_player = bot ? newBotPlayer(bot, game) : NULL;
+
+    /* Play every wave, building towers before each of them */
+    int first_turn = game->total_turns, nb_built = 0;
+    int nb_threads = max((int) sysconf(_SC_NPROCESSORS_ONLN), 1);
+    TranspositionTable *table = auto_build ? newTranspositionTable(TRANSPOSITION_TABLE_BITS) : NULL;
+    long long nb_rollouts = 0, plan_rollouts; double search_time = 0.0, search_start; BuildPlan plan;
+    bool stuck = false;
+    start = getTimeMs();
+    int built_wave = game->current_wave_nb - 1; bool pre_wave;
+    while (game->game_phase != VICTORY_PHASE && game->game_phase != DEFEAT_PHASE) {
+        if (replay) {
+            playReplay(game, replay);
+            /* The replay is over once the player stopped starting waves */
+            if (game->game_phase == PRE_WAVE_PHASE || game->game_phase == WAITING_FOR_USER_PHASE) break;
+        }
+        else {
+            /* Survival waves start right after the previous one without a pre-wave phase (see playStrategy) */
+            if (max_waves >= 0 && game->current_wave_nb > max_waves) break;
+            pre_wave = (game->game_phase == PRE_WAVE_PHASE || game->game_phase == WAITING_FOR_USER_PHASE);
+            if (pre_wave || (game->game_phase == WAVE_PHASE && game->turn_nb == 0 && game->current_wave_nb != built_wave)) {
+                built_wave = game->current_wave_nb;
+                nb_built += applyBuildOrder(game, build_order, nb_steps, true);
+                if (bot_player) nb_built += playBotBuildPhase(bot_player, game);
+                if (auto_build) {
+                    search_start = getTimeMs();
+                    plan = autoBuild(game, table, AUTO_BUILD_WAVES, time_budget, nb_threads, &plan_rollouts);
+                    search_time += getTimeMs() - search_start;
+                    nb_rollouts += plan_rollouts;
+                    for (int i = 0; i < plan.nb_actions; i++) nb_built += applyAction(game, plan.actions[i]);
+                }
+                if (pre_wave) applyAction(game, (Action) {START_WAVE_ACTION, 0, 0, 0, 0});
+            }
+        }
+        updateGame(game, NULL);
+        if (game->turn_nb > MAX_TURNS_PER_WAVE) {
+            stuck = true;
+            break;
+        }
+    }
+    /* Searches of the auto-build are timed apart */
+    double sim_time = getTimeMs() - start - search_time;
+    int nb_turns = game->total_turns - first_turn;
+
+    /* Outcome and timings */
+    const char *outcome = (game->game_phase == VICTORY_PHASE) ? "VICTORY" : ((game->game_phase == DEFEAT_PHASE) ? "DEFEAT" : (stuck ? "STUCK" : (replay ? "REPLAY OVER" : "SURVIVED")));
+    printf("Level:        %s\n", argv[1]);
+    printf("Seed:         %llu\n", seed);
+    printf("Outcome:      %s\n", outcome);
+    if (game->nb_waves >= 0) printf("Wave:         %d/%d\n", game->current_wave_nb, game->nb_waves);
+    else printf("Wave:         %d\n", game->current_wave_nb);
+    printf("Turns:        %d\n", game->total_turns);
+    if (replay) printf("Actions:      %d/%d\n", replay->head, replay->nb_actions);
+    else printf("Towers built: %d\n", nb_built);
+    printf("Score:        %d\n", game->score);
+    printf("Funds:        %d\n", game->funds);
+    printf("Load time:    %.3f ms\n", load_time);
+    if (replay && start_turn > 0) printf("Seek time:    %.3f ms (to turn %d)\n", seek_time, first_turn);
+    printf("Sim time:     %.3f ms (%.0f turns/s)\n", sim_time, (sim_time > 0.0) ? nb_turns * 1000.0 / sim_time : 0.0);
+    if (bot) printf("Bot:          %s (%d commands rejected before the last wave)\n", bot->interface->name ? bot->interface->name : argv[2], bot_player->nb_rejected_commands);
+    if (auto_build) printf("Auto-build:   %lld rollouts in %.3f ms on %d threads (%.0f rollouts/s, %lld positions reused)\n", nb_rollouts, search_time, nb_threads,
+        (search_time > 0.0) ? nb_rollouts * 1000.0 / search_time : 0.0, atomic_load(&table->nb_hits));
+
+    /* Free memory */
+    bool defeated = (game->game_phase == DEFEAT_PHASE);
+    bool saved = !record_name || saveReplay(game->replay, record_name);
+    destroyGame(game);
+    destroyReplay(replay);
+    destroyTranspositionTable(table);
+    destroyBotPlayer(bot_player);
+    destroyBot(bot);
+    free(build_order);
+    return defeated || !saved;
+}
@@ -0,0 +1,420 @@
+#define _POSIX_C_SOURCE 200809L  // sysconf
+#include "../sim.h"
+#include "bot.h"
+#include <dirent.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define MAX_SURVIVAL_WAVES 50    // Survival matches still alive after this many waves are stopped (and counted as wins)
+#define MAX_LEVELS 64            // Level files beyond this are left out of the tournament
+#define LEVEL_DIRECTORY "../assets/lvl/"
+#define LEVEL_SEED 1             // Seed every level file is played on (their waves are scripted)
+#define SURVIVAL_LEVEL_NAME "survival"
+#define RATING_ITERATIONS 1000   // Maximum number of iterations of the rating fit
+#define BASE_RATING 1500.0       // Rating of a strategy as strong as the average of the tournament
+
+
+
+
+/* Strategy played on a level (or a survival seed) */
+typedef struct {
+    int strategy;             // Index of the strategy
+    int level;                // Index of the level (nb_levels for the survival mode)
+    unsigned long long seed;  // Seed of the game
+    bool done;                // Has the match been played (or found in the cache)
+    char outcome;             // Match outcome (VICTORY_OUTCOME...)
+    int wave_nb;              // Wave reached
+    int total_turns;          // Number of turns survived
+    int score;                // Final score
+} Match;
+
+/* Matches given to a worker, the worker takes them from the tail and idle workers steal them from the head */
+typedef struct {
+    int *matches;          // Indices of the matches
+    int head;              // Index of the oldest match left
+    int tail;              // Index after the newest match left
+    pthread_mutex_t lock;  // Taken by the owner and the thieves alike (a match lasts far longer than the lock)
+} MatchDeque;
+
+/* Every match of the tournament, shared by all workers */
+typedef struct {
+    char **level_names;        // Name of each level file, then SURVIVAL_LEVEL_NAME
+    uint64_t *level_hashes;    // Hash of each level file (the survival curve file for the survival mode)
+    int nb_levels;             // Number of level files
+    int nb_seeds;              // Number of survival seeds (seeds 1 to nb_seeds)
+    char **strategy_paths;     // Path of each strategy
+    uint64_t *strategy_hashes; // Hash of each strategy file
+    BuildStep **build_orders;  // Build order of each strategy (NULL for plugins)
+    int *nb_steps;             // Number of steps of each build order
+    Bot **bots;                // Plugin playing each strategy (NULL for build orders)
+    int nb_strategies;         // Number of strategies
+    Match *matches;            // Every match (see matchIndex)
+    int nb_matches;            // Number of matches
+    MatchDeque *deques;        // Matches left to each worker
+    int nb_workers;            // Number of workers
+    atomic_int nb_stolen;      // Number of matches stolen from another worker
+    FILE *cache;               // Cache file, a line is appended for each match played
+    pthread_mutex_t cache_lock;
+} Tournament;
+
+/* Thread playing matches until none is left to any worker */
+typedef struct {
+    pthread_t thread;        // Thread of the worker
+    Tournament *tournament;  // Matches to play
+    int index;               // Index of the deque of the worker
+} Worker;
+
+/* Place of a strategy in the ranking */
+typedef struct {
+    int strategy;            // Index of the strategy
+    double rating;           // Rating (Elo scale)
+    int nb_wins;             // Number of matches won
+    double mean_wave;        // Mean wave reached
+    double mean_score;       // Mean final score
+    int nb_pairwise_wins;    // Number of matches done better than another strategy on the same level and seed
+    int nb_pairwise_draws;   // Same for matches done as well
+    int nb_pairwise_losses;  // Same for matches done worse
+} Rank;
+
+
+/* Header */
+uint64_t hashFile(const char *path, bool *found);
+int compareStrings(const void *a, const void *b);
+int listLevels(char **level_names, int max_levels);
+int matchIndex(Tournament *tournament, int strategy, int level, unsigned long long seed);
+int loadCache(Tournament *tournament, const char *path);
+void appendToCache(Tournament *tournament, Match *match);
+void playMatch(Tournament *tournament, Match *match);
+bool takeMatch(Tournament *tournament, int index, int *match);
+void *workerMain(void *arg);
+int compareMatches(Match *a, Match *b);
+int compareRanks(const void *a, const void *b);
+void rankStrategies(Tournament *tournament, Rank *ranks);
+bool writeRanking(const char *path, Tournament *tournament, Rank *ranks);
+
+
+
+/* Return the FNV-1a hash of the content of a file (0 and found set to false if it cannot be read) */
+uint64_t hashFile(const char *path, bool *found) {
+    FILE *file = fopen(path, "rb");
+    *found = file;
+    if (!file) return 0;
+    uint64_t hash = 0xcbf29ce484222325ull;
+    int c;
+    while ((c = fgetc(file)) != EOF) hash = (hash ^ (unsigned char) c) * 0x100000001b3ull;
+    fclose(file);
+    return hash;
+}
+
+/* Compare two strings (for qsort) */
+int compareStrings(const void *a, const void *b) {
+    return strcmp(*(char **) a, *(char **) b);
+}
+
+/* Fill the names of the level files (without extension) in alphabetical order, return their number */
+int listLevels(char **level_names, int max_levels) {
+    DIR *d = opendir(LEVEL_DIRECTORY);
+    if (!d) {
+        printf("[ERROR]    Unable to get availible levels name\n");
+        return 0;
+    }
+    int nb_levels = 0; struct dirent *dir; char *c;
+    while ((dir = readdir(d)) != NULL && nb_levels < max_levels) {
+        if (dir->d_name[0] == '.') continue;
+        level_names[nb_levels] = duplicateString(dir->d_name);
+        if ((c = strchr(level_names[nb_levels], '.'))) *c = '\0';
+        nb_levels++;
+    }
+    closedir(d);
+    qsort(level_names, nb_levels, sizeof(char *), compareStrings);
+    return nb_levels;
+}
+
+/* Index of a match, the matches of a strategy being its level files then its survival seeds (-1 if there is no such match) */
+int matchIndex(Tournament *tournament, int strategy, int level, unsigned long long seed) {
+    if (level < tournament->nb_levels) return (seed == LEVEL_SEED) ? strategy * (tournament->nb_levels + tournament->nb_seeds) + level : -1;
+    if (seed < 1 || seed > (unsigned long long) tournament->nb_seeds) return -1;
+    return strategy * (tournament->nb_levels + tournament->nb_seeds) + tournament->nb_levels + (int) seed - 1;
+}
+
+/* Mark the matches found in the cache file as done, then open it to append the next ones, return the number of matches found */
+/* Each line is "<strategy hash> <level hash> <level> <seed> <outcome> <wave> <turns> <score>", a match is only reused if neither file changed */
+int loadCache(Tournament *tournament, const char *path) {
+    int nb_found = 0;
+    bool ends_with_newline = true;
+    FILE *file = fopen(path, "r");
+    if (file) {
+        char line[256], level_name[128], outcome; unsigned long long strategy_hash, level_hash, seed; int wave_nb, total_turns, score, strategy, level, index;
+        while (fgets(line, sizeof(line), file)) {
+            ends_with_newline = strchr(line, '\n');
+            /* A line cut short by an interrupted run is ignored */
+            if (!ends_with_newline || sscanf(line, "%llx %llx %127s %llu %c %d %d %d", &strategy_hash, &level_hash, level_name, &seed, &outcome, &wave_nb, &total_turns, &score) != 8) continue;
+            for (level = 0; level <= tournament->nb_levels && (strcmp(tournament->level_names[level], level_name) || tournament->level_hashes[level] != level_hash); level++);
+            if (level > tournament->nb_levels) continue;
+            for (strategy = 0; strategy < tournament->nb_strategies; strategy++) {
+                if (tournament->strategy_hashes[strategy] != strategy_hash || (index = matchIndex(tournament, strategy, level, seed)) < 0) continue;
+                Match *match = &tournament->matches[index];
+                nb_found += !match->done;
+                match->done = true;
+                match->outcome = outcome;
+                match->wave_nb = wave_nb;
+                match->total_turns = total_turns;
+                match->score = score;
+            }
+        }
+        fclose(file);
+    }
+    if (!(tournament->cache = fopen(path, "a"))) {
+        printf("[ERROR]    Unable to write file at \"%s\"\n", path);
+        return -1;
+    }
+    if (!ends_with_newline) fputc('\n', tournament->cache);
+    return nb_found;
+}
+
+/* Append the result of a match to the cache file, flushed right away so that an interrupted run loses nothing done */
+void appendToCache(Tournament *tournament, Match *match) {
+    pthread_mutex_lock(&tournament->cache_lock);
+    fprintf(tournament->cache, "%016llx %016llx %s %llu %c %d %d %d\n", (unsigned long long) tournament->strategy_hashes[match->strategy], (unsigned long long) tournament->level_hashes[match->level],
+        tournament->level_names[match->level], match->seed, match->outcome, match->wave_nb, match->total_turns, match->score);
+    fflush(tournament->cache);
+    pthread_mutex_unlock(&tournament->cache_lock);
+}
+
+/* Play a match without display */
+void playMatch(Tournament *tournament, Match *match) {
+    bool survival = (match->level == tournament->nb_levels);
+    Game *game = createNewGame(survival ? SURVIVAL_MODE : tournament->level_names[match->level], match->seed);
+    destroyEventLog(game->event_log);
+    game->event_log = NULL;
+    match->outcome = playStrategy(game, tournament->build_orders[match->strategy], tournament->nb_steps[match->strategy], tournament->bots[match->strategy], survival ? MAX_SURVIVAL_WAVES : -1);
+    match->wave_nb = game->current_wave_nb;
+    match->total_turns = game->total_turns;
+    match->score = game->score;
+    match->done = true;
+    destroyGame(game);
+}
+
+/* Take the newest match left to a worker, or steal the oldest match left to another one, return false once no match is left */
+bool takeMatch(Tournament *tournament, int index, int *match) {
+    MatchDeque *deque = &tournament->deques[index];
+    pthread_mutex_lock(&deque->lock);
+    bool found = (deque->head < deque->tail);
+    if (found) *match = deque->matches[--deque->tail];
+    pthread_mutex_unlock(&deque->lock);
+    /* Victims are tried from the next worker on, so that thieves spread over them */
+    for (int i = 1; i < tournament->nb_workers && !found; i++) {
+        deque = &tournament->deques[(index + i) % tournament->nb_workers];
+        pthread_mutex_lock(&deque->lock);
+        if ((found = (deque->head < deque->tail))) *match = deque->matches[deque->head++];
+        pthread_mutex_unlock(&deque->lock);
+        if (found) atomic_fetch_add(&tournament->nb_stolen, 1);
+    }
+    return found;
+}
+
+/* Play matches until none is left to any worker */
+void *workerMain(void *arg) {
+    Worker *worker = arg;
+    Tournament *tournament = worker->tournament;
+    int match;
+    while (takeMatch(tournament, worker->index, &match)) {
+        playMatch(tournament, &tournament->matches[match]);
+        appendToCache(tournament, &tournament->matches[match]);
+    }
+    return NULL;
+}
+
+/* Compare how well two strategies did on the same level and seed: winning first, then the wave reached, then the score */
+int compareMatches(Match *a, Match *b) {
+    bool a_won = (a->outcome == VICTORY_OUTCOME || a->outcome == SURVIVED_OUTCOME), b_won = (b->outcome == VICTORY_OUTCOME || b->outcome == SURVIVED_OUTCOME);
+    if (a_won != b_won) return a_won - b_won;
+    if (a->wave_nb != b->wave_nb) return (a->wave_nb > b->wave_nb) - (a->wave_nb < b->wave_nb);
+    return (a->score > b->score) - (a->score < b->score);
+}
+
+/* Compare two ranks by decreasing rating (for qsort) */
+int compareRanks(const void *a, const void *b) {
+    double rating_a = ((Rank *) a)->rating, rating_b = ((Rank *) b)->rating;
+    return (rating_a < rating_b) - (rating_a > rating_b);
+}
+
+/* Rate the strategies from every pair of matches played on the same level and seed, then sort them from best to worst */
+/* Ratings are the Bradley-Terry strengths fitted on these pairs (a draw counting half a win), on the Elo scale */
+void rankStrategies(Tournament *tournament, Rank *ranks) {
+    int nb_strategies = tournament->nb_strategies, nb_games = tournament->nb_levels + tournament->nb_seeds, comparison;
+    /* Pairwise wins, with one virtual draw between every pair so that a strategy that never won keeps a finite rating */
+    double *wins = malloc(nb_strategies * nb_strategies * sizeof(double)), *strengths = malloc(nb_strategies * sizeof(double)), *new_strengths = malloc(nb_strategies * sizeof(double));
+    for (int i = 0; i < nb_strategies * nb_strategies; i++) wins[i] = 0.5;
+    for (int s = 0; s < nb_strategies; s++) {
+        Match *matches = &tournament->matches[s * nb_games];
+        ranks[s] = (Rank) {s, 0.0, 0, 0.0, 0.0, 0, 0, 0};
+        for (int g = 0; g < nb_games; g++) {
+            ranks[s].nb_wins += (matches[g].outcome == VICTORY_OUTCOME || matches[g].outcome == SURVIVED_OUTCOME);
+            ranks[s].mean_wave += matches[g].wave_nb / (double) nb_games;
+            ranks[s].mean_score += matches[g].score / (double) nb_games;
+            for (int o = 0; o < nb_strategies; o++) if (o != s) {
+                comparison = compareMatches(&matches[g], &tournament->matches[o * nb_games + g]);
+                wins[s * nb_strategies + o] += (comparison > 0) ? 1.0 : ((comparison == 0) ? 0.5 : 0.0);
+                ranks[s].nb_pairwise_wins += (comparison > 0);
+                ranks[s].nb_pairwise_draws += (comparison == 0);
+                ranks[s].nb_pairwise_losses += (comparison < 0);
+            }
+        }
+        strengths[s] = 1.0;
+    }
+    /* Minorization-maximization updates of the strengths, kept at a geometric mean of 1 */
+    double total_wins, denominator, log_mean, change = 1.0;
+    for (int iteration = 0; iteration < RATING_ITERATIONS && change > 1e-9; iteration++) {
+        log_mean = 0.0;
+        for (int s = 0; s < nb_strategies; s++) {
+            total_wins = denominator = 0.0;
+            for (int o = 0; o < nb_strategies; o++) if (o != s) {
+                total_wins += wins[s * nb_strategies + o];
+                denominator += (wins[s * nb_strategies + o] + wins[o * nb_strategies + s]) / (strengths[s] + strengths[o]);
+            }
+            new_strengths[s] = (denominator > 0.0) ? total_wins / denominator : 1.0;
+            log_mean += log(new_strengths[s]) / nb_strategies;
+        }
+        change = 0.0;
+        for (int s = 0; s < nb_strategies; s++) {
+            new_strengths[s] /= exp(log_mean);
+            change = fmax(change, fabs(new_strengths[s] - strengths[s]));
+            strengths[s] = new_strengths[s];
+        }
+    }
+    for (int s = 0; s < nb_strategies; s++) ranks[s].rating = BASE_RATING + 400.0 * log10(strengths[s]);
+    qsort(ranks, nb_strategies, sizeof(Rank), compareRanks);
+    free(wins);
+    free(strengths);
+    free(new_strengths);
+}
+
+/* Write the ranking in a CSV file, best strategy first */
+bool writeRanking(const char *path, Tournament *tournament, Rank *ranks) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        printf("[ERROR]    Unable to write file at \"%s\"\n", path);
+        return false;
+    }
+    int nb_games = tournament->nb_levels + tournament->nb_seeds;
+    fprintf(file, "rank,strategy,rating,matches,wins,win_rate,mean_wave,mean_score,pairwise_wins,pairwise_draws,pairwise_losses\n");
+    for (int i = 0; i < tournament->nb_strategies; i++)
+        fprintf(file, "%d,%s,%.1f,%d,%d,%.4f,%.2f,%.2f,%d,%d,%d\n", i + 1, strategyName(tournament->strategy_paths[ranks[i].strategy]), ranks[i].rating, nb_games, ranks[i].nb_wins,
+            (double) ranks[i].nb_wins / nb_games, ranks[i].mean_wave, ranks[i].mean_score, ranks[i].nb_pairwise_wins, ranks[i].nb_pairwise_draws, ranks[i].nb_pairwise_losses);
+    fclose(file);
+    return true;
+}
+
+
+
+
+/* Play every strategy on every level file and on many survival seeds using all processor cores, then rank the strategies */
+/* Usage: td-tournament <nb survival seeds> <cache file> <output csv> <build order file|bot plugin (.so)> [build order file|bot plugin...] */
+/* Matches already in the cache file are not played again (unless their strategy or level file changed), so an interrupted run resumes */
+int main(int argc, char *argv[]) {
+    if (argc < 5) {
+        printf("Usage: %s <nb survival seeds> <cache file> <output csv> <build order file|bot plugin (.so)> [build order file|bot plugin...]\n", argv[0]);
+        return 1;
+    }
+    Tournament tournament;
+    bool found;
+    /* Levels, the survival mode coming last */
+    tournament.level_names = malloc((MAX_LEVELS + 1) * sizeof(char *));
+    tournament.level_hashes = malloc((MAX_LEVELS + 1) * sizeof(uint64_t));
+    tournament.nb_levels = listLevels(tournament.level_names, MAX_LEVELS);
+    tournament.level_names[tournament.nb_levels] = duplicateString(SURVIVAL_LEVEL_NAME);
+    tournament.level_hashes[tournament.nb_levels] = hashFile(SURVIVAL_CURVE_PATH, &found);
+    for (int i = 0; i < tournament.nb_levels; i++) {
+        char *partial_path = concatString(LEVEL_DIRECTORY, tournament.level_names[i]), *path = concatString(partial_path, ".txt");
+        tournament.level_hashes[i] = hashFile(path, &found);
+        free(partial_path);
+        free(path);
+    }
+    tournament.nb_seeds = max(stringToInt(argv[1]), 0);
+    /* Strategies */
+    tournament.nb_strategies = argc - 4;
+    tournament.strategy_paths = argv + 4;
+    tournament.strategy_hashes = malloc(tournament.nb_strategies * sizeof(uint64_t));
+    tournament.build_orders = calloc(tournament.nb_strategies, sizeof(BuildStep *));
+    tournament.nb_steps = calloc(tournament.nb_strategies, sizeof(int));
+    tournament.bots = calloc(tournament.nb_strategies, sizeof(Bot *));
+    for (int i = 0; i < tournament.nb_strategies; i++) {
+        tournament.strategy_hashes[i] = hashFile(argv[i+4], &found);
+        if (isBotPath(argv[i+4]) ? !(tournament.bots[i] = loadBot(argv[i+4])) : !(tournament.build_orders[i] = loadBuildOrder(argv[i+4], &tournament.nb_steps[i]))) return 1;
+    }
+    int nb_games = tournament.nb_levels + tournament.nb_seeds;
+    if (!nb_games) {
+        printf("[ERROR]    No level to play\n");
+        return 1;
+    }
+    tournament.nb_matches = tournament.nb_strategies * nb_games;
+    tournament.matches = malloc(tournament.nb_matches * sizeof(Match));
+    for (int s = 0; s < tournament.nb_strategies; s++) for (int g = 0; g < nb_games; g++)
+        tournament.matches[s * nb_games + g] = (Match) {s, min(g, tournament.nb_levels), (g < tournament.nb_levels) ? LEVEL_SEED : g - tournament.nb_levels + 1, false, 0, 0, 0, 0};
+    pthread_mutex_init(&tournament.cache_lock, NULL);
+    int nb_cached = loadCache(&tournament, argv[2]);
+    if (nb_cached < 0) return 1;
+
+    /* Matches left are dealt to the workers in contiguous blocks, workers done with their block steal from the others */
+    int nb_left = tournament.nb_matches - nb_cached;
+    tournament.nb_workers = max(min((int) sysconf(_SC_NPROCESSORS_ONLN), nb_left), 1);
+    tournament.deques = malloc(tournament.nb_workers * sizeof(MatchDeque));
+    atomic_init(&tournament.nb_stolen, 0);
+    for (int i = 0, match = 0; i < tournament.nb_workers; i++) {
+        MatchDeque *deque = &tournament.deques[i];
+        deque->matches = malloc(max(nb_left / tournament.nb_workers + 1, 1) * sizeof(int));
+        deque->head = deque->tail = 0;
+        pthread_mutex_init(&deque->lock, NULL);
+        for (int nb_dealt = 0; match < tournament.nb_matches && nb_dealt < nb_left / tournament.nb_workers + (i < nb_left % tournament.nb_workers); match++)
+            if (!tournament.matches[match].done) deque->matches[deque->tail++] = match, nb_dealt++;
+    }
+    Worker *workers = malloc(tournament.nb_workers * sizeof(Worker));
+    double start = getTimeMs();
+    for (int i = 0; i < tournament.nb_workers; i++) {
+        workers[i].tournament = &tournament;
+        workers[i].index = i;
+        pthread_create(&workers[i].thread, NULL, workerMain, &workers[i]);
+    }
+    for (int i = 0; i < tournament.nb_workers; i++) pthread_join(workers[i].thread, NULL);
+    double sim_time = getTimeMs() - start;
+
+    /* Ranking */
+    Rank *ranks = malloc(tournament.nb_strategies * sizeof(Rank));
+    rankStrategies(&tournament, ranks);
+    bool written = writeRanking(argv[3], &tournament, ranks);
+    printf("Levels:       %d level files and %d survival seeds\n", tournament.nb_levels, tournament.nb_seeds);
+    printf("Matches:      %d (%d strategies, %d found in the cache)\n", tournament.nb_matches, tournament.nb_strategies, nb_cached);
+    printf("Threads:      %d (%d matches stolen)\n", tournament.nb_workers, atomic_load(&tournament.nb_stolen));
+    printf("Sim time:     %.3f ms (%.0f matches/s)\n", sim_time, (sim_time > 0.0) ? nb_left * 1000.0 / sim_time : 0.0);
+    printf("\nRank  Rating  Wins        Pairwise W/D/L     Mean score  Strategy\n");
+    for (int i = 0; i < tournament.nb_strategies; i++)
+        printf("%4d  %6.1f  %5d/%-5d %6d/%d/%-6d %11.1f  %s\n", i + 1, ranks[i].rating, ranks[i].nb_wins, nb_games, ranks[i].nb_pairwise_wins, ranks[i].nb_pairwise_draws,
+            ranks[i].nb_pairwise_losses, ranks[i].mean_score, strategyName(tournament.strategy_paths[ranks[i].strategy]));
+
+    /* Free memory */
+    fclose(tournament.cache);
+    pthread_mutex_destroy(&tournament.cache_lock);
+    for (int i = 0; i < tournament.nb_workers; i++) {
+        free(tournament.deques[i].matches);
+        pthread_mutex_destroy(&tournament.deques[i].lock);
+    }
+    for (int i = 0; i <= tournament.nb_levels; i++) free(tournament.level_names[i]);
+    for (int i = 0; i < tournament.nb_strategies; i++) {
+        free(tournament.build_orders[i]);
+        destroyBot(tournament.bots[i]);
+    }
+    free(tournament.level_names);
+    free(tournament.level_hashes);
+    free(tournament.strategy_hashes);
+    free(tournament.build_orders);
+    free(tournament.nb_steps);
+    free(tournament.bots);
+    free(tournament.matches);
+    free(tournament.deques);
+    free(workers);
+    free(ranks);
+    return !written;
+}
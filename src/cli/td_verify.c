@@ -0,0 +1,336 @@
+#define _POSIX_C_SOURCE 200809L  // sysconf
+#include "../sim.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define VERIFY_BEAM_WIDTH 8        // Number of layouts kept at each step of the search of a wave
+#define VERIFY_TIME_BUDGET 20      // Time (in s) the search of a wave may spend by default
+#define SHORTFALL_FUNDS 1000000    // Funds added to search the layout of a wave that cannot be cleared with the funds available
+#define DEFAULT_SEED 1             // Seed the level is verified on by default
+#define MAX_LAYOUT_ACTIONS (NB_ROWS * (NB_COLLUMNS-1))  // A layout may build on every tile
+#define LEAKED_LIFE_VALUE 10       // Value lost for each life point of the enemies reaching the castle when evaluating a layout
+
+
+
+
+/* Towers built before a wave, and how the wave goes with them */
+typedef struct {
+    Action actions[MAX_LAYOUT_ACTIONS];  // Towers built or upgraded before the wave, in order
+    int nb_actions;                      // Number of actions
+    int cost;                            // Funds spent on them
+    bool cleared;                        // Is the wave cleared without any enemy reaching the castle
+    double value;                        // Orders the layouts that do not clear it, the higher the closer to clearing it
+} Layout;
+
+/* Layouts evaluated in parallel by the threads of a search */
+typedef struct {
+    Game *game;                // Game before the wave (never modified by the search)
+    int budget;                // Funds the layouts may spend
+    Layout *layouts;           // Layouts to evaluate
+    int nb_layouts;            // Number of layouts to evaluate
+    atomic_int next_layout;    // Index of the next layout to evaluate
+    atomic_llong nb_rollouts;  // Number of layouts evaluated so far
+    double deadline;           // Time (in ms) after which layouts are not evaluated anymore
+} LayoutSearch;
+
+
+/* Header */
+void evaluateLayout(LayoutSearch *search, Layout *layout);
+void *layoutSearchWorker(void *data);
+void evaluateLayouts(LayoutSearch *search, int nb_threads);
+bool isTileInLayout(Layout *layout, int collumn, int row);
+bool areLayoutsEqual(Layout *a, Layout *b);
+int compareLayouts(const void *a, const void *b);
+Layout searchWaveLayout(Game *game, int budget, double time_budget, int nb_threads, long long *nb_rollouts);
+Layout minimizeLayout(Game *game, Layout layout, double deadline, int nb_threads, long long *nb_rollouts);
+bool replayWitness(char *level_name, unsigned long long seed, BuildStep *witness, int nb_steps);
+
+
+
+/* Play the upcoming wave on a clone of the game after the towers of a layout, the layout being invalid if they cost more than the budget */
+/* Enemies reaching the castle are taken off the board instead of ending the wave, so that a layout is judged on every row and not only the first to give way */
+void evaluateLayout(LayoutSearch *search, Layout *layout) {
+    Game *clone = cloneGame(search->game);
+    syncEntityIds(clone);
+    clone->funds = search->budget;
+    layout->cleared = false;
+    layout->value = INVALID_PLAN_VALUE;
+    for (int i = 0; i < layout->nb_actions; i++) if (!applyAction(clone, layout->actions[i])) {
+        destroyGame(clone);
+        return;
+    }
+    layout->cost = search->budget - clone->funds;
+    int score = clone->score, leaked_life_points = 0, nb_turns = 0, slot;
+    Board *board = newBoard();
+    startNextWave(clone);
+    if (loadBoard(board, clone)) {
+        do {
+            for (int row = 1; row <= NB_ROWS; row++) if (board->enemy_mask[row-1] & 1u) {
+                slot = board->enemy_slot[row-1][0];
+                leaked_life_points += board->enemy_life_points[slot * board->stride];
+                removeBoardEnemy(board, slot);
+            }
+            if (isBoardWaveOver(board) || nb_turns >= MAX_PREDICTED_TURNS) break;
+            resolveBoardTurn(board);
+            nb_turns++;
+        } while (true);
+        layout->cleared = !leaked_life_points && nb_turns < MAX_PREDICTED_TURNS;
+        layout->value = board->score - score - LEAKED_LIFE_VALUE * leaked_life_points - layout->cost;
+    }
+    /* Waves too large for a board are only judged on how long the defences hold */
+    else {
+        WavePrediction prediction;
+        clone->game_phase = PRE_WAVE_PHASE;
+        predictWave(clone, &prediction, NULL, 0);
+        layout->cleared = !prediction.defeat && prediction.nb_turns < MAX_PREDICTED_TURNS;
+        layout->value = prediction.nb_turns * DEFEAT_TURN_VALUE + prediction.score - TOWER_LOST_VALUE * prediction.nb_towers_lost - layout->cost;
+    }
+    destroyBoard(board);
+    destroyGame(clone);
+}
+
+/* Thread of a layout search, evaluate layouts until none is left or the deadline has passed */
+void *layoutSearchWorker(void *data) {
+    LayoutSearch *search = data;
+    int i;
+    while ((i = atomic_fetch_add(&search->next_layout, 1)) < search->nb_layouts) {
+        if (getTimeMs() > search->deadline) {
+            search->layouts[i].value = INVALID_PLAN_VALUE;
+            search->layouts[i].cleared = false;
+            continue;
+        }
+        evaluateLayout(search, &search->layouts[i]);
+        atomic_fetch_add(&search->nb_rollouts, 1);
+    }
+    return NULL;
+}
+
+/* Evaluate every layout of a search on several threads */
+void evaluateLayouts(LayoutSearch *search, int nb_threads) {
+    atomic_init(&search->next_layout, 0);
+    nb_threads = min(max(nb_threads, 1), max(search->nb_layouts, 1));
+    pthread_t *threads = malloc(nb_threads * sizeof(pthread_t));
+    for (int i = 0; i < nb_threads; i++) pthread_create(&threads[i], NULL, layoutSearchWorker, search);
+    for (int i = 0; i < nb_threads; i++) pthread_join(threads[i], NULL);
+    free(threads);
+}
+
+/* Return if a layout already builds or upgrades a tower on a tile */
+bool isTileInLayout(Layout *layout, int collumn, int row) {
+    for (int i = 0; i < layout->nb_actions; i++) if (layout->actions[i].collumn == collumn && layout->actions[i].row == row) return true;
+    return false;
+}
+
+/* Return if two layouts do the same actions (in any order) */
+bool areLayoutsEqual(Layout *a, Layout *b) {
+    if (a->nb_actions != b->nb_actions) return false;
+    for (int i = 0; i < a->nb_actions; i++) {
+        bool found = false;
+        for (int j = 0; j < b->nb_actions && !found; j++) found = !memcmp(&a->actions[i], &b->actions[j], sizeof(Action));
+        if (!found) return false;
+    }
+    return true;
+}
+
+/* Compare two layouts by decreasing value (for qsort) */
+int compareLayouts(const void *a, const void *b) {
+    double value_a = ((Layout *) a)->value, value_b = ((Layout *) b)->value;
+    return (value_a < value_b) - (value_a > value_b);
+}
+
+/* Search the cheapest layout clearing the upcoming wave of a game within a budget (funds) and a time budget (in ms) */
+/* Beam search adding one tower per step, pruned by cost: once a layout clears the wave, only cheaper ones are evaluated */
+Layout searchWaveLayout(Game *game, int budget, double time_budget, int nb_threads, long long *nb_rollouts) {
+    /* Actions considered: buying any base tower on any free tile, upgrading any tower already built */
+    const char tower_types[] = {ARCHER_TOWER, WALL_TOWER, CANON_TOWER, SORCERER_TOWER};
+    int nb_candidates = 0;
+    Action *candidates = malloc((sizeof(tower_types) * NB_ROWS * NB_COLLUMNS + NB_ROWS * NB_COLLUMNS) * sizeof(Action));
+    for (int collumn = 1; collumn < NB_COLLUMNS; collumn++) for (int row = 1; row <= NB_ROWS; row++) {
+        if (isTileBlocked(game->flow_field, collumn, row)) continue;
+        Tower *tower = NULL;
+        getEnemyAndTowerAt(NULL, game->tower_list, collumn, row, NULL, &tower);
+        if (!tower) for (unsigned long i = 0; i < sizeof(tower_types); i++) candidates[nb_candidates++] = (Action) {BUY_ACTION, tower_types[i], collumn, row, 0};
+        else if (tower->type == WALL_TOWER || tower->type == SORCERER_TOWER || tower->type == CANON_TOWER) candidates[nb_candidates++] = (Action) {UPGRADE_ACTION, 0, collumn, row, 0};
+    }
+    LayoutSearch search;
+    search.game = game;
+    search.budget = budget;
+    search.deadline = getTimeMs() + time_budget;
+    search.layouts = malloc((VERIFY_BEAM_WIDTH * nb_candidates + 1) * sizeof(Layout));
+    atomic_init(&search.nb_rollouts, 0);
+    /* Building nothing is the first layout */
+    Layout beam[VERIFY_BEAM_WIDTH], best;
+    beam[0].nb_actions = 0;
+    evaluateLayout(&search, &beam[0]);
+    best = beam[0];
+    int beam_size = !best.cleared;
+    for (int depth = 0; depth < MAX_LAYOUT_ACTIONS && beam_size && getTimeMs() < search.deadline; depth++) {
+        /* Layouts costing as much as the cheapest one clearing the wave are not worth evaluating */
+        if (best.cleared) search.budget = best.cost - 1;
+        search.nb_layouts = 0;
+        for (int i = 0; i < beam_size; i++) for (int j = 0; j < nb_candidates; j++) {
+            if (isTileInLayout(&beam[i], candidates[j].collumn, candidates[j].row)) continue;
+            Layout *layout = &search.layouts[search.nb_layouts++];
+            *layout = beam[i];
+            layout->actions[layout->nb_actions++] = candidates[j];
+        }
+        evaluateLayouts(&search, nb_threads);
+        /* Layouts clearing the wave are not extended (more towers only cost more), the best others are */
+        qsort(search.layouts, search.nb_layouts, sizeof(Layout), compareLayouts);
+        beam_size = 0;
+        for (int i = 0; i < search.nb_layouts && search.layouts[i].value > INVALID_PLAN_VALUE; i++) {
+            if (search.layouts[i].cleared) {
+                if (!best.cleared || search.layouts[i].cost < best.cost) best = search.layouts[i];
+                continue;
+            }
+            bool duplicate = false;
+            for (int j = 0; j < beam_size && !duplicate; j++) duplicate = areLayoutsEqual(&beam[j], &search.layouts[i]);
+            if (!duplicate && beam_size < VERIFY_BEAM_WIDTH) beam[beam_size++] = search.layouts[i];
+        }
+    }
+    *nb_rollouts += atomic_load(&search.nb_rollouts) + 1;
+    free(search.layouts);
+    free(candidates);
+    if (best.cleared) best = minimizeLayout(game, best, search.deadline, nb_threads, nb_rollouts);
+    return best;
+}
+
+/* Make a layout clearing the wave cheaper until it cannot be: remove one of its towers or replace it by another type, keeping the cheapest that still clears it */
+Layout minimizeLayout(Game *game, Layout layout, double deadline, int nb_threads, long long *nb_rollouts) {
+    const char tower_types[] = {ARCHER_TOWER, WALL_TOWER, CANON_TOWER, SORCERER_TOWER};
+    LayoutSearch search;
+    search.game = game;
+    search.deadline = deadline;
+    search.layouts = malloc(MAX_LAYOUT_ACTIONS * (sizeof(tower_types) + 1) * sizeof(Layout));
+    atomic_init(&search.nb_rollouts, 0);
+    bool improved = true;
+    while (improved && getTimeMs() < deadline) {
+        search.budget = layout.cost - 1;
+        search.nb_layouts = 0;
+        for (int i = 0; i < layout.nb_actions; i++) {
+            Layout *variant = &search.layouts[search.nb_layouts++];
+            *variant = layout;
+            variant->actions[i] = variant->actions[--variant->nb_actions];
+            if (layout.actions[i].type != BUY_ACTION) continue;
+            for (unsigned long j = 0; j < sizeof(tower_types); j++) if (tower_types[j] != layout.actions[i].tower_type) {
+                variant = &search.layouts[search.nb_layouts++];
+                *variant = layout;
+                variant->actions[i].tower_type = tower_types[j];
+            }
+        }
+        evaluateLayouts(&search, nb_threads);
+        improved = false;
+        for (int i = 0; i < search.nb_layouts; i++) if (search.layouts[i].cleared && search.layouts[i].cost < layout.cost) {
+            layout = search.layouts[i];
+            improved = true;
+        }
+    }
+    *nb_rollouts += atomic_load(&search.nb_rollouts);
+    free(search.layouts);
+    return layout;
+}
+
+/* Play the level with the towers found by the verifier on the game resolver, return if it is won */
+bool replayWitness(char *level_name, unsigned long long seed, BuildStep *witness, int nb_steps) {
+    Game *game = createNewGame(level_name, seed);
+    destroyEventLog(game->event_log);
+    game->event_log = NULL;
+    while (game->game_phase != VICTORY_PHASE && game->game_phase != DEFEAT_PHASE && game->turn_nb <= MAX_PREDICTED_TURNS) {
+        if (game->game_phase == PRE_WAVE_PHASE || game->game_phase == WAITING_FOR_USER_PHASE) {
+            applyBuildOrder(game, witness, nb_steps, true);
+            applyAction(game, (Action) {START_WAVE_ACTION, 0, 0, 0, 0});
+        }
+        updateGame(game, NULL);
+    }
+    bool won = (game->game_phase == VICTORY_PHASE);
+    destroyGame(game);
+    return won;
+}
+
+
+
+
+/* Check that every wave of a level can be cleared with the funds a player gets (income of each wave plus interest on savings) */
+/* Waves are searched in order, each one with the towers found for the previous ones, and the cheapest layout found is reported */
+/* Usage: td-verify <level> [witness build order file] [time budget per wave in s] [seed] */
+/* The witness is a build order file winning the level (replayable with td-sim), it is played on the game resolver as a final check */
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        printf("Usage: %s <level> [witness build order file] [time budget per wave in s] [seed]\n", argv[0]);
+        return 1;
+    }
+    double time_budget = ((argc > 3) ? stringToInt(argv[3]) : VERIFY_TIME_BUDGET) * 1000.0;
+    unsigned long long seed = (argc > 4) ? strtoull(argv[4], NULL, 10) : DEFAULT_SEED;
+    int nb_threads = max((int) sysconf(_SC_NPROCESSORS_ONLN), 1);
+    Game *game = createNewGame(argv[1], seed);
+    destroyEventLog(game->event_log);
+    game->event_log = NULL;
+    if (game->nb_waves <= 0) {
+        destroyGame(game);
+        return 1;
+    }
+
+    /* Search every wave, building the layout found before playing it */
+    BuildStep *witness = malloc(game->nb_waves * MAX_LAYOUT_ACTIONS * sizeof(BuildStep));
+    int nb_steps = 0, nb_short = 0, funds, wave_nb; long long nb_rollouts, total_rollouts = 0;
+    bool stopped = false;
+    double start = getTimeMs(), wave_start;
+    printf("Wave  Funds    Minimum  Margin   Towers  Rollouts  Time (ms)\n");
+    while (game->game_phase == PRE_WAVE_PHASE || game->game_phase == WAITING_FOR_USER_PHASE) {
+        wave_start = getTimeMs();
+        funds = game->funds; wave_nb = game->current_wave_nb; nb_rollouts = 0;
+        Layout layout = searchWaveLayout(game, funds, time_budget, nb_threads, &nb_rollouts);
+        /* The funds the wave needs are still searched when it cannot be cleared with the funds available, the next waves being verified as if they were given */
+        if (!layout.cleared) {
+            layout = searchWaveLayout(game, funds + SHORTFALL_FUNDS, time_budget, nb_threads, &nb_rollouts);
+            if (layout.cleared) {
+                nb_short++;
+                game->funds = max(funds, layout.cost);
+            }
+        }
+        total_rollouts += nb_rollouts;
+        if (!layout.cleared) {
+            printf("%4d  %-7d  %-7s  %-7s  %-6s  %-8lld  %.0f\n", wave_nb, funds, "-", "-", "-", nb_rollouts, getTimeMs() - wave_start);
+            printf("[ERROR]    No layout clearing wave %d was found\n", wave_nb);
+            stopped = true;
+            break;
+        }
+        for (int i = 0; i < layout.nb_actions; i++) {
+            Action action = layout.actions[i];
+            Tower *tower = NULL;
+            if (action.type == UPGRADE_ACTION) getEnemyAndTowerAt(NULL, game->tower_list, action.collumn, action.row, NULL, &tower);
+            witness[nb_steps++] = (BuildStep) {wave_nb, tower ? tower->type : action.tower_type, action.collumn, action.row};
+            applyAction(game, action);
+        }
+        printf("%4d  %-7d  %-7d  %-7d  %-6d  %-8lld  %.0f\n", wave_nb, funds, layout.cost, funds - layout.cost, layout.nb_actions, nb_rollouts, getTimeMs() - wave_start);
+        /* Play the wave, then load the next one (income and interest) or win the level */
+        syncEntityIds(game);
+        WavePrediction prediction;
+        predictWave(game, &prediction, NULL, 0);
+        updateGame(game, NULL);
+    }
+    double verify_time = getTimeMs() - start;
+
+    /* Outcome, the witness being played from the start on the game resolver (it cannot win if some waves were given more funds) */
+    bool won = !stopped && !nb_short && replayWitness(argv[1], seed, witness, nb_steps);
+    printf("\nLevel:        %s (seed %llu)\n", argv[1], seed);
+    printf("Outcome:      %s\n", stopped ? "NO LAYOUT FOUND" : (nb_short ? "UNSOLVABLE WITH THE FUNDS GIVEN" : (won ? "SOLVABLE" : "WITNESS LOST")));
+    if (nb_short) printf("Short waves:  %d (minimum funds above the funds available)\n", nb_short);
+    printf("Search time:  %.3f ms (%lld rollouts on %d threads)\n", verify_time, total_rollouts, nb_threads);
+    if (argc > 2 && !stopped && !nb_short) {
+        FILE *file = fopen(argv[2], "w");
+        if (file) {
+            for (int i = 0; i < nb_steps; i++) fprintf(file, "%d %c %d %d\n", witness[i].wave_nb, witness[i].type, witness[i].collumn, witness[i].row);
+            fclose(file);
+            printf("Witness:      %s (%d towers, %s on replay)\n", argv[2], nb_steps, won ? "won" : "lost");
+        }
+        else printf("[ERROR]    Unable to write file at \"%s\"\n", argv[2]);
+    }
+
+    /* Free memory */
+    bool solvable = !stopped && !nb_short && won;
+    destroyGame(game);
+    free(witness);
+    return !solvable;
+}
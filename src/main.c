@@ -1,19 +1,13 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <stdbool.h>
-#include <time.h>
 #include <SDL.h>
 #include <dirent.h>
-
-
-
+#include "sim.h"
 
 #define FULLSCREEN false        // Set if the game should start on fullscreen (F11 to toggle on/off)
 #define ANTI_ALIASING "2"       // Set if the game should use anti aliasing for rendering
 #define FPS 60                  // Game target FPS
-#define NB_ROWS 7               // Number of rows for the map
-#define NB_COLLUMNS 15          // Number of collumns for the map
+#define TURBO_RENDER_INTERVAL 6 // In turbo mode (T to toggle on/off), turns are resolved without animation and only one frame out of this many is drawn
+#define REPLAY_SEEK_TURNS 100   // Number of turns skipped forward or backward (right and left arrows) while watching a replay
+#define LEVEL_PREVIEW_TIME 4    // Time (in ms) spent each frame simulating the waves of the level being edited (E to toggle on/off)
 #define TILE_WIDTH 256          // Width of a tile in px
 #define TILE_HEIGHT 192         // Height of a tile in px
 #define SPRITE_SIZE 320         // Height and width of all sprites in px
@@ -24,29 +18,9 @@
 #define BASE_WINDOW_WIDTH 1280  // Default width of the window
 #define BASE_WINDOW_HEIGHT 720  // Default width of the window
 
-#define MAX_LENGTH_NICKNAME 32
-#define MAX_SIZE_SCORE_FILE 100
-
-
-
-
-/* Enemy types */
-#define SLIME_ENEMY 'S'
-#define GELLY_ENEMY 'G'
-#define GOBLIN_ENEMY 'g'
-#define ORC_ENEMY 'O'
-#define NECROMANCER_ENEMY 'N'
-#define SKELETON_ENEMY 's'
-#define WITCH_ENEMY 'W'
-/* Tower types */
-#define ARCHER_TOWER 'A'
-#define WALL_TOWER 'W'
-#define BARRACK_TOWER 'B'
-#define SOLIDER_TOWER 's'
-#define CANON_TOWER 'C'
-#define DESTROYER_TOWER 'D'
-#define SORCERER_TOWER 'S'
-#define MAGE_TOWER 'M'
+
+
+
 /* Animation type */
 #define IDLE_ANIMATION 'I'
 #define HURT_ANIMATION 'H'
@@ -55,20 +29,6 @@
 #define MOVE_ANIMATION 'M'
 #define PROJECTILE_ANIMATION 'P'
 #define DAMAGE_NUMBER_ANIMATION 'd'
-/* Game phases */
-#define WAITING_FOR_USER_PHASE -1
-#define PRE_WAVE_PHASE 0
-#define ENEMIES_MOVING_PHASE 1
-#define TOWERS_ATTACKING_PHASE 2
-#define ENEMIES_ATTACKING_PHASE 3
-#define VICTORY_PHASE 4
-#define DEFEAT_PHASE 5
-#define SCORE_PHASE 6
-
-
-
-/* Survival mode level name */
-#define SURVIVAL_MODE "$urv1v@lM0d3"
 
 
 
@@ -169,6 +129,8 @@ double CAM_POS_Y = (NB_ROWS*TILE_HEIGHT)/2;
 
 /* Current game tick */
 Uint64 CURRENT_TICK = 0;
+/* Random number generator of visual effects (on its own stream, so that it never changes the game outcome) */
+Rng COSMETIC_RNG;
 
 
 
@@ -192,91 +154,50 @@ typedef struct text_element {
     struct text_element *next;
 } TextElement;
 
-/* Towers */
-typedef struct tower {
-    int type;                  // Tower type, determine it's abilities, look and upgrades
-    int max_life_points;       // Maximum life points of the tower
-    int life_points;           // Life points of the tower, when it reaches 0 or bellow the tower is destroyed
-    int row;                   // Row number of the tower, 0 being the topmost row
-    int collumn;               // Collumn number of the tower, 0 being the leftmost collumn
-    int cost;                  // Placement cost of the tower
-    int base_attack_cooldown;  // Cooldown between each attack (1 or less being none)
-    int attack_cooldown;       // Current cooldown before the next attack
-    struct tower* next;        // Pointer to the next tower placed
-    SDL_Surface *sprite;       // Sprite of the tower
-    Animation *anim;           // Animation of the tower
-    TextElement *life_bar;     // Life bar of the tower
-} Tower;
-
-/* Enemies */
-typedef struct enemy {
-    int type;                   // Enemy type, determine it's abilities and look
-    int max_life_points;        // Maximum life points of the enemy
-    int life_points;            // Life points of the enemy, when it reaches 0 or bellow the enemy is defeated
-    int row;                    // Row number of the enemy, 0 being the topmost row
-    int collumn;                // Collumn number of the enemy, 0 being the leftmost collumn
-    int base_speed;             // Base number of collumn travelled per turn
-    int speed;                  // Number of collumn travelled per turn, reseted to base_speed after moving
-    struct enemy* next;         // Next enemy (in order of apparition)
-    struct enemy* next_on_row;  // Next enemy on the same row (behind this)
-    struct enemy* prev_on_row;  // Previous enemy on the same row (in front of this)
-    SDL_Surface *sprite;        // Sprite of the enemy
-    Animation *anim;            // Animation of the enemy
-    TextElement *life_bar;      // Life bar of the enemy
-    int score_on_kill;          // Score given when killing the enemy
-} Enemy;
-
-/* Projectile shoot by a tower */
+/* Projectile shoot by a tower (only shown on screen, the hit is applied by the turn resolver) */
 typedef struct projectile {
-    Tower *origin;            // Tower that shot the projectile
-    Enemy *target;            // Enemy target of the projectile
     struct projectile* next;  // Next projectile (in order of apparition)
     SDL_Surface *sprite;      // Sprite of the projectile
     Animation *anim;          // Animation of the projectile
 } Projectile;
 
-/* Waves */
+/* Enemy or tower as shown on screen, following the events played */
+typedef struct visual {
+    int id;                  // Identifier of the enemy or tower shown
+    bool is_tower;           // Is it a tower or an enemy
+    char type;               // Enemy or tower type, determine its sprite
+    int collumn;             // Collumn shown, only matches the entity once all events are played
+    int row;                 // Row shown
+    int life_points;         // Life points shown
+    int max_life_points;     // Maximum life points
+    Animation *anim;         // Animation
+    TextElement *life_bar;   // Life bar
+    struct visual *next;     // Next visual
+} Visual;
+
+/* Everything shown on screen over the map */
 typedef struct {
-    Enemy *enemy_list;  // Enemies of the wave
-    int income;         // Funds gain before the wave to build towers
-} Wave;
-
-/* Game structure, composed of multiple waves */
-typedef struct {
-    Wave **waves;                    // Array of waves
-    int nb_waves;                    // Number of waves
-    int current_wave_nb;             // Current wave
-    Tower *tower_list;               // Towers
-    Tower *currently_acting_tower;   // Tower currently acting
-    Enemy *enemy_list;               // Enemies
-    Enemy *currently_acting_enemy;   // Enemy currently acting
-    Projectile *projectile_list;     // Projectiles
-    TextElement *text_element_list;  // Text elements representing damage numbers
-    int funds;                       // Availible funds to build tower
-    int score;                       // Player score
-    int turn_nb;                     // Turn number
-    int game_phase;                  // Current game phase, determine what type of actions to handle next
-    char *level_name;                // Name of the played level
-} Game;
-
+    Visual *visual_list;              // Enemies and towers
+    Projectile *projectile_list;      // Projectiles
+    TextElement *text_element_list;   // Text elements representing damage numbers
+    SDL_Surface *enemy_sprites[128];  // Sprite of each enemy type, loaded when first needed
+    SDL_Surface *tower_sprites[128];  // Sprite of each tower type, loaded when first needed
+} Scene;
+
+/* Background worker predicting the outcome of the upcoming wave while the player builds defences */
 typedef struct {
-    char *nickname;  // Nickname of the player
-    int score;       // Score of the player
-} Scoreboard;
+    SDL_Thread *thread;          // Worker thread
+    SDL_mutex *mutex;            // Protects every field bellow
+    SDL_cond *cond;              // Signaled when a game is waiting to be predicted or when stopping
+    bool running;                // Should the worker keep running
+    Game *pending;               // Clone of the game waiting to be predicted (owned by the predictor)
+    atomic_int generation;       // Incremented on each request, the prediction running is cancelled when it changes
+    WavePrediction prediction;   // Last prediction done
+    int prediction_generation;   // Generation of the last prediction (up to date if it matches generation)
+} Predictor;
 
 
 /* Header */
-int randrange(int a, int b);
-bool roll(double p);
-int sign(double x);
-double min(double x, double y);
-double max(double x, double y);
-double power(double x, int n);
-char *concatString(const char *a, const char *b);
-char *duplicateString(const char *a);
-int stringToInt(const char *str);
-int positive_div(int i, int n);
-int positive_mod(int i, int n);
 double periodicFunctionSub(double x);
 double periodicFunction(Uint64 x);
 SDL_Surface *textSurface(char *text, SDL_Color main_color, SDL_Color outline_color);
@@ -295,49 +216,35 @@ TextElement *addTextElement(TextElement **text_element_list, char *text, double
 void destroyTextElement(TextElement *text_element, TextElement **text_element_list);
 void drawTextElements(SDL_Renderer *rend, TextElement **text_element_list);
 TextElement *addDamageNumber(TextElement **text_element_list, int amount, int collumn, int row);
-bool getEnemyAndTowerAt(Enemy *enemy_list, Tower *tower_list, int collumn, int row, Enemy **enemy, Tower **tower);
-bool isTileEmpty(Enemy *enemy_list, Tower *tower_list, int collumn, int row);
-bool doesTileExist(int collumn, int row);
-Enemy *addEnemy(Enemy **enemy_list, char enemy_type, int spawn_collumn, int spawn_row, int life_points);
-void destroyEnemy(Enemy *enemy, Enemy **enemy_list);
-Enemy **getFirstEnemyOfAllRows(Enemy *enemy_list);
-Enemy *getFirstEnemyInRow(Enemy *enemy_list, int row);
-void updateEnemies(Enemy **currently_acting_enemy, Enemy **enemy_list, Tower **tower_list, TextElement **text_element_list);
-int moveEnemy(Enemy *enemy, Enemy *enemy_list, Tower *tower_list, int delta, char axis);
-void makeAllEnemiesMove(Enemy *enemy_list, Tower *tower_list);
-void enemyAttack(Enemy *enemy, Tower **tower_list, Enemy **enemy_list, TextElement **text_element_list);
-void makeAllEnemiesAct(Enemy *enemy_list, Enemy **currently_acting_enemy);
-bool damageEnemy(Enemy *enemy, int amount, Enemy **enemy_list, Tower *tower_list, TextElement **text_element_list, int *score);
-Tower *addTower(Tower **tower_list, Enemy *enemy_list, char tower_type, int placement_row, int placement_collumn, int life_points);
-Tower *buyTower(Tower **tower_list, Enemy *enemy_list, char tower_type, int placement_row, int placement_collumn, int *funds);
-void destroyTower(Tower *tower, Tower **tower_list);
-void sellTower(Tower *tower, Tower **tower_list, int *funds);
-void towerAct(Tower *tower, Tower **tower_list, Enemy *enemy_list, Projectile **projectile_list);
-void updateTowers(Tower **currently_acting_tower, Tower **tower_list, Enemy *enemy_list, Projectile **projectile_list);
-void makeAllTowersAct(Tower *tower_list, Tower **currently_acting_tower);
-bool damageTower(Tower *tower, int amount, Tower **tower_list, TextElement **text_element_list);
-Projectile *addProjectile(Projectile **projectile_list, Tower *origin, Enemy *target);
+SDL_Surface *loadEnemyImg(char enemy_type);
+void drawSpawnQueue(SDL_Renderer *rend, SpawnQueue *spawn_queue, int turn_nb, SDL_Surface *enemy_sprites[128]);
+SDL_Surface *loadTowerImg(char tower_type);
+Projectile *addProjectile(Projectile **projectile_list, char tower_type, int x1, int y1, int x2, int y2);
 void destroyProjectile(Projectile *projectile, Projectile **projectile_list);
 bool hasProjectileReachedTarget(Projectile *projectile);
-void updateProjectiles(Projectile **projectile_list, Enemy **enemy_list, Tower *tower_list, TextElement **text_element_list, int *score);
+void updateProjectiles(Projectile **projectile_list);
 void drawProjectiles(SDL_Renderer *rend, Projectile *projectile_list);
-Game *createNewGame(char *level_name);
-Game *loadGameFromSave(char *save_file);
-bool loadNextWave(Game *game);
-void startNextWave(Game *game);
-void updateGame(Game *game, const char *nickname);
-void beguinNewSurvivalWave(Game *game);
-Wave *newWave(int income, Enemy *enemy_list);
-void destroyWaveList(Wave **wave_list, int nb_wave);
-bool isWhitespace(char c);
-bool readValue(char **line, char **value);
-bool readLine(FILE *file, char ***values, int *nb_values);
-bool loadLevel(const char *path, Wave ***waves, int *nb_waves);
-bool saveGame(const char *save_name, Game *game);
-bool deleteSaveFile(const char *name);
+int fastForwardGame(Game *game, const char *nickname, Uint64 time_budget);
+Predictor *newPredictor();
+void destroyPredictor(Predictor *predictor);
+int predictorMain(void *data);
+void requestPrediction(Predictor *predictor, Game *game);
+int getPrediction(Predictor *predictor, WavePrediction *prediction);
+unsigned int hashLayout(Game *game);
 SDL_Surface *loadImg(const char *path);
 void delImg(SDL_Surface *img);
-void drawEnemiesAndTowers(SDL_Renderer *rend, Enemy *enemy_list, Tower *tower_list, int game_phase);
+Scene *newScene();
+void destroyScene(Scene *scene);
+Visual *addVisual(Scene *scene, int id, bool is_tower, char type, int collumn, int row, int life_points, int max_life_points);
+void destroyVisual(Visual *visual, Visual **visual_list);
+Visual *getVisual(Visual *visual_list, int id);
+void setVisualLifePoints(Visual *visual, int life_points, int max_life_points);
+SDL_Surface *getVisualSprite(Scene *scene, Visual *visual);
+bool isAnimOver(Animation *anim);
+bool isSceneIdle(Scene *scene);
+void playEvents(Scene *scene, EventLog *event_log);
+void syncScene(Scene *scene, Game *game);
+void drawEnemiesAndTowers(SDL_Renderer *rend, Scene *scene, int game_phase, bool enemies_shown);
 void dynamicToStatic(SDL_Rect *rect);
 void staticToDynamic(SDL_Rect *rect);
 void tileToPixel(int *x, int *y);
@@ -346,86 +253,10 @@ void drawImgStatic(SDL_Renderer *rend, SDL_Surface *img, int pos_x, int pos_y, i
 void drawImgDynamic(SDL_Renderer *rend, SDL_Surface *img, int pos_x, int pos_y, int width, int height, Animation *anim);
 void drawRect(SDL_Renderer *rend, int pos_x, int pos_y, int width, int height, int red, int green, int blue, int alpha);
 void drawFilledRect(SDL_Renderer *rend, int pos_x, int pos_y, int width, int height, int red, int green, int blue, int alpha);
-Tower *upgradeTower(Tower **tower_list, Enemy *enemy_list, char tower_type, int placement_collumn, int placement_row, int *funds);
-void saveScore(const char *current_nickname,int current_score,char *level_name);
+void drawRectDynamic(SDL_Renderer *rend, int pos_x, int pos_y, int width, int height, int red, int green, int blue, int alpha);
 
 
 
-/* Return an integer between a and b (included) */
-int randrange(int a, int b) {
-    return positive_mod(rand(), abs(b-a)+1) + min(a, b);
-}
-
-/* Has p chance to return true, and 1-p chance to return false */
-bool roll(double p) {
-    /* Roll precision */
-    int precision = 10000;
-    /* p must be a value between 0.0 and 1.0 included */
-    p = min(max(0.0, p), 1.0);
-    /* Return the roll */
-    return (p * precision > randrange(0, precision));
-}
-
-/* Return the sign of a number */
-int sign(double x) {return (x < 0.0) ? -1 : ((x > 0.0) ? +1 : 0);}
-
-/* Return the minimum between x and y */
-double min(double x, double y) {return (x < y) ? x : y;}
-
-/* Return the maximum between x and y */
-double max(double x, double y) {return (x > y) ? x : y;}
-
-/* Compute x to the power of n */
-double power(double x, int n) {
-    /* Base case */
-    if (n == 0) return 1;
-    if (x == 0.0) return 0;
-    /* Recursive case */
-    if (n > 0) {
-        double y = x;
-        int i = 1;
-        while (i*2 <= n) {
-            y *= y;
-            i *= 2;
-        }
-        return y * power(x, n-i);
-    }
-    /* Negative exponents */
-    else return 1.0 / power(x, -n);
-}
-
-/* Add 2 strings together into a new string, memory must be freed after use */
-char *concatString(const char *a, const char *b) {
-    char *c = malloc((strlen(a) + strlen(b) + 1) * sizeof(char));
-    strcpy(c, a);
-    strcat(c, b);
-    return c;
-}
-
-/* Duplicate a string and automaticaly allocate memory */
-char *duplicateString(const char *a) {
-    char *b = malloc(strlen(a) + 1);
-    if (b) strcpy(b, a);
-    return b;
-}
-
-/* Convert a string to an int */
-int stringToInt(const char *str) {
-    int n = 0;
-    sscanf(str, " %d", &n);
-    return n;
-}
-
-/* Used to get "a = q*b + r" with "0 <= r < b" */
-int positive_div(int i, int n) {
-    return (i - positive_mod(i, n)) / n;
-}
-
-/* Used to get "a = q*b + r" with "0 <= r < b" */
-int positive_mod(int i, int n) {
-    return (n + (i % n)) % n;
-}
-
 double periodicFunctionSub(double x) {
     return 1.0 / (24.0*x + 2.0) - x/2.0;
 }
@@ -775,7 +606,7 @@ void setAnim(Animation *anim, char type, Uint64 length, int *data) {
 /* Set animation to idle */
 void setAnimIdle(Animation *anim) {
     int *data = malloc(1 * sizeof(int));
-    data[0] = randrange(40, 100);
+    data[0] = randrange(&COSMETIC_RNG, 40, 100);
     setAnim(anim, IDLE_ANIMATION, -1, data);
 }
 
@@ -996,772 +827,66 @@ TextElement *updateLifeBarTextElement(TextElement **text_element, int current_li
 }
 
 
-
-
-/* Get the tower and enemy at a specified position */
-bool getEnemyAndTowerAt(Enemy *enemy_list, Tower *tower_list, int collumn, int row, Enemy **enemy, Tower **tower) {
-    /* Getting enemy */
-    while (enemy_list) {
-        if (enemy_list->collumn == collumn && enemy_list->row == row) {
-            break;
-        }
-        enemy_list = enemy_list->next;
-    }
-    if (enemy) *enemy = enemy_list;
-    /* Getting tower */
-    while (tower_list) {
-        if (tower_list->collumn == collumn && tower_list->row == row) {
-            break;
-        }
-        tower_list = tower_list->next;
-    }
-    if (tower) *tower = tower_list;
-    /* Return true if an enemy or tower was found, false otherwise (meaning the space is empty) */
-    return (enemy_list || tower_list);
-}
-
-/* Return if the specified space is empty, if outside of the map return false */
-bool isTileEmpty(Enemy *enemy_list, Tower *tower_list, int collumn, int row) {
-    return !getEnemyAndTowerAt(enemy_list, tower_list, collumn, row, NULL, NULL);
-}
-
-/* Return if the tile is in the map */
-bool doesTileExist(int collumn, int row) {
-    return (1 <= collumn && collumn <= NB_COLLUMNS && 1 <= row && row <= NB_ROWS);
-}
-
-
-
-
-/* Add an enemy to the list of enemies, fail if cannot spawn enemy at specified location or if enemy type is not defined */
-Enemy *addEnemy(Enemy **enemy_list, char enemy_type, int spawn_collumn, int spawn_row, int life_points) {
-    if (!enemy_list) return NULL;
-    /* Can't summon enemies in not existing rows */
-    if (1 > spawn_row || spawn_row > NB_ROWS) return NULL;
-
-    /* Initialize the new enemy */
-    Enemy *new_enemy = malloc(sizeof(Enemy));
-    new_enemy->type = enemy_type;
-    new_enemy->collumn = spawn_collumn;
-    new_enemy->row = spawn_row;
-    new_enemy->next = new_enemy->next_on_row = new_enemy->prev_on_row = NULL;
-    new_enemy->anim = newAnim();
-    new_enemy->life_bar = NULL;
-    /* Match the enemy type to its stats */
+/* Load the sprite of an enemy type */
+SDL_Surface *loadEnemyImg(char enemy_type) {
     switch (enemy_type) {
         case SLIME_ENEMY:
-            new_enemy->max_life_points = new_enemy->life_points = 5;
-            new_enemy->base_speed = new_enemy->speed = 2;
-            new_enemy->sprite = loadImg("enemies/Slime");
-            new_enemy->score_on_kill = 25;
-            break;
+            return loadImg("enemies/Slime");
         case GELLY_ENEMY:
-            new_enemy->max_life_points = new_enemy->life_points = 6;
-            new_enemy->base_speed = new_enemy->speed = 2;
-            new_enemy->sprite = loadImg("enemies/Gelly");
-            new_enemy->score_on_kill = 50;
-            break;
+            return loadImg("enemies/Gelly");
         case GOBLIN_ENEMY:
-            new_enemy->max_life_points = new_enemy->life_points = 10;
-            new_enemy->base_speed = new_enemy->speed = 3;
-            new_enemy->sprite = loadImg("enemies/Goblin");
-            new_enemy->score_on_kill = 75;
-            break;
+            return loadImg("enemies/Goblin");
         case ORC_ENEMY:
-            new_enemy->max_life_points = new_enemy->life_points = 20;
-            new_enemy->base_speed = new_enemy->speed = 1;
-            new_enemy->sprite = loadImg("enemies/Orc");
-            new_enemy->score_on_kill = 150;
-            break;
+            return loadImg("enemies/Orc");
         case NECROMANCER_ENEMY:
-            new_enemy->max_life_points = new_enemy->life_points = 13;
-            new_enemy->base_speed = new_enemy->speed = 1;
-            new_enemy->sprite = loadImg("enemies/necromancer");
-            new_enemy->score_on_kill = 200;
-            break;
+            return loadImg("enemies/necromancer");
         case SKELETON_ENEMY:
-            new_enemy->max_life_points = new_enemy->life_points = 4;
-            new_enemy->base_speed = new_enemy->speed = 3;
-            new_enemy->sprite = loadImg("enemies/skeleton");
-            new_enemy->score_on_kill = 25;
-            break;
+            return loadImg("enemies/skeleton");
         case WITCH_ENEMY:
-            new_enemy->max_life_points = new_enemy->life_points = 7;
-            new_enemy->base_speed = new_enemy->speed = 1;
-            new_enemy->sprite = loadImg("enemies/Witch");
-            new_enemy->score_on_kill = 100;
-            break;
+            return loadImg("enemies/Witch");
         default:  /* Unknown enemy type */
-            printf("[ERROR]    Unknown enemy type '%c'\n", enemy_type);
-            destroyAnim(new_enemy->anim);
-            free(new_enemy);
             return NULL;
     }
-    /* Initialize life bar */
-    
-    /* If health is manualy set */
-    if (!enemy_list) return new_enemy;
-    if (life_points != -1){
-        new_enemy->life_points = life_points;
-    }
-    updateLifeBarTextElement(&new_enemy->life_bar, new_enemy->life_points, new_enemy->max_life_points);
-    /* Add the new enemy to the enemy list */
-    /* If empty then no search is needed */
-    if (!(*enemy_list)) {
-        *enemy_list = new_enemy;
-        return new_enemy;
-    }
-    
-    Enemy *current = *enemy_list;
-    /* Look for the previous and next enemy on the same row as this new enemy */
-    while (true) {
-        if (current->row == new_enemy->row) {
-            /* Enemy located on the same row and in front of this new enemy (to the left) */
-            if (current->collumn < new_enemy->collumn) {
-                if (!new_enemy->prev_on_row || new_enemy->prev_on_row->collumn < current->collumn) new_enemy->prev_on_row = current;
-            }
-            /* Enemy located on the same row and behind this new enemy (to the right) */
-            else if (current->collumn > new_enemy->collumn) {
-                if (!new_enemy->next_on_row || new_enemy->next_on_row->collumn > current->collumn) new_enemy->next_on_row = current;
-            }
-            /* Enemy located on the same exact spot as this new enemy, cannot spawn properly */
-            else {
-                destroyAnim(new_enemy->anim);
-                free(new_enemy);
-                return NULL;
-            }
-        }
-        if (!current->next) break;
-        current = current->next;
-    }
-    /* Add the new enemy to the enemy list */
-    current->next = new_enemy;
-    if (new_enemy->prev_on_row) new_enemy->prev_on_row->next_on_row = new_enemy;
-    if (new_enemy->next_on_row) new_enemy->next_on_row->prev_on_row = new_enemy;
-    return new_enemy;
-}
-
-/* Destroy an enemy and free its allocated memory */
-void destroyEnemy(Enemy *enemy, Enemy **enemy_list) {
-    if (!enemy) return;
-    /* Change pointers of enemies accordingly */
-    if (enemy_list) {
-        if (*enemy_list == enemy) {
-            *enemy_list = enemy->next;
-        }
-        else {
-            Enemy *prev_enemy = *enemy_list;
-            while (prev_enemy && prev_enemy->next != enemy) prev_enemy = prev_enemy->next;
-            if (prev_enemy) prev_enemy->next = enemy->next;
-        }
-    }
-    if (enemy->prev_on_row) enemy->prev_on_row->next_on_row = enemy->next_on_row;
-    if (enemy->next_on_row) enemy->next_on_row->prev_on_row = enemy->prev_on_row;
-    /* Destroy enemy data */
-    if (enemy->sprite) delImg(enemy->sprite);
-    if (enemy->anim) destroyAnim(enemy->anim);
-    if (enemy->life_bar) destroyTextElement(enemy->life_bar, NULL);
-    free(enemy);
-}
-
-/* Get an array containing the first enemy of each row, NULL if there is none on the row */
-Enemy **getFirstEnemyOfAllRows(Enemy *enemy_list) {
-    /* Initializing to NULL */
-    Enemy **first_of_each_row = malloc(NB_ROWS * sizeof(Enemy *));
-    for (int row_nb = 1; row_nb <= NB_ROWS; row_nb++) first_of_each_row[row_nb-1] = NULL;
-    /* Go trough all enemies */
-    Enemy *enemy = enemy_list;
-    while (enemy) {
-        if (!first_of_each_row[enemy->row-1] || first_of_each_row[enemy->row-1]->collumn > enemy->collumn) first_of_each_row[enemy->row-1] = enemy;
-        enemy = enemy->next;
-    }
-    return first_of_each_row;
-}
-
-/* Get the first enemy of a row */
-Enemy *getFirstEnemyInRow(Enemy *enemy_list, int row) {
-    Enemy **first_of_each_row = getFirstEnemyOfAllRows(enemy_list);
-    Enemy *first_of_row = first_of_each_row[row-1];
-    free(first_of_each_row);
-    return first_of_row;
-}
-
-/* Move enemy, return number of tile moved */
-int moveEnemy(Enemy *enemy, Enemy *enemy_list, Tower *tower_list, int delta, char axis) {
-    /* Move on the x axis */
-    if (axis == 'x' || axis == 'X') {
-        /* Colliding with towers and other enemies */
-        for (int i = 0; i < abs(delta); i++) if (!isTileEmpty(enemy_list, tower_list, enemy->collumn + (i+1)*sign(delta), enemy->row)) {
-            delta = i*sign(delta);
-            break;
-        }
-        /* Moving on the x axis */
-        enemy->collumn += delta;
-        return delta;
-    }
-
-    /* Move on the y axis */
-    if (axis == 'y' || axis == 'Y') {
-        /* Colliding with towers and other enemies */
-        for (int i = 0; i < abs(delta); i++) if (!doesTileExist(enemy->collumn, enemy->row + (i+1)*sign(delta)) || !isTileEmpty(enemy_list, tower_list, enemy->collumn, enemy->row + (i+1)*sign(delta))) {
-            delta = i*sign(delta);
-            break;
-        }
-        /* If delta == 0, nothing happens */
-        if (!delta) return 0;
-        /* Updating pointers */
-        if (enemy->next_on_row) enemy->next_on_row->prev_on_row = enemy->prev_on_row;
-        if (enemy->prev_on_row) enemy->prev_on_row->next_on_row = enemy->next_on_row;
-        enemy->prev_on_row = enemy->next_on_row = NULL;
-        enemy->row += delta;
-        /* Moving on the y axis */
-        Enemy *current = enemy_list;
-        while (current) {
-            if (current->row == enemy->row) {
-                /* Enemy located on the same row and in front of this new enemy (to the left) */
-                if (current->collumn < enemy->collumn) {
-                    if (!enemy->prev_on_row || enemy->prev_on_row->collumn < current->collumn) enemy->prev_on_row = current;
-                }
-                /* Enemy located on the same row and behind this new enemy (to the right) */
-                else if (current->collumn > enemy->collumn) {
-                    if (!enemy->next_on_row || enemy->next_on_row->collumn > current->collumn) enemy->next_on_row = current;
-                }
-            }
-            current = current->next;
-        }
-        /* Updating pointers */
-        if (enemy->prev_on_row) enemy->prev_on_row->next_on_row = enemy;
-        if (enemy->next_on_row) enemy->next_on_row->prev_on_row = enemy;
-        return delta;
-    }
-
-    /* Invalid axis */
-    printf("[ERROR]    Can only move an enemy on the 'x' or 'y' axis, not on the '%c' axis\n", axis);
-    return 0;
-}
-
-/* Update all enemies */
-void updateEnemies(Enemy **currently_acting_enemy, Enemy **enemy_list, Tower **tower_list, TextElement **text_element_list) {
-    Enemy *enemy;// = *enemy_list; Enemy *tmp;
-    // while (enemy) {
-    //     /* Destroy enemy when life points are bellow 0 */
-    //     if (enemy->life_points <= 0) {
-    //         tmp = enemy->next;
-    //         destroyEnemy(enemy, enemy_list);
-    //         enemy = tmp;
-    //         continue;
-    //     }
-    //     tower = tower->next;
-    // }
-    while (currently_acting_enemy && *currently_acting_enemy) {
-        /* Wait for previous enemy to finish his attack before attacking */
-        enemy = *enemy_list;
-        while (enemy && enemy->next != *currently_acting_enemy) enemy = enemy->next;
-        if (enemy && enemy->anim && enemy->anim->type == ATTACK_ANIMATION) return;
-        enemyAttack(*currently_acting_enemy, tower_list, enemy_list, text_element_list);
-        *currently_acting_enemy = (*currently_acting_enemy)->next;
-    }
-}
-
-/* Make all enemies move accordingly to their type */
-void makeAllEnemiesMove(Enemy *enemy_list, Tower *tower_list) {
-    /* Update enemies from left to right, from top to bottom */
-    Enemy **first_of_each_row = getFirstEnemyOfAllRows(enemy_list);
-    Enemy *enemy;
-    int delta;
-    /* From top to bottom */
-    for (int row_nb = 1; row_nb <= NB_ROWS; row_nb++) {
-        enemy = first_of_each_row[row_nb-1];
-        /* From left to right */
-        while (enemy) {
-            if (enemy->collumn > NB_COLLUMNS) enemy->speed = 1;
-            delta = moveEnemy(enemy, enemy_list, tower_list, -enemy->speed, 'x');
-            if (delta) {
-                /* If the enemy just spawned in, play a special animation */
-                if (enemy->collumn == NB_COLLUMNS) setAnimSpawn(enemy->anim);
-                /* Default movement animation */
-                else if (enemy->collumn < NB_COLLUMNS) setAnimMove(enemy->anim, delta, 0);
-            }
-            enemy->speed = enemy->base_speed;
-            enemy = enemy->next_on_row;
-        }
-    }
-    /* Free memory */
-    free(first_of_each_row);
 }
 
-/* Make a singular enemy attack */
-void enemyAttack(Enemy *enemy, Tower **tower_list, Enemy **enemy_list, TextElement **text_element_list) {
-    if (!enemy) return;
-    /* Getting tower in front of the enemy (if there is one) */
-    Enemy *e; Tower *tower; bool result;
-    getEnemyAndTowerAt(*enemy_list, *tower_list, enemy->collumn-1, enemy->row, &e, &tower);
-    /* Making enemy act accordingly to its type */
-    result = 0;
-    switch (enemy->type) {
-        case SLIME_ENEMY:
-            if (tower) result = damageTower(tower, 2, tower_list, text_element_list);
-            break;
-        case GELLY_ENEMY:
-            if (tower) result = damageTower(tower, 2, tower_list, text_element_list);
-            break;
-        case GOBLIN_ENEMY:
-            if (tower) result = damageTower(tower, 3, tower_list, text_element_list);
-            break;
-        case ORC_ENEMY:
-            if (tower) result = damageTower(tower, 5, tower_list, text_element_list);
-            break;
-        case NECROMANCER_ENEMY:
-            if (tower) result = damageTower(tower, 4, tower_list,text_element_list);
-            break;
-        case SKELETON_ENEMY:
-            if (tower) result = damageTower(tower, 2, tower_list,text_element_list);
-            break;
-        case WITCH_ENEMY:
-            if (tower) result = damageTower(tower, 2, tower_list,text_element_list);
-            /* Area heal and speed boost (except for self) */
-            for (int y = -1; y <= 1; y++) for (int x = -1; x <= 1; x++) if (x || y) if (getEnemyAndTowerAt(*enemy_list, NULL, enemy->collumn+x, enemy->row+y, &e, NULL)) {
-                /* Heal */
-                if (e->max_life_points != e->life_points) {
-                    addDamageNumber(text_element_list, - min(3, e->max_life_points - e->life_points), e->collumn, e->row);
-                    e->life_points = min(e->life_points+3, e->max_life_points);
-                    updateLifeBarTextElement(&e->life_bar, e->life_points, e->max_life_points);
-                }
-                /* Speed boost */
-                e->speed += 1;
-            }
-            break;
-        default:  /* Unknown enemy type */
-            printf("[ERROR]    Unknown enemy type '%c'\n", enemy->type);
-            destroyEnemy(enemy, enemy_list);
-            break;
-    }
-    if (result) {
-        setAnimAttack(enemy->anim, -1);
-        enemy->speed = 0;
-    }
-}
-
-/* Make all enemies attack */
-void makeAllEnemiesAct(Enemy *enemy_list, Enemy **currently_acting_enemy) {
-    if (!enemy_list) {
-        *currently_acting_enemy = NULL;
-        return;
-    }
-    *currently_acting_enemy = enemy_list;
-}
-
-/* Damage an enemy */
-bool damageEnemy(Enemy *enemy, int amount, Enemy **enemy_list, Tower *tower_list, TextElement **text_element_list, int *score) {
-    if (!enemy || !amount || !enemy_list) return false;
-    int n, x, y;
-
-    /* Check that enemy still exist */
-    Enemy *e = *enemy_list;
-    while (e && e != enemy) e = e->next;
-    if (!e) return false;
-    /* Show damage number */
-    if (text_element_list) addDamageNumber(text_element_list, amount, enemy->collumn, enemy->row);
-    /* Damage enemy */
-    enemy->life_points -= amount;
-    setAnimHurt(enemy->anim);
-    /* Update life bar */
-    updateLifeBarTextElement(&enemy->life_bar, enemy->life_points, enemy->max_life_points);
-    /* Kill enemy if health reaches 0 or less */
-    if (enemy->life_points <= 0) {
-        n = enemy->type; x = enemy->collumn; y = enemy->row;
-        *score += enemy->score_on_kill;
-        destroyEnemy(enemy, enemy_list);
-        /* Gelly splits into 2 slimes on death, one above and one bellow + one at current position or behind if a slime spawn position is blocked */
-        if (n == GELLY_ENEMY) {
-            n = 2;
-            if (n-- && isTileEmpty(*enemy_list, tower_list, x, y - 1) && doesTileExist(x, y - 1) && (e = addEnemy(enemy_list, SLIME_ENEMY, x, y - 1, -1))) setAnimMove(e->anim, 0, -1);
-            else n++;
-            if (n-- && isTileEmpty(*enemy_list, tower_list, x, y + 1) && doesTileExist(x, y + 1) && (e = addEnemy(enemy_list, SLIME_ENEMY, x, y + 1, -1))) setAnimMove(e->anim, 0, +1);
-            else n++;
-            if (n-- && isTileEmpty(*enemy_list, tower_list, x + 1, y) && doesTileExist(x + 1, y) && (e = addEnemy(enemy_list, SLIME_ENEMY, x + 1, y, -1))) setAnimMove(e->anim, +1, 0);
-            else n++;
-            if (n-- && isTileEmpty(*enemy_list, tower_list, x, y) && doesTileExist(x, y) && addEnemy(enemy_list, SLIME_ENEMY, x, y, -1));
-            else n++;
-        }
-        return true;
-    }
-
-    /* Goblin changes row on hit, depending on its hp left */
-    if (enemy->type == GOBLIN_ENEMY) {
-        n = 0;
-        if (enemy->life_points % 2) {
-            n = moveEnemy(enemy, *enemy_list, tower_list, 1, 'y');
-            if (!n) n = moveEnemy(enemy, *enemy_list, tower_list, -1, 'y');
-        }
-        else {
-            n = moveEnemy(enemy, *enemy_list, tower_list, -1, 'y');
-            if (!n) n = moveEnemy(enemy, *enemy_list, tower_list, 1, 'y');
-        }
-        if (n && enemy->anim) setAnimMove(enemy->anim, 0, n);
-    }
-    /* Necromancer summons a skeleton nearby on hit */
-    else if (enemy->type == NECROMANCER_ENEMY) {
-        x = enemy->collumn; y = enemy->row;
-        if (isTileEmpty(*enemy_list, tower_list, x - 1, y) && doesTileExist(x - 1, y) && (e = addEnemy(enemy_list, SKELETON_ENEMY, x - 1, y, -1))) setAnimSpawn(e->anim);
-        else if (isTileEmpty(*enemy_list, tower_list, x, y - 1) && doesTileExist(x, y - 1) && (e = addEnemy(enemy_list, SKELETON_ENEMY, x, y - 1, -1))) setAnimSpawn(e->anim);
-        else if (isTileEmpty(*enemy_list, tower_list, x, y + 1) && doesTileExist(x, y + 1) && (e = addEnemy(enemy_list, SKELETON_ENEMY, x, y + 1, -1))) setAnimSpawn(e->anim);
-        else if (isTileEmpty(*enemy_list, tower_list, x + 1, y) && doesTileExist(x + 1, y) && (e = addEnemy(enemy_list, SKELETON_ENEMY, x + 1, y, -1))) setAnimSpawn(e->anim);
-    }
-    return true;
-}
-
-
-
-
-Tower *addTower(Tower **tower_list, Enemy *enemy_list, char tower_type, int placement_collumn, int placement_row, int life_points) {
-    /* Invalid position (cannot place outside of the map or on the last collumn) */
-    if (1 > placement_row || placement_row > NB_ROWS || 1 > placement_collumn || placement_collumn > NB_COLLUMNS-1) return NULL;
-
-    /* Initialize a new tower object */
-    Tower *new_tower = malloc(sizeof(Tower));
-    new_tower->type = tower_type;
-    new_tower->collumn = placement_collumn;
-    new_tower->row = placement_row;
-    new_tower->attack_cooldown = 1;
-    new_tower->next = NULL;
-    new_tower->anim = newAnim();
-    new_tower->life_bar = NULL;
-    switch (tower_type){
+/* Load the sprite of a tower type */
+SDL_Surface *loadTowerImg(char tower_type) {
+    switch (tower_type) {
         case ARCHER_TOWER:
-            new_tower->max_life_points = new_tower->life_points = 6;
-            new_tower->cost = 50;
-            new_tower->base_attack_cooldown = 1;
-            new_tower->sprite = loadImg("towers/Archer_tower");
-            break;
+            return loadImg("towers/Archer_tower");
         case WALL_TOWER:
-            new_tower->max_life_points = new_tower->life_points = 10;
-            new_tower->cost = 30;
-            new_tower->base_attack_cooldown = 1;
-            new_tower->sprite = loadImg("towers/Empty_tower");
-            break;
+            return loadImg("towers/Empty_tower");
         case BARRACK_TOWER:
-            new_tower->max_life_points = new_tower->life_points = 15;
-            new_tower->cost = 70;
-            new_tower->base_attack_cooldown = 5;
-            new_tower->sprite = loadImg("towers/barracks");
-            break;
+            return loadImg("towers/barracks");
         case SOLIDER_TOWER:
-            new_tower->max_life_points = new_tower->life_points = 4;
-            new_tower->cost = 0;
-            new_tower->base_attack_cooldown = 1;
-            new_tower->sprite = loadImg("towers/Spearman");
-            break;
+            return loadImg("towers/Spearman");
         case CANON_TOWER:
-            new_tower->max_life_points = new_tower->life_points = 4;
-            new_tower->cost = 100;
-            new_tower->base_attack_cooldown = 3;
-            new_tower->sprite = loadImg("towers/canon");
-            break;
+            return loadImg("towers/canon");
         case DESTROYER_TOWER:
-            new_tower->max_life_points = new_tower->life_points = 8;
-            new_tower->cost = 120;
-            new_tower->base_attack_cooldown = 3;
-            new_tower->sprite = loadImg("towers/canon_evolved");
-            break;
+            return loadImg("towers/canon_evolved");
         case SORCERER_TOWER:
-            new_tower->max_life_points = new_tower->life_points = 5;
-            new_tower->cost = 70;
-            new_tower->base_attack_cooldown = 2;
-            new_tower->sprite = loadImg("towers/sorcerer");
-            break;
+            return loadImg("towers/sorcerer");
         case MAGE_TOWER:
-            new_tower->max_life_points = new_tower->life_points = 7;
-            new_tower->cost = 100;
-            new_tower->base_attack_cooldown = 2;
-            new_tower->sprite = loadImg("towers/sorcerer_evolved");
-            break;
-        default:  /* Invalid tower type */
-            printf("[ERROR]    Unknown tower type '%c'\n", tower_type);
-            destroyTower(new_tower, tower_list);
+            return loadImg("towers/sorcerer_evolved");
+        default:  /* Unknown tower type */
             return NULL;
     }
-    /* Initialize life bar */
-    
-
-    /* If health is manually set */
-    if (life_points !=-1){
-        new_tower->life_points = life_points;
-    }
-    updateLifeBarTextElement(&new_tower->life_bar, new_tower->life_points, new_tower->max_life_points);
-    if (!tower_list) return new_tower;
-    /* Add the tower to the list of towers */
-    if (!(*tower_list)) {
-        *tower_list = new_tower;
-        return new_tower;
-    }
-    /* Verify if the creation space is empty, as towers cannot be build on an already occupied space */
-    if (!isTileEmpty(enemy_list, *tower_list, placement_collumn, placement_row)) {
-        destroyTower(new_tower, tower_list);
-        return NULL;
-    }
-    Tower *prev_tower = *tower_list; 
-    while (prev_tower->next != NULL) {
-        prev_tower = prev_tower->next;
-    }
-    prev_tower->next = new_tower;
-    return new_tower;
 }
 
-/* Try to buy a tower */
-Tower *buyTower(Tower **tower_list, Enemy *enemy_list, char tower_type, int placement_collumn, int placement_row, int *funds) {
-    Tower *new_tower;
-    new_tower = addTower(tower_list, enemy_list, tower_type, placement_collumn, placement_row,-1);
-    /* If new_tower is NULL, it means it couldn't be build */
-    if (!new_tower) return NULL;
-    /* Check if the player has enough funds to build the tower */
-    if (*funds < new_tower->cost) {
-        destroyTower(new_tower, tower_list);
-        return NULL;
-    }
-    *funds -= new_tower->cost;
-    /* Play a spawning animation */
-    setAnimSpawn(new_tower->anim);
-    return new_tower;
-}
 
-/* Try to upgrade a tower */
-Tower *upgradeTower(Tower **tower_list, Enemy *enemy_list, char tower_type, int placement_collumn, int placement_row, int *funds) {
-    Tower *old_tower,*new_tower;
-    switch (tower_type){
-        case WALL_TOWER:
-            getEnemyAndTowerAt(NULL, *tower_list, placement_collumn, placement_row, NULL, &old_tower);
-            destroyTower(old_tower, tower_list);
-            new_tower = addTower(tower_list,enemy_list, BARRACK_TOWER, placement_collumn, placement_row,-1);
-            if (*funds < new_tower->cost){
-                destroyTower(new_tower,tower_list);
-                addTower(tower_list, enemy_list, tower_type, placement_collumn, placement_row,-1);
-                return NULL;
-            }
-            *funds -= new_tower->cost;
-            break;
-        case SORCERER_TOWER:
-            getEnemyAndTowerAt(NULL, *tower_list, placement_collumn, placement_row, NULL, &old_tower);
-            destroyTower(old_tower, tower_list);
-            new_tower = addTower(tower_list, enemy_list, MAGE_TOWER, placement_collumn, placement_row,-1);
-            if (*funds < new_tower->cost){
-                destroyTower(new_tower,tower_list);
-                addTower(tower_list, enemy_list, tower_type, placement_collumn, placement_row,-1);
-                return NULL;
-            }
-            *funds -= new_tower->cost;
-            break;
-        case CANON_TOWER:
-            getEnemyAndTowerAt(NULL, *tower_list, placement_collumn, placement_row, NULL, &old_tower);
-            destroyTower(old_tower, tower_list);
-            new_tower = addTower(tower_list, enemy_list, DESTROYER_TOWER, placement_collumn, placement_row,-1);
-            if (*funds < new_tower->cost) {
-                destroyTower(new_tower, tower_list);
-                addTower(tower_list, enemy_list, tower_type, placement_collumn, placement_row,-1);
-                return NULL;
-            }
-            *funds -= new_tower->cost;
-            break;
-        default:
-            printf("No upgrade for that kind of tower");
-            return NULL;
-    }
-    return new_tower;
-}
 
-/* Destroy an tower and free its allocated memory */
-void destroyTower(Tower *tower, Tower **tower_list) {
-    if (!tower) return;
-    /* Change pointers of tower accordingly */
-    if (tower_list) {
-        Tower *prev_tower = *tower_list;
-        if (prev_tower == tower) {
-            *tower_list = tower->next;
-        }
-        else {
-            while (prev_tower && prev_tower->next != tower) prev_tower = prev_tower->next;
-            if (prev_tower) prev_tower->next = tower->next;
-        }
-    }
-    /* Destroy tower data */
-    if (tower->sprite) delImg(tower->sprite);
-    if (tower->anim) destroyAnim(tower->anim);
-    if (tower->life_bar) destroyTextElement(tower->life_bar, NULL);
-    free(tower);
-}
 
-/* Sell the tower and refund its cost (in case of miss click) */
-void sellTower(Tower *tower, Tower **tower_list, int *funds){
-    *funds += tower->cost;
-    destroyTower(tower, tower_list);
-}
-
-/* Make a singular tower act */
-void towerAct(Tower *tower, Tower **tower_list, Enemy *enemy_list, Projectile **projectile_list) {
-    if (!tower || !tower_list) return;
-    int i; Enemy *target; Tower *tmp;
-    /* Can only act when action cooldown reaches 0 or less */
-    tower->attack_cooldown--;
-    if (tower->attack_cooldown <= 0) {
-        switch (tower->type) {
-            case ARCHER_TOWER:
-                /* Attack the firt enemy on the same row at most 9 tiles away */
-                for (i = 1; i <= 9; i++) if (doesTileExist(tower->collumn + i, tower->row) && getEnemyAndTowerAt(enemy_list, NULL, tower->collumn + i, tower->row, &target, NULL)) {
-                    tower->attack_cooldown = tower->base_attack_cooldown;
-                    addProjectile(projectile_list, tower, target);
-                    break;
-                }
-                break;
-            case WALL_TOWER:
-                tower->attack_cooldown = tower->base_attack_cooldown;
-                break;
-            case BARRACK_TOWER:
-                tower->attack_cooldown = tower->base_attack_cooldown;
-                tmp = NULL;
-                if (isTileEmpty(enemy_list, *tower_list, tower->collumn, tower->row - 1) && doesTileExist(tower->collumn, tower->row - 1) && (tmp = addTower(tower_list, enemy_list, SOLIDER_TOWER, tower->collumn, tower->row - 1,-1)));
-                else if (isTileEmpty(enemy_list, *tower_list, tower->collumn, tower->row + 1) && doesTileExist(tower->collumn, tower->row + 1) && (tmp = addTower(tower_list, enemy_list, SOLIDER_TOWER, tower->collumn, tower->row + 1,-1)));
-                else if (isTileEmpty(enemy_list, *tower_list, tower->collumn + 1, tower->row) && doesTileExist(tower->collumn + 1, tower->row) && (tmp = addTower(tower_list, enemy_list, SOLIDER_TOWER, tower->collumn + 1, tower->row,-1)));
-                else if (isTileEmpty(enemy_list, *tower_list, tower->collumn - 1, tower->row) && doesTileExist(tower->collumn- 1, tower->row ) && (tmp = addTower(tower_list, enemy_list, SOLIDER_TOWER, tower->collumn - 1, tower->row,-1)));
-                else tower->attack_cooldown = 1;
-                if (tmp) setAnimMove(tmp->anim, tmp->collumn - tower->collumn, tmp->row - tower->row);
-                break;
-            case SOLIDER_TOWER:
-                /* Attack the firt enemy on the same or adjacent rows at most 2 tiles away */
-                for (i = 1; i <= 2; i++) {
-                    if (
-                        (doesTileExist(tower->collumn + i, tower->row) && getEnemyAndTowerAt(enemy_list, NULL, tower->collumn + i, tower->row, &target, NULL)) ||
-                        (doesTileExist(tower->collumn + i, tower->row - 1) && getEnemyAndTowerAt(enemy_list, NULL, tower->collumn + i, tower->row - 1, &target, NULL)) ||
-                        (doesTileExist(tower->collumn + i, tower->row + 1) && getEnemyAndTowerAt(enemy_list, NULL, tower->collumn + i, tower->row + 1, &target, NULL))
-                    ) {
-                        tower->attack_cooldown = tower->base_attack_cooldown;
-                        addProjectile(projectile_list, tower, target);
-                        break;
-                    }
-                }
-                break;
-            case CANON_TOWER:
-                /* Attack the firt enemy on the same row at most 3 tiles away */
-                for (i = 1; i <= 3; i++) if (doesTileExist(tower->collumn + i, tower->row) && getEnemyAndTowerAt(enemy_list, NULL, tower->collumn + i, tower->row, &target, NULL)) {
-                    tower->attack_cooldown = tower->base_attack_cooldown;
-                    addProjectile(projectile_list, tower, target);
-                    break;
-                }
-                break;
-            case DESTROYER_TOWER:
-                /* Attack the firt enemy on the same row at most 4 tiles away */
-                for (i = 1; i <= 4; i++) if (doesTileExist(tower->collumn + i, tower->row) && getEnemyAndTowerAt(enemy_list, NULL, tower->collumn + i, tower->row, &target, NULL)) {
-                    tower->attack_cooldown = tower->base_attack_cooldown;
-                    addProjectile(projectile_list, tower, target);
-                    break;
-                }
-                break;
-            case SORCERER_TOWER:
-                /* Attack the firt enemy on the same row at most 7 tiles away */
-                for (i = 1; i <= 7; i++) if (doesTileExist(tower->collumn + i, tower->row) && getEnemyAndTowerAt(enemy_list, NULL, tower->collumn + i, tower->row, &target, NULL)) {
-                    tower->attack_cooldown = tower->base_attack_cooldown;
-                    addProjectile(projectile_list, tower, target);
-                    break;
-                }
-                break;
-            case MAGE_TOWER:
-                /* Attack the firt enemy on the same row and on the adjacent rows at most 7 tiles away */
-                for (i = 1; i <= 7; i++) if (doesTileExist(tower->collumn + i, tower->row) && getEnemyAndTowerAt(enemy_list, NULL, tower->collumn + i, tower->row, &target, NULL)) {
-                    tower->attack_cooldown = tower->base_attack_cooldown;
-                    addProjectile(projectile_list, tower, target);
-                    break;
-                }
-                for (i = 1; i <= 7; i++) if (doesTileExist(tower->collumn + i, tower->row - 1) && getEnemyAndTowerAt(enemy_list, NULL, tower->collumn + i, tower->row - 1, &target, NULL)) {
-                    tower->attack_cooldown = tower->base_attack_cooldown;
-                    addProjectile(projectile_list, tower, target);
-                    break;
-                }
-                for (i = 1; i <= 7; i++) if (doesTileExist(tower->collumn + i, tower->row + 1) && getEnemyAndTowerAt(enemy_list, NULL, tower->collumn + i, tower->row + 1, &target, NULL)) {
-                    tower->attack_cooldown = tower->base_attack_cooldown;
-                    addProjectile(projectile_list, tower, target);
-                    break;
-                }
-                break;
-            default:  /* Invalid tower type */
-                printf("[ERROR]    Unknown tower type '%c'\n", tower->type);
-                break;
-        }
-    }
-}
-
-/* Update all towers */
-void updateTowers(Tower **currently_acting_tower, Tower **tower_list, Enemy *enemy_list, Projectile **projectile_list) {
-    // Tower *tower = *tower_list; Tower *tmp;
-    // while (tower) {
-    //     /* Destroy tower when life points are bellow 0 */
-    //     if (tower->live_points <= 0) {
-    //         tmp = tower->next;
-    //         destroyTower(tower, tower_list);
-    //         tower = tmp;
-    //         continue;
-    //     }
-    //     tower = tower->next;
-    // }
-    Enemy *e; Tower *t;
-    while (currently_acting_tower && *currently_acting_tower && projectile_list && !(*projectile_list)) {
-        e = enemy_list;
-        while (e) {
-            if (e->anim && e->anim->type != IDLE_ANIMATION) return;
-            e = e->next;
-        }
-        t = *tower_list;
-        while (t) {
-            if (t->anim && t->anim->type != IDLE_ANIMATION) return;
-            t = t->next;
-        }
-        towerAct(*currently_acting_tower, tower_list, enemy_list, projectile_list);
-        *currently_acting_tower = (*currently_acting_tower)->next;
-    }
-}
-
-/* Make all tower act */
-void makeAllTowersAct(Tower *tower_list, Tower **currently_acting_tower) {
-    if (!tower_list) {
-        *currently_acting_tower = NULL;
-        return;
-    }
-    *currently_acting_tower = tower_list;
-}
-
-/* Damage a tower */
-bool damageTower(Tower *tower, int amount, Tower **tower_list, TextElement **text_element_list) {
-    if (!tower || !amount || !tower_list) return false;
-    /* Check that tower still exist */
-    Tower *t = *tower_list;
-    while (t && t != tower) t = t->next;
-    if (!t) return false;
-    /* Show damage number */
-    if (text_element_list) addDamageNumber(text_element_list, amount, tower->collumn, tower->row);
-    /* Damage tower */
-    tower->life_points -= amount;
-    setAnimHurt(tower->anim);
-    /* Update life bar */
-    updateLifeBarTextElement(&tower->life_bar, tower->life_points, tower->max_life_points);
-    /* Kill tower if health reaches 0 or less */
-    if (tower->life_points <= 0) destroyTower(tower, tower_list);
-    return true;
-}
-
-
-
-
-/* Create and add a projectile to the projectile list */
-Projectile *addProjectile(Projectile **projectile_list, Tower *origin, Enemy *target) {
-    if (!projectile_list || !origin || !target) return NULL;
+/* Create and add a projectile to the projectile list, shot by a tower type from tile (x1 y1) to tile (x2 y2) */
+Projectile *addProjectile(Projectile **projectile_list, char tower_type, int x1, int y1, int x2, int y2) {
+    if (!projectile_list) return NULL;
 
     /* Initialize a new projectile object */
     Projectile *new_projectile = malloc(sizeof(Projectile));
-    new_projectile->origin = origin;
-    new_projectile->target = target;
     new_projectile->next = NULL;
     new_projectile->sprite = NULL;
     new_projectile->anim = newAnim();
     double projectile_speed;
-    switch (origin->type){
+    switch (tower_type){
         /* Shoot by a level 1 archer tower */
         case ARCHER_TOWER:
             new_projectile->sprite = loadImg("projectiles/arrow");
@@ -1788,11 +913,11 @@ Projectile *addProjectile(Projectile **projectile_list, Tower *origin, Enemy *ta
             projectile_speed = 10.0;
             break;
         default:  /* Shoot by a tower of unknown type */
-            printf("[ERROR]    Unknown tower type '%c'\n", origin->type);
+            printf("[ERROR]    Unknown tower type '%c'\n", tower_type);
             destroyProjectile(new_projectile, projectile_list);
             return NULL;
     }
-    setAnimProjectile(new_projectile->anim, origin->collumn, origin->row, target->collumn, target->row, projectile_speed);
+    setAnimProjectile(new_projectile->anim, x1, y1, x2, y2, projectile_speed);
 
     /* Add the projectile to the list of projectiles */
     if (!(*projectile_list)) {
@@ -1827,60 +952,16 @@ void destroyProjectile(Projectile *projectile, Projectile **projectile_list) {
 
 /* Return if the projectile has visualy reached it's target */
 bool hasProjectileReachedTarget(Projectile *projectile) {
-    return (!projectile || !projectile->anim || projectile->anim->type != PROJECTILE_ANIMATION);
+    return (!projectile || isAnimOver(projectile->anim));
 }
 
-/* Update all projectiles */
-void updateProjectiles(Projectile **projectile_list, Enemy **enemy_list, Tower *tower_list, TextElement **text_element_list,int *score) {
+/* Remove projectiles that have visualy reached their target */
+void updateProjectiles(Projectile **projectile_list) {
     Projectile *projectile = *projectile_list; Projectile *tmp;
-    Enemy *enemy;
-    bool result;
     while (projectile) {
-        /* On target reached */
-        if (hasProjectileReachedTarget(projectile)) {
-            /* Apply projectile effects */
-            switch (projectile->origin->type) {
-                case ARCHER_TOWER:
-                    damageEnemy(projectile->target, 2, enemy_list, tower_list,text_element_list,score);
-                    break;
-                case WALL_TOWER:
-                    break;
-                case BARRACK_TOWER:
-                    break;
-                case SOLIDER_TOWER:
-                    damageEnemy(projectile->target, 2, enemy_list,tower_list, text_element_list, score);
-                    break;
-                case CANON_TOWER:
-                    damageEnemy(projectile->target, 9, enemy_list, tower_list, text_element_list, score);
-                    break;
-                case DESTROYER_TOWER:
-                    damageEnemy(projectile->target, 10, enemy_list, tower_list, text_element_list, score);
-                    /* Area damage */
-                    for (int dy = -1; dy <= 1; dy++) for (int dx = -1; dx <= 1; dx++) if (dx || dy)
-                        if (doesTileExist(projectile->target->collumn + dx, projectile->target->row + dy) && getEnemyAndTowerAt(*enemy_list, NULL, projectile->target->collumn + dx, projectile->target->row + dy, &enemy, NULL))
-                            damageEnemy(enemy, 4, enemy_list, tower_list, text_element_list, score);
-                    break;
-                case SORCERER_TOWER:
-                    result = damageEnemy(projectile->target, 3, enemy_list, tower_list, text_element_list, score);
-                    /* Enemy slowdown on hit */
-                    if (result && projectile->target) projectile->target->speed = min(max(projectile->target->speed - 1, 1), projectile->target->speed);
-                    break;
-                case MAGE_TOWER:
-                    result = damageEnemy(projectile->target, 3, enemy_list, tower_list, text_element_list, score);
-                    /* Enemy slowdown on hit */
-                    if (result && projectile->target) projectile->target->speed = min(max(projectile->target->speed - 1, 1), projectile->target->speed);
-                    break;
-                default:  /* Invalid tower type */
-                    printf("[ERROR]    Unknown tower type '%c'\n", projectile->origin->type);
-                    break;
-            }
-            /* Delete projectile */
-            tmp = projectile->next;
-            destroyProjectile(projectile, projectile_list);
-            projectile = tmp;
-            continue;
-        }
-        projectile = projectile->next;
+        tmp = projectile->next;
+        if (hasProjectileReachedTarget(projectile)) destroyProjectile(projectile, projectile_list);
+        projectile = tmp;
     }
 }
 
@@ -1892,559 +973,340 @@ void drawProjectiles(SDL_Renderer *rend, Projectile *projectile_list) {
     }
 }
 
-
-void saveScore(const char *current_nickname, int current_score, char *level_name) {
-    char *partial_path = concatString("../assets/scores/", level_name);
-    char *full_path = concatString(partial_path, ".txt");
-    FILE *file = fopen(full_path, "r");
-    free(partial_path);
-    /* Reading scoreboard file (if there is one) */
-    char **values; int nb_values, nb_score_entry = 0;
-    Scoreboard game_scoreboard[MAX_SIZE_SCORE_FILE]; Scoreboard temp;
-    if (file) {
-        while (readLine(file, &values, &nb_values)) {
-            game_scoreboard[nb_score_entry].nickname = duplicateString(values[0]);
-            game_scoreboard[nb_score_entry].score = stringToInt(values[1]);
-            nb_score_entry++;
-            /* Free memory */
-            for (int j = nb_values; j > 0; j--) free(values[j-1]);
-            free(values);
-        }
-        fclose(file);
-    }
-    /* Add the new player at the end of the scoreboard struct before sorting the array */
-    game_scoreboard[nb_score_entry].nickname = duplicateString(current_nickname);
-    game_scoreboard[nb_score_entry].score = current_score;
-    nb_score_entry++;
-    /* Sort the array using the selection sort */
-    for (int x = 0; x < nb_score_entry; x++) {
-        temp = game_scoreboard[x];
-        int y = x-1;
-        while (y >= 0 && temp.score > game_scoreboard[y].score){
-            game_scoreboard[y+1] = game_scoreboard[y];
-            y--;
-        }
-        game_scoreboard[y+1] = temp;
-    }
-    /* Re-write first 5 scores in scoreboard file */
-    file = fopen(full_path, "w");
-    if (!file) printf("[ERROR]    Cannot open scoreboard file at \"%s\"\n", full_path);
-    else {
-        for (int j = 0; j < min(nb_score_entry, 5); j++) fprintf(file,"%s %d\n", game_scoreboard[j].nickname, game_scoreboard[j].score);
-        for (int j = nb_score_entry; j > 0; j--) free(game_scoreboard[j-1].nickname);
-        fclose(file);
-    }
-    free(full_path);
-}
-
-/* Create a new game */
-Game *createNewGame(char *level_name) {
-    /* Initialize the new game object */
-    Game *new_game = malloc(sizeof(Game));
-    new_game->waves = NULL;
-    new_game->nb_waves = 0;
-    new_game->current_wave_nb = 0;
-    new_game->tower_list = NULL;
-    new_game->currently_acting_tower = NULL;
-    new_game->enemy_list = NULL;
-    new_game->currently_acting_enemy = NULL;
-    new_game->projectile_list = NULL;
-    new_game->text_element_list = NULL;
-    new_game->funds = 0;
-    new_game->score = 0;
-    new_game->turn_nb = 0;
-    new_game->game_phase = PRE_WAVE_PHASE;
-    new_game->level_name = duplicateString(level_name);
-    /* Load the waves */
-    if (!strcmp(level_name, SURVIVAL_MODE)) {
-        /* Survival mode pre-wave, no enemies, only income */
-        new_game->waves = malloc(sizeof(Wave *));
-        new_game->waves[0] = newWave(2025, NULL);
-        new_game->current_wave_nb = new_game->nb_waves = -1;
-    }
-    else {
-        /* Load waves based on level file */
-        loadLevel(level_name, &new_game->waves, &new_game->nb_waves);
-    }
-    /* Load initial wave */
-    if (new_game->nb_waves) loadNextWave(new_game);
-    return new_game;
-}
-
-/* Load a game from a save file */
-Game *loadGameFromSave(char *save_file){
-    /* Openning text file */
-    char *partial_path = concatString("../assets/saves/", save_file);
-    char *full_path = concatString(partial_path, ".txt");
-    FILE *file = fopen(full_path, "r");
-    free(partial_path);
-    /* Checking if file was open successfully */
-    if (!file) {
-        printf("Save file at \"%s\" not found, creating new save file for player %s\n", full_path, save_file);
-        free(full_path);
-        return NULL;
-    }
-    Game *new_game = NULL;
-    /* Retrieve all informations from the file */
-    char **values; int nb_values;
-    while (readLine(file, &values, &nb_values)) {
-        if (nb_values == 5) {
-            /* Header line */
-            if (!new_game) {
-                new_game = createNewGame(values[0]);
-                new_game->current_wave_nb = stringToInt(values[1]);
-                new_game->funds = stringToInt(values[2]);
-                new_game->score = stringToInt(values[3]);
-                new_game->game_phase = (stringToInt(values[4]) ? PRE_WAVE_PHASE : WAITING_FOR_USER_PHASE);
-                /* Remove any enemy loaded with the level, as they will instead be loaded from this save file and not from the level file */
-                while (new_game->enemy_list) destroyEnemy(new_game->enemy_list, &new_game->enemy_list);
-                continue;
-            }
-            /* Enemy or torwer to add */
-            else {
-                if (values[0][0] == 'E') addEnemy(&new_game->enemy_list, values[1][0], stringToInt(values[3]), stringToInt(values[2]), stringToInt(values[4]));
-                else if (values[0][0] == 'T') addTower(&new_game->tower_list,new_game->enemy_list, values[1][0], stringToInt(values[3]), stringToInt(values[2]), stringToInt(values[4]));
-            }
-            /* Free memory */
-            for (int i = nb_values; i > 0; i--) free(values[i-1]);
-            free(values);
-        }
-        else if (nb_values) {
-            printf("[ERROR]    Invalid syntax for level file \"%s\"\n", full_path);
-            free(full_path);
-            for (int i = 0; i < nb_values; i++) free(values[i]);
-            free(values);
-            fclose(file);
-            return NULL;
-        }
-    }
-    free(full_path);
-    fclose(file);
-    return new_game;
-}
-
-/* Load next wave, return true if successfull */
-bool loadNextWave(Game *game) {
-    if (game->current_wave_nb >= game->nb_waves && game->nb_waves >= 0) return false;
-    int wave_nb = max(game->current_wave_nb, 0);
-    game->current_wave_nb++;
-    /* Destroy any remaining enemy and load new wave */
-    while (game->enemy_list) destroyEnemy(game->enemy_list, &game->enemy_list);
-    game->enemy_list = game->waves[wave_nb]->enemy_list;
-    /* Give wave income */
-    game->funds += game->waves[wave_nb]->income;
-    /* Reset game phase */
-    game->game_phase = PRE_WAVE_PHASE;
-    return true;
-}
-
-/* Launch next wave */
-void startNextWave(Game *game) {
-    game->game_phase = TOWERS_ATTACKING_PHASE;
-}
-
-/* Update game */
-void updateGame(Game *game, const char *nickname) {
-    bool condition; Enemy *enemy; Tower *tower;
-    /* Update game phase */
-    switch (game->game_phase) {
-        case WAITING_FOR_USER_PHASE:
-            break;
-        case PRE_WAVE_PHASE:
-            
-            saveGame(nickname, game);
-            break;
-        case ENEMIES_MOVING_PHASE:
-            /* Change phase when all enemies have finished moving and gone back to their idle animation */
-            condition = true; enemy = game->enemy_list;
-            while (enemy && condition) {
-                if (enemy->anim && enemy->anim->type != IDLE_ANIMATION) condition = false;
-                enemy = enemy->next;
-            }
-            /* Change phase */
-            if (condition) {
-                game->game_phase = TOWERS_ATTACKING_PHASE;
-                makeAllTowersAct(game->tower_list, &game->currently_acting_tower);
-                game->currently_acting_tower = game->tower_list;
-            }
-            break;
-        case TOWERS_ATTACKING_PHASE:
-            /* Change phase when towers have attacked, no projectiles are left and all enemies have stoped gone back to their idle animation */
-            condition = true; enemy = game->enemy_list;
-            while (enemy && condition) {
-                if (enemy->anim && enemy->anim->type != IDLE_ANIMATION) condition = false;
-                
-                enemy = enemy->next;
-            }
-            /* Change phase */
-            if (!game->currently_acting_tower && !game->projectile_list && condition) {
-                /* Save game (turn ending) */
-                saveGame(nickname, game);
-                game->game_phase = ENEMIES_ATTACKING_PHASE;
-                makeAllEnemiesAct(game->enemy_list, &game->currently_acting_enemy);
-            }
-            break;
-        case ENEMIES_ATTACKING_PHASE:
-            /* Change phase when enemies have finished attacking and gone back to their idle animation, same for the towers */
-            condition = true; enemy = game->enemy_list; tower = game->tower_list;
-            while (enemy && condition) {
-                if (enemy->anim && enemy->anim->type != IDLE_ANIMATION) condition = false;
-                enemy = enemy->next;
-            }
-            while (tower && condition) {
-                if (tower->anim && tower->anim->type != IDLE_ANIMATION) condition = false;
-                tower = tower->next;
-            }
-            /* Change phase */
-            if (!game->currently_acting_enemy && condition) {
-                game->game_phase = ENEMIES_MOVING_PHASE;
-                makeAllEnemiesMove(game->enemy_list, game->tower_list);
-            }
-            break;
-        case VICTORY_PHASE:
-            break;
-        case DEFEAT_PHASE:
-            break;
-        default:
-            break;
-    }
-    /* On wave defeated */
-    if (!game->enemy_list && game->game_phase != PRE_WAVE_PHASE) {
-        /* If currently on survival mode */
-        if (!strcmp(game->level_name, SURVIVAL_MODE)) beguinNewSurvivalWave(game);
-        /* If defeated a wave */
-        else if (game->current_wave_nb < game->nb_waves) {
-            /* Gain interest on money saved each wave */
-            game->funds *= 1.2;
-            loadNextWave(game);
-        }
-        /* If defeated last wave (victory) */
-        else if (game->game_phase != VICTORY_PHASE) {
-            game->game_phase = VICTORY_PHASE;
-            /* 1G = 1 point */
-            game->score += game->funds;
-            /* Save score */
-            saveScore(nickname, game->score, game->level_name);
-            /* Delete save file */
-            deleteSaveFile(nickname);
+/* Resolve as many turns of the current wave as the time budget (in ms) allows, without logging anything to animate */
+/* Return the number of turns resolved, the wave stops being fast forwarded once it is over */
+int fastForwardGame(Game *game, const char *nickname, Uint64 time_budget) {
+    Uint64 start_tick = SDL_GetTicks64();
+    EventLog *event_log = game->event_log;
+    int nb_turns = 0, turn_nb;
+    /* Events of the turn being animated are skipped */
+    clearEventLog(event_log);
+    game->event_log = NULL;
+    while (game->game_phase == WAVE_PHASE && SDL_GetTicks64() - start_tick < time_budget) {
+        turn_nb = game->turn_nb;
+        updateGame(game, nickname);
+        nb_turns += game->turn_nb - turn_nb;
+    }
+    game->event_log = event_log;
+    return nb_turns;
+}
+
+
+
+
+/* Create a predictor and start its worker thread */
+Predictor *newPredictor() {
+    Predictor *predictor = malloc(sizeof(Predictor));
+    predictor->mutex = SDL_CreateMutex();
+    predictor->cond = SDL_CreateCond();
+    predictor->running = true;
+    predictor->pending = NULL;
+    atomic_init(&predictor->generation, 0);
+    predictor->prediction_generation = -1;
+    predictor->thread = SDL_CreateThread(predictorMain, "predictor", predictor);
+    return predictor;
+}
+
+/* Stop the worker thread of a predictor (cancelling the prediction running) and free its allocated memory */
+void destroyPredictor(Predictor *predictor) {
+    if (!predictor) return;
+    SDL_LockMutex(predictor->mutex);
+    predictor->running = false;
+    atomic_fetch_add(&predictor->generation, 1);
+    SDL_CondSignal(predictor->cond);
+    SDL_UnlockMutex(predictor->mutex);
+    SDL_WaitThread(predictor->thread, NULL);
+    if (predictor->pending) destroyGame(predictor->pending);
+    SDL_DestroyCond(predictor->cond);
+    SDL_DestroyMutex(predictor->mutex);
+    free(predictor);
+}
+
+/* Worker thread of a predictor, simulate the last game requested until asked to stop */
+int predictorMain(void *data) {
+    Predictor *predictor = data;
+    WavePrediction prediction; Game *game; int generation; bool done;
+    SDL_LockMutex(predictor->mutex);
+    while (predictor->running) {
+        if (!predictor->pending) {
+            SDL_CondWait(predictor->cond, predictor->mutex);
+            continue;
         }
-    }
-
-    /* Defeat condition (an enemy has reached the castle) */
-    enemy = game->enemy_list;
-    if (game->game_phase != DEFEAT_PHASE) while (enemy) {
-        if (enemy->collumn <= 0) {
-            game->game_phase = DEFEAT_PHASE;
-            /* Save score */
-            saveScore(nickname, game->score, game->level_name);
-            /* Delete save file */
-            deleteSaveFile(nickname);
-            break;
+        game = predictor->pending;
+        predictor->pending = NULL;
+        generation = atomic_load(&predictor->generation);
+        /* The wave is simulated without holding the lock, so that new requests can cancel it */
+        SDL_UnlockMutex(predictor->mutex);
+        done = predictWave(game, &prediction, &predictor->generation, generation);
+        destroyGame(game);
+        SDL_LockMutex(predictor->mutex);
+        if (done && generation == atomic_load(&predictor->generation)) {
+            predictor->prediction = prediction;
+            predictor->prediction_generation = generation;
         }
-        enemy = enemy->next;
     }
-
-    /* Update all game entities */
-    updateProjectiles(&game->projectile_list, &game->enemy_list, game->tower_list, &game->text_element_list, &game->score);
-    updateEnemies(&game->currently_acting_enemy, &game->enemy_list, &game->tower_list, &game->text_element_list);
-    updateTowers(&game->currently_acting_tower, &game->tower_list, game->enemy_list, &game->projectile_list);
-}
-
-/* Destroy a game structure and free its allocated memory */
-void destroyGame(Game *game) {
-    /* Destroy all enemies */
-    while (game->enemy_list) destroyEnemy(game->enemy_list, &game->enemy_list);
-    /* Destroy all towers */
-    while (game->tower_list) destroyTower(game->tower_list, &game->tower_list);
-    /* Destroy all projectiles */
-    while (game->projectile_list) destroyProjectile(game->projectile_list, &game->projectile_list);
-    /* Destroy all text elements (damage numbers) */
-    while (game->text_element_list) destroyTextElement(game->text_element_list, &game->text_element_list);
-    /* Destroy all waves */
-    destroyWaveList(game->waves, game->nb_waves);
-    /* Destroy game object */
-    if (game->level_name) free(game->level_name);
-    free(game);
+    SDL_UnlockMutex(predictor->mutex);
+    return 0;
 }
 
-/* Launch a new random wave of enemy for survival mode */
-void beguinNewSurvivalWave(Game *game) {
-    if (!game) return;
-
-    /* Delete the old wave */
-    while (game->enemy_list) destroyEnemy(game->enemy_list, &game->enemy_list);
-    destroyWaveList(game->waves, game->nb_waves);
-
-    /* Build the new survival wave */
-    /* Wave power determine how strong are the wave enemies and how numerous they are */
-    int wave_power = 1000 + power(game->current_wave_nb, 2) * 250;
-    /* Initialize new wave object */
-    Wave *new_wave = newWave(0, NULL);
-    /* Add enemies to the wave */
-    char enemy_type; int collumn, row; int nb_enemy = 0;
-    while (wave_power > 0) {
-        nb_enemy++;
-        /* Chose enemy type */
-        /* Add a necromancer enemy */
-        if (roll(1.0 - 20000.0/(20000.0 + wave_power))) {
-            enemy_type = NECROMANCER_ENEMY;
-            wave_power -= 400;
-        }
-        /* Add an orc enemy */
-        else if (roll(1.0 - 10000.0/(10000.0 + wave_power))) {
-            enemy_type = ORC_ENEMY;
-            wave_power -= 300;
-        }
-        /* Add a witch enemy */
-        else if (roll(1.0 - 5000.0/(5000.0 + wave_power))) {
-            enemy_type = WITCH_ENEMY;
-            wave_power -= 200;
-        }
-        /* Add a goblin enemy */
-        else if (roll(1.0 - 2500.0/(2500.0 + wave_power))) {
-            enemy_type = GOBLIN_ENEMY;
-            wave_power -= 150;
-        }
-        /* Add a gelly enemy */
-        else if (roll(1.0 - 1000.0/(1000.0 + wave_power))) {
-            enemy_type = GELLY_ENEMY;
-            wave_power -= 100;
-        }
-        /* Add a slime enemy */
+/* Predict the upcoming wave of a game in the background, cancelling any older prediction */
+void requestPrediction(Predictor *predictor, Game *game) {
+    Game *clone = cloneGame(game);
+    SDL_LockMutex(predictor->mutex);
+    atomic_fetch_add(&predictor->generation, 1);
+    if (predictor->pending) destroyGame(predictor->pending);
+    predictor->pending = clone;
+    SDL_CondSignal(predictor->cond);
+    SDL_UnlockMutex(predictor->mutex);
+}
+
+/* Return a hash of the defences of a game (towers, funds and wave), it changes whenever the player builds something */
+unsigned int hashLayout(Game *game) {
+    unsigned int hash = 2166136261u ^ game->funds ^ (game->current_wave_nb << 20);
+    for (Tower *tower = game->tower_list; tower; tower = tower->next) hash = (hash ^ (tower->type << 16 | tower->collumn << 8 | tower->row)) * 16777619u;
+    return hash;
+}
+
+/* Copy the prediction of the last game requested, return its generation (-1 if it is not done yet) */
+int getPrediction(Predictor *predictor, WavePrediction *prediction) {
+    int generation = -1;
+    SDL_LockMutex(predictor->mutex);
+    if (predictor->prediction_generation == atomic_load(&predictor->generation)) {
+        *prediction = predictor->prediction;
+        generation = predictor->prediction_generation;
+    }
+    SDL_UnlockMutex(predictor->mutex);
+    return generation;
+}
+
+
+
+/* Create a new empty scene, sprites are loaded when first needed */
+Scene *newScene() {
+    Scene *scene = malloc(sizeof(Scene));
+    scene->visual_list = NULL;
+    scene->projectile_list = NULL;
+    scene->text_element_list = NULL;
+    for (int i = 0; i < 128; i++) scene->enemy_sprites[i] = scene->tower_sprites[i] = NULL;
+    return scene;
+}
+
+/* Destroy a scene and free its allocated memory */
+void destroyScene(Scene *scene) {
+    if (!scene) return;
+    while (scene->visual_list) destroyVisual(scene->visual_list, &scene->visual_list);
+    while (scene->projectile_list) destroyProjectile(scene->projectile_list, &scene->projectile_list);
+    while (scene->text_element_list) destroyTextElement(scene->text_element_list, &scene->text_element_list);
+    for (int i = 0; i < 128; i++) {
+        delImg(scene->enemy_sprites[i]);
+        delImg(scene->tower_sprites[i]);
+    }
+    free(scene);
+}
+
+/* Create and add the visual of an enemy or a tower to the scene */
+Visual *addVisual(Scene *scene, int id, bool is_tower, char type, int collumn, int row, int life_points, int max_life_points) {
+    if (!scene) return NULL;
+    Visual *new_visual = malloc(sizeof(Visual));
+    new_visual->id = id;
+    new_visual->is_tower = is_tower;
+    new_visual->type = type;
+    new_visual->collumn = collumn;
+    new_visual->row = row;
+    new_visual->life_points = life_points;
+    new_visual->max_life_points = max_life_points;
+    new_visual->anim = newAnim();
+    new_visual->life_bar = NULL;
+    new_visual->next = NULL;
+    updateLifeBarTextElement(&new_visual->life_bar, life_points, max_life_points);
+    /* Add the visual at the end of the list */
+    if (!scene->visual_list) {
+        scene->visual_list = new_visual;
+        return new_visual;
+    }
+    Visual *prev_visual = scene->visual_list;
+    while (prev_visual->next) prev_visual = prev_visual->next;
+    prev_visual->next = new_visual;
+    return new_visual;
+}
+
+/* Remove a visual from the visual list */
+void destroyVisual(Visual *visual, Visual **visual_list) {
+    if (!visual) return;
+    /* Modify pointers */
+    if (visual_list) {
+        if (*visual_list == visual) *visual_list = visual->next;
         else {
-            enemy_type = SLIME_ENEMY;
-            wave_power -= 50;
-        }
-        /* Chose enemy position */
-        collumn = randrange(0, nb_enemy/2) + NB_COLLUMNS + 1;
-        row = randrange(0, NB_ROWS) + 1;
-        /* Check if tile is free for the enemy to spawn, otherwise try another position further right */
-        while (!isTileEmpty(new_wave->enemy_list, NULL, collumn, row)) {
-            collumn += randrange(0, 3) + 1;
-            row = randrange(0, NB_ROWS) + 1;
+            Visual *current = *visual_list;
+            while (current && current->next != visual) current = current->next;
+            if (current) current->next = visual->next;
         }
-        /* Add the enemy to the wave */
-        addEnemy(&new_wave->enemy_list, enemy_type, collumn, row, -1);
     }
-
-    /* Launch the new survival wave */
-    int wave_nb = game->current_wave_nb;
-    game->waves = malloc(sizeof(Wave *));
-    game->waves[0] = new_wave;
-    game->current_wave_nb = 0;
-    game->nb_waves = 1;
-    loadNextWave(game);
-    game->nb_waves = -1;
-    game->current_wave_nb = wave_nb + 1;
-    startNextWave(game);
+    /* Free memory */
+    if (visual->anim) destroyAnim(visual->anim);
+    if (visual->life_bar) destroyTextElement(visual->life_bar, NULL);
+    free(visual);
 }
 
-
-
-
-/* Initialize new wave object */
-Wave *newWave(int income, Enemy *enemy_list) {
-    Wave *new_wave = malloc(sizeof(Wave));
-    new_wave->income = income;
-    new_wave->enemy_list = enemy_list;
-    return new_wave;
+/* Get the visual of the enemy or tower with the given identifier, NULL if there is none */
+Visual *getVisual(Visual *visual_list, int id) {
+    while (visual_list && visual_list->id != id) visual_list = visual_list->next;
+    return visual_list;
 }
 
-/* Initialize new wave object */
-void destroyWaveList(Wave **wave_list, int nb_wave) {
-    if (!wave_list) return;
-    for (int i = nb_wave; i > 0; i--) free(wave_list[i-1]);
-    free(wave_list);
+/* Change the life points shown by a visual, its life bar is only regenerated when they changed */
+void setVisualLifePoints(Visual *visual, int life_points, int max_life_points) {
+    if (!visual || (visual->life_points == life_points && visual->max_life_points == max_life_points)) return;
+    visual->life_points = life_points;
+    visual->max_life_points = max_life_points;
+    updateLifeBarTextElement(&visual->life_bar, life_points, max_life_points);
 }
 
-
-
-
-/* Return if the caracter is considered to be a whitespace */
-bool isWhitespace(char c) {
-    return (!c) || (c == ' ') || (c == '\n') || (c == '\r') || (c == '\t');
+/* Get the sprite of a visual, sprites are only loaded once per enemy or tower type */
+SDL_Surface *getVisualSprite(Scene *scene, Visual *visual) {
+    SDL_Surface **sprites = (visual->is_tower ? scene->tower_sprites : scene->enemy_sprites);
+    if (!sprites[(int) visual->type]) sprites[(int) visual->type] = (visual->is_tower ? loadTowerImg(visual->type) : loadEnemyImg(visual->type));
+    return sprites[(int) visual->type];
 }
 
-/* Read a singular value on a line, move line pointer after the value read */
-bool readValue(char **line, char **value) {
-    if (!line || !(*line)) return false;
-    /* Get to the first value of the line, ignore all whitespaces before it */
-    while (**line && isWhitespace(**line)) (*line)++;
-    char *start = *line;
-    /* Find the end of the word */
-    while (!isWhitespace(**line)) (*line)++;
-    /* If the value read is an empty string, it means that the line does not contain any value */
-    if (start == *line) return NULL;
-    /* Copy the value read into the value variable */
-    *value = malloc((*line - start + 1) * sizeof(char));
-    char c = **line;
-    **line = '\0';
-    strcpy(*value, start);
-    **line = c;
-    return true;
+/* Return if an animation is over (idle animations never keep the scene busy) */
+bool isAnimOver(Animation *anim) {
+    return (!anim || anim->type == IDLE_ANIMATION || (anim->length != (Uint64) -1 && CURRENT_TICK - anim->start_tick >= anim->length));
 }
 
-/* Read single file line */
-bool readLine(FILE *file, char ***values, int *nb_values) {
-    /* Get the full line */
-    char line_buffer[64];
-    if (!fgets(line_buffer, 64, file)) return false;
-    /* Split it into all of its individual values */
-    *values = malloc(sizeof(char *)); *nb_values = 0; char *value, *line = line_buffer;
-    while (readValue(&line, &value)) {
-        (*nb_values)++;
-        *values = realloc(*values, (*nb_values) * sizeof(char *));
-        (*values)[*nb_values - 1] = value;
+/* Return if nothing is currently being animated on the scene */
+bool isSceneIdle(Scene *scene) {
+    for (Projectile *projectile = scene->projectile_list; projectile; projectile = projectile->next) {
+        if (!hasProjectileReachedTarget(projectile)) return false;
+    }
+    for (Visual *visual = scene->visual_list; visual; visual = visual->next) {
+        if (!isAnimOver(visual->anim)) return false;
     }
     return true;
 }
 
-/* Load a level */
-/* File must be located in "../assets/lvl/<path>.txt" */
-bool loadLevel(const char *path, Wave ***waves, int *nb_waves) {
-    /* Openning text file */
-    char *partial_path = concatString("../assets/lvl/", path);
-    char *full_path = concatString(partial_path, ".txt");
-    FILE *file = fopen(full_path, "r");
-    free(partial_path);
-    /* Checking if file was open successfully */
-    if (!file) {
-        printf("[ERROR]    Level file at \"%s\" not found\n", full_path);
-        free(full_path);
-        return false;
-    }
-
-    /* Retrieve all informations from the file */
-    *waves = malloc(sizeof(Wave *)); *nb_waves = 0; char **values; int nb_values;
-    while (readLine(file, &values, &nb_values)) {
-        switch (nb_values) {
-            /* Empty line, ignore it */
-            case 0:
+/* Play the events of the log until a wait event is reached while the scene is still busy */
+void playEvents(Scene *scene, EventLog *event_log) {
+    if (!scene || !event_log) return;
+    Event *event; Visual *visual;
+    while (!isEventLogDone(event_log)) {
+        event = &event_log->events[event_log->head];
+        visual = getVisual(scene->visual_list, event->id);
+        switch (event->type) {
+            case WAIT_EVENT:
+                if (!isSceneIdle(scene)) return;
                 break;
-            /* New wave (int income) */
-            case 1:
-                (*nb_waves)++;
-                *waves = realloc(*waves, (*nb_waves) * sizeof(Wave *));
-                (*waves)[*nb_waves - 1] = newWave(stringToInt(values[0]), NULL);
+            case PROJECTILE_EVENT:
+                addProjectile(&scene->projectile_list, event->entity_type, event->collumn, event->row, event->collumn + event->dx, event->row + event->dy);
                 break;
-            /* Add enemy (int spawn_delay, int row, char type) */
-            case 3:
-                if (!(*nb_waves)) {
-                    printf("[ERROR]    Invalid syntax for level file \"%s\"\n", full_path);
-                    free(full_path);
-                    fclose(file);
-                    return false;
-                }
-                addEnemy(&(*waves)[*nb_waves - 1]->enemy_list, values[2][0], NB_COLLUMNS + stringToInt(values[0]), stringToInt(values[1]), -1);
+            case DAMAGE_EVENT:
+                addDamageNumber(&scene->text_element_list, event->amount, event->collumn, event->row);
+                setVisualLifePoints(visual, event->life_points, event->max_life_points);
+                if (visual && event->amount > 0) setAnimHurt(visual->anim);
+                break;
+            case DEATH_EVENT:
+                destroyVisual(visual, &scene->visual_list);
+                break;
+            case ENEMY_SPAWN_EVENT:
+            case TOWER_SPAWN_EVENT:
+                destroyVisual(visual, &scene->visual_list);
+                visual = addVisual(scene, event->id, event->type == TOWER_SPAWN_EVENT, event->entity_type, event->collumn, event->row, event->life_points, event->max_life_points);
+                if (event->dx || event->dy) setAnimMove(visual->anim, event->dx, event->dy);
+                else setAnimSpawn(visual->anim);
+                break;
+            case MOVE_EVENT:
+                if (!visual) break;
+                visual->collumn = event->collumn;
+                visual->row = event->row;
+                setAnimMove(visual->anim, event->dx, event->dy);
+                break;
+            case ATTACK_EVENT:
+                if (visual) setAnimAttack(visual->anim, event->dx);
                 break;
-            /* Invalid value count on line */
             default:
-                printf("[ERROR]    Invalid syntax for level file \"%s\"\n", full_path);
-                free(full_path);
-                for (int i = 0; i < nb_values; i++) free(values[i]);
-                free(values);
-                fclose(file);
-                return false;
+                printf("[ERROR]    Unknown event type '%c'\n", event->type);
+                break;
         }
-        for (int i = 0; i < nb_values; i++) free(values[i]);
-        free(values);
-    }
-    free(full_path);
-    fclose(file);
-    return true;
-}
-
-bool saveGame(const char *save_name, Game *game){
-    /* Save the game in a text file */
-    char *partial_path = concatString("../assets/saves/", save_name);
-    char *full_path = concatString(partial_path, ".txt");
-    FILE *file = fopen(full_path, "w");
-    free(partial_path);
-    if (!file) {
-        printf("[ERROR]    Level file at \"%s\" not found\n", full_path);
-        free(full_path);
-        return false;
+        event_log->head++;
+    }
+}
+
+/* Make the scene match the game state once every event has been played (new entities appear, missing ones disappear) */
+void syncScene(Scene *scene, Game *game) {
+    if (!scene || !game) return;
+    /* Update or remove the visuals of existing entities */
+    Visual *visual = scene->visual_list, *tmp; Enemy *enemy; Tower *tower;
+    while (visual) {
+        tmp = visual->next;
+        enemy = NULL; tower = NULL;
+        if (visual->is_tower) for (tower = game->tower_list; tower && tower->id != visual->id; tower = tower->next);
+        else for (enemy = game->enemy_list; enemy && enemy->id != visual->id; enemy = enemy->next);
+        if (tower) {
+            visual->type = tower->type; visual->collumn = tower->collumn; visual->row = tower->row;
+            setVisualLifePoints(visual, tower->life_points, tower->max_life_points);
+        }
+        else if (enemy) {
+            visual->type = enemy->type; visual->collumn = enemy->collumn; visual->row = enemy->row;
+            setVisualLifePoints(visual, enemy->life_points, enemy->max_life_points);
+        }
+        else destroyVisual(visual, &scene->visual_list);
+        visual = tmp;
     }
-    /* Write the header with all keys infos that need to be saved and used when charging the save */
-    fprintf(file,"%s %d %d %d %d\n", game->level_name, game->current_wave_nb, game->funds, game->score, game->game_phase == PRE_WAVE_PHASE);
-    /* Add all the tower and the enemy file with all their characteristics */
-    Tower *current_tower = game->tower_list;
-    while(current_tower) {
-        fprintf(file, "T %c %d %d %d\n", current_tower->type, current_tower->row, current_tower->collumn, current_tower->life_points);
-        current_tower = current_tower->next;
+    /* Add the visuals of entities that have none */
+    for (tower = game->tower_list; tower; tower = tower->next) {
+        if (getVisual(scene->visual_list, tower->id)) continue;
+        visual = addVisual(scene, tower->id, true, tower->type, tower->collumn, tower->row, tower->life_points, tower->max_life_points);
+        setAnimSpawn(visual->anim);
     }
-    Enemy *current_enemy = game->enemy_list;
-    while(current_enemy){
-        fprintf(file, "E %c %d %d %d\n", current_enemy->type, current_enemy->row, current_enemy->collumn, current_enemy->life_points);
-        current_enemy = current_enemy->next;
+    for (enemy = game->enemy_list; enemy; enemy = enemy->next) {
+        if (getVisual(scene->visual_list, enemy->id)) continue;
+        visual = addVisual(scene, enemy->id, false, enemy->type, enemy->collumn, enemy->row, enemy->life_points, enemy->max_life_points);
+        setAnimSpawn(visual->anim);
     }
-    free(full_path);
-    fclose(file);
-    return true;
 }
 
-/* Delete save file */
-bool deleteSaveFile(const char *name) {
-    char save_path[64]; sprintf(save_path, "../assets/saves/%s.txt", name);
-    return remove(save_path);
-}
-
-
-
-/* Draw on screen enemies and towers, from top to bottom */
-void drawEnemiesAndTowers(SDL_Renderer *rend, Enemy *enemy_list, Tower *tower_list, int game_phase) {
-    Enemy **first_of_each_row = getFirstEnemyOfAllRows(enemy_list);
-    Enemy *enemy; Tower *tower;
+/* Draw on screen enemies (unless hidden) and towers, from top to bottom */
+void drawEnemiesAndTowers(SDL_Renderer *rend, Scene *scene, int game_phase, bool enemies_shown) {
+    Visual *visual;
     SDL_Rect dest;
     int w, h;
-    /* Draw from top to bottom */
+    /* Draw from top to bottom, enemies of a row being drawn before its towers */
     for (int row_nb = 1; row_nb <= NB_ROWS; row_nb++) {
-        /* Draw enemies on the current row */
-        enemy = first_of_each_row[row_nb-1];
-        while (enemy) {
-            if (enemy->collumn <= NB_COLLUMNS || game_phase == PRE_WAVE_PHASE) {
-                dest.x = (enemy->collumn - 1) * TILE_WIDTH; dest.y = (enemy->row - 1) * TILE_HEIGHT; dest.w = SPRITE_SIZE; dest.h = SPRITE_SIZE;
-                drawImgDynamic(rend, enemy->sprite, dest.x, dest.y, dest.w, dest.h, enemy->anim);
-                /* Life bar */
-                if (enemy->life_bar && (!enemy->anim || enemy->anim->type != SPAWN_ANIMATION) && game_phase != PRE_WAVE_PHASE) {
-                    enemy->life_bar->rect.x = dest.x;
-                    enemy->life_bar->rect.y = dest.y + SPRITE_SIZE - enemy->life_bar->sprite->h;
-                    /* Apply enemy anim to lifebar (except for size change) to match it's current visual position */
-                    if (enemy->anim && enemy->anim->type != IDLE_ANIMATION) {
-                        w = enemy->life_bar->rect.w; h = enemy->life_bar->rect.h;
-                        applyAnim(enemy->anim, &enemy->life_bar->rect);
-                        enemy->life_bar->rect.w = w; enemy->life_bar->rect.h = h;
-                    }
-                    drawTextElements(rend, &enemy->life_bar);
+        for (int drawing_towers = 0; drawing_towers <= 1; drawing_towers++) {
+            for (visual = scene->visual_list; visual; visual = visual->next) {
+                if (visual->row != row_nb || visual->is_tower != drawing_towers || (!visual->is_tower && !enemies_shown)) continue;
+                if (!visual->is_tower && visual->collumn > NB_COLLUMNS && game_phase != PRE_WAVE_PHASE) continue;
+                dest.x = (visual->collumn - 1) * TILE_WIDTH; dest.y = (visual->row - 1) * TILE_HEIGHT; dest.w = SPRITE_SIZE; dest.h = SPRITE_SIZE;
+                drawImgDynamic(rend, getVisualSprite(scene, visual), dest.x, dest.y, dest.w, dest.h, visual->anim);
+                /* Life bar (enemies only show it during waves) */
+                if (!visual->life_bar || (visual->anim && visual->anim->type == SPAWN_ANIMATION) || (!visual->is_tower && game_phase == PRE_WAVE_PHASE)) continue;
+                visual->life_bar->rect.x = dest.x;
+                visual->life_bar->rect.y = dest.y + SPRITE_SIZE - visual->life_bar->sprite->h;
+                /* Apply entity anim to lifebar (except for size change) to match it's current visual position */
+                if (visual->anim && visual->anim->type != IDLE_ANIMATION) {
+                    w = visual->life_bar->rect.w; h = visual->life_bar->rect.h;
+                    applyAnim(visual->anim, &visual->life_bar->rect);
+                    visual->life_bar->rect.w = w; visual->life_bar->rect.h = h;
                 }
+                drawTextElements(rend, &visual->life_bar);
             }
-            enemy = enemy->next_on_row;
         }
-        /* Draw towers on the current row */
-        tower = tower_list;
-        while (tower) {
-            if (tower->row == row_nb) {
-                dest.x = (tower->collumn - 1) * TILE_WIDTH; dest.y = (tower->row - 1) * TILE_HEIGHT; dest.w = SPRITE_SIZE; dest.h = SPRITE_SIZE;
-                drawImgDynamic(rend, tower->sprite, dest.x, dest.y, dest.w, dest.h, tower->anim);
-                drawImgDynamic(rend, tower->sprite, dest.x, dest.y, SPRITE_SIZE, SPRITE_SIZE, tower->anim);
-                /* Life bar */
-                if (tower->life_bar && (!tower->anim || tower->anim->type != SPAWN_ANIMATION)) {
-                    tower->life_bar->rect.x = dest.x;
-                    tower->life_bar->rect.y = dest.y + SPRITE_SIZE - tower->life_bar->sprite->h;
-                    /* Apply tower anim to lifebar (except for size change) to match it's current visual position */
-                    if (tower->anim && tower->anim->type != IDLE_ANIMATION) {
-                        w = tower->life_bar->rect.w; h = tower->life_bar->rect.h;
-                        applyAnim(tower->anim, &tower->life_bar->rect);
-                        tower->life_bar->rect.w = w; tower->life_bar->rect.h = h;
-                    }
-                    drawTextElements(rend, &tower->life_bar);
-                }
-            }
-            tower = tower->next;
+    }
+}
+
+/* Draw on screen enemies still waiting to enter the map, each one as far right as its spawn turn is away, from top to bottom */
+void drawSpawnQueue(SDL_Renderer *rend, SpawnQueue *spawn_queue, int turn_nb, SDL_Surface *enemy_sprites[128]) {
+    if (isSpawnQueueEmpty(spawn_queue)) return;
+    SpawnEntry *entry;
+    for (int row_nb = 1; row_nb <= NB_ROWS; row_nb++) {
+        for (int i = spawn_queue->head; i < spawn_queue->nb_entries; i++) {
+            entry = &spawn_queue->entries[i];
+            if (entry->row != row_nb || !entry->type) continue;
+            /* Sprites are only loaded once per enemy type */
+            if (!enemy_sprites[(int) entry->type]) enemy_sprites[(int) entry->type] = loadEnemyImg(entry->type);
+            drawImgDynamic(rend, enemy_sprites[(int) entry->type], (NB_COLLUMNS + entry->turn - turn_nb - 1) * TILE_WIDTH, (entry->row - 1) * TILE_HEIGHT, SPRITE_SIZE, SPRITE_SIZE, NULL);
         }
     }
-    /* Free memory */
-    free(first_of_each_row);
 }
 
 
@@ -2548,8 +1410,8 @@ void drawRectDynamic(SDL_Renderer *rend, int pos_x, int pos_y, int width, int he
 
 
 int main(int argc, char* argv[]) {
-    /* Initialize a new random seed */
-    srand(time(NULL));
+    /* Initialize a new random seed, used by new games (saved games keep their own) */
+    unsigned long long seed = time(NULL);
 
 
     /* Part in terminal */
@@ -2594,9 +1456,19 @@ int main(int argc, char* argv[]) {
         printf("  %2d) Load save\n", nb_availible_levels+2);
         save_availible = true;
     }
+    char replay_path[64]; sprintf(replay_path, "../assets/replays/%s.rpl", nickname);
+    FILE *replay_file;
+    bool replay_availible = false;
+    if ((replay_file = fopen(replay_path, "r"))) {
+        fclose(replay_file);
+        printf("  %2d) Watch replay\n", nb_availible_levels+3);
+        replay_availible = true;
+    }
 
     /* Allow user to chose which level they want to play */
     Game *game = NULL;
+    Replay *watched_replay = NULL;
+    bool loaded_save = false;
     while (!game) {
         char buffer[64];
         printf("Please chose a level by entering its numerical ID or its name\n");
@@ -2611,22 +1483,32 @@ int main(int argc, char* argv[]) {
         if (!strcmp(buffer, "quit") || !strcmp(buffer, "exit") || !strcmp(buffer, "")) return 0;
         /* Load a level by entering its name */
         for (int i = 0; i < nb_availible_levels; i++) if (!strcmp(buffer, availible_levels[i])) {
-            game = createNewGame(buffer);
+            game = createNewGame(buffer, seed);
             break;
         }
         /* Load a level by entering its numerical ID */
         if (!game) if (0 < num_id && num_id <= nb_availible_levels)
-            game = createNewGame(availible_levels[num_id-1]);
+            game = createNewGame(availible_levels[num_id-1], seed);
         /* Load survival mode */
         if (!game) if (!strcmp(buffer, "Survival mode") || num_id == nb_availible_levels+1)
-            game = createNewGame(SURVIVAL_MODE);
+            game = createNewGame(SURVIVAL_MODE, seed);
         /* Load savefile */
         if (!game) if (save_availible && (!strcmp(buffer, "Load save") || num_id == nb_availible_levels+2))
-            game = loadGameFromSave(nickname);
+            loaded_save = (game = loadGameFromSave(nickname));
+        /* Watch the replay of the last game played */
+        if (!game) if (replay_availible && (!strcmp(buffer, "Watch replay") || num_id == nb_availible_levels+3))
+            if ((watched_replay = loadReplay(nickname))) game = createReplayGame(watched_replay);
         /* Error */
         if (!game) printf("Could not find level \"%s\", please try again\n", buffer);
     }
     printf("Level loaded successfully, have fun!\n");
+    seedRng(&COSMETIC_RNG, game->seed, COSMETIC_STREAM);
+    /* Record the actions of the player (only for new games, as a save cannot be replayed from the start) */
+    if (!watched_replay && !loaded_save) game->replay = newReplay(game->level_name, game->seed);
+    /* Keep the last turns to rewind to (not while watching a replay) */
+    if (!watched_replay) game->rewind_buffer = newRewindBuffer(REWIND_TURNS, REWIND_BUFFER_SIZE);
+    /* Nothing is saved while watching a replay */
+    const char *save_name = (watched_replay ? NULL : nickname);
     for (int i = nb_availible_levels; i > 0; i--) free(availible_levels[i-1]);
 
 
@@ -2694,14 +1576,27 @@ int main(int argc, char* argv[]) {
 
     /* Main loop */
     Tower *towerOnTile;
-    int var; Enemy *enemy;
+    int var;
+    Scene *scene = newScene();
     int score = -1, wave_nb = -1, nb_waves = -1, funds = -1; char text_value[256];
+    /* Outcome of the upcoming wave, predicted in the background while building defences */
+    Predictor *predictor = newPredictor();
+    WavePrediction prediction;
+    int prediction_generation = -2; unsigned int predicted_layout = 0; Game *predicted_game = NULL;
+    /* Positions evaluated by the auto-build, kept from one search to the next */
+    TranspositionTable *transposition_table = newTranspositionTable(TRANSPOSITION_TABLE_BITS);
+    /* Level being edited, its waves are simulated again from the first one edited (with the current defences) */
+    LevelPreview *level_preview = NULL;
+    int edited_wave = 0; char edited_enemy_type = SLIME_ENEMY; unsigned int previewed_layout = 0; bool level_preview_shown = false;
+    const char enemy_types[] = {SLIME_ENEMY, GELLY_ENEMY, GOBLIN_ENEMY, ORC_ENEMY, NECROMANCER_ENEMY, SKELETON_ENEMY, WITCH_ENEMY};
+    TextElement *prediction_text = addTextElement(NULL, "", 0.5, (SDL_Color) {0, 0, 0, 0}, (SDL_Color) {0, 0, 0, 0}, (SDL_Rect) {0, BASE_WINDOW_HEIGHT - 2*FONT_HEIGHT, WINDOW_WIDTH, FONT_HEIGHT}, true, false, NULL);
     int cam_x_speed = 0, cam_y_speed = 0, cam_speed_mult = 0;
     int *selected_tile_pos = malloc(2 * sizeof(int)); selected_tile_pos[0] = 0; selected_tile_pos[1] = 0;
     bool menu_hidden = true;
     bool mouse_dragging = false;
     bool fullscreen = FULLSCREEN;
     float game_speed = 1.0;
+    bool turbo = false;
     int last_tick = SDL_GetTicks();
     SDL_Event event;
     bool running = true;
@@ -2756,11 +1651,79 @@ int main(int argc, char* argv[]) {
                         case SDL_SCANCODE_P:
                             game_speed *= 2.0;
                             break;
+                        /* Turn on/off turbo mode (waves are fast forwarded) */
+                        case SDL_SCANCODE_T:
+                            turbo = !turbo;
+                            break;
+                        /* Turn on/off concurrent turns (all towers then all enemies act at once) */
+                        case SDL_SCANCODE_V:
+                            game->concurrent_turns = !game->concurrent_turns;
+                            break;
+                        /* Let the auto-build search and build the best defences for the upcoming wave (on every processor core) */
+                        case SDL_SCANCODE_B:
+                            if (watched_replay || game->game_phase != PRE_WAVE_PHASE) break;
+                            long long nb_rollouts;
+                            Uint64 search_start = SDL_GetTicks64();
+                            BuildPlan plan = autoBuild(game, transposition_table, AUTO_BUILD_WAVES, AUTO_BUILD_TIME_BUDGET, SDL_GetCPUCount(), &nb_rollouts);
+                            for (int i = 0; i < plan.nb_actions; i++) applyAction(game, plan.actions[i]);
+                            printf("Auto-build: %d towers built or upgraded, %lld rollouts (%.0f rollouts/s)\n", plan.nb_actions, nb_rollouts, nb_rollouts * 1000.0 / max(SDL_GetTicks64() - search_start, 1));
+                            break;
+                        /* Rewind the last turn (or the start of the wave), the scene is rebuilt from the restored state */
+                        case SDL_SCANCODE_BACKSPACE:
+                            if (watched_replay || level_preview || (game->game_phase != WAVE_PHASE && game->game_phase != PRE_WAVE_PHASE)) break;
+                            if (!rewindGame(game, 1)) break;
+                            destroyScene(scene);
+                            scene = newScene();
+                            printf("Rewound to turn %d (%d turns left to rewind, %d/%d bytes used, %zu bytes allocated)\n", game->total_turns, game->rewind_buffer->nb_entries, game->rewind_buffer->used_bytes, game->rewind_buffer->nb_bytes, getRewindBufferMemory(game->rewind_buffer));
+                            break;
+                        /* Seek backward/forward in the watched replay, the game is rebuilt from the closest keyframe */
+                        case SDL_SCANCODE_LEFT:
+                        case SDL_SCANCODE_RIGHT:
+                            if (!watched_replay) break;
+                            var = game->total_turns + ((event.key.keysym.scancode == SDL_SCANCODE_RIGHT) ? REPLAY_SEEK_TURNS : -REPLAY_SEEK_TURNS);
+                            Game *seeked_game = seekReplay(watched_replay, max(var, 0));
+                            seeked_game->concurrent_turns = game->concurrent_turns;
+                            destroyGame(game);
+                            game = seeked_game;
+                            destroyScene(scene);
+                            scene = newScene();
+                            break;
+                        /* Open/close the level editor, the edits are given to the game when it is closed */
+                        case SDL_SCANCODE_E:
+                            if (level_preview) {
+                                applyLevelPreview(level_preview, game);
+                                destroyLevelPreview(level_preview);
+                                level_preview = NULL;
+                                destroyScene(scene);
+                                scene = newScene();
+                                predicted_game = NULL; prediction_generation = -3;
+                                break;
+                            }
+                            if (watched_replay || game->game_phase != PRE_WAVE_PHASE || !(level_preview = newLevelPreview(game))) break;
+                            edited_wave = level_preview->first_wave;
+                            previewed_layout = hashLayout(game); level_preview_shown = false;
+                            menu_hidden = true;
+                            printf("Level editor: click a tile to add/remove an enemy, 1-7 to choose its type, up/down to choose the wave, F5 to save the level, E to close\n");
+                            break;
+                        /* Choose the wave edited */
+                        case SDL_SCANCODE_UP:
+                        case SDL_SCANCODE_DOWN:
+                            if (!level_preview) break;
+                            edited_wave = min(max(level_preview->first_wave, edited_wave + ((event.key.keysym.scancode == SDL_SCANCODE_UP) ? 1 : -1)), level_preview->nb_waves - 1);
+                            level_preview_shown = false;
+                            break;
+                        /* Choose the type of the enemies added */
+                        case SDL_SCANCODE_1: case SDL_SCANCODE_2: case SDL_SCANCODE_3: case SDL_SCANCODE_4: case SDL_SCANCODE_5: case SDL_SCANCODE_6: case SDL_SCANCODE_7:
+                            edited_enemy_type = enemy_types[event.key.keysym.scancode - SDL_SCANCODE_1];
+                            level_preview_shown = false;
+                            break;
+                        /* Save the level being edited */
+                        case SDL_SCANCODE_F5:
+                            if (level_preview && saveLevel(game->level_name, level_preview->waves, level_preview->nb_waves, game->flow_field)) printf("Level \"%s\" saved\n", game->level_name);
+                            break;
                         /* Start the wave */
                         case SDL_SCANCODE_SPACE:
-                            if (game->game_phase == PRE_WAVE_PHASE || game->game_phase == WAITING_FOR_USER_PHASE){
-                                startNextWave(game);
-                            }
+                            if (!watched_replay && !level_preview) applyAction(game, (Action) {START_WAVE_ACTION, 0, 0, 0, 0});
                             if (game->game_phase == VICTORY_PHASE || game->game_phase == DEFEAT_PHASE) game->game_phase = SCORE_PHASE;
                             
                             break;
@@ -2803,13 +1766,20 @@ int main(int argc, char* argv[]) {
                             break;
                         /* Tower placement */
                         case SDL_BUTTON_LEFT:
+                            /* Level editor: the enemy entering the edited wave on that row and on that turn (the tiles right of the map being later turns) is added, removed or changed */
+                            if (level_preview) {
+                                var = event.button.x; int row = event.button.y;
+                                pixelToTile(&var, &row);
+                                if (1 <= var && 1 <= row && row <= NB_ROWS && editLevelPreviewEnemy(level_preview, edited_wave, edited_enemy_type, row, var - NB_COLLUMNS)) level_preview_shown = false;
+                                break;
+                            }
                             /* If tile selected */
                             if (event.button.y > WINDOW_HEIGHT/4 || menu_hidden) {
                                 selected_tile_pos[0] = event.button.x;
                                 selected_tile_pos[1] = event.button.y;
                                 pixelToTile(&selected_tile_pos[0], &selected_tile_pos[1]);
-                                /* Check if tile is on map (last collumn cannot be build on) */
-                                if (1 <= selected_tile_pos[0] && selected_tile_pos[0] <= NB_COLLUMNS-1 && 1 <= selected_tile_pos[1] && selected_tile_pos[1] <= NB_ROWS) {
+                                /* Check if tile is on map (last collumn and blocked terrain cannot be build on) */
+                                if (1 <= selected_tile_pos[0] && selected_tile_pos[0] <= NB_COLLUMNS-1 && 1 <= selected_tile_pos[1] && selected_tile_pos[1] <= NB_ROWS && !isTileBlocked(game->flow_field, selected_tile_pos[0], selected_tile_pos[1])) {
                                     menu_hidden = (game->game_phase != PRE_WAVE_PHASE);
                                 }
                                 else {
@@ -2825,12 +1795,12 @@ int main(int argc, char* argv[]) {
                                     menu_hidden = true;
                                 }
                                 else if (WINDOW_HEIGHT/4 <= event.button.x && event.button.x <= WINDOW_HEIGHT*2/4 && 0 <= event.button.y && event.button.y <= WINDOW_HEIGHT/4){
-                                    sellTower(towerOnTile, &game->tower_list, &game->funds);
+                                    applyAction(game, (Action) {SELL_ACTION, 0, selected_tile_pos[0], selected_tile_pos[1], 0});
                                     menu_hidden = true;
                                 }
                                 else if (0 <= event.button.x && event.button.x <= WINDOW_HEIGHT/4 && 0 <= event.button.y && event.button.y <= WINDOW_HEIGHT/4){
                                     /* Clicked on the turret upgrade */
-                                    upgradeTower(&game->tower_list, game->enemy_list, towerOnTile->type, selected_tile_pos[0], selected_tile_pos[1], &game->funds);
+                                    applyAction(game, (Action) {UPGRADE_ACTION, 0, selected_tile_pos[0], selected_tile_pos[1], 0});
                                     menu_hidden = true;
                                 }
                             }
@@ -2838,19 +1808,19 @@ int main(int argc, char* argv[]) {
                             else {
                                 /* Archer tower */
                                 if (WINDOW_HEIGHT*0/4 <= event.button.x && event.button.x <= WINDOW_HEIGHT*1/4 && 0 <= event.button.y && event.button.y <= WINDOW_HEIGHT/4) {
-                                    if (buyTower(&game->tower_list, game->enemy_list, ARCHER_TOWER, selected_tile_pos[0], selected_tile_pos[1], &game->funds)) menu_hidden = true;
+                                    if (applyAction(game, (Action) {BUY_ACTION, ARCHER_TOWER, selected_tile_pos[0], selected_tile_pos[1], 0})) menu_hidden = true;
                                 }
                                 /* Wall tower */
                                 else if (WINDOW_HEIGHT*1/4 <= event.button.x && event.button.x <= WINDOW_HEIGHT*2/4 && 0 <= event.button.y && event.button.y <= WINDOW_HEIGHT/4) {
-                                    if (buyTower(&game->tower_list, game->enemy_list, WALL_TOWER, selected_tile_pos[0], selected_tile_pos[1], &game->funds)) menu_hidden = true;
+                                    if (applyAction(game, (Action) {BUY_ACTION, WALL_TOWER, selected_tile_pos[0], selected_tile_pos[1], 0})) menu_hidden = true;
                                 }
                                 /* Canon tower */
                                 else if (WINDOW_HEIGHT*2/4 <= event.button.x && event.button.x <= WINDOW_HEIGHT*3/4 && 0 <= event.button.y && event.button.y <= WINDOW_HEIGHT/4) {
-                                    if (buyTower(&game->tower_list, game->enemy_list, CANON_TOWER, selected_tile_pos[0], selected_tile_pos[1], &game->funds)) menu_hidden = true;
+                                    if (applyAction(game, (Action) {BUY_ACTION, CANON_TOWER, selected_tile_pos[0], selected_tile_pos[1], 0})) menu_hidden = true;
                                 }
                                 /* Sorcerer tower */
                                 else if (WINDOW_HEIGHT*3/4 <= event.button.x && event.button.x <= WINDOW_HEIGHT*4/4 && 0 <= event.button.y && event.button.y <= WINDOW_HEIGHT/4) {
-                                    if (buyTower(&game->tower_list, game->enemy_list, SORCERER_TOWER, selected_tile_pos[0], selected_tile_pos[1], &game->funds)) menu_hidden = true;
+                                    if (applyAction(game, (Action) {BUY_ACTION, SORCERER_TOWER, selected_tile_pos[0], selected_tile_pos[1], 0})) menu_hidden = true;
                                 }
                                 else if (WINDOW_WIDTH-WINDOW_HEIGHT/4 <= event.button.x && event.button.x <= WINDOW_WIDTH && 0 <= event.button.y && event.button.y <= WINDOW_HEIGHT/4){
                                     /* Clicked on the X to quit the menu */
@@ -2892,11 +1862,30 @@ int main(int argc, char* argv[]) {
         
         }
 
-        /* Update game */
-        updateGame(game, nickname);
+        /* Play the events of the last resolved turn, the scene then matches the game state */
+        updateProjectiles(&scene->projectile_list);
+        playEvents(scene, game->event_log);
+        if (isEventLogDone(game->event_log)) syncScene(scene, game);
+
+        /* Do the actions of the watched replay once the scene is idle */
+        if (watched_replay && isEventLogDone(game->event_log)) playReplay(game, watched_replay);
 
-        /* Automaticaly close building menu durring waves (canot build in the middle of a wave) */
-        if (game->game_phase != PRE_WAVE_PHASE) menu_hidden = true;
+        /* Update game, in turbo mode the time of the frames that are not drawn is spent resolving turns */
+        if (turbo && game->game_phase == WAVE_PHASE) {
+            fastForwardGame(game, save_name, TURBO_RENDER_INTERVAL * 1000/FPS - 1000/FPS);
+            syncScene(scene, game);
+        }
+        else updateGame(game, save_name);
+
+        /* Predict the upcoming wave again whenever the defences change, the previous prediction being cancelled */
+        if (game->game_phase == PRE_WAVE_PHASE && (game != predicted_game || hashLayout(game) != predicted_layout)) {
+            predicted_game = game; predicted_layout = hashLayout(game);
+            requestPrediction(predictor, game);
+        }
+        if (game->game_phase != PRE_WAVE_PHASE) predicted_game = NULL;
+
+        /* Automaticaly close building menu durring waves (canot build in the middle of a wave), it is never shown while watching a replay */
+        if (game->game_phase != PRE_WAVE_PHASE || watched_replay) menu_hidden = true;
 
         /* Update UI if needed */
         /* Update score display */
@@ -2914,6 +1903,37 @@ int main(int argc, char* argv[]) {
             else sprintf(text_value, "Wave: %d", game->current_wave_nb);
             ui_text_element->next->sprite = textSurface(text_value, (SDL_Color) {255, 127, 0, 255}, (SDL_Color) {127, 63, 0, 255});
         }
+        /* Simulate the waves of the edited level that are not up to date (from scratch when the defences change), a few ms per frame */
+        if (level_preview) {
+            if (hashLayout(game) != previewed_layout) {
+                previewed_layout = hashLayout(game);
+                resetLevelPreview(level_preview, game);
+            }
+            if (!level_preview->up_to_date) level_preview_shown = false;
+            if (updateLevelPreview(level_preview, LEVEL_PREVIEW_TIME) && !level_preview_shown) {
+                level_preview_shown = true;
+                delImg(prediction_text->sprite);
+                WavePrediction *wave_prediction = &level_preview->predictions[edited_wave];
+                var = sprintf(text_value, "Editing wave %d/%d ('%c'): ", edited_wave + 1, level_preview->nb_waves, edited_enemy_type);
+                if (edited_wave >= level_preview->next_wave) var += sprintf(text_value + var, "not reached");
+                else if (wave_prediction->defeat) var += sprintf(text_value + var, "DEFEAT (%d leak%s)", wave_prediction->nb_leaks, (wave_prediction->nb_leaks > 1) ? "s" : "");
+                else var += sprintf(text_value + var, "cleared in %d turns", wave_prediction->nb_turns);
+                if (level_preview->lost_wave >= 0) sprintf(text_value + var, ", level lost on wave %d (%d points)", level_preview->lost_wave + 1, level_preview->score);
+                else sprintf(text_value + var, ", level won (%d points)", level_preview->score);
+                if (level_preview->lost_wave >= 0) prediction_text->sprite = textSurface(text_value, (SDL_Color) {255, 63, 63, 255}, (SDL_Color) {127, 31, 31, 255});
+                else prediction_text->sprite = textSurface(text_value, (SDL_Color) {127, 255, 127, 255}, (SDL_Color) {63, 127, 63, 255});
+            }
+        }
+        /* Update prediction display */
+        else if (game->game_phase == PRE_WAVE_PHASE && (var = getPrediction(predictor, &prediction)) != prediction_generation) {
+            prediction_generation = var;
+            delImg(prediction_text->sprite);
+            if (prediction_generation < 0) sprintf(text_value, "Predicting next wave...");
+            else if (prediction.defeat) sprintf(text_value, "Predicted: DEFEAT (%d leak%s), +%d points, %d tower%s lost", prediction.nb_leaks, (prediction.nb_leaks > 1) ? "s" : "", prediction.score, prediction.nb_towers_lost, (prediction.nb_towers_lost > 1) ? "s" : "");
+            else sprintf(text_value, "Predicted: wave cleared in %d turns, +%d points, %d tower%s lost", prediction.nb_turns, prediction.score, prediction.nb_towers_lost, (prediction.nb_towers_lost > 1) ? "s" : "");
+            if (prediction_generation >= 0 && prediction.defeat) prediction_text->sprite = textSurface(text_value, (SDL_Color) {255, 63, 63, 255}, (SDL_Color) {127, 31, 31, 255});
+            else prediction_text->sprite = textSurface(text_value, (SDL_Color) {127, 255, 127, 255}, (SDL_Color) {63, 127, 63, 255});
+        }
         /* Update funds display */
         if (funds != game->funds) {
             funds = game->funds;
@@ -2937,26 +1957,35 @@ int main(int argc, char* argv[]) {
         for (int y = 0; y < NB_ROWS; y++) for (int x = -NB_ROWS * TILE_HEIGHT/TILE_WIDTH + 1; x < 0; x++)
             drawImgDynamic(rend, grass_tiles[4 + positive_mod(x, 2) + positive_mod(y, 2) * 2], TILE_WIDTH * x, TILE_HEIGHT * y, SPRITE_SIZE, SPRITE_SIZE, NULL);
         drawImgDynamic(rend, castle, -(NB_ROWS-2)*TILE_HEIGHT, TILE_HEIGHT, (NB_ROWS-2)*TILE_HEIGHT, (NB_ROWS-2)*TILE_HEIGHT, NULL);
-        /* Draw grass tiles */
+        /* Draw grass tiles (blocked terrain uses the alternative tiles) */
         for (int y = 0; y < NB_ROWS; y++) for (int x = 0; x < NB_COLLUMNS; x++) 
-            drawImgDynamic(rend, grass_tiles[x%2 + (y%2) * 2], TILE_WIDTH * x, TILE_HEIGHT * y, SPRITE_SIZE, SPRITE_SIZE, NULL);
-        /* Draw additional grass tiles for enemy preview, only in pre-wave game phase */
+            drawImgDynamic(rend, grass_tiles[4*isTileBlocked(game->flow_field, x+1, y+1) + x%2 + (y%2) * 2], TILE_WIDTH * x, TILE_HEIGHT * y, SPRITE_SIZE, SPRITE_SIZE, NULL);
+        /* Draw additional grass tiles for enemy preview, only in pre-wave game phase (with room for later enemies in the level editor) */
         if (game->game_phase == PRE_WAVE_PHASE) {
-            var = 0; enemy = game->enemy_list;
-            while (enemy) {
-                var = max(var, enemy->collumn - NB_COLLUMNS);
-                enemy = enemy->next;
-            }
+            if (level_preview) var = max(0, getLastSpawnTurn(level_preview->waves[edited_wave]->spawn_queue)) + 3;
+            else var = max(0, getLastSpawnTurn(game->spawn_queue) - game->turn_nb);
             for (int y = 0; y < NB_ROWS; y++) for (int x = NB_COLLUMNS; x < NB_COLLUMNS + var; x++)
                 drawImgDynamic(rend, grass_tiles[4 + x%2 + (y%2) * 2], TILE_WIDTH * x, TILE_HEIGHT * y, SPRITE_SIZE, SPRITE_SIZE, NULL);
         }
         /* Draw selection cursor */
         if (!menu_hidden) drawImgDynamic(rend, highlighted_tile, (selected_tile_pos[0]-1)*TILE_WIDTH, (selected_tile_pos[1]-1)*TILE_HEIGHT, SPRITE_SIZE, SPRITE_SIZE, NULL);
         /* Draw entities */
-        drawEnemiesAndTowers(rend, game->enemy_list, game->tower_list, game->game_phase);
-        drawProjectiles(rend, game->projectile_list);
+        /* In the level editor, the enemies shown are the ones of the edited wave (all of them waiting to enter the map) */
+        drawEnemiesAndTowers(rend, scene, game->game_phase, !level_preview);
+        if (level_preview) drawSpawnQueue(rend, level_preview->waves[edited_wave]->spawn_queue, 0, scene->enemy_sprites);
+        else if (game->game_phase == PRE_WAVE_PHASE) drawSpawnQueue(rend, game->spawn_queue, game->turn_nb, scene->enemy_sprites);
+        /* Draw predicted tower losses and leaks (in front of the castle), of the edited wave in the level editor */
+        WavePrediction *shown_prediction = (prediction_generation >= 0) ? &prediction : NULL;
+        if (level_preview) shown_prediction = (edited_wave < level_preview->next_wave) ? &level_preview->predictions[edited_wave] : NULL;
+        if (game->game_phase == PRE_WAVE_PHASE && shown_prediction) {
+            for (int y = 0; y < NB_ROWS; y++) {
+                for (int x = 0; x < NB_COLLUMNS; x++) if (shown_prediction->tower_lost[y][x]) drawRectDynamic(rend, TILE_WIDTH * x, TILE_HEIGHT * y, TILE_WIDTH, TILE_HEIGHT, 255, 63, 63, 255);
+                if (shown_prediction->leak[y]) drawRectDynamic(rend, -TILE_WIDTH, TILE_HEIGHT * y, TILE_WIDTH, TILE_HEIGHT, 255, 0, 0, 255);
+            }
+        }
+        drawProjectiles(rend, scene->projectile_list);
         /* Draw damage numbers */
-        drawTextElements(rend, &game->text_element_list);
+        drawTextElements(rend, &scene->text_element_list);
 
         /* Draw the Menu if necessary */
         if (!menu_hidden) {
@@ -2997,7 +2026,10 @@ int main(int argc, char* argv[]) {
         /* Draw victory/defeat text */
         if (game->game_phase == VICTORY_PHASE) drawTextElements(rend, &win_text_surface);
         else if (game->game_phase == DEFEAT_PHASE) drawTextElements(rend, &lose_text_surface);
-        else if (game->game_phase == PRE_WAVE_PHASE) drawTextElements(rend,&protect_castle_surface);
+        else if (game->game_phase == PRE_WAVE_PHASE) {
+            drawTextElements(rend,&protect_castle_surface);
+            drawTextElements(rend, &prediction_text);
+        }
         else drawTextElements(rend, &wave_coming_surface);
 
         /* Draw scoreboard on victory/defeat */
@@ -3047,6 +2079,13 @@ int main(int argc, char* argv[]) {
     for (int i = 3; i > 0; i--) delImg(towers_upgrades[i-1]);
     free(selected_tile_pos); delImg(highlighted_tile);
     while (ui_text_element) destroyTextElement(ui_text_element, &ui_text_element);
+    destroyScene(scene);
+    destroyPredictor(predictor);
+    destroyLevelPreview(level_preview);
+    destroyTranspositionTable(transposition_table);
+    destroyTextElement(prediction_text, NULL);
+    saveReplay(game->replay, nickname);
+    destroyReplay(watched_replay);
     destroyGame(game);
     /* Release resources */
     SDL_DestroyRenderer(rend);
@@ -0,0 +1,3707 @@
+#include "sim.h"
+
+
+
+
+/* Identifier given to the next enemy or tower created */
+_Thread_local int NEXT_ENTITY_ID = 0;
+
+
+
+/* Seed a random number generator, generators given the same seed on different streams are independent */
+void seedRng(Rng *rng, unsigned long long seed, unsigned long long stream) {
+    rng->state = 0;
+    rng->inc = (stream << 1) | 1;
+    nextRandom(rng);
+    rng->state += seed;
+    nextRandom(rng);
+}
+
+/* Return the next random 32 bits integer of a generator (PCG32) */
+uint32_t nextRandom(Rng *rng) {
+    uint64_t old_state = rng->state;
+    rng->state = old_state * 6364136223846793005ULL + rng->inc;
+    uint32_t xorshifted = ((old_state >> 18) ^ old_state) >> 27;
+    uint32_t rot = old_state >> 59;
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+/* Return an integer between a and b (included) */
+int randrange(Rng *rng, int a, int b) {
+    uint32_t range = abs(b-a) + 1;
+    /* Scale a random number to the range (Lemire's method), rejecting the few values that would make some results more likely */
+    uint64_t m = (uint64_t) nextRandom(rng) * range;
+    if ((uint32_t) m < range) {
+        uint32_t threshold = -range % range;
+        while ((uint32_t) m < threshold) m = (uint64_t) nextRandom(rng) * range;
+    }
+    return (int) (m >> 32) + min(a, b);
+}
+
+/* Has p chance to return true, and 1-p chance to return false */
+bool roll(Rng *rng, double p) {
+    /* p must be a value between 0.0 and 1.0 included */
+    p = min(max(0.0, p), 1.0);
+    /* Return the roll */
+    return (p * 4294967296.0 > nextRandom(rng));
+}
+
+/* Return the sign of a number */
+int sign(double x) {return (x < 0.0) ? -1 : ((x > 0.0) ? +1 : 0);}
+
+/* Return the minimum between x and y */
+double min(double x, double y) {return (x < y) ? x : y;}
+
+/* Return the maximum between x and y */
+double max(double x, double y) {return (x > y) ? x : y;}
+
+/* Compute x to the power of n */
+double power(double x, int n) {
+    /* Base case */
+    if (n == 0) return 1;
+    if (x == 0.0) return 0;
+    /* Recursive case */
+    if (n > 0) {
+        double y = x;
+        int i = 1;
+        while (i*2 <= n) {
+            y *= y;
+            i *= 2;
+        }
+        return y * power(x, n-i);
+    }
+    /* Negative exponents */
+    else return 1.0 / power(x, -n);
+}
+
+/* Add 2 strings together into a new string, memory must be freed after use */
+char *concatString(const char *a, const char *b) {
+    char *c = malloc((strlen(a) + strlen(b) + 1) * sizeof(char));
+    strcpy(c, a);
+    strcat(c, b);
+    return c;
+}
+
+/* Duplicate a string and automaticaly allocate memory */
+char *duplicateString(const char *a) {
+    char *b = malloc(strlen(a) + 1);
+    if (b) strcpy(b, a);
+    return b;
+}
+
+/* Convert a string to an int */
+int stringToInt(const char *str) {
+    int n = 0;
+    sscanf(str, " %d", &n);
+    return n;
+}
+
+/* Used to get "a = q*b + r" with "0 <= r < b" */
+int positive_div(int i, int n) {
+    return (i - positive_mod(i, n)) / n;
+}
+
+/* Used to get "a = q*b + r" with "0 <= r < b" */
+int positive_mod(int i, int n) {
+    return (n + (i % n)) % n;
+}
+
+
+
+
+/* Get the tower and enemy at a specified position */
+bool getEnemyAndTowerAt(Enemy *enemy_list, Tower *tower_list, int collumn, int row, Enemy **enemy, Tower **tower) {
+    /* Getting enemy */
+    while (enemy_list) {
+        if (enemy_list->collumn == collumn && enemy_list->row == row) {
+            break;
+        }
+        enemy_list = enemy_list->next;
+    }
+    if (enemy) *enemy = enemy_list;
+    /* Getting tower */
+    while (tower_list) {
+        if (tower_list->collumn == collumn && tower_list->row == row) {
+            break;
+        }
+        tower_list = tower_list->next;
+    }
+    if (tower) *tower = tower_list;
+    /* Return true if an enemy or tower was found, false otherwise (meaning the space is empty) */
+    return (enemy_list || tower_list);
+}
+
+/* Return if the specified space is empty, if outside of the map return false */
+bool isTileEmpty(Enemy *enemy_list, Tower *tower_list, int collumn, int row) {
+    return !getEnemyAndTowerAt(enemy_list, tower_list, collumn, row, NULL, NULL);
+}
+
+/* Return if the tile is in the map */
+bool doesTileExist(int collumn, int row) {
+    return (1 <= collumn && collumn <= NB_COLLUMNS && 1 <= row && row <= NB_ROWS);
+}
+
+
+
+
+/* Create a new flow field for a map without any terrain */
+FlowField *newFlowField() {
+    FlowField *flow_field = malloc(sizeof(FlowField));
+    for (int row = 1; row <= NB_ROWS; row++) for (int collumn = 1; collumn <= NB_COLLUMNS; collumn++) {
+        flow_field->blocked[row-1][collumn-1] = false;
+        flow_field->tower[row-1][collumn-1] = false;
+    }
+    computeFlowField(flow_field);
+    return flow_field;
+}
+
+/* Destroy a flow field and free its allocated memory */
+void destroyFlowField(FlowField *flow_field) {
+    if (flow_field) free(flow_field);
+}
+
+/* Return if the tile is blocked by the terrain, tiles outside of the map are never blocked */
+bool isTileBlocked(FlowField *flow_field, int collumn, int row) {
+    return flow_field && doesTileExist(collumn, row) && flow_field->blocked[row-1][collumn-1];
+}
+
+/* Return the path cost from a tile to the castle, the castle itself costs nothing */
+int getPathCost(FlowField *flow_field, int collumn, int row) {
+    if (collumn <= 0 && 1 <= row && row <= NB_ROWS) return 0;
+    if (!doesTileExist(collumn, row) || flow_field->blocked[row-1][collumn-1]) return UNREACHABLE_PATH_COST;
+    return flow_field->cost[row-1][collumn-1];
+}
+
+/* Return the cost of a single step between two adjacent tiles */
+int getStepCost(FlowField *flow_field, int from_collumn, int to_collumn, int to_row) {
+    int cost = (from_collumn != to_collumn) ? STEP_PATH_COST : LANE_CHANGE_PATH_COST;
+    if (doesTileExist(to_collumn, to_row) && flow_field->tower[to_row-1][to_collumn-1]) cost += TOWER_PATH_COST;
+    return cost;
+}
+
+/* Lower path costs starting from open tiles (Dijkstra), every tile whose cost changed is marked as touched */
+void propagateFlowField(FlowField *flow_field, bool open[NB_ROWS][NB_COLLUMNS], bool touched[NB_ROWS][NB_COLLUMNS]) {
+    int neighbours[4][2] = {{-1, 0}, {0, -1}, {0, +1}, {+1, 0}};
+    /* Open tiles are kept in a binary heap sorted by cost then by tile index, so they are picked in the same order as a scan of the map would */
+    int heap[5*NB_ROWS*NB_COLLUMNS], heap_size = 0, collumn, row, cost, key, x, y, i, j;
+    for (y = 1; y <= NB_ROWS; y++) for (x = 1; x <= NB_COLLUMNS; x++) if (open[y-1][x-1] && flow_field->cost[y-1][x-1] < UNREACHABLE_PATH_COST)
+        heap[heap_size++] = flow_field->cost[y-1][x-1] * 128 + (y-1) * NB_COLLUMNS + (x-1);
+    for (i = heap_size / 2 - 1; i >= 0; i--) for (j = i; 2*j + 1 < heap_size; ) {
+        int child = (2*j + 2 < heap_size && heap[2*j + 2] < heap[2*j + 1]) ? 2*j + 2 : 2*j + 1;
+        if (heap[j] <= heap[child]) break;
+        key = heap[j]; heap[j] = heap[child]; heap[child] = key; j = child;
+    }
+    while (heap_size) {
+        /* Pick the open tile closest to the castle (outdated entries are skipped) */
+        key = heap[0];
+        heap[0] = heap[--heap_size];
+        for (j = 0; 2*j + 1 < heap_size; ) {
+            int child = (2*j + 2 < heap_size && heap[2*j + 2] < heap[2*j + 1]) ? 2*j + 2 : 2*j + 1;
+            if (heap[j] <= heap[child]) break;
+            i = heap[j]; heap[j] = heap[child]; heap[child] = i; j = child;
+        }
+        collumn = key % 128 % NB_COLLUMNS + 1; row = key % 128 / NB_COLLUMNS + 1; cost = key / 128;
+        if (!open[row-1][collumn-1] || flow_field->cost[row-1][collumn-1] != cost) continue;
+        open[row-1][collumn-1] = false;
+        /* Neighbours can reach the castle through this tile */
+        for (i = 0; i < 4; i++) {
+            x = collumn + neighbours[i][0]; y = row + neighbours[i][1];
+            if (!doesTileExist(x, y) || flow_field->blocked[y-1][x-1]) continue;
+            if (cost + getStepCost(flow_field, x, collumn, row) < flow_field->cost[y-1][x-1]) {
+                flow_field->cost[y-1][x-1] = cost + getStepCost(flow_field, x, collumn, row);
+                open[y-1][x-1] = touched[y-1][x-1] = true;
+                /* Sift the new entry up */
+                for (j = heap_size++, heap[j] = flow_field->cost[y-1][x-1] * 128 + (y-1) * NB_COLLUMNS + (x-1); j && heap[(j-1) / 2] > heap[j]; j = (j-1) / 2) {
+                    key = heap[j]; heap[j] = heap[(j-1) / 2]; heap[(j-1) / 2] = key;
+                }
+            }
+        }
+    }
+}
+
+/* Choose the next step of touched tiles and of their neighbours, ties favor going straight toward the castle */
+void refreshFlowSteps(FlowField *flow_field, bool touched[NB_ROWS][NB_COLLUMNS]) {
+    int neighbours[4][2] = {{-1, 0}, {0, -1}, {0, +1}, {+1, 0}};
+    bool refresh[NB_ROWS][NB_COLLUMNS] = {{false}};
+    int x, y, cost, best_cost;
+    for (int row = 1; row <= NB_ROWS; row++) for (int collumn = 1; collumn <= NB_COLLUMNS; collumn++) if (touched[row-1][collumn-1]) {
+        refresh[row-1][collumn-1] = true;
+        for (int i = 0; i < 4; i++) if (doesTileExist(collumn + neighbours[i][0], row + neighbours[i][1])) refresh[row-1 + neighbours[i][1]][collumn-1 + neighbours[i][0]] = true;
+    }
+    for (int row = 1; row <= NB_ROWS; row++) for (int collumn = 1; collumn <= NB_COLLUMNS; collumn++) if (refresh[row-1][collumn-1]) {
+        flow_field->step_x[row-1][collumn-1] = flow_field->step_y[row-1][collumn-1] = 0;
+        if (flow_field->blocked[row-1][collumn-1]) continue;
+        best_cost = UNREACHABLE_PATH_COST;
+        for (int i = 0; i < 4; i++) {
+            x = collumn + neighbours[i][0]; y = row + neighbours[i][1];
+            if (getPathCost(flow_field, x, y) >= UNREACHABLE_PATH_COST) continue;
+            cost = getPathCost(flow_field, x, y) + getStepCost(flow_field, collumn, x, y);
+            if (cost < best_cost) {
+                best_cost = cost;
+                flow_field->step_x[row-1][collumn-1] = neighbours[i][0];
+                flow_field->step_y[row-1][collumn-1] = neighbours[i][1];
+            }
+        }
+    }
+}
+
+/* Compute the whole flow field from scratch, should only be needed once per map */
+void computeFlowField(FlowField *flow_field) {
+    bool open[NB_ROWS][NB_COLLUMNS] = {{false}}, touched[NB_ROWS][NB_COLLUMNS];
+    for (int row = 1; row <= NB_ROWS; row++) for (int collumn = 1; collumn <= NB_COLLUMNS; collumn++) {
+        flow_field->cost[row-1][collumn-1] = UNREACHABLE_PATH_COST;
+        touched[row-1][collumn-1] = true;
+    }
+    /* The first collumn leads directly to the castle */
+    for (int row = 1; row <= NB_ROWS; row++) if (!flow_field->blocked[row-1][0]) {
+        flow_field->cost[row-1][0] = getStepCost(flow_field, 1, 0, row);
+        open[row-1][0] = true;
+    }
+    propagateFlowField(flow_field, open, touched);
+    refreshFlowSteps(flow_field, touched);
+}
+
+/* Repair the flow field after a tower was built (or destroyed) on a tile, only tiles whose path goes through that tile are updated */
+void repairFlowField(FlowField *flow_field, int collumn, int row, bool tower) {
+    if (!doesTileExist(collumn, row) || flow_field->tower[row-1][collumn-1] == tower) return;
+    int neighbours[4][2] = {{-1, 0}, {0, -1}, {0, +1}, {+1, 0}};
+    bool open[NB_ROWS][NB_COLLUMNS] = {{false}}, touched[NB_ROWS][NB_COLLUMNS] = {{false}}, affected[NB_ROWS][NB_COLLUMNS] = {{false}};
+    int stack[NB_ROWS*NB_COLLUMNS][2], stack_size = 0, x, y, cost, current_collumn, current_row;
+    flow_field->tower[row-1][collumn-1] = tower;
+    touched[row-1][collumn-1] = true;
+    /* Tower destroyed, paths through this tile can only get cheaper */
+    if (!tower) {
+        cost = getPathCost(flow_field, collumn, row);
+        if (cost < UNREACHABLE_PATH_COST) for (int i = 0; i < 4; i++) {
+            x = collumn + neighbours[i][0]; y = row + neighbours[i][1];
+            if (!doesTileExist(x, y) || flow_field->blocked[y-1][x-1]) continue;
+            if (cost + getStepCost(flow_field, x, collumn, row) < flow_field->cost[y-1][x-1]) {
+                flow_field->cost[y-1][x-1] = cost + getStepCost(flow_field, x, collumn, row);
+                open[y-1][x-1] = touched[y-1][x-1] = true;
+            }
+        }
+    }
+    /* Tower built, every tile whose path went through this tile has to find its path again */
+    else {
+        stack[stack_size][0] = collumn; stack[stack_size][1] = row; stack_size++;
+        while (stack_size) {
+            stack_size--;
+            current_collumn = stack[stack_size][0]; current_row = stack[stack_size][1];
+            for (int i = 0; i < 4; i++) {
+                x = current_collumn + neighbours[i][0]; y = current_row + neighbours[i][1];
+                if (!doesTileExist(x, y) || affected[y-1][x-1]) continue;
+                if (x + flow_field->step_x[y-1][x-1] != current_collumn || y + flow_field->step_y[y-1][x-1] != current_row) continue;
+                affected[y-1][x-1] = touched[y-1][x-1] = true;
+                flow_field->cost[y-1][x-1] = UNREACHABLE_PATH_COST;
+                stack[stack_size][0] = x; stack[stack_size][1] = y; stack_size++;
+            }
+        }
+        /* Affected tiles start again from their unaffected neighbours */
+        for (y = 1; y <= NB_ROWS; y++) for (x = 1; x <= NB_COLLUMNS; x++) if (affected[y-1][x-1]) {
+            for (int i = 0; i < 4; i++) {
+                cost = getPathCost(flow_field, x + neighbours[i][0], y + neighbours[i][1]);
+                if (cost >= UNREACHABLE_PATH_COST || (doesTileExist(x + neighbours[i][0], y + neighbours[i][1]) && affected[y-1 + neighbours[i][1]][x-1 + neighbours[i][0]])) continue;
+                cost += getStepCost(flow_field, x, x + neighbours[i][0], y + neighbours[i][1]);
+                if (cost < flow_field->cost[y-1][x-1]) flow_field->cost[y-1][x-1] = cost;
+            }
+            open[y-1][x-1] = (flow_field->cost[y-1][x-1] < UNREACHABLE_PATH_COST);
+        }
+    }
+    propagateFlowField(flow_field, open, touched);
+    refreshFlowSteps(flow_field, touched);
+}
+
+/* Repair the flow field where towers were built or destroyed since the last update */
+void updateFlowField(FlowField *flow_field, Tower *tower_list) {
+    if (!flow_field) return;
+    bool tower[NB_ROWS][NB_COLLUMNS] = {{false}};
+    for (; tower_list; tower_list = tower_list->next) if (doesTileExist(tower_list->collumn, tower_list->row)) tower[tower_list->row-1][tower_list->collumn-1] = true;
+    for (int row = 1; row <= NB_ROWS; row++) for (int collumn = 1; collumn <= NB_COLLUMNS; collumn++)
+        if (flow_field->tower[row-1][collumn-1] != tower[row-1][collumn-1]) repairFlowField(flow_field, collumn, row, tower[row-1][collumn-1]);
+}
+
+/* Get the next step toward the castle from a tile, return false if there is none */
+bool getFlowStep(FlowField *flow_field, int collumn, int row, int *dx, int *dy) {
+    *dx = 0; *dy = 0;
+    /* Enemies outside of the map walk straight toward it */
+    if (collumn > NB_COLLUMNS) *dx = -1;
+    else if (flow_field && doesTileExist(collumn, row)) {
+        *dx = flow_field->step_x[row-1][collumn-1];
+        *dy = flow_field->step_y[row-1][collumn-1];
+    }
+    /* No flow field, walk straight toward the castle */
+    else if (collumn >= 1) *dx = -1;
+    return (*dx || *dy);
+}
+
+
+
+
+/* Get the stats of an enemy type, return false if the type is unknown */
+bool getEnemyStats(char enemy_type, int *max_life_points, int *base_speed, int *score_on_kill) {
+    switch (enemy_type) {
+        case SLIME_ENEMY:       *max_life_points = 5;  *base_speed = 2; *score_on_kill = 25;  return true;
+        case GELLY_ENEMY:       *max_life_points = 6;  *base_speed = 2; *score_on_kill = 50;  return true;
+        case GOBLIN_ENEMY:      *max_life_points = 10; *base_speed = 3; *score_on_kill = 75;  return true;
+        case ORC_ENEMY:         *max_life_points = 20; *base_speed = 1; *score_on_kill = 150; return true;
+        case NECROMANCER_ENEMY: *max_life_points = 13; *base_speed = 1; *score_on_kill = 200; return true;
+        case SKELETON_ENEMY:    *max_life_points = 4;  *base_speed = 3; *score_on_kill = 25;  return true;
+        case WITCH_ENEMY:       *max_life_points = 7;  *base_speed = 1; *score_on_kill = 100; return true;
+        default:                return false;
+    }
+}
+
+/* Add an enemy to the list of enemies, fail if cannot spawn enemy at specified location or if enemy type is not defined */
+Enemy *addEnemy(Enemy **enemy_list, char enemy_type, int spawn_collumn, int spawn_row, int life_points, uint64_t *hash) {
+    if (!enemy_list) return NULL;
+    /* Can't summon enemies in not existing rows */
+    if (1 > spawn_row || spawn_row > NB_ROWS) return NULL;
+
+    /* Initialize the new enemy */
+    Enemy *new_enemy = malloc(sizeof(Enemy));
+    new_enemy->type = enemy_type;
+    new_enemy->collumn = spawn_collumn;
+    new_enemy->row = spawn_row;
+    new_enemy->next = new_enemy->next_on_row = new_enemy->prev_on_row = NULL;
+    new_enemy->id = NEXT_ENTITY_ID++;
+    /* Match the enemy type to its stats */
+    if (!getEnemyStats(enemy_type, &new_enemy->max_life_points, &new_enemy->base_speed, &new_enemy->score_on_kill)) {
+        printf("[ERROR]    Unknown enemy type '%c'\n", enemy_type);
+        free(new_enemy);
+        return NULL;
+    }
+    new_enemy->life_points = new_enemy->max_life_points;
+    new_enemy->speed = new_enemy->base_speed;
+    /* If health is manualy set */
+    if (!enemy_list) return new_enemy;
+    if (life_points != -1){
+        new_enemy->life_points = life_points;
+    }
+    /* Add the new enemy to the enemy list */
+    /* If empty then no search is needed */
+    if (!(*enemy_list)) {
+        *enemy_list = new_enemy;
+        toggleEnemyHash(hash, new_enemy);
+        return new_enemy;
+    }
+    
+    Enemy *current = *enemy_list;
+    /* Look for the previous and next enemy on the same row as this new enemy */
+    while (true) {
+        if (current->row == new_enemy->row) {
+            /* Enemy located on the same row and in front of this new enemy (to the left) */
+            if (current->collumn < new_enemy->collumn) {
+                if (!new_enemy->prev_on_row || new_enemy->prev_on_row->collumn < current->collumn) new_enemy->prev_on_row = current;
+            }
+            /* Enemy located on the same row and behind this new enemy (to the right) */
+            else if (current->collumn > new_enemy->collumn) {
+                if (!new_enemy->next_on_row || new_enemy->next_on_row->collumn > current->collumn) new_enemy->next_on_row = current;
+            }
+            /* Enemy located on the same exact spot as this new enemy, cannot spawn properly */
+            else {
+                free(new_enemy);
+                return NULL;
+            }
+        }
+        if (!current->next) break;
+        current = current->next;
+    }
+    /* Add the new enemy to the enemy list */
+    current->next = new_enemy;
+    if (new_enemy->prev_on_row) new_enemy->prev_on_row->next_on_row = new_enemy;
+    if (new_enemy->next_on_row) new_enemy->next_on_row->prev_on_row = new_enemy;
+    toggleEnemyHash(hash, new_enemy);
+    return new_enemy;
+}
+
+/* Destroy an enemy and free its allocated memory */
+void destroyEnemy(Enemy *enemy, Enemy **enemy_list, uint64_t *hash) {
+    if (!enemy) return;
+    /* Change pointers of enemies accordingly (its key only leaves the hash if it was in the list) */
+    if (enemy_list) {
+        if (*enemy_list == enemy) {
+            *enemy_list = enemy->next;
+            toggleEnemyHash(hash, enemy);
+        }
+        else {
+            Enemy *prev_enemy = *enemy_list;
+            while (prev_enemy && prev_enemy->next != enemy) prev_enemy = prev_enemy->next;
+            if (prev_enemy) {
+                prev_enemy->next = enemy->next;
+                toggleEnemyHash(hash, enemy);
+            }
+        }
+    }
+    if (enemy->prev_on_row) enemy->prev_on_row->next_on_row = enemy->next_on_row;
+    if (enemy->next_on_row) enemy->next_on_row->prev_on_row = enemy->prev_on_row;
+    /* Destroy enemy data */
+    free(enemy);
+}
+
+/* Return if an enemy still exists, and was not replaced by a new enemy at the same address */
+bool doesEnemyExist(Enemy *enemy_list, Enemy *enemy, int id) {
+    if (!enemy) return false;
+    while (enemy_list && enemy_list != enemy) enemy_list = enemy_list->next;
+    return enemy_list && enemy_list->id == id;
+}
+
+/* Get an array containing the first enemy of each row, NULL if there is none on the row */
+Enemy **getFirstEnemyOfAllRows(Enemy *enemy_list) {
+    /* Initializing to NULL */
+    Enemy **first_of_each_row = malloc(NB_ROWS * sizeof(Enemy *));
+    for (int row_nb = 1; row_nb <= NB_ROWS; row_nb++) first_of_each_row[row_nb-1] = NULL;
+    /* Go trough all enemies */
+    Enemy *enemy = enemy_list;
+    while (enemy) {
+        if (!first_of_each_row[enemy->row-1] || first_of_each_row[enemy->row-1]->collumn > enemy->collumn) first_of_each_row[enemy->row-1] = enemy;
+        enemy = enemy->next;
+    }
+    return first_of_each_row;
+}
+
+/* Get the first enemy of a row */
+Enemy *getFirstEnemyInRow(Enemy *enemy_list, int row) {
+    Enemy **first_of_each_row = getFirstEnemyOfAllRows(enemy_list);
+    Enemy *first_of_row = first_of_each_row[row-1];
+    free(first_of_each_row);
+    return first_of_row;
+}
+
+/* Move enemy, return number of tile moved */
+int moveEnemy(Enemy *enemy, Enemy *enemy_list, Tower *tower_list, FlowField *flow_field, int delta, char axis, uint64_t *hash) {
+    /* Move on the x axis */
+    if (axis == 'x' || axis == 'X') {
+        /* Colliding with terrain, towers and other enemies */
+        for (int i = 0; i < abs(delta); i++) if (isTileBlocked(flow_field, enemy->collumn + (i+1)*sign(delta), enemy->row) || !isTileEmpty(enemy_list, tower_list, enemy->collumn + (i+1)*sign(delta), enemy->row)) {
+            delta = i*sign(delta);
+            break;
+        }
+        /* Moving on the x axis */
+        toggleEnemyHash(hash, enemy);
+        enemy->collumn += delta;
+        toggleEnemyHash(hash, enemy);
+        return delta;
+    }
+
+    /* Move on the y axis */
+    if (axis == 'y' || axis == 'Y') {
+        /* Colliding with terrain, towers and other enemies */
+        for (int i = 0; i < abs(delta); i++) if (!doesTileExist(enemy->collumn, enemy->row + (i+1)*sign(delta)) || isTileBlocked(flow_field, enemy->collumn, enemy->row + (i+1)*sign(delta)) || !isTileEmpty(enemy_list, tower_list, enemy->collumn, enemy->row + (i+1)*sign(delta))) {
+            delta = i*sign(delta);
+            break;
+        }
+        /* If delta == 0, nothing happens */
+        if (!delta) return 0;
+        /* Updating pointers */
+        if (enemy->next_on_row) enemy->next_on_row->prev_on_row = enemy->prev_on_row;
+        if (enemy->prev_on_row) enemy->prev_on_row->next_on_row = enemy->next_on_row;
+        enemy->prev_on_row = enemy->next_on_row = NULL;
+        toggleEnemyHash(hash, enemy);
+        enemy->row += delta;
+        toggleEnemyHash(hash, enemy);
+        /* Moving on the y axis */
+        Enemy *current = enemy_list;
+        while (current) {
+            if (current->row == enemy->row) {
+                /* Enemy located on the same row and in front of this new enemy (to the left) */
+                if (current->collumn < enemy->collumn) {
+                    if (!enemy->prev_on_row || enemy->prev_on_row->collumn < current->collumn) enemy->prev_on_row = current;
+                }
+                /* Enemy located on the same row and behind this new enemy (to the right) */
+                else if (current->collumn > enemy->collumn) {
+                    if (!enemy->next_on_row || enemy->next_on_row->collumn > current->collumn) enemy->next_on_row = current;
+                }
+            }
+            current = current->next;
+        }
+        /* Updating pointers */
+        if (enemy->prev_on_row) enemy->prev_on_row->next_on_row = enemy;
+        if (enemy->next_on_row) enemy->next_on_row->prev_on_row = enemy;
+        return delta;
+    }
+
+    /* Invalid axis */
+    printf("[ERROR]    Can only move an enemy on the 'x' or 'y' axis, not on the '%c' axis\n", axis);
+    return 0;
+}
+
+/* Make all enemies move accordingly to their type, following the flow field toward the castle */
+void makeAllEnemiesMove(Enemy *enemy_list, Tower *tower_list, FlowField *flow_field, EventLog *event_log, uint64_t *hash) {
+    /* Take into account towers built or destroyed since last turn */
+    updateFlowField(flow_field, tower_list);
+    /* Update enemies from left to right, from top to bottom (order is fixed before moving as enemies may change row) */
+    Enemy **first_of_each_row = getFirstEnemyOfAllRows(enemy_list);
+    Enemy **moving_order = NULL, *enemy;
+    int nb_enemies = 0, dx, dy, total_dx, total_dy;
+    /* From top to bottom */
+    for (int row_nb = 1; row_nb <= NB_ROWS; row_nb++) {
+        enemy = first_of_each_row[row_nb-1];
+        /* From left to right */
+        while (enemy) {
+            nb_enemies++;
+            moving_order = realloc(moving_order, nb_enemies * sizeof(Enemy *));
+            moving_order[nb_enemies-1] = enemy;
+            enemy = enemy->next_on_row;
+        }
+    }
+    for (int i = 0; i < nb_enemies; i++) {
+        enemy = moving_order[i];
+        total_dx = total_dy = 0;
+        /* One flow field lookup per tile travelled */
+        for (int j = 0; j < enemy->speed && getFlowStep(flow_field, enemy->collumn, enemy->row, &dx, &dy); j++) {
+            if (dx && moveEnemy(enemy, enemy_list, tower_list, flow_field, dx, 'x', hash)) total_dx += dx;
+            else if (dy && moveEnemy(enemy, enemy_list, tower_list, flow_field, dy, 'y', hash)) total_dy += dy;
+            else break;
+        }
+        /* Spawn animations are logged when enemies enter the map (see spawnQueuedEnemies) */
+        if (total_dx || total_dy) logEnemyEvent(event_log, MOVE_EVENT, enemy, total_dx, total_dy, 0);
+        toggleEnemyHash(hash, enemy);
+        enemy->speed = enemy->base_speed;
+        toggleEnemyHash(hash, enemy);
+    }
+    /* Free memory */
+    free(moving_order);
+    free(first_of_each_row);
+}
+
+/* Make a singular enemy attack */
+void enemyAttack(Enemy *enemy, Tower **tower_list, Enemy **enemy_list, FlowField *flow_field, EventLog *event_log, CombatStats *stats, uint64_t *hash) {
+    if (!enemy) return;
+    /* Getting tower in front of the enemy (if there is one), following its path toward the castle */
+    Enemy *e; Tower *tower; bool result; int dx, dy, n;
+    if (!getFlowStep(flow_field, enemy->collumn, enemy->row, &dx, &dy)) dx = -1;
+    getEnemyAndTowerAt(*enemy_list, *tower_list, enemy->collumn + dx, enemy->row + dy, &e, &tower);
+    /* Making enemy act accordingly to its type */
+    result = 0;
+    if (stats) stats->attacker_type = enemy->type;
+    switch (enemy->type) {
+        case SLIME_ENEMY:
+            if (tower) result = damageTower(tower, 2, tower_list, event_log, stats, hash);
+            break;
+        case GELLY_ENEMY:
+            if (tower) result = damageTower(tower, 2, tower_list, event_log, stats, hash);
+            break;
+        case GOBLIN_ENEMY:
+            if (tower) result = damageTower(tower, 3, tower_list, event_log, stats, hash);
+            break;
+        case ORC_ENEMY:
+            if (tower) result = damageTower(tower, 5, tower_list, event_log, stats, hash);
+            break;
+        case NECROMANCER_ENEMY:
+            if (tower) result = damageTower(tower, 4, tower_list, event_log, stats, hash);
+            break;
+        case SKELETON_ENEMY:
+            if (tower) result = damageTower(tower, 2, tower_list, event_log, stats, hash);
+            break;
+        case WITCH_ENEMY:
+            if (tower) result = damageTower(tower, 2, tower_list, event_log, stats, hash);
+            /* Area heal and speed boost (except for self) */
+            for (int y = -1; y <= 1; y++) for (int x = -1; x <= 1; x++) if (x || y) if (getEnemyAndTowerAt(*enemy_list, NULL, enemy->collumn+x, enemy->row+y, &e, NULL)) {
+                toggleEnemyHash(hash, e);
+                /* Heal */
+                if (e->max_life_points != e->life_points) {
+                    n = min(3, e->max_life_points - e->life_points);
+                    e->life_points += n;
+                    logEnemyEvent(event_log, DAMAGE_EVENT, e, 0, 0, -n);
+                }
+                /* Speed boost */
+                e->speed += 1;
+                toggleEnemyHash(hash, e);
+            }
+            break;
+        default:  /* Unknown enemy type */
+            printf("[ERROR]    Unknown enemy type '%c'\n", enemy->type);
+            logEnemyEvent(event_log, DEATH_EVENT, enemy, 0, 0, 0);
+            destroyEnemy(enemy, enemy_list, hash);
+            return;
+    }
+    if (result) {
+        logEnemyEvent(event_log, ATTACK_EVENT, enemy, dx ? dx : -1, 0, 0);
+        toggleEnemyHash(hash, enemy);
+        enemy->speed = 0;
+        toggleEnemyHash(hash, enemy);
+    }
+}
+
+/* Damage an enemy */
+bool damageEnemy(Enemy *enemy, int amount, Enemy **enemy_list, Tower *tower_list, FlowField *flow_field, EventLog *event_log, int *score, CombatStats *stats, uint64_t *hash) {
+    if (!enemy || !amount || !enemy_list) return false;
+    int n, x, y;
+
+    /* Check that enemy still exist */
+    Enemy *e = *enemy_list;
+    while (e && e != enemy) e = e->next;
+    if (!e) return false;
+    /* Damage enemy (only the life points actually lost count in statistics) */
+    if (stats) {
+        stats->tower_damage_dealt[(int) stats->attacker_type] += min(amount, max(enemy->life_points, 0));
+        stats->enemy_damage_taken[enemy->type] += min(amount, max(enemy->life_points, 0));
+    }
+    toggleEnemyHash(hash, enemy);
+    enemy->life_points -= amount;
+    toggleEnemyHash(hash, enemy);
+    logEnemyEvent(event_log, DAMAGE_EVENT, enemy, 0, 0, amount);
+    /* Kill enemy if health reaches 0 or less */
+    if (enemy->life_points <= 0) {
+        n = enemy->type; x = enemy->collumn; y = enemy->row;
+        if (hash) *hash ^= hashValue(SCORE_FEATURE, *score) ^ hashValue(SCORE_FEATURE, *score + enemy->score_on_kill);
+        *score += enemy->score_on_kill;
+        if (stats) stats->nb_enemies_killed[n]++;
+        logEnemyEvent(event_log, DEATH_EVENT, enemy, 0, 0, 0);
+        destroyEnemy(enemy, enemy_list, hash);
+        /* Gelly splits into 2 slimes on death, one above and one bellow + one at current position or behind if a slime spawn position is blocked */
+        if (n == GELLY_ENEMY) {
+            n = 2;
+            if (n-- && isTileEmpty(*enemy_list, tower_list, x, y - 1) && doesTileExist(x, y - 1) && !isTileBlocked(flow_field, x, y - 1) && (e = addEnemy(enemy_list, SLIME_ENEMY, x, y - 1, -1, hash))) logEnemyEvent(event_log, ENEMY_SPAWN_EVENT, e, 0, -1, 0);
+            else n++;
+            if (n-- && isTileEmpty(*enemy_list, tower_list, x, y + 1) && doesTileExist(x, y + 1) && !isTileBlocked(flow_field, x, y + 1) && (e = addEnemy(enemy_list, SLIME_ENEMY, x, y + 1, -1, hash))) logEnemyEvent(event_log, ENEMY_SPAWN_EVENT, e, 0, +1, 0);
+            else n++;
+            if (n-- && isTileEmpty(*enemy_list, tower_list, x + 1, y) && doesTileExist(x + 1, y) && !isTileBlocked(flow_field, x + 1, y) && (e = addEnemy(enemy_list, SLIME_ENEMY, x + 1, y, -1, hash))) logEnemyEvent(event_log, ENEMY_SPAWN_EVENT, e, +1, 0, 0);
+            else n++;
+            if (n-- && isTileEmpty(*enemy_list, tower_list, x, y) && doesTileExist(x, y) && !isTileBlocked(flow_field, x, y) && (e = addEnemy(enemy_list, SLIME_ENEMY, x, y, -1, hash))) logEnemyEvent(event_log, ENEMY_SPAWN_EVENT, e, 0, 0, 0);
+            else n++;
+        }
+        return true;
+    }
+
+    /* Goblin changes row on hit, depending on its hp left */
+    if (enemy->type == GOBLIN_ENEMY) {
+        n = 0;
+        if (enemy->life_points % 2) {
+            n = moveEnemy(enemy, *enemy_list, tower_list, flow_field, 1, 'y', hash);
+            if (!n) n = moveEnemy(enemy, *enemy_list, tower_list, flow_field, -1, 'y', hash);
+        }
+        else {
+            n = moveEnemy(enemy, *enemy_list, tower_list, flow_field, -1, 'y', hash);
+            if (!n) n = moveEnemy(enemy, *enemy_list, tower_list, flow_field, 1, 'y', hash);
+        }
+        if (n) logEnemyEvent(event_log, MOVE_EVENT, enemy, 0, n, 0);
+    }
+    /* Necromancer summons a skeleton nearby on hit */
+    else if (enemy->type == NECROMANCER_ENEMY) {
+        x = enemy->collumn; y = enemy->row;
+        if (isTileEmpty(*enemy_list, tower_list, x - 1, y) && doesTileExist(x - 1, y) && !isTileBlocked(flow_field, x - 1, y) && (e = addEnemy(enemy_list, SKELETON_ENEMY, x - 1, y, -1, hash))) logEnemyEvent(event_log, ENEMY_SPAWN_EVENT, e, 0, 0, 0);
+        else if (isTileEmpty(*enemy_list, tower_list, x, y - 1) && doesTileExist(x, y - 1) && !isTileBlocked(flow_field, x, y - 1) && (e = addEnemy(enemy_list, SKELETON_ENEMY, x, y - 1, -1, hash))) logEnemyEvent(event_log, ENEMY_SPAWN_EVENT, e, 0, 0, 0);
+        else if (isTileEmpty(*enemy_list, tower_list, x, y + 1) && doesTileExist(x, y + 1) && !isTileBlocked(flow_field, x, y + 1) && (e = addEnemy(enemy_list, SKELETON_ENEMY, x, y + 1, -1, hash))) logEnemyEvent(event_log, ENEMY_SPAWN_EVENT, e, 0, 0, 0);
+        else if (isTileEmpty(*enemy_list, tower_list, x + 1, y) && doesTileExist(x + 1, y) && !isTileBlocked(flow_field, x + 1, y) && (e = addEnemy(enemy_list, SKELETON_ENEMY, x + 1, y, -1, hash))) logEnemyEvent(event_log, ENEMY_SPAWN_EVENT, e, 0, 0, 0);
+    }
+    return true;
+}
+
+
+
+
+/* Create a new empty spawn queue */
+SpawnQueue *newSpawnQueue() {
+    SpawnQueue *spawn_queue = malloc(sizeof(SpawnQueue));
+    spawn_queue->entries = NULL;
+    spawn_queue->head = spawn_queue->nb_entries = spawn_queue->capacity = 0;
+    return spawn_queue;
+}
+
+/* Destroy a spawn queue and free its allocated memory */
+void destroySpawnQueue(SpawnQueue *spawn_queue) {
+    if (!spawn_queue) return;
+    if (spawn_queue->entries) free(spawn_queue->entries);
+    free(spawn_queue);
+}
+
+/* Create a copy of a spawn queue (entries are copied at once) */
+SpawnQueue *cloneSpawnQueue(SpawnQueue *spawn_queue) {
+    SpawnQueue *clone = malloc(sizeof(SpawnQueue));
+    *clone = *spawn_queue;
+    clone->entries = NULL;
+    if (spawn_queue->capacity) {
+        clone->entries = malloc(spawn_queue->capacity * sizeof(SpawnEntry));
+        memcpy(clone->entries, spawn_queue->entries, spawn_queue->nb_entries * sizeof(SpawnEntry));
+    }
+    return clone;
+}
+
+/* Remove every entry of the spawn queue (memory is kept for the next wave) */
+void clearSpawnQueue(SpawnQueue *spawn_queue) {
+    spawn_queue->head = spawn_queue->nb_entries = 0;
+}
+
+/* Return if no enemy is waiting to enter the map */
+bool isSpawnQueueEmpty(SpawnQueue *spawn_queue) {
+    return !spawn_queue || spawn_queue->head >= spawn_queue->nb_entries;
+}
+
+/* Return the index of the first waiting entry that is not before (turn, row), using a binary search */
+int findSpawnEntry(SpawnQueue *spawn_queue, int turn, int row) {
+    int a = spawn_queue->head, b = spawn_queue->nb_entries, c;
+    while (a < b) {
+        c = (a + b) / 2;
+        if (spawn_queue->entries[c].turn < turn || (spawn_queue->entries[c].turn == turn && spawn_queue->entries[c].row < row)) a = c + 1;
+        else b = c;
+    }
+    return a;
+}
+
+/* Return if an enemy is already waiting to enter the map on this row and on this turn */
+bool isSpawnQueued(SpawnQueue *spawn_queue, int turn, int row) {
+    int i = findSpawnEntry(spawn_queue, turn, row);
+    return i < spawn_queue->nb_entries && spawn_queue->entries[i].turn == turn && spawn_queue->entries[i].row == row;
+}
+
+/* Add an enemy to the spawn queue, fail if the row does not exist or if an enemy already enters there on that turn */
+bool queueEnemy(SpawnQueue *spawn_queue, char enemy_type, int row, int turn) {
+    if (!spawn_queue || 1 > row || row > NB_ROWS) return false;
+    int i = findSpawnEntry(spawn_queue, turn, row);
+    if (i < spawn_queue->nb_entries && spawn_queue->entries[i].turn == turn && spawn_queue->entries[i].row == row) return false;
+    /* Make room for the new entry */
+    if (spawn_queue->nb_entries >= spawn_queue->capacity) {
+        spawn_queue->capacity = max(16, spawn_queue->capacity * 2);
+        spawn_queue->entries = realloc(spawn_queue->entries, spawn_queue->capacity * sizeof(SpawnEntry));
+    }
+    memmove(&spawn_queue->entries[i+1], &spawn_queue->entries[i], (spawn_queue->nb_entries - i) * sizeof(SpawnEntry));
+    spawn_queue->entries[i] = (SpawnEntry) {enemy_type, row, turn};
+    spawn_queue->nb_entries++;
+    return true;
+}
+
+/* Remove the enemy waiting to enter the map on this row and on this turn, fail if there is none */
+bool unqueueEnemy(SpawnQueue *spawn_queue, int row, int turn) {
+    if (!spawn_queue || !isSpawnQueued(spawn_queue, turn, row)) return false;
+    int i = findSpawnEntry(spawn_queue, turn, row);
+    memmove(&spawn_queue->entries[i], &spawn_queue->entries[i+1], (spawn_queue->nb_entries - i - 1) * sizeof(SpawnEntry));
+    spawn_queue->nb_entries--;
+    return true;
+}
+
+/* Return the turn on which the last waiting enemy enters the map, 0 if there is none */
+int getLastSpawnTurn(SpawnQueue *spawn_queue) {
+    if (isSpawnQueueEmpty(spawn_queue)) return 0;
+    return spawn_queue->entries[spawn_queue->nb_entries - 1].turn;
+}
+
+/* Make waiting enemies enter the map (on the last collumn) once their turn has come and their spawn tile is free, return the number of enemies spawned */
+int spawnQueuedEnemies(SpawnQueue *spawn_queue, int turn_nb, Enemy **enemy_list, Tower *tower_list, EventLog *event_log, uint64_t *hash) {
+    if (!spawn_queue) return 0;
+    int nb_spawned = 0, last = spawn_queue->head, kept;
+    Enemy *enemy;
+    /* Only entries whose turn has come are looked at */
+    while (last < spawn_queue->nb_entries && spawn_queue->entries[last].turn <= turn_nb) last++;
+    for (int i = spawn_queue->head; i < last; i++) {
+        /* Spawn tile still occupied, wait for next turn */
+        if (!isTileEmpty(*enemy_list, tower_list, NB_COLLUMNS, spawn_queue->entries[i].row)) continue;
+        if ((enemy = addEnemy(enemy_list, spawn_queue->entries[i].type, NB_COLLUMNS, spawn_queue->entries[i].row, -1, hash))) {
+            logEnemyEvent(event_log, ENEMY_SPAWN_EVENT, enemy, 0, 0, 0);
+            nb_spawned++;
+        }
+        if (hash) *hash ^= hashSpawn(spawn_queue->entries[i].type, spawn_queue->entries[i].row, spawn_queue->entries[i].turn);
+        spawn_queue->entries[i].type = '\0';
+    }
+    /* Keep entries still waiting right before the entries whose turn has not come yet */
+    kept = last;
+    for (int i = last - 1; i >= spawn_queue->head; i--) if (spawn_queue->entries[i].type) spawn_queue->entries[--kept] = spawn_queue->entries[i];
+    spawn_queue->head = kept;
+    return nb_spawned;
+}
+
+
+
+/* Get the stats of a tower type, return false if the type is unknown */
+bool getTowerStats(char tower_type, int *max_life_points, int *cost, int *base_attack_cooldown) {
+    switch (tower_type) {
+        case ARCHER_TOWER:    *max_life_points = 6;  *cost = 50;  *base_attack_cooldown = 1; return true;
+        case WALL_TOWER:      *max_life_points = 10; *cost = 30;  *base_attack_cooldown = 1; return true;
+        case BARRACK_TOWER:   *max_life_points = 15; *cost = 70;  *base_attack_cooldown = 5; return true;
+        case SOLIDER_TOWER:   *max_life_points = 4;  *cost = 0;   *base_attack_cooldown = 1; return true;
+        case CANON_TOWER:     *max_life_points = 4;  *cost = 100; *base_attack_cooldown = 3; return true;
+        case DESTROYER_TOWER: *max_life_points = 8;  *cost = 120; *base_attack_cooldown = 3; return true;
+        case SORCERER_TOWER:  *max_life_points = 5;  *cost = 70;  *base_attack_cooldown = 2; return true;
+        case MAGE_TOWER:      *max_life_points = 7;  *cost = 100; *base_attack_cooldown = 2; return true;
+        default:              return false;
+    }
+}
+
+Tower *addTower(Tower **tower_list, Enemy *enemy_list, char tower_type, int placement_collumn, int placement_row, int life_points, uint64_t *hash) {
+    /* Invalid position (cannot place outside of the map or on the last collumn) */
+    if (1 > placement_row || placement_row > NB_ROWS || 1 > placement_collumn || placement_collumn > NB_COLLUMNS-1) return NULL;
+
+    /* Initialize a new tower object */
+    Tower *new_tower = malloc(sizeof(Tower));
+    new_tower->type = tower_type;
+    new_tower->collumn = placement_collumn;
+    new_tower->row = placement_row;
+    new_tower->attack_cooldown = 1;
+    new_tower->next = NULL;
+    new_tower->id = NEXT_ENTITY_ID++;
+    if (!getTowerStats(tower_type, &new_tower->max_life_points, &new_tower->cost, &new_tower->base_attack_cooldown)) {
+        printf("[ERROR]    Unknown tower type '%c'\n", tower_type);
+        destroyTower(new_tower, tower_list, hash);
+        return NULL;
+    }
+    new_tower->life_points = new_tower->max_life_points;
+    /* If health is manually set */
+    if (life_points !=-1){
+        new_tower->life_points = life_points;
+    }
+    if (!tower_list) return new_tower;
+    /* Add the tower to the list of towers */
+    if (!(*tower_list)) {
+        *tower_list = new_tower;
+        toggleTowerHash(hash, new_tower);
+        return new_tower;
+    }
+    /* Verify if the creation space is empty, as towers cannot be build on an already occupied space */
+    if (!isTileEmpty(enemy_list, *tower_list, placement_collumn, placement_row)) {
+        destroyTower(new_tower, tower_list, hash);
+        return NULL;
+    }
+    Tower *prev_tower = *tower_list; 
+    while (prev_tower->next != NULL) {
+        prev_tower = prev_tower->next;
+    }
+    prev_tower->next = new_tower;
+    toggleTowerHash(hash, new_tower);
+    return new_tower;
+}
+
+/* Try to buy a tower */
+Tower *buyTower(Tower **tower_list, Enemy *enemy_list, FlowField *flow_field, char tower_type, int placement_collumn, int placement_row, int *funds, uint64_t *hash) {
+    Tower *new_tower;
+    /* Cannot build on blocked terrain */
+    if (isTileBlocked(flow_field, placement_collumn, placement_row)) return NULL;
+    new_tower = addTower(tower_list, enemy_list, tower_type, placement_collumn, placement_row, -1, hash);
+    /* If new_tower is NULL, it means it couldn't be build */
+    if (!new_tower) return NULL;
+    /* Check if the player has enough funds to build the tower */
+    if (*funds < new_tower->cost) {
+        destroyTower(new_tower, tower_list, hash);
+        return NULL;
+    }
+    *funds -= new_tower->cost;
+    return new_tower;
+}
+
+/* Try to upgrade a tower */
+Tower *upgradeTower(Tower **tower_list, Enemy *enemy_list, char tower_type, int placement_collumn, int placement_row, int *funds, uint64_t *hash) {
+    Tower *old_tower,*new_tower;
+    switch (tower_type){
+        case WALL_TOWER:
+            getEnemyAndTowerAt(NULL, *tower_list, placement_collumn, placement_row, NULL, &old_tower);
+            destroyTower(old_tower, tower_list, hash);
+            new_tower = addTower(tower_list,enemy_list, BARRACK_TOWER, placement_collumn, placement_row, -1, hash);
+            if (*funds < new_tower->cost){
+                destroyTower(new_tower,tower_list, hash);
+                addTower(tower_list, enemy_list, tower_type, placement_collumn, placement_row, -1, hash);
+                return NULL;
+            }
+            *funds -= new_tower->cost;
+            break;
+        case SORCERER_TOWER:
+            getEnemyAndTowerAt(NULL, *tower_list, placement_collumn, placement_row, NULL, &old_tower);
+            destroyTower(old_tower, tower_list, hash);
+            new_tower = addTower(tower_list, enemy_list, MAGE_TOWER, placement_collumn, placement_row, -1, hash);
+            if (*funds < new_tower->cost){
+                destroyTower(new_tower,tower_list, hash);
+                addTower(tower_list, enemy_list, tower_type, placement_collumn, placement_row, -1, hash);
+                return NULL;
+            }
+            *funds -= new_tower->cost;
+            break;
+        case CANON_TOWER:
+            getEnemyAndTowerAt(NULL, *tower_list, placement_collumn, placement_row, NULL, &old_tower);
+            destroyTower(old_tower, tower_list, hash);
+            new_tower = addTower(tower_list, enemy_list, DESTROYER_TOWER, placement_collumn, placement_row, -1, hash);
+            if (*funds < new_tower->cost) {
+                destroyTower(new_tower, tower_list, hash);
+                addTower(tower_list, enemy_list, tower_type, placement_collumn, placement_row, -1, hash);
+                return NULL;
+            }
+            *funds -= new_tower->cost;
+            break;
+        default:
+            printf("No upgrade for that kind of tower");
+            return NULL;
+    }
+    return new_tower;
+}
+
+/* Destroy an tower and free its allocated memory */
+void destroyTower(Tower *tower, Tower **tower_list, uint64_t *hash) {
+    if (!tower) return;
+    /* Change pointers of tower accordingly (its key only leaves the hash if it was in the list) */
+    if (tower_list) {
+        Tower *prev_tower = *tower_list;
+        if (prev_tower == tower) {
+            *tower_list = tower->next;
+            toggleTowerHash(hash, tower);
+        }
+        else {
+            while (prev_tower && prev_tower->next != tower) prev_tower = prev_tower->next;
+            if (prev_tower) {
+                prev_tower->next = tower->next;
+                toggleTowerHash(hash, tower);
+            }
+        }
+    }
+    /* Destroy tower data */
+    free(tower);
+}
+
+/* Sell the tower and refund its cost (in case of miss click) */
+void sellTower(Tower *tower, Tower **tower_list, int *funds, uint64_t *hash){
+    *funds += tower->cost;
+    destroyTower(tower, tower_list, hash);
+}
+
+/* Make a singular tower act, its hits are applied right away */
+void towerAct(Tower *tower, Tower **tower_list, Enemy **enemy_list, FlowField *flow_field, EventLog *event_log, int *score, CombatStats *stats, uint64_t *hash) {
+    if (!tower || !tower_list) return;
+    int i; Enemy *target; Tower *tmp;
+    Enemy *targets[3] = {NULL, NULL, NULL}; int target_ids[3] = {-1, -1, -1}, target_rows[3] = {0, -1, +1};
+    /* Its key is xored out while its cooldown changes, and back in once it has acted */
+    toggleTowerHash(hash, tower);
+    /* Can only act when action cooldown reaches 0 or less */
+    tower->attack_cooldown--;
+    if (tower->attack_cooldown <= 0) {
+        switch (tower->type) {
+            case ARCHER_TOWER:
+                /* Attack the firt enemy on the same row at most 9 tiles away */
+                for (i = 1; i <= 9; i++) if (doesTileExist(tower->collumn + i, tower->row) && getEnemyAndTowerAt(*enemy_list, NULL, tower->collumn + i, tower->row, &target, NULL)) {
+                    tower->attack_cooldown = tower->base_attack_cooldown;
+                    shootEnemy(tower, target, enemy_list, *tower_list, flow_field, event_log, score, stats, hash);
+                    break;
+                }
+                break;
+            case WALL_TOWER:
+                tower->attack_cooldown = tower->base_attack_cooldown;
+                break;
+            case BARRACK_TOWER:
+                tower->attack_cooldown = tower->base_attack_cooldown;
+                tmp = NULL;
+                if (isTileEmpty(*enemy_list, *tower_list, tower->collumn, tower->row - 1) && doesTileExist(tower->collumn, tower->row - 1) && !isTileBlocked(flow_field, tower->collumn, tower->row - 1) && (tmp = addTower(tower_list, *enemy_list, SOLIDER_TOWER, tower->collumn, tower->row - 1, -1, hash)));
+                else if (isTileEmpty(*enemy_list, *tower_list, tower->collumn, tower->row + 1) && doesTileExist(tower->collumn, tower->row + 1) && !isTileBlocked(flow_field, tower->collumn, tower->row + 1) && (tmp = addTower(tower_list, *enemy_list, SOLIDER_TOWER, tower->collumn, tower->row + 1, -1, hash)));
+                else if (isTileEmpty(*enemy_list, *tower_list, tower->collumn + 1, tower->row) && doesTileExist(tower->collumn + 1, tower->row) && !isTileBlocked(flow_field, tower->collumn + 1, tower->row) && (tmp = addTower(tower_list, *enemy_list, SOLIDER_TOWER, tower->collumn + 1, tower->row, -1, hash)));
+                else if (isTileEmpty(*enemy_list, *tower_list, tower->collumn - 1, tower->row) && doesTileExist(tower->collumn- 1, tower->row ) && !isTileBlocked(flow_field, tower->collumn - 1, tower->row) && (tmp = addTower(tower_list, *enemy_list, SOLIDER_TOWER, tower->collumn - 1, tower->row, -1, hash)));
+                else tower->attack_cooldown = 1;
+                if (tmp) logTowerEvent(event_log, TOWER_SPAWN_EVENT, tmp, tmp->collumn - tower->collumn, tmp->row - tower->row, 0);
+                break;
+            case SOLIDER_TOWER:
+                /* Attack the firt enemy on the same or adjacent rows at most 2 tiles away */
+                for (i = 1; i <= 2; i++) {
+                    if (
+                        (doesTileExist(tower->collumn + i, tower->row) && getEnemyAndTowerAt(*enemy_list, NULL, tower->collumn + i, tower->row, &target, NULL)) ||
+                        (doesTileExist(tower->collumn + i, tower->row - 1) && getEnemyAndTowerAt(*enemy_list, NULL, tower->collumn + i, tower->row - 1, &target, NULL)) ||
+                        (doesTileExist(tower->collumn + i, tower->row + 1) && getEnemyAndTowerAt(*enemy_list, NULL, tower->collumn + i, tower->row + 1, &target, NULL))
+                    ) {
+                        tower->attack_cooldown = tower->base_attack_cooldown;
+                        shootEnemy(tower, target, enemy_list, *tower_list, flow_field, event_log, score, stats, hash);
+                        break;
+                    }
+                }
+                break;
+            case CANON_TOWER:
+                /* Attack the firt enemy on the same row at most 3 tiles away */
+                for (i = 1; i <= 3; i++) if (doesTileExist(tower->collumn + i, tower->row) && getEnemyAndTowerAt(*enemy_list, NULL, tower->collumn + i, tower->row, &target, NULL)) {
+                    tower->attack_cooldown = tower->base_attack_cooldown;
+                    shootEnemy(tower, target, enemy_list, *tower_list, flow_field, event_log, score, stats, hash);
+                    break;
+                }
+                break;
+            case DESTROYER_TOWER:
+                /* Attack the firt enemy on the same row at most 4 tiles away */
+                for (i = 1; i <= 4; i++) if (doesTileExist(tower->collumn + i, tower->row) && getEnemyAndTowerAt(*enemy_list, NULL, tower->collumn + i, tower->row, &target, NULL)) {
+                    tower->attack_cooldown = tower->base_attack_cooldown;
+                    shootEnemy(tower, target, enemy_list, *tower_list, flow_field, event_log, score, stats, hash);
+                    break;
+                }
+                break;
+            case SORCERER_TOWER:
+                /* Attack the firt enemy on the same row at most 7 tiles away */
+                for (i = 1; i <= 7; i++) if (doesTileExist(tower->collumn + i, tower->row) && getEnemyAndTowerAt(*enemy_list, NULL, tower->collumn + i, tower->row, &target, NULL)) {
+                    tower->attack_cooldown = tower->base_attack_cooldown;
+                    shootEnemy(tower, target, enemy_list, *tower_list, flow_field, event_log, score, stats, hash);
+                    break;
+                }
+                break;
+            case MAGE_TOWER:
+                /* Attack the firt enemy on the same row and on the adjacent rows at most 7 tiles away (targets are all chosen before shooting) */
+                for (int j = 0; j < 3; j++) for (i = 1; i <= 7; i++) if (doesTileExist(tower->collumn + i, tower->row + target_rows[j]) && getEnemyAndTowerAt(*enemy_list, NULL, tower->collumn + i, tower->row + target_rows[j], &target, NULL)) {
+                    tower->attack_cooldown = tower->base_attack_cooldown;
+                    targets[j] = target; target_ids[j] = target->id;
+                    break;
+                }
+                for (int j = 0; j < 3; j++) if (doesEnemyExist(*enemy_list, targets[j], target_ids[j]))
+                    shootEnemy(tower, targets[j], enemy_list, *tower_list, flow_field, event_log, score, stats, hash);
+                break;
+            default:  /* Invalid tower type */
+                printf("[ERROR]    Unknown tower type '%c'\n", tower->type);
+                break;
+        }
+    }
+    toggleTowerHash(hash, tower);
+}
+
+/* Make a tower shoot an enemy, the hit is applied right away (the projectile is only animated afterward) */
+void shootEnemy(Tower *tower, Enemy *target, Enemy **enemy_list, Tower *tower_list, FlowField *flow_field, EventLog *event_log, int *score, CombatStats *stats, uint64_t *hash) {
+    if (!tower || !target) return;
+    /* Impact position is kept as the target may die or move when hit */
+    Enemy *enemy; bool result; int x = target->collumn, y = target->row, id = target->id;
+    logTowerEvent(event_log, PROJECTILE_EVENT, tower, x - tower->collumn, y - tower->row, 0);
+    if (stats) stats->attacker_type = tower->type;
+    /* Apply projectile effects */
+    switch (tower->type) {
+        case ARCHER_TOWER:
+            damageEnemy(target, 2, enemy_list, tower_list, flow_field, event_log, score, stats, hash);
+            break;
+        case WALL_TOWER:
+            break;
+        case BARRACK_TOWER:
+            break;
+        case SOLIDER_TOWER:
+            damageEnemy(target, 2, enemy_list, tower_list, flow_field, event_log, score, stats, hash);
+            break;
+        case CANON_TOWER:
+            damageEnemy(target, 9, enemy_list, tower_list, flow_field, event_log, score, stats, hash);
+            break;
+        case DESTROYER_TOWER:
+            damageEnemy(target, 10, enemy_list, tower_list, flow_field, event_log, score, stats, hash);
+            /* Area damage */
+            for (int dy = -1; dy <= 1; dy++) for (int dx = -1; dx <= 1; dx++) if (dx || dy)
+                if (doesTileExist(x + dx, y + dy) && getEnemyAndTowerAt(*enemy_list, NULL, x + dx, y + dy, &enemy, NULL))
+                    damageEnemy(enemy, 4, enemy_list, tower_list, flow_field, event_log, score, stats, hash);
+            break;
+        case SORCERER_TOWER:
+            result = damageEnemy(target, 3, enemy_list, tower_list, flow_field, event_log, score, stats, hash);
+            /* Enemy slowdown on hit */
+            if (result && doesEnemyExist(*enemy_list, target, id)) {
+                toggleEnemyHash(hash, target);
+                target->speed = min(max(target->speed - 1, 1), target->speed);
+                toggleEnemyHash(hash, target);
+            }
+            break;
+        case MAGE_TOWER:
+            result = damageEnemy(target, 3, enemy_list, tower_list, flow_field, event_log, score, stats, hash);
+            /* Enemy slowdown on hit */
+            if (result && doesEnemyExist(*enemy_list, target, id)) {
+                toggleEnemyHash(hash, target);
+                target->speed = min(max(target->speed - 1, 1), target->speed);
+                toggleEnemyHash(hash, target);
+            }
+            break;
+        default:  /* Invalid tower type */
+            printf("[ERROR]    Unknown tower type '%c'\n", tower->type);
+            break;
+    }
+}
+
+/* Damage a tower */
+bool damageTower(Tower *tower, int amount, Tower **tower_list, EventLog *event_log, CombatStats *stats, uint64_t *hash) {
+    if (!tower || !amount || !tower_list) return false;
+    /* Check that tower still exist */
+    Tower *t = *tower_list;
+    while (t && t != tower) t = t->next;
+    if (!t) return false;
+    /* Damage tower (only the life points actually lost count in statistics) */
+    if (stats) {
+        stats->enemy_damage_dealt[(int) stats->attacker_type] += min(amount, max(tower->life_points, 0));
+        stats->tower_damage_taken[tower->type] += min(amount, max(tower->life_points, 0));
+    }
+    toggleTowerHash(hash, tower);
+    tower->life_points -= amount;
+    toggleTowerHash(hash, tower);
+    logTowerEvent(event_log, DAMAGE_EVENT, tower, 0, 0, amount);
+    /* Kill tower if health reaches 0 or less */
+    if (tower->life_points <= 0) {
+        if (stats) stats->nb_towers_destroyed[tower->type]++;
+        logTowerEvent(event_log, DEATH_EVENT, tower, 0, 0, 0);
+        destroyTower(tower, tower_list, hash);
+    }
+    return true;
+}
+
+
+
+
+/* Create a new empty event log */
+EventLog *newEventLog() {
+    EventLog *event_log = malloc(sizeof(EventLog));
+    event_log->events = NULL;
+    event_log->head = event_log->nb_events = event_log->capacity = 0;
+    return event_log;
+}
+
+/* Destroy an event log and free its allocated memory */
+void destroyEventLog(EventLog *event_log) {
+    if (!event_log) return;
+    if (event_log->events) free(event_log->events);
+    free(event_log);
+}
+
+/* Remove every event of the event log (memory is kept for the next turn) */
+void clearEventLog(EventLog *event_log) {
+    if (!event_log) return;
+    event_log->head = event_log->nb_events = 0;
+}
+
+/* Return if every event of the log has been played */
+bool isEventLogDone(EventLog *event_log) {
+    return !event_log || event_log->head >= event_log->nb_events;
+}
+
+/* Add an event at the end of the log, nothing is logged if there is no log */
+void logEvent(EventLog *event_log, Event event) {
+    if (!event_log) return;
+    if (event_log->nb_events >= event_log->capacity) {
+        event_log->capacity = max(64, event_log->capacity * 2);
+        event_log->events = realloc(event_log->events, event_log->capacity * sizeof(Event));
+    }
+    event_log->events[event_log->nb_events++] = event;
+}
+
+/* Log an event concerning an enemy, as it is right after the event */
+void logEnemyEvent(EventLog *event_log, char type, Enemy *enemy, int dx, int dy, int amount) {
+    if (!event_log || !enemy) return;
+    logEvent(event_log, (Event) {type, enemy->type, enemy->collumn, enemy->row, dx, dy, enemy->life_points, enemy->max_life_points, amount, enemy->id});
+}
+
+/* Log an event concerning a tower, as it is right after the event */
+void logTowerEvent(EventLog *event_log, char type, Tower *tower, int dx, int dy, int amount) {
+    if (!event_log || !tower) return;
+    logEvent(event_log, (Event) {type, tower->type, tower->collumn, tower->row, dx, dy, tower->life_points, tower->max_life_points, amount, tower->id});
+}
+
+/* Reorder the events logged since start so that all projectiles are shot at once, their hits being played once they have all landed */
+void separateVolley(EventLog *event_log, int start) {
+    if (!event_log || start >= event_log->nb_events) return;
+    int nb_events = event_log->nb_events - start, nb_projectiles = 0, i;
+    Event *events = malloc(nb_events * sizeof(Event));
+    memcpy(events, &event_log->events[start], nb_events * sizeof(Event));
+    event_log->nb_events = start;
+    /* Projectiles first, then wait for them to land */
+    for (i = 0; i < nb_events; i++) if (events[i].type == PROJECTILE_EVENT) {
+        logEvent(event_log, events[i]);
+        nb_projectiles++;
+    }
+    if (nb_projectiles) logEvent(event_log, (Event) {.type = WAIT_EVENT});
+    /* Then everything else in the order it happened, and wait for it to be over */
+    for (i = 0; i < nb_events; i++) if (events[i].type != PROJECTILE_EVENT) logEvent(event_log, events[i]);
+    logEvent(event_log, (Event) {.type = WAIT_EVENT});
+    free(events);
+}
+
+
+
+
+/* Add the score of a player to the scoreboard of a level, nothing is saved without a nickname (headless runs) */
+void saveScore(const char *current_nickname, int current_score, char *level_name) {
+    if (!current_nickname) return;
+    char *partial_path = concatString("../assets/scores/", level_name);
+    char *full_path = concatString(partial_path, ".txt");
+    FILE *file = fopen(full_path, "r");
+    free(partial_path);
+    /* Reading scoreboard file (if there is one) */
+    char **values; int nb_values, nb_score_entry = 0;
+    Scoreboard game_scoreboard[MAX_SIZE_SCORE_FILE]; Scoreboard temp;
+    if (file) {
+        while (readLine(file, &values, &nb_values)) {
+            game_scoreboard[nb_score_entry].nickname = duplicateString(values[0]);
+            game_scoreboard[nb_score_entry].score = stringToInt(values[1]);
+            nb_score_entry++;
+            /* Free memory */
+            for (int j = nb_values; j > 0; j--) free(values[j-1]);
+            free(values);
+        }
+        fclose(file);
+    }
+    /* Add the new player at the end of the scoreboard struct before sorting the array */
+    game_scoreboard[nb_score_entry].nickname = duplicateString(current_nickname);
+    game_scoreboard[nb_score_entry].score = current_score;
+    nb_score_entry++;
+    /* Sort the array using the selection sort */
+    for (int x = 0; x < nb_score_entry; x++) {
+        temp = game_scoreboard[x];
+        int y = x-1;
+        while (y >= 0 && temp.score > game_scoreboard[y].score){
+            game_scoreboard[y+1] = game_scoreboard[y];
+            y--;
+        }
+        game_scoreboard[y+1] = temp;
+    }
+    /* Re-write first 5 scores in scoreboard file */
+    file = fopen(full_path, "w");
+    if (!file) printf("[ERROR]    Cannot open scoreboard file at \"%s\"\n", full_path);
+    else {
+        for (int j = 0; j < min(nb_score_entry, 5); j++) fprintf(file,"%s %d\n", game_scoreboard[j].nickname, game_scoreboard[j].score);
+        for (int j = nb_score_entry; j > 0; j--) free(game_scoreboard[j-1].nickname);
+        fclose(file);
+    }
+    free(full_path);
+}
+
+/* Create a new game */
+Game *createNewGame(char *level_name, unsigned long long seed) {
+    Game *new_game = newEmptyGame(level_name, seed);
+    /* Load the waves */
+    if (!strcmp(level_name, SURVIVAL_MODE)) {
+        /* Survival mode pre-wave, no enemies, only income */
+        new_game->waves = malloc(sizeof(Wave *));
+        new_game->waves[0] = newWave(2025);
+        new_game->current_wave_nb = new_game->nb_waves = -1;
+        loadSurvivalCurve(SURVIVAL_CURVE_PATH, &new_game->survival_curve);
+    }
+    else {
+        /* Load waves and terrain based on level file */
+        loadLevel(level_name, &new_game->waves, &new_game->nb_waves, new_game->flow_field);
+    }
+    /* Load initial wave */
+    if (new_game->nb_waves) loadNextWave(new_game);
+    return new_game;
+}
+
+/* Create a new game on waves built in memory instead of a level file, the game taking the waves (terrain is the blocked tiles of a flow field, NULL for none) */
+Game *createGameFromWaves(char *level_name, Wave **waves, int nb_waves, FlowField *terrain, unsigned long long seed) {
+    Game *new_game = newEmptyGame(level_name, seed);
+    new_game->waves = waves;
+    new_game->nb_waves = nb_waves;
+    if (terrain) memcpy(new_game->flow_field->blocked, terrain->blocked, sizeof(terrain->blocked));
+    computeFlowField(new_game->flow_field);
+    if (new_game->nb_waves) loadNextWave(new_game);
+    return new_game;
+}
+
+/* Create a game without any wave */
+Game *newEmptyGame(char *level_name, unsigned long long seed) {
+    /* Initialize the new game object */
+    Game *new_game = malloc(sizeof(Game));
+    new_game->waves = NULL;
+    new_game->nb_waves = 0;
+    new_game->current_wave_nb = 0;
+    new_game->tower_list = NULL;
+    new_game->enemy_list = NULL;
+    new_game->spawn_queue = newSpawnQueue();
+    new_game->funds = 0;
+    new_game->score = 0;
+    new_game->turn_nb = 0;
+    new_game->total_turns = 0;
+    new_game->game_phase = PRE_WAVE_PHASE;
+    new_game->level_name = duplicateString(level_name);
+    new_game->flow_field = newFlowField();
+    new_game->concurrent_turns = CONCURRENT_TURNS;
+    new_game->event_log = newEventLog();
+    new_game->seed = seed;
+    seedRng(&new_game->rng, seed, GAMEPLAY_STREAM);
+    new_game->replay = NULL;
+    new_game->combat_stats = NULL;
+    new_game->rewind_buffer = NULL;
+    new_game->survival_curve = defaultSurvivalCurve();
+    /* No entity yet, only the score and turn number are hashed */
+    new_game->hash = hashValue(SCORE_FEATURE, 0) ^ hashValue(TURN_FEATURE, 0);
+    return new_game;
+}
+
+/* Load a game from a save file */
+Game *loadGameFromSave(char *save_file){
+    /* Openning text file */
+    char *partial_path = concatString("../assets/saves/", save_file);
+    char *full_path = concatString(partial_path, ".txt");
+    FILE *file = fopen(full_path, "r");
+    free(partial_path);
+    /* Checking if file was open successfully */
+    if (!file) {
+        printf("Save file at \"%s\" not found, creating new save file for player %s\n", full_path, save_file);
+        free(full_path);
+        return NULL;
+    }
+    Game *new_game = NULL;
+    /* Retrieve all informations from the file */
+    char **values; int nb_values;
+    while (readLine(file, &values, &nb_values)) {
+        if (nb_values == 5) {
+            /* Header line */
+            if (!new_game) {
+                new_game = createNewGame(values[0], 0);
+                new_game->current_wave_nb = stringToInt(values[1]);
+                new_game->funds = stringToInt(values[2]);
+                new_game->hash ^= hashValue(SCORE_FEATURE, new_game->score) ^ hashValue(SCORE_FEATURE, stringToInt(values[3]));
+                new_game->score = stringToInt(values[3]);
+                new_game->game_phase = (stringToInt(values[4]) ? PRE_WAVE_PHASE : WAITING_FOR_USER_PHASE);
+                /* Remove any enemy loaded with the level, as they will instead be loaded from this save file and not from the level file */
+                while (new_game->enemy_list) destroyEnemy(new_game->enemy_list, &new_game->enemy_list, &new_game->hash);
+                toggleSpawnQueueHash(&new_game->hash, new_game->spawn_queue);
+                clearSpawnQueue(new_game->spawn_queue);
+                continue;
+            }
+            /* Enemy or torwer to add */
+            else {
+                /* Enemies outside of the map wait in the spawn queue */
+                if (values[0][0] == 'E' && stringToInt(values[3]) > NB_COLLUMNS) {
+                    int turn = new_game->turn_nb + stringToInt(values[3]) - NB_COLLUMNS;
+                    if (queueEnemy(new_game->spawn_queue, values[1][0], stringToInt(values[2]), turn)) new_game->hash ^= hashSpawn(values[1][0], stringToInt(values[2]), turn);
+                }
+                else if (values[0][0] == 'E') addEnemy(&new_game->enemy_list, values[1][0], stringToInt(values[3]), stringToInt(values[2]), stringToInt(values[4]), &new_game->hash);
+                else if (values[0][0] == 'T') addTower(&new_game->tower_list,new_game->enemy_list, values[1][0], stringToInt(values[3]), stringToInt(values[2]), stringToInt(values[4]), &new_game->hash);
+            }
+            /* Free memory */
+            for (int i = nb_values; i > 0; i--) free(values[i-1]);
+            free(values);
+        }
+        /* Random number generator (seed and current state) */
+        else if (nb_values == 3 && values[0][0] == 'R' && new_game) {
+            new_game->seed = strtoull(values[1], NULL, 10);
+            new_game->rng.state = strtoull(values[2], NULL, 10);
+            for (int i = nb_values; i > 0; i--) free(values[i-1]);
+            free(values);
+        }
+        else if (nb_values) {
+            printf("[ERROR]    Invalid syntax for level file \"%s\"\n", full_path);
+            free(full_path);
+            for (int i = 0; i < nb_values; i++) free(values[i]);
+            free(values);
+            fclose(file);
+            return NULL;
+        }
+    }
+    free(full_path);
+    fclose(file);
+    return new_game;
+}
+
+/* Load next wave, return true if successfull */
+bool loadNextWave(Game *game) {
+    if (game->current_wave_nb >= game->nb_waves && game->nb_waves >= 0) return false;
+    int wave_nb = max(game->current_wave_nb, 0);
+    game->current_wave_nb++;
+    game->hash ^= hashValue(TURN_FEATURE, game->turn_nb) ^ hashValue(TURN_FEATURE, 0);
+    game->turn_nb = 0;
+    /* Destroy any remaining enemy and load new wave */
+    while (game->enemy_list) destroyEnemy(game->enemy_list, &game->enemy_list, &game->hash);
+    toggleSpawnQueueHash(&game->hash, game->spawn_queue);
+    clearSpawnQueue(game->spawn_queue);
+    /* The wave enemies become the ones waiting to enter the map (queues are swapped, no copy needed) */
+    SpawnQueue *spawn_queue = game->spawn_queue;
+    game->spawn_queue = game->waves[wave_nb]->spawn_queue;
+    game->waves[wave_nb]->spawn_queue = spawn_queue;
+    toggleSpawnQueueHash(&game->hash, game->spawn_queue);
+    /* Enemies without spawn delay are instantiated right away on the map */
+    SpawnEntry *entry;
+    while (!isSpawnQueueEmpty(game->spawn_queue) && (entry = &game->spawn_queue->entries[game->spawn_queue->head])->turn <= 0) {
+        addEnemy(&game->enemy_list, entry->type, NB_COLLUMNS + entry->turn, entry->row, -1, &game->hash);
+        game->hash ^= hashSpawn(entry->type, entry->row, entry->turn);
+        game->spawn_queue->head++;
+    }
+    /* The waves already played are not kept (their enemies are gone), so turns before this wave cannot be rewound to */
+    clearRewindBuffer(game->rewind_buffer);
+    /* Give wave income */
+    game->funds += game->waves[wave_nb]->income;
+    /* Reset game phase */
+    game->game_phase = PRE_WAVE_PHASE;
+    return true;
+}
+
+/* Launch next wave */
+void startNextWave(Game *game) {
+    game->game_phase = WAVE_PHASE;
+}
+
+/* Resolve a whole turn at once: enemies attack, move (and new ones enter the map), then towers act */
+/* Everything that happens is logged in the game event log (if there is one) to be animated afterward */
+void resolveTurn(Game *game) {
+    EventLog *event_log = game->event_log;
+    Enemy *enemy, *next; Tower *tower;
+    clearEventLog(event_log);
+    /* Enemies attack, one after the other unless turns are concurrent */
+    updateFlowField(game->flow_field, game->tower_list);
+    enemy = game->enemy_list;
+    while (enemy) {
+        next = enemy->next;
+        enemyAttack(enemy, &game->tower_list, &game->enemy_list, game->flow_field, event_log, game->combat_stats, &game->hash);
+        if (!game->concurrent_turns && !isEventLogDone(event_log) && event_log->events[event_log->nb_events-1].type != WAIT_EVENT) logEvent(event_log, (Event) {.type = WAIT_EVENT});
+        enemy = next;
+    }
+    logEvent(event_log, (Event) {.type = WAIT_EVENT});
+    /* Enemies move, then waiting enemies enter the map */
+    game->hash ^= hashValue(TURN_FEATURE, game->turn_nb) ^ hashValue(TURN_FEATURE, game->turn_nb + 1);
+    game->turn_nb++;
+    game->total_turns++;
+    makeAllEnemiesMove(game->enemy_list, game->tower_list, game->flow_field, event_log, &game->hash);
+    spawnQueuedEnemies(game->spawn_queue, game->turn_nb, &game->enemy_list, game->tower_list, event_log, &game->hash);
+    logEvent(event_log, (Event) {.type = WAIT_EVENT});
+    /* Towers do not act if an enemy has reached the castle */
+    enemy = game->enemy_list;
+    while (enemy) {
+        if (enemy->collumn <= 0) return;
+        enemy = enemy->next;
+    }
+    /* Towers act, their shots being animated one after the other unless turns are concurrent */
+    int start = event_log ? event_log->nb_events : 0;
+    tower = game->tower_list;
+    while (tower) {
+        towerAct(tower, &game->tower_list, &game->enemy_list, game->flow_field, event_log, &game->score, game->combat_stats, &game->hash);
+        if (!game->concurrent_turns) {
+            separateVolley(event_log, start);
+            start = event_log ? event_log->nb_events : 0;
+        }
+        tower = tower->next;
+    }
+    separateVolley(event_log, start);
+}
+
+/* Update game, a new turn is only resolved once the previous one has been animated */
+void updateGame(Game *game, const char *nickname) {
+    if (!isEventLogDone(game->event_log)) return;
+    Enemy *enemy;
+    /* Save game while building defences */
+    if (game->game_phase == PRE_WAVE_PHASE) saveGame(nickname, game);
+    /* On wave defeated */
+    if (!game->enemy_list && isSpawnQueueEmpty(game->spawn_queue) && game->game_phase != PRE_WAVE_PHASE && game->game_phase != WAITING_FOR_USER_PHASE) {
+        /* If currently on survival mode */
+        if (!strcmp(game->level_name, SURVIVAL_MODE)) beguinNewSurvivalWave(game);
+        /* If defeated a wave */
+        else if (game->current_wave_nb < game->nb_waves) {
+            /* Gain interest on money saved each wave */
+            game->funds *= 1.2;
+            loadNextWave(game);
+        }
+        /* If defeated last wave (victory) */
+        else if (game->game_phase != VICTORY_PHASE) {
+            game->game_phase = VICTORY_PHASE;
+            /* 1G = 1 point */
+            game->hash ^= hashValue(SCORE_FEATURE, game->score) ^ hashValue(SCORE_FEATURE, game->score + game->funds);
+            game->score += game->funds;
+            /* Save score */
+            saveScore(nickname, game->score, game->level_name);
+            /* Delete save file */
+            deleteSaveFile(nickname);
+        }
+        /* New enemies are shown before the next turn is resolved */
+        return;
+    }
+
+    /* Defeat condition (an enemy has reached the castle) */
+    enemy = game->enemy_list;
+    if (game->game_phase == WAVE_PHASE) while (enemy) {
+        if (enemy->collumn <= 0) {
+            game->game_phase = DEFEAT_PHASE;
+            /* Save score */
+            saveScore(nickname, game->score, game->level_name);
+            /* Delete save file */
+            deleteSaveFile(nickname);
+            return;
+        }
+        enemy = enemy->next;
+    }
+
+    /* Resolve next turn */
+    if (game->game_phase == WAVE_PHASE) {
+        /* Save game (turn starting) */
+        saveGame(nickname, game);
+        recordRewindTurn(game->rewind_buffer, game);
+        resolveTurn(game);
+        /* Keep a keyframe of the recorded game from time to time */
+        if (game->replay && game->total_turns % KEYFRAME_INTERVAL == 0) recordKeyframe(game->replay, game);
+    }
+}
+
+/* Destroy a game structure and free its allocated memory */
+void destroyGame(Game *game) {
+    /* Destroy all enemies */
+    while (game->enemy_list) destroyEnemy(game->enemy_list, &game->enemy_list, NULL);
+    destroySpawnQueue(game->spawn_queue);
+    /* Destroy all towers */
+    while (game->tower_list) destroyTower(game->tower_list, &game->tower_list, NULL);
+    destroyEventLog(game->event_log);
+    destroyReplay(game->replay);
+    if (game->combat_stats) free(game->combat_stats);
+    destroyRewindBuffer(game->rewind_buffer);
+    /* Destroy all waves (survival mode always holds a single one) */
+    destroyWaveList(game->waves, (game->nb_waves < 0) ? 1 : game->nb_waves);
+    /* Destroy game object */
+    if (game->level_name) free(game->level_name);
+    destroyFlowField(game->flow_field);
+    free(game);
+}
+
+/* Create an independent copy of the gameplay state of a game (for previews, searches or rewinds) */
+/* The copy has no event log, replay nor rewind buffer, its entities keep their identifiers */
+Game *cloneGame(Game *game) {
+    Game *clone = malloc(sizeof(Game));
+    *clone = *game;
+    clone->event_log = NULL;
+    clone->replay = NULL;
+    clone->rewind_buffer = NULL;
+    clone->level_name = duplicateString(game->level_name);
+    clone->flow_field = malloc(sizeof(FlowField));
+    *clone->flow_field = *game->flow_field;
+    clone->spawn_queue = cloneSpawnQueue(game->spawn_queue);
+    if (game->combat_stats) {
+        clone->combat_stats = malloc(sizeof(CombatStats));
+        *clone->combat_stats = *game->combat_stats;
+    }
+    /* Waves (survival mode always holds a single one) */
+    int nb_waves = (game->nb_waves < 0) ? 1 : game->nb_waves;
+    clone->waves = malloc(max(nb_waves, 1) * sizeof(Wave *));
+    for (int i = 0; i < nb_waves; i++) {
+        clone->waves[i] = malloc(sizeof(Wave));
+        clone->waves[i]->income = game->waves[i]->income;
+        clone->waves[i]->spawn_queue = cloneSpawnQueue(game->waves[i]->spawn_queue);
+    }
+    /* Towers, in the same order */
+    Tower **last_tower = &clone->tower_list;
+    for (Tower *tower = game->tower_list; tower; tower = tower->next) {
+        *last_tower = malloc(sizeof(Tower));
+        **last_tower = *tower;
+        last_tower = &(*last_tower)->next;
+    }
+    *last_tower = NULL;
+    /* Enemies, in the same order */
+    int nb_enemies = 0;
+    for (Enemy *enemy = game->enemy_list; enemy; enemy = enemy->next) nb_enemies++;
+    Enemy **copies = malloc(max(nb_enemies, 1) * sizeof(Enemy *)), *enemy = game->enemy_list;
+    for (int i = 0; i < nb_enemies; i++, enemy = enemy->next) {
+        copies[i] = malloc(sizeof(Enemy));
+        *copies[i] = *enemy;
+        copies[i]->next = NULL;
+        if (i > 0) copies[i-1]->next = copies[i];
+    }
+    clone->enemy_list = nb_enemies ? copies[0] : NULL;
+    /* Rebase row links on the copies */
+    for (int i = 0; i < nb_enemies; i++) {
+        if (copies[i]->next_on_row) copies[i]->next_on_row = findEnemyById(copies, nb_enemies, copies[i]->next_on_row->id);
+        if (copies[i]->prev_on_row) copies[i]->prev_on_row = findEnemyById(copies, nb_enemies, copies[i]->prev_on_row->id);
+    }
+    free(copies);
+    return clone;
+}
+
+/* Find an enemy from its identifier in an array of enemies sorted by identifier */
+/* Enemies are listed in order of apparition, so their list is always sorted by increasing identifier */
+Enemy *findEnemyById(Enemy **enemies, int nb_enemies, int id) {
+    int low = 0, high = nb_enemies - 1, middle;
+    while (low <= high) {
+        middle = (low + high) / 2;
+        if (enemies[middle]->id == id) return enemies[middle];
+        if (enemies[middle]->id < id) low = middle + 1;
+        else high = middle - 1;
+    }
+    return NULL;
+}
+
+/* Identifiers only need to be unique within a game, make sure the ones created by this thread do not collide with those of a game cloned in another thread */
+void syncEntityIds(Game *game) {
+    for (Tower *tower = game->tower_list; tower; tower = tower->next) NEXT_ENTITY_ID = max(NEXT_ENTITY_ID, tower->id + 1);
+    for (Enemy *enemy = game->enemy_list; enemy; enemy = enemy->next) NEXT_ENTITY_ID = max(NEXT_ENTITY_ID, enemy->id + 1);
+}
+
+/* Simulate the upcoming wave of a game in the pre-wave phase (the game is played, use a clone) */
+/* The prediction is cancelled (false returned) as soon as generation differs from expected_generation */
+bool predictWave(Game *game, WavePrediction *prediction, atomic_int *generation, int expected_generation) {
+    memset(prediction, 0, sizeof(WavePrediction));
+    syncEntityIds(game);
+    /* Towers placed by the player, to find the ones destroyed */
+    int nb_towers = 0, score = game->score;
+    for (Tower *tower = game->tower_list; tower; tower = tower->next) if (tower->type != SOLIDER_TOWER) nb_towers++;
+    Tower *towers = malloc(max(nb_towers, 1) * sizeof(Tower)), *tower;
+    nb_towers = 0;
+    for (tower = game->tower_list; tower; tower = tower->next) if (tower->type != SOLIDER_TOWER) towers[nb_towers++] = *tower;
+    EventLog *event_log = game->event_log;
+    game->event_log = NULL;
+    startNextWave(game);
+    /* The wave is played on a board when it fits in one, the game being updated at the end */
+    Board *board = newBoard();
+    if (loadBoard(board, game)) {
+        while (!isBoardWaveOver(board)) {
+            if (generation && atomic_load(generation) != expected_generation) break;
+            /* Defeat condition (an enemy has reached the castle) */
+            for (int row = 1; row <= NB_ROWS; row++) if (board->enemy_mask[row-1] & 1u) {
+                prediction->defeat = true;
+                prediction->nb_leaks++;
+                prediction->leak[row-1] = true;
+            }
+            if (prediction->defeat || prediction->nb_turns >= MAX_PREDICTED_TURNS) break;
+            resolveBoardTurn(board);
+            prediction->nb_turns++;
+        }
+        storeBoard(board, game);
+    }
+    else while (game->enemy_list || !isSpawnQueueEmpty(game->spawn_queue)) {
+        if (generation && atomic_load(generation) != expected_generation) break;
+        /* Defeat condition (an enemy has reached the castle) */
+        for (Enemy *enemy = game->enemy_list; enemy; enemy = enemy->next) if (enemy->collumn <= 0) {
+            prediction->defeat = true;
+            prediction->nb_leaks++;
+            prediction->leak[enemy->row-1] = true;
+        }
+        if (prediction->defeat || prediction->nb_turns >= MAX_PREDICTED_TURNS) break;
+        resolveTurn(game);
+        prediction->nb_turns++;
+    }
+    destroyBoard(board);
+    game->event_log = event_log;
+    /* Towers lost */
+    for (int i = 0; i < nb_towers; i++) {
+        for (tower = game->tower_list; tower && tower->id != towers[i].id; tower = tower->next);
+        if (tower) continue;
+        prediction->nb_towers_lost++;
+        prediction->tower_lost[towers[i].row-1][towers[i].collumn-1] = true;
+    }
+    free(towers);
+    prediction->score = game->score - score;
+    return !generation || atomic_load(generation) == expected_generation;
+}
+
+/* Launch a new random wave of enemy for survival mode */
+void beguinNewSurvivalWave(Game *game) {
+    if (!game) return;
+
+    /* Delete the old wave */
+    while (game->enemy_list) destroyEnemy(game->enemy_list, &game->enemy_list, &game->hash);
+    destroyWaveList(game->waves, 1);
+
+    /* Build the new survival wave */
+    /* Wave power determine how strong are the wave enemies and how numerous they are */
+    SurvivalCurve *curve = &game->survival_curve;
+    int wave_power = curve->base_power + power(game->current_wave_nb, 2) * curve->power_per_wave;
+    /* Initialize new wave object */
+    Wave *new_wave = newWave(0);
+    /* Add enemies to the wave */
+    char enemy_type; int turn, row; int nb_enemy = 0;
+    while (wave_power > 0) {
+        nb_enemy++;
+        /* Chose enemy type */
+        /* Add a necromancer enemy */
+        if (roll(&game->rng, 1.0 - (double) curve->necromancer/(curve->necromancer + wave_power))) {
+            enemy_type = NECROMANCER_ENEMY;
+            wave_power -= 400;
+        }
+        /* Add an orc enemy */
+        else if (roll(&game->rng, 1.0 - (double) curve->orc/(curve->orc + wave_power))) {
+            enemy_type = ORC_ENEMY;
+            wave_power -= 300;
+        }
+        /* Add a witch enemy */
+        else if (roll(&game->rng, 1.0 - (double) curve->witch/(curve->witch + wave_power))) {
+            enemy_type = WITCH_ENEMY;
+            wave_power -= 200;
+        }
+        /* Add a goblin enemy */
+        else if (roll(&game->rng, 1.0 - (double) curve->goblin/(curve->goblin + wave_power))) {
+            enemy_type = GOBLIN_ENEMY;
+            wave_power -= 150;
+        }
+        /* Add a gelly enemy */
+        else if (roll(&game->rng, 1.0 - (double) curve->gelly/(curve->gelly + wave_power))) {
+            enemy_type = GELLY_ENEMY;
+            wave_power -= 100;
+        }
+        /* Add a slime enemy */
+        else {
+            enemy_type = SLIME_ENEMY;
+            wave_power -= 50;
+        }
+        /* Chose enemy spawn turn and row */
+        turn = randrange(&game->rng, 0, nb_enemy/2) + 1;
+        row = randrange(&game->rng, 0, NB_ROWS) + 1;
+        /* Check if no other enemy spawns there on that turn, otherwise try another position later */
+        while (isSpawnQueued(new_wave->spawn_queue, turn, row)) {
+            turn += randrange(&game->rng, 0, 3) + 1;
+            row = randrange(&game->rng, 0, NB_ROWS) + 1;
+        }
+        /* Add the enemy to the wave */
+        queueEnemy(new_wave->spawn_queue, enemy_type, row, turn);
+    }
+
+    /* Launch the new survival wave */
+    int wave_nb = game->current_wave_nb;
+    game->waves = malloc(sizeof(Wave *));
+    game->waves[0] = new_wave;
+    game->current_wave_nb = 0;
+    game->nb_waves = 1;
+    loadNextWave(game);
+    game->nb_waves = -1;
+    game->current_wave_nb = wave_nb + 1;
+    startNextWave(game);
+}
+
+/* Survival mode difficulty used when no calibrated curve is available */
+SurvivalCurve defaultSurvivalCurve() {
+    return (SurvivalCurve) {1000, 250, 20000, 10000, 5000, 2500, 1000};
+}
+
+/* Load the survival mode difficulty from a file of "<name> <value>" lines, missing values are left unchanged */
+bool loadSurvivalCurve(const char *path, SurvivalCurve *curve) {
+    FILE *file = fopen(path, "r");
+    if (!file) return false;
+    char **values; int nb_values;
+    while (readLine(file, &values, &nb_values)) {
+        if (nb_values == 2) {
+            if (!strcmp(values[0], "base_power")) curve->base_power = stringToInt(values[1]);
+            else if (!strcmp(values[0], "power_per_wave")) curve->power_per_wave = stringToInt(values[1]);
+            else if (!strcmp(values[0], "necromancer")) curve->necromancer = stringToInt(values[1]);
+            else if (!strcmp(values[0], "orc")) curve->orc = stringToInt(values[1]);
+            else if (!strcmp(values[0], "witch")) curve->witch = stringToInt(values[1]);
+            else if (!strcmp(values[0], "goblin")) curve->goblin = stringToInt(values[1]);
+            else if (!strcmp(values[0], "gelly")) curve->gelly = stringToInt(values[1]);
+            else printf("[ERROR]    Unknown value \"%s\" in survival curve file \"%s\"\n", values[0], path);
+        }
+        for (int i = 0; i < nb_values; i++) free(values[i]);
+        free(values);
+    }
+    fclose(file);
+    return true;
+}
+
+/* Save the survival mode difficulty, read back by loadSurvivalCurve */
+bool saveSurvivalCurve(const char *path, SurvivalCurve *curve) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        printf("[ERROR]    Could not write survival curve file \"%s\"\n", path);
+        return false;
+    }
+    fprintf(file, "base_power %d\n", curve->base_power);
+    fprintf(file, "power_per_wave %d\n", curve->power_per_wave);
+    fprintf(file, "necromancer %d\n", curve->necromancer);
+    fprintf(file, "orc %d\n", curve->orc);
+    fprintf(file, "witch %d\n", curve->witch);
+    fprintf(file, "goblin %d\n", curve->goblin);
+    fprintf(file, "gelly %d\n", curve->gelly);
+    fclose(file);
+    return true;
+}
+
+
+
+
+/* Initialize new wave object */
+Wave *newWave(int income) {
+    Wave *new_wave = malloc(sizeof(Wave));
+    new_wave->income = income;
+    new_wave->spawn_queue = newSpawnQueue();
+    return new_wave;
+}
+
+/* Destroy a list of waves (including the ones not played yet) and free its allocated memory */
+void destroyWaveList(Wave **wave_list, int nb_wave) {
+    if (!wave_list) return;
+    for (int i = nb_wave; i > 0; i--) {
+        destroySpawnQueue(wave_list[i-1]->spawn_queue);
+        free(wave_list[i-1]);
+    }
+    free(wave_list);
+}
+
+
+
+
+/* Return if the caracter is considered to be a whitespace */
+bool isWhitespace(char c) {
+    return (!c) || (c == ' ') || (c == '\n') || (c == '\r') || (c == '\t');
+}
+
+/* Read a singular value on a line, move line pointer after the value read */
+bool readValue(char **line, char **value) {
+    if (!line || !(*line)) return false;
+    /* Get to the first value of the line, ignore all whitespaces before it */
+    while (**line && isWhitespace(**line)) (*line)++;
+    char *start = *line;
+    /* Find the end of the word */
+    while (!isWhitespace(**line)) (*line)++;
+    /* If the value read is an empty string, it means that the line does not contain any value */
+    if (start == *line) return NULL;
+    /* Copy the value read into the value variable */
+    *value = malloc((*line - start + 1) * sizeof(char));
+    char c = **line;
+    **line = '\0';
+    strcpy(*value, start);
+    **line = c;
+    return true;
+}
+
+/* Read single file line */
+bool readLine(FILE *file, char ***values, int *nb_values) {
+    /* Get the full line */
+    char line_buffer[64];
+    if (!fgets(line_buffer, 64, file)) return false;
+    /* Split it into all of its individual values */
+    *values = malloc(sizeof(char *)); *nb_values = 0; char *value, *line = line_buffer;
+    while (readValue(&line, &value)) {
+        (*nb_values)++;
+        *values = realloc(*values, (*nb_values) * sizeof(char *));
+        (*values)[*nb_values - 1] = value;
+    }
+    return true;
+}
+
+/* Load a level, terrain tiles are set as blocked in the flow field */
+/* File must be located in "../assets/lvl/<path>.txt" */
+bool loadLevel(const char *path, Wave ***waves, int *nb_waves, FlowField *flow_field) {
+    /* Openning text file */
+    char *partial_path = concatString("../assets/lvl/", path);
+    char *full_path = concatString(partial_path, ".txt");
+    FILE *file = fopen(full_path, "r");
+    free(partial_path);
+    /* Checking if file was open successfully */
+    if (!file) {
+        printf("[ERROR]    Level file at \"%s\" not found\n", full_path);
+        free(full_path);
+        return false;
+    }
+
+    /* Retrieve all informations from the file */
+    *waves = malloc(sizeof(Wave *)); *nb_waves = 0; char **values; int nb_values;
+    while (readLine(file, &values, &nb_values)) {
+        switch (nb_values) {
+            /* Empty line, ignore it */
+            case 0:
+                break;
+            /* New wave (int income) */
+            case 1:
+                (*nb_waves)++;
+                *waves = realloc(*waves, (*nb_waves) * sizeof(Wave *));
+                (*waves)[*nb_waves - 1] = newWave(stringToInt(values[0]));
+                break;
+            /* Blocked terrain tile ('X', int row, int collumn), enemies need the last collumn to enter the map */
+            case 3:
+                if (values[0][0] == BLOCKED_TILE) {
+                    if (!doesTileExist(stringToInt(values[2]), stringToInt(values[1])) || stringToInt(values[2]) == NB_COLLUMNS) {
+                        printf("[ERROR]    Invalid terrain tile in level file \"%s\"\n", full_path);
+                        free(full_path);
+                        for (int i = 0; i < nb_values; i++) free(values[i]);
+                        free(values);
+                        fclose(file);
+                        return false;
+                    }
+                    if (flow_field) flow_field->blocked[stringToInt(values[1])-1][stringToInt(values[2])-1] = true;
+                    break;
+                }
+                /* Add enemy (int spawn_delay, int row, char type) */
+                if (!(*nb_waves)) {
+                    printf("[ERROR]    Invalid syntax for level file \"%s\"\n", full_path);
+                    free(full_path);
+                    fclose(file);
+                    return false;
+                }
+                queueEnemy((*waves)[*nb_waves - 1]->spawn_queue, values[2][0], stringToInt(values[1]), stringToInt(values[0]));
+                break;
+            /* Invalid value count on line */
+            default:
+                printf("[ERROR]    Invalid syntax for level file \"%s\"\n", full_path);
+                free(full_path);
+                for (int i = 0; i < nb_values; i++) free(values[i]);
+                free(values);
+                fclose(file);
+                return false;
+        }
+        for (int i = 0; i < nb_values; i++) free(values[i]);
+        free(values);
+    }
+    /* Compute the path followed by enemies across the terrain */
+    if (flow_field) {
+        computeFlowField(flow_field);
+        for (int row = 1; row <= NB_ROWS; row++) if (flow_field->cost[row-1][NB_COLLUMNS-1] >= UNREACHABLE_PATH_COST)
+            printf("[ERROR]    Row %d of level file \"%s\" cannot reach the castle\n", row, full_path);
+    }
+    free(full_path);
+    fclose(file);
+    return true;
+}
+
+/* Write a level file in "../assets/lvl/<path>.txt" (the format read by loadLevel), terrain is the blocked tiles of a flow field (NULL for none) */
+bool saveLevel(const char *path, Wave **waves, int nb_waves, FlowField *terrain) {
+    char *partial_path = concatString("../assets/lvl/", path);
+    char *full_path = concatString(partial_path, ".txt");
+    FILE *file = fopen(full_path, "w");
+    free(partial_path);
+    if (!file) {
+        printf("[ERROR]    Unable to write file at \"%s\"\n", full_path);
+        free(full_path);
+        return false;
+    }
+    if (terrain) for (int row = 1; row <= NB_ROWS; row++) for (int collumn = 1; collumn <= NB_COLLUMNS; collumn++)
+        if (terrain->blocked[row-1][collumn-1]) fprintf(file, "%c %d %d\n", BLOCKED_TILE, row, collumn);
+    /* Each wave is its income, then one "<spawn delay> <row> <enemy type>" line per enemy */
+    for (int i = 0; i < nb_waves; i++) {
+        if (i || terrain) fprintf(file, "\n");
+        fprintf(file, "%d\n\n", waves[i]->income);
+        SpawnQueue *spawn_queue = waves[i]->spawn_queue;
+        for (int j = spawn_queue->head; j < spawn_queue->nb_entries; j++) fprintf(file, "%d %d %c\n", spawn_queue->entries[j].turn, spawn_queue->entries[j].row, spawn_queue->entries[j].type);
+    }
+    free(full_path);
+    fclose(file);
+    return true;
+}
+
+bool saveGame(const char *save_name, Game *game){
+    /* Nothing is saved without a save name (headless runs) */
+    if (!save_name) return false;
+    /* Save the game in a text file */
+    char *partial_path = concatString("../assets/saves/", save_name);
+    char *full_path = concatString(partial_path, ".txt");
+    FILE *file = fopen(full_path, "w");
+    free(partial_path);
+    if (!file) {
+        printf("[ERROR]    Level file at \"%s\" not found\n", full_path);
+        free(full_path);
+        return false;
+    }
+    /* Write the header with all keys infos that need to be saved and used when charging the save */
+    fprintf(file,"%s %d %d %d %d\n", game->level_name, game->current_wave_nb, game->funds, game->score, game->game_phase == PRE_WAVE_PHASE);
+    /* Random number generator, so that the game goes on as it would have without being saved */
+    fprintf(file, "R %llu %llu\n", game->seed, (unsigned long long) game->rng.state);
+    /* Add all the tower and the enemy file with all their characteristics */
+    Tower *current_tower = game->tower_list;
+    while(current_tower) {
+        fprintf(file, "T %c %d %d %d\n", current_tower->type, current_tower->row, current_tower->collumn, current_tower->life_points);
+        current_tower = current_tower->next;
+    }
+    Enemy *current_enemy = game->enemy_list;
+    while(current_enemy){
+        fprintf(file, "E %c %d %d %d\n", current_enemy->type, current_enemy->row, current_enemy->collumn, current_enemy->life_points);
+        current_enemy = current_enemy->next;
+    }
+    /* Enemies of the spawn queue are saved outside of the map, enemies kept waiting by a busy spawn tile are lined up behind it */
+    int last_collumn[NB_ROWS] = {0}; SpawnEntry *entry;
+    for (int i = game->spawn_queue->head; i < game->spawn_queue->nb_entries; i++) {
+        entry = &game->spawn_queue->entries[i];
+        last_collumn[entry->row-1] = max(NB_COLLUMNS + entry->turn - game->turn_nb, max(last_collumn[entry->row-1] + 1, NB_COLLUMNS + 1));
+        fprintf(file, "E %c %d %d %d\n", entry->type, entry->row, last_collumn[entry->row-1], -1);
+    }
+    free(full_path);
+    fclose(file);
+    return true;
+}
+
+/* Delete save file */
+bool deleteSaveFile(const char *name) {
+    if (!name) return false;
+    char save_path[64]; sprintf(save_path, "../assets/saves/%s.txt", name);
+    return remove(save_path);
+}
+
+
+
+
+/* Create a new empty replay of a game */
+Replay *newReplay(const char *level_name, unsigned long long seed) {
+    Replay *replay = malloc(sizeof(Replay));
+    replay->level_name = duplicateString(level_name);
+    replay->seed = seed;
+    replay->actions = NULL;
+    replay->head = replay->nb_actions = replay->capacity = 0;
+    replay->keyframes = NULL;
+    replay->nb_keyframes = replay->keyframe_capacity = 0;
+    return replay;
+}
+
+/* Destroy a replay and free its allocated memory */
+void destroyReplay(Replay *replay) {
+    if (!replay) return;
+    if (replay->actions) free(replay->actions);
+    for (int i = 0; i < replay->nb_keyframes; i++) free(replay->keyframes[i].data);
+    if (replay->keyframes) free(replay->keyframes);
+    free(replay->level_name);
+    free(replay);
+}
+
+/* Add an action at the end of a replay, nothing is recorded if there is no replay */
+void recordAction(Replay *replay, Action action) {
+    if (!replay) return;
+    if (replay->nb_actions >= replay->capacity) {
+        replay->capacity = max(16, replay->capacity * 2);
+        replay->actions = realloc(replay->actions, replay->capacity * sizeof(Action));
+    }
+    replay->actions[replay->nb_actions++] = action;
+}
+
+/* Do an action of the player, it is recorded in the game replay only if it succeeded */
+bool applyAction(Game *game, Action action) {
+    Tower *tower = NULL;
+    bool done = false;
+    action.wave_nb = game->current_wave_nb;
+    switch (action.type) {
+        case BUY_ACTION:
+            done = buyTower(&game->tower_list, game->enemy_list, game->flow_field, action.tower_type, action.collumn, action.row, &game->funds, &game->hash);
+            break;
+        case UPGRADE_ACTION:
+            getEnemyAndTowerAt(NULL, game->tower_list, action.collumn, action.row, NULL, &tower);
+            done = tower && upgradeTower(&game->tower_list, game->enemy_list, tower->type, action.collumn, action.row, &game->funds, &game->hash);
+            break;
+        case SELL_ACTION:
+            getEnemyAndTowerAt(NULL, game->tower_list, action.collumn, action.row, NULL, &tower);
+            if (tower) sellTower(tower, &game->tower_list, &game->funds, &game->hash);
+            done = tower;
+            break;
+        case START_WAVE_ACTION:
+            done = (game->game_phase == PRE_WAVE_PHASE || game->game_phase == WAITING_FOR_USER_PHASE);
+            /* The defences as they were before the wave can be rewound to, to build them again */
+            if (done) recordRewindTurn(game->rewind_buffer, game);
+            if (done) startNextWave(game);
+            break;
+        default:
+            printf("[ERROR]    Unknown action type '%c'\n", action.type);
+            return false;
+    }
+    if (done) recordAction(game->replay, action);
+    return done;
+}
+
+/* Create the game a replay was recorded on */
+Game *createReplayGame(Replay *replay) {
+    replay->head = 0;
+    return createNewGame(replay->level_name, replay->seed);
+}
+
+/* Do every action of the replay done before the current wave started, return the number of actions done */
+/* Survival waves start right after the previous one, so their actions are done on the first turn of the wave */
+int playReplay(Game *game, Replay *replay) {
+    int nb_actions = 0; Action *action;
+    while (replay->head < replay->nb_actions && (game->game_phase == PRE_WAVE_PHASE || game->game_phase == WAITING_FOR_USER_PHASE || (game->game_phase == WAVE_PHASE && !game->turn_nb))) {
+        action = &replay->actions[replay->head];
+        if (action->wave_nb != game->current_wave_nb) break;
+        if (!applyAction(game, *action)) printf("[ERROR]    Replay action '%c' at (%d, %d) failed on wave %d\n", action->type, action->collumn, action->row, action->wave_nb);
+        replay->head++;
+        nb_actions++;
+    }
+    return nb_actions;
+}
+
+/* Return if every action of a replay has been done */
+bool isReplayOver(Replay *replay) {
+    return !replay || replay->head >= replay->nb_actions;
+}
+
+/* Save a replay in a binary file: header, varint encoded action stream (waves as deltas), then keyframes */
+/* File is located in "../assets/replays/<name>.rpl" */
+bool saveReplay(Replay *replay, const char *name) {
+    if (!replay || !name) return false;
+    char replay_path[64]; sprintf(replay_path, "../assets/replays/%s.rpl", name);
+    FILE *file = fopen(replay_path, "wb");
+    if (!file) {
+        printf("[ERROR]    Unable to write replay file at \"%s\"\n", replay_path);
+        return false;
+    }
+    ByteBuffer buffer = {NULL, 0, 0, 0};
+    /* Header */
+    for (const char *c = REPLAY_MAGIC; *c; c++) writeByte(&buffer, *c);
+    writeVarint(&buffer, strlen(replay->level_name));
+    for (char *c = replay->level_name; *c; c++) writeByte(&buffer, *c);
+    writeVarint(&buffer, replay->seed);
+    /* Actions */
+    Action *action; int prev_wave_nb = 0;
+    writeVarint(&buffer, replay->nb_actions);
+    for (int i = 0; i < replay->nb_actions; i++) {
+        action = &replay->actions[i];
+        writeSignedVarint(&buffer, action->wave_nb - prev_wave_nb);
+        writeByte(&buffer, action->type);
+        if (action->type == BUY_ACTION) writeByte(&buffer, action->tower_type);
+        if (action->type != START_WAVE_ACTION) writeVarint(&buffer, action->collumn * (NB_ROWS+1) + action->row);
+        prev_wave_nb = action->wave_nb;
+    }
+    /* Keyframes */
+    Keyframe *keyframe; int prev_total_turns = 0, prev_action_index = 0;
+    writeVarint(&buffer, replay->nb_keyframes);
+    for (int i = 0; i < replay->nb_keyframes; i++) {
+        keyframe = &replay->keyframes[i];
+        writeVarint(&buffer, keyframe->total_turns - prev_total_turns);
+        writeVarint(&buffer, keyframe->action_index - prev_action_index);
+        writeVarint(&buffer, keyframe->size);
+        for (int j = 0; j < keyframe->size; j++) writeByte(&buffer, keyframe->data[j]);
+        prev_total_turns = keyframe->total_turns; prev_action_index = keyframe->action_index;
+    }
+    fwrite(buffer.bytes, 1, buffer.size, file);
+    free(buffer.bytes);
+    fclose(file);
+    return true;
+}
+
+/* Load a replay from a binary file */
+/* File must be located in "../assets/replays/<name>.rpl" */
+Replay *loadReplay(const char *name) {
+    char replay_path[64]; sprintf(replay_path, "../assets/replays/%s.rpl", name);
+    FILE *file = fopen(replay_path, "rb");
+    if (!file) {
+        printf("[ERROR]    Replay file at \"%s\" not found\n", replay_path);
+        return NULL;
+    }
+    /* Read the whole file */
+    ByteBuffer buffer = {NULL, 0, 0, 0};
+    fseek(file, 0, SEEK_END);
+    buffer.size = buffer.capacity = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    buffer.bytes = malloc(buffer.size + 1);
+    buffer.size = fread(buffer.bytes, 1, buffer.size, file);
+    fclose(file);
+    /* Header */
+    for (const char *c = REPLAY_MAGIC; *c; c++) if (readByte(&buffer) != *c) {
+        printf("[ERROR]    Invalid replay file \"%s\"\n", replay_path);
+        free(buffer.bytes);
+        return NULL;
+    }
+    int length = readVarint(&buffer);
+    char *level_name = malloc((length + 1) * sizeof(char));
+    for (int i = 0; i < length; i++) level_name[i] = readByte(&buffer);
+    level_name[length] = '\0';
+    Replay *replay = newReplay(level_name, readVarint(&buffer));
+    free(level_name);
+    /* Actions */
+    Action action = {0, 0, 0, 0, 0}; int position;
+    int nb_actions = readVarint(&buffer);
+    for (int i = 0; i < nb_actions; i++) {
+        action.wave_nb += readSignedVarint(&buffer);
+        action.type = readByte(&buffer);
+        action.tower_type = (action.type == BUY_ACTION) ? readByte(&buffer) : 0;
+        position = (action.type != START_WAVE_ACTION) ? readVarint(&buffer) : 0;
+        action.collumn = position / (NB_ROWS+1); action.row = position % (NB_ROWS+1);
+        recordAction(replay, action);
+    }
+    /* Keyframes */
+    Keyframe keyframe = {0, 0, NULL, 0};
+    int nb_keyframes = readVarint(&buffer);
+    replay->keyframes = malloc(max(1, nb_keyframes) * sizeof(Keyframe));
+    replay->keyframe_capacity = max(1, nb_keyframes);
+    for (int i = 0; i < nb_keyframes && buffer.pos < buffer.size; i++) {
+        keyframe.total_turns += readVarint(&buffer);
+        keyframe.action_index += readVarint(&buffer);
+        keyframe.size = readVarint(&buffer);
+        keyframe.data = malloc(max(1, keyframe.size));
+        for (int j = 0; j < keyframe.size; j++) keyframe.data[j] = readByte(&buffer);
+        replay->keyframes[replay->nb_keyframes++] = keyframe;
+    }
+    free(buffer.bytes);
+    return replay;
+}
+
+
+
+
+/* Write a byte at the end of a byte buffer */
+void writeByte(ByteBuffer *buffer, unsigned char byte) {
+    if (buffer->size >= buffer->capacity) {
+        buffer->capacity = max(64, buffer->capacity * 2);
+        buffer->bytes = realloc(buffer->bytes, buffer->capacity);
+    }
+    buffer->bytes[buffer->size++] = byte;
+}
+
+/* Write an unsigned integer using as few bytes as needed (7 bits per byte, the highest bit telling if more bytes follow) */
+void writeVarint(ByteBuffer *buffer, uint64_t value) {
+    while (value >= 0x80) {
+        writeByte(buffer, (value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    writeByte(buffer, value);
+}
+
+/* Write a signed integer as a varint, small negative values staying small (zigzag encoding) */
+void writeSignedVarint(ByteBuffer *buffer, int64_t value) {
+    writeVarint(buffer, ((uint64_t) value << 1) ^ (uint64_t) (value >> 63));
+}
+
+/* Read the next byte of a byte buffer, 0 once everything has been read */
+unsigned char readByte(ByteBuffer *buffer) {
+    return (buffer->pos < buffer->size) ? buffer->bytes[buffer->pos++] : 0;
+}
+
+/* Read an unsigned integer written with writeVarint */
+uint64_t readVarint(ByteBuffer *buffer) {
+    uint64_t value = 0; unsigned char byte; int shift = 0;
+    do {
+        byte = readByte(buffer);
+        value |= (uint64_t) (byte & 0x7F) << shift;
+        shift += 7;
+    } while ((byte & 0x80) && shift < 64);
+    return value;
+}
+
+/* Read a signed integer written with writeSignedVarint */
+int64_t readSignedVarint(ByteBuffer *buffer) {
+    uint64_t value = readVarint(buffer);
+    return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+}
+
+/* Write the state of a game (everything that changes once the level is loaded) */
+void encodeGameState(ByteBuffer *buffer, Game *game) {
+    writeSignedVarint(buffer, game->current_wave_nb);
+    writeSignedVarint(buffer, game->turn_nb);
+    writeVarint(buffer, game->total_turns);
+    writeSignedVarint(buffer, game->funds);
+    writeSignedVarint(buffer, game->score);
+    writeSignedVarint(buffer, game->game_phase);
+    writeVarint(buffer, game->rng.state);
+    /* Towers */
+    int nb_towers = 0, nb_enemies = 0;
+    for (Tower *tower = game->tower_list; tower; tower = tower->next) nb_towers++;
+    writeVarint(buffer, nb_towers);
+    for (Tower *tower = game->tower_list; tower; tower = tower->next) {
+        writeByte(buffer, tower->type);
+        writeVarint(buffer, tower->collumn * (NB_ROWS+1) + tower->row);
+        writeSignedVarint(buffer, tower->life_points);
+        writeSignedVarint(buffer, tower->attack_cooldown);
+    }
+    /* Enemies */
+    for (Enemy *enemy = game->enemy_list; enemy; enemy = enemy->next) nb_enemies++;
+    writeVarint(buffer, nb_enemies);
+    for (Enemy *enemy = game->enemy_list; enemy; enemy = enemy->next) {
+        writeByte(buffer, enemy->type);
+        writeSignedVarint(buffer, enemy->collumn);
+        writeVarint(buffer, enemy->row);
+        writeSignedVarint(buffer, enemy->life_points);
+        writeSignedVarint(buffer, enemy->speed);
+    }
+    /* Enemies waiting to enter the map (turns as deltas, as entries are sorted by turn) */
+    SpawnEntry *entry; int prev_turn = 0;
+    writeVarint(buffer, game->spawn_queue->nb_entries - game->spawn_queue->head);
+    for (int i = game->spawn_queue->head; i < game->spawn_queue->nb_entries; i++) {
+        entry = &game->spawn_queue->entries[i];
+        writeByte(buffer, entry->type);
+        writeVarint(buffer, entry->row);
+        writeSignedVarint(buffer, entry->turn - prev_turn);
+        prev_turn = entry->turn;
+    }
+}
+
+/* Restore the state of a game written with encodeGameState, the game must have been created on the same level */
+void decodeGameState(ByteBuffer *buffer, Game *game) {
+    game->hash ^= hashValue(SCORE_FEATURE, game->score) ^ hashValue(TURN_FEATURE, game->turn_nb);
+    game->current_wave_nb = readSignedVarint(buffer);
+    game->turn_nb = readSignedVarint(buffer);
+    game->total_turns = readVarint(buffer);
+    game->funds = readSignedVarint(buffer);
+    game->score = readSignedVarint(buffer);
+    game->game_phase = readSignedVarint(buffer);
+    game->rng.state = readVarint(buffer);
+    game->hash ^= hashValue(SCORE_FEATURE, game->score) ^ hashValue(TURN_FEATURE, game->turn_nb);
+    /* Towers (their key is xored in once their cooldown is read) */
+    while (game->tower_list) destroyTower(game->tower_list, &game->tower_list, &game->hash);
+    int nb_towers = readVarint(buffer), type, position, life_points; Tower *tower;
+    for (int i = 0; i < nb_towers; i++) {
+        type = readByte(buffer);
+        position = readVarint(buffer);
+        life_points = readSignedVarint(buffer);
+        tower = addTower(&game->tower_list, NULL, type, position / (NB_ROWS+1), position % (NB_ROWS+1), life_points, NULL);
+        if (tower) {
+            tower->attack_cooldown = readSignedVarint(buffer);
+            toggleTowerHash(&game->hash, tower);
+        }
+        else readSignedVarint(buffer);
+    }
+    updateFlowField(game->flow_field, game->tower_list);
+    /* Enemies */
+    while (game->enemy_list) destroyEnemy(game->enemy_list, &game->enemy_list, &game->hash);
+    int nb_enemies = readVarint(buffer), collumn, row; Enemy *enemy;
+    for (int i = 0; i < nb_enemies; i++) {
+        type = readByte(buffer);
+        collumn = readSignedVarint(buffer);
+        row = readVarint(buffer);
+        life_points = readSignedVarint(buffer);
+        enemy = addEnemy(&game->enemy_list, type, collumn, row, life_points, NULL);
+        if (enemy) {
+            enemy->speed = readSignedVarint(buffer);
+            toggleEnemyHash(&game->hash, enemy);
+        }
+        else readSignedVarint(buffer);
+    }
+    /* Enemies waiting to enter the map */
+    toggleSpawnQueueHash(&game->hash, game->spawn_queue);
+    clearSpawnQueue(game->spawn_queue);
+    int nb_entries = readVarint(buffer), turn = 0;
+    for (int i = 0; i < nb_entries; i++) {
+        type = readByte(buffer);
+        row = readVarint(buffer);
+        turn += readSignedVarint(buffer);
+        queueEnemy(game->spawn_queue, type, row, turn);
+    }
+    toggleSpawnQueueHash(&game->hash, game->spawn_queue);
+}
+
+/* Add a keyframe of the current state of a game to its replay */
+void recordKeyframe(Replay *replay, Game *game) {
+    if (!replay) return;
+    ByteBuffer buffer = {NULL, 0, 0, 0};
+    encodeGameState(&buffer, game);
+    if (replay->nb_keyframes >= replay->keyframe_capacity) {
+        replay->keyframe_capacity = max(16, replay->keyframe_capacity * 2);
+        replay->keyframes = realloc(replay->keyframes, replay->keyframe_capacity * sizeof(Keyframe));
+    }
+    replay->keyframes[replay->nb_keyframes++] = (Keyframe) {game->total_turns, replay->nb_actions, buffer.bytes, buffer.size};
+}
+
+/* Create the game of a replay as it was at a given turn (or when the replay ends if it is sooner) */
+/* The game is resumed from the last keyframe before that turn, only the turns after it are resolved */
+Game *seekReplay(Replay *replay, int total_turns) {
+    Game *game = createReplayGame(replay);
+    /* Find the last keyframe before that turn */
+    int i = replay->nb_keyframes - 1;
+    while (i >= 0 && replay->keyframes[i].total_turns > total_turns) i--;
+    if (i >= 0) {
+        ByteBuffer buffer = {replay->keyframes[i].data, replay->keyframes[i].size, replay->keyframes[i].size, 0};
+        decodeGameState(&buffer, game);
+        replay->head = replay->keyframes[i].action_index;
+    }
+    /* Resolve the remaining turns without logging anything */
+    EventLog *event_log = game->event_log;
+    game->event_log = NULL;
+    while (game->total_turns < total_turns && game->game_phase != VICTORY_PHASE && game->game_phase != DEFEAT_PHASE) {
+        playReplay(game, replay);
+        if (game->game_phase != WAVE_PHASE) break;
+        updateGame(game, NULL);
+    }
+    game->event_log = event_log;
+    return game;
+}
+
+
+
+
+/* Create a rewind buffer keeping up to nb_turns game states in nb_bytes bytes, everything is allocated here */
+RewindBuffer *newRewindBuffer(int nb_turns, int nb_bytes) {
+    RewindBuffer *rewind_buffer = malloc(sizeof(RewindBuffer));
+    rewind_buffer->entries = malloc(max(1, nb_turns) * sizeof(RewindEntry));
+    rewind_buffer->capacity = max(1, nb_turns);
+    rewind_buffer->first = 0;
+    rewind_buffer->nb_entries = 0;
+    rewind_buffer->bytes = malloc(max(1, nb_bytes));
+    rewind_buffer->nb_bytes = max(1, nb_bytes);
+    rewind_buffer->used_bytes = 0;
+    rewind_buffer->scratch = (ByteBuffer) {malloc(1024), 0, 1024, 0};
+    return rewind_buffer;
+}
+
+/* Destroy a rewind buffer and free its allocated memory */
+void destroyRewindBuffer(RewindBuffer *rewind_buffer) {
+    if (!rewind_buffer) return;
+    free(rewind_buffer->entries);
+    free(rewind_buffer->bytes);
+    free(rewind_buffer->scratch.bytes);
+    free(rewind_buffer);
+}
+
+/* Forget every state kept in a rewind buffer (memory is kept) */
+void clearRewindBuffer(RewindBuffer *rewind_buffer) {
+    if (!rewind_buffer) return;
+    rewind_buffer->first = rewind_buffer->nb_entries = rewind_buffer->used_bytes = 0;
+}
+
+/* Keep the current state of a game as the newest state of a rewind buffer, the oldest states are dropped to make room */
+void recordRewindTurn(RewindBuffer *rewind_buffer, Game *game) {
+    if (!rewind_buffer) return;
+    rewind_buffer->scratch.size = 0;
+    encodeGameState(&rewind_buffer->scratch, game);
+    int size = rewind_buffer->scratch.size;
+    if (size > rewind_buffer->nb_bytes) {
+        printf("[ERROR]    Game state of %d bytes does not fit in the rewind buffer\n", size);
+        return;
+    }
+    /* Drop the oldest states until there is room for this one */
+    while (rewind_buffer->nb_entries && (rewind_buffer->nb_entries >= rewind_buffer->capacity || rewind_buffer->used_bytes + size > rewind_buffer->nb_bytes)) {
+        rewind_buffer->used_bytes -= rewind_buffer->entries[rewind_buffer->first].size;
+        rewind_buffer->first = (rewind_buffer->first + 1) % rewind_buffer->capacity;
+        rewind_buffer->nb_entries--;
+    }
+    /* States follow each other in the ring of bytes */
+    RewindEntry *last = &rewind_buffer->entries[(rewind_buffer->first + rewind_buffer->nb_entries - 1) % rewind_buffer->capacity];
+    int start = rewind_buffer->nb_entries ? (last->start + last->size) % rewind_buffer->nb_bytes : 0;
+    int part = min(size, rewind_buffer->nb_bytes - start);
+    memcpy(rewind_buffer->bytes + start, rewind_buffer->scratch.bytes, part);
+    memcpy(rewind_buffer->bytes, rewind_buffer->scratch.bytes + part, size - part);
+    if (!rewind_buffer->nb_entries) rewind_buffer->first = 0;
+    rewind_buffer->entries[(rewind_buffer->first + rewind_buffer->nb_entries) % rewind_buffer->capacity] = (RewindEntry) {game->total_turns, game->replay ? game->replay->nb_actions : 0, start, size};
+    rewind_buffer->nb_entries++;
+    rewind_buffer->used_bytes += size;
+}
+
+/* Bring a game back to the state it was in nb_turns states ago (the oldest state kept if there are less), return the number of states rewound */
+/* The states after it are dropped, as well as the actions and keyframes recorded since then in the replay of the game */
+int rewindGame(Game *game, int nb_turns) {
+    RewindBuffer *rewind_buffer = game->rewind_buffer;
+    if (!rewind_buffer || !rewind_buffer->nb_entries || nb_turns <= 0) return 0;
+    nb_turns = min(nb_turns, rewind_buffer->nb_entries);
+    RewindEntry entry = rewind_buffer->entries[(rewind_buffer->first + rewind_buffer->nb_entries - nb_turns) % rewind_buffer->capacity];
+    /* Copy the state out of the ring of bytes, then restore it */
+    int part = min(entry.size, rewind_buffer->nb_bytes - entry.start);
+    memcpy(rewind_buffer->scratch.bytes, rewind_buffer->bytes + entry.start, part);
+    memcpy(rewind_buffer->scratch.bytes + part, rewind_buffer->bytes, entry.size - part);
+    rewind_buffer->scratch.size = entry.size;
+    rewind_buffer->scratch.pos = 0;
+    decodeGameState(&rewind_buffer->scratch, game);
+    rewind_buffer->nb_entries -= nb_turns;
+    rewind_buffer->used_bytes = 0;
+    for (int i = 0; i < rewind_buffer->nb_entries; i++) rewind_buffer->used_bytes += rewind_buffer->entries[(rewind_buffer->first + i) % rewind_buffer->capacity].size;
+    /* Events of the turns undone are not animated */
+    clearEventLog(game->event_log);
+    if (game->replay) {
+        game->replay->nb_actions = min(game->replay->nb_actions, entry.action_index);
+        while (game->replay->nb_keyframes && game->replay->keyframes[game->replay->nb_keyframes - 1].total_turns > entry.total_turns) free(game->replay->keyframes[--game->replay->nb_keyframes].data);
+    }
+    return nb_turns;
+}
+
+/* Return the memory held by a rewind buffer in bytes (the whole rings, used or not) */
+size_t getRewindBufferMemory(RewindBuffer *rewind_buffer) {
+    if (!rewind_buffer) return 0;
+    return sizeof(RewindBuffer) + rewind_buffer->capacity * sizeof(RewindEntry) + rewind_buffer->nb_bytes + rewind_buffer->scratch.capacity;
+}
+
+
+
+
+/* Create the preview of a level being edited from a game in the pre-wave phase, the waves are read again from the level file */
+/* The waves already played come from the file, the upcoming ones (the current one included) from the game */
+LevelPreview *newLevelPreview(Game *game) {
+    if (game->nb_waves <= 0 || game->game_phase != PRE_WAVE_PHASE) {
+        printf("[ERROR]    Only levels in the pre-wave phase can be edited\n");
+        return NULL;
+    }
+    Wave **waves; int nb_waves;
+    if (!loadLevel(game->level_name, &waves, &nb_waves, NULL)) return NULL;
+    if (nb_waves != game->nb_waves) {
+        printf("[ERROR]    Level file \"%s\" does not match the game played\n", game->level_name);
+        destroyWaveList(waves, nb_waves);
+        return NULL;
+    }
+    LevelPreview *preview = malloc(sizeof(LevelPreview));
+    preview->waves = waves;
+    preview->nb_waves = nb_waves;
+    preview->first_wave = game->current_wave_nb - 1;
+    for (int i = preview->first_wave; i < nb_waves; i++) {
+        destroySpawnQueue(waves[i]->spawn_queue);
+        waves[i]->income = game->waves[i]->income;
+        /* The current wave is already loaded: its enemies are on the map or waiting to enter it */
+        if (i == preview->first_wave) {
+            waves[i]->spawn_queue = newSpawnQueue();
+            for (Enemy *enemy = game->enemy_list; enemy; enemy = enemy->next) queueEnemy(waves[i]->spawn_queue, enemy->type, enemy->row, enemy->collumn - NB_COLLUMNS + game->turn_nb);
+            for (int j = game->spawn_queue->head; j < game->spawn_queue->nb_entries; j++) queueEnemy(waves[i]->spawn_queue, game->spawn_queue->entries[j].type, game->spawn_queue->entries[j].row, game->spawn_queue->entries[j].turn);
+        }
+        else waves[i]->spawn_queue = cloneSpawnQueue(game->waves[i]->spawn_queue);
+    }
+    preview->game = cloneGame(game);
+    preview->checkpoints = calloc(nb_waves, sizeof(ByteBuffer));
+    preview->predictions = calloc(nb_waves, sizeof(WavePrediction));
+    preview->nb_waves_simulated = 0;
+    resetLevelPreview(preview, game);
+    return preview;
+}
+
+/* Destroy a level preview and free its allocated memory */
+void destroyLevelPreview(LevelPreview *preview) {
+    if (!preview) return;
+    destroyWaveList(preview->waves, preview->nb_waves);
+    destroyGame(preview->game);
+    for (int i = 0; i < preview->nb_waves; i++) free(preview->checkpoints[i].bytes);
+    free(preview->checkpoints);
+    free(preview->predictions);
+    free(preview);
+}
+
+/* Simulate every wave of a level preview again, from the current state of the game (to do when its defences change) */
+/* The first checkpoint is the game as it was before its current wave was loaded */
+void resetLevelPreview(LevelPreview *preview, Game *game) {
+    Game *checkpoint = preview->game;
+    checkpoint->current_wave_nb = preview->first_wave;
+    checkpoint->hash ^= hashValue(SCORE_FEATURE, checkpoint->score) ^ hashValue(TURN_FEATURE, checkpoint->turn_nb) ^ hashValue(SCORE_FEATURE, game->score) ^ hashValue(TURN_FEATURE, 0);
+    checkpoint->turn_nb = 0;
+    checkpoint->total_turns = game->total_turns;
+    checkpoint->funds = game->funds - game->waves[preview->first_wave]->income;
+    checkpoint->score = game->score;
+    checkpoint->game_phase = PRE_WAVE_PHASE;
+    checkpoint->rng = game->rng;
+    /* Towers, in the same order */
+    while (checkpoint->tower_list) destroyTower(checkpoint->tower_list, &checkpoint->tower_list, &checkpoint->hash);
+    Tower **last_tower = &checkpoint->tower_list;
+    for (Tower *tower = game->tower_list; tower; tower = tower->next) {
+        *last_tower = malloc(sizeof(Tower));
+        **last_tower = *tower;
+        toggleTowerHash(&checkpoint->hash, *last_tower);
+        last_tower = &(*last_tower)->next;
+    }
+    *last_tower = NULL;
+    while (checkpoint->enemy_list) destroyEnemy(checkpoint->enemy_list, &checkpoint->enemy_list, &checkpoint->hash);
+    toggleSpawnQueueHash(&checkpoint->hash, checkpoint->spawn_queue);
+    clearSpawnQueue(checkpoint->spawn_queue);
+    preview->checkpoints[preview->first_wave].size = 0;
+    encodeGameState(&preview->checkpoints[preview->first_wave], checkpoint);
+    preview->next_wave = preview->first_wave;
+    preview->up_to_date = false;
+}
+
+/* Mark a wave of a level preview as edited, the waves from it onward are simulated again (unless it was not reached anyway) */
+void invalidateLevelPreview(LevelPreview *preview, int wave_index) {
+    if (wave_index < preview->first_wave || wave_index >= preview->next_wave) return;
+    preview->next_wave = wave_index;
+    preview->up_to_date = false;
+}
+
+/* Edit the enemy entering a wave of a level preview on a row and on a turn, return if the wave changed */
+/* The enemy is added if there is none, removed if it has the same type, its type is replaced otherwise */
+bool editLevelPreviewEnemy(LevelPreview *preview, int wave_index, char enemy_type, int row, int turn) {
+    if (wave_index < 0 || wave_index >= preview->nb_waves) return false;
+    SpawnQueue *spawn_queue = preview->waves[wave_index]->spawn_queue;
+    if (isSpawnQueued(spawn_queue, turn, row)) {
+        SpawnEntry *entry = &spawn_queue->entries[findSpawnEntry(spawn_queue, turn, row)];
+        if (entry->type == enemy_type) unqueueEnemy(spawn_queue, row, turn);
+        else entry->type = enemy_type;
+    }
+    else if (!queueEnemy(spawn_queue, enemy_type, row, turn)) return false;
+    invalidateLevelPreview(preview, wave_index);
+    return true;
+}
+
+/* Simulate the waves of a level preview that are not up to date, each from the checkpoint taken before it, return if it is up to date */
+/* At least one wave is simulated, then waves are simulated until time_budget (in ms) is spent, the next call going on from there */
+bool updateLevelPreview(LevelPreview *preview, double time_budget) {
+    if (preview->up_to_date) return true;
+    Game *game = preview->game;
+    double start = getTimeMs();
+    do {
+        int i = preview->next_wave;
+        preview->checkpoints[i].pos = 0;
+        decodeGameState(&preview->checkpoints[i], game);
+        /* The wave played is the edited one */
+        destroySpawnQueue(game->waves[i]->spawn_queue);
+        game->waves[i]->spawn_queue = cloneSpawnQueue(preview->waves[i]->spawn_queue);
+        game->waves[i]->income = preview->waves[i]->income;
+        loadNextWave(game);
+        predictWave(game, &preview->predictions[i], NULL, 0);
+        preview->nb_waves_simulated++;
+        preview->next_wave++;
+        /* Level lost (or stuck) */
+        if (preview->predictions[i].defeat || preview->predictions[i].nb_turns >= MAX_PREDICTED_TURNS) {
+            preview->lost_wave = i;
+            preview->score = game->score;
+            preview->up_to_date = true;
+        }
+        /* Level won, 1G = 1 point */
+        else if (preview->next_wave >= preview->nb_waves) {
+            preview->lost_wave = -1;
+            preview->score = game->score + game->funds;
+            preview->up_to_date = true;
+        }
+        /* Gain interest on money saved, then keep the state the next wave starts from */
+        else {
+            game->funds *= 1.2;
+            preview->checkpoints[preview->next_wave].size = 0;
+            encodeGameState(&preview->checkpoints[preview->next_wave], game);
+        }
+    } while (!preview->up_to_date && getTimeMs() - start < time_budget);
+    return preview->up_to_date;
+}
+
+/* Give the edited waves to the game of a level preview, its current wave being loaded again */
+void applyLevelPreview(LevelPreview *preview, Game *game) {
+    game->funds -= game->waves[preview->first_wave]->income;
+    for (int i = preview->first_wave; i < preview->nb_waves; i++) {
+        destroySpawnQueue(game->waves[i]->spawn_queue);
+        game->waves[i]->spawn_queue = cloneSpawnQueue(preview->waves[i]->spawn_queue);
+        game->waves[i]->income = preview->waves[i]->income;
+    }
+    game->current_wave_nb = preview->first_wave;
+    loadNextWave(game);
+}
+
+
+
+
+/* Load a build order file, each line being "<wave> <tower type> <collumn> <row>" */
+BuildStep *loadBuildOrder(const char *path, int *nb_steps) {
+    *nb_steps = 0;
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        printf("[ERROR]    Build order file at \"%s\" not found\n", path);
+        return NULL;
+    }
+    BuildStep *build_order = malloc(sizeof(BuildStep)); char **values; int nb_values;
+    while (readLine(file, &values, &nb_values)) {
+        if (nb_values == 4) {
+            build_order = realloc(build_order, (*nb_steps + 1) * sizeof(BuildStep));
+            build_order[*nb_steps] = (BuildStep) {stringToInt(values[0]), values[1][0], stringToInt(values[2]), stringToInt(values[3])};
+            (*nb_steps)++;
+        }
+        else if (nb_values) printf("[ERROR]    Invalid syntax for build order file \"%s\"\n", path);
+        /* Free memory */
+        for (int i = nb_values; i > 0; i--) free(values[i-1]);
+        free(values);
+    }
+    fclose(file);
+    return build_order;
+}
+
+/* Build (or upgrade) every tower planned before the current wave, return the number of towers built */
+int applyBuildOrder(Game *game, BuildStep *build_order, int nb_steps, bool verbose) {
+    int nb_built = 0; char action_type;
+    for (int i = 0; i < nb_steps; i++) {
+        if (build_order[i].wave_nb != game->current_wave_nb) continue;
+        action_type = (isTileEmpty(NULL, game->tower_list, build_order[i].collumn, build_order[i].row) ? BUY_ACTION : UPGRADE_ACTION);
+        if (applyAction(game, (Action) {action_type, build_order[i].type, build_order[i].collumn, build_order[i].row, 0})) nb_built++;
+        else if (verbose) printf("[ERROR]    Could not build tower '%c' at (%d, %d) before wave %d\n", build_order[i].type, build_order[i].collumn, build_order[i].row, build_order[i].wave_nb);
+    }
+    return nb_built;
+}
+
+
+
+
+/* Return the current time in ms (real time, so that it can be shared by threads) */
+double getTimeMs() {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+/* Evaluate a build plan by playing the upcoming waves headlessly on a clone of the game */
+/* Clearing a wave is worth more than anything else, then come the score earned, the funds left and the towers kept */
+/* When a wave is lost, holding enemies longer is what matters (funds left are worth nothing) */
+/* Plans leading to a position already evaluated (the same towers built in another order, by another beam plan or search) reuse its value */
+double evaluateBuildPlan(Game *game, BuildPlan *plan, int nb_waves, TranspositionTable *table) {
+    Game *clone = cloneGame(game);
+    syncEntityIds(clone);
+    double value = 0.0; WavePrediction prediction; bool defeat = false;
+    for (int i = 0; i < plan->nb_actions; i++) if (!applyAction(clone, plan->actions[i])) {
+        destroyGame(clone);
+        return INVALID_PLAN_VALUE;
+    }
+    uint64_t key = hashGame(clone) ^ hashValue(ROLLOUT_FEATURE, nb_waves);
+    if (probeTranspositionTable(table, key, &value)) {
+        destroyGame(clone);
+        return value;
+    }
+    /* Waves without any enemy (such as the first survival one) are not counted */
+    for (int i = 0, nb_played = 0; nb_played < nb_waves && i <= nb_waves; i++) {
+        predictWave(clone, &prediction, NULL, 0);
+        value += prediction.score - TOWER_LOST_VALUE * prediction.nb_towers_lost;
+        if ((defeat = prediction.defeat)) {
+            value += DEFEAT_TURN_VALUE * prediction.nb_turns;
+            break;
+        }
+        if (prediction.nb_turns) {
+            value += WAVE_CLEARED_VALUE;
+            nb_played++;
+        }
+        /* Load the next wave (or win the game) */
+        updateGame(clone, NULL);
+        if (clone->game_phase == VICTORY_PHASE) break;
+    }
+    if (!defeat) value += clone->funds;
+    storeTranspositionTable(table, key, value);
+    destroyGame(clone);
+    return value;
+}
+
+/* Thread of an auto-build search, evaluate plans until none is left or the deadline has passed */
+void *buildSearchWorker(void *data) {
+    BuildSearch *search = data;
+    int i;
+    while ((i = atomic_fetch_add(&search->next_plan, 1)) < search->nb_plans) {
+        if (getTimeMs() > search->deadline) break;
+        search->plans[i].value = evaluateBuildPlan(search->game, &search->plans[i], search->nb_waves, search->table);
+        atomic_fetch_add(&search->nb_rollouts, 1);
+    }
+    return NULL;
+}
+
+/* Return if a build plan already builds or upgrades a tower on a tile */
+bool isTileInBuildPlan(BuildPlan *plan, int collumn, int row) {
+    for (int i = 0; i < plan->nb_actions; i++) if (plan->actions[i].collumn == collumn && plan->actions[i].row == row) return true;
+    return false;
+}
+
+/* Return if two build plans do the same actions (in any order) */
+bool areBuildPlansEqual(BuildPlan *a, BuildPlan *b) {
+    if (a->nb_actions != b->nb_actions) return false;
+    for (int i = 0; i < a->nb_actions; i++) {
+        bool found = false;
+        for (int j = 0; j < b->nb_actions && !found; j++) found = !memcmp(&a->actions[i], &b->actions[j], sizeof(Action));
+        if (!found) return false;
+    }
+    return true;
+}
+
+/* Compare two build plans by decreasing value (for qsort) */
+int compareBuildPlans(const void *a, const void *b) {
+    double value_a = ((BuildPlan *) a)->value, value_b = ((BuildPlan *) b)->value;
+    return (value_a < value_b) - (value_a > value_b);
+}
+
+/* Search the best towers to build or upgrade before the upcoming wave within a time budget (in ms) */
+/* Beam search: each step adds one action to the best plans found so far, every new plan being evaluated by a headless rollout */
+/* The transposition table (NULL for none) can be kept from one search to the next, the level being part of the keys */
+BuildPlan autoBuild(Game *game, TranspositionTable *table, int nb_waves, double time_budget, int nb_threads, long long *nb_rollouts) {
+    /* Actions considered: buying any base tower on any free tile, upgrading any tower */
+    const char tower_types[] = {ARCHER_TOWER, WALL_TOWER, CANON_TOWER, SORCERER_TOWER};
+    int nb_candidates = 0;
+    Action *candidates = malloc((sizeof(tower_types) * NB_ROWS * NB_COLLUMNS + NB_ROWS * NB_COLLUMNS) * sizeof(Action));
+    for (int collumn = 1; collumn < NB_COLLUMNS; collumn++) for (int row = 1; row <= NB_ROWS; row++) {
+        if (isTileBlocked(game->flow_field, collumn, row)) continue;
+        Tower *tower = NULL;
+        getEnemyAndTowerAt(NULL, game->tower_list, collumn, row, NULL, &tower);
+        if (!tower) for (unsigned long i = 0; i < sizeof(tower_types); i++) candidates[nb_candidates++] = (Action) {BUY_ACTION, tower_types[i], collumn, row, 0};
+        else if (tower->type == WALL_TOWER || tower->type == SORCERER_TOWER || tower->type == CANON_TOWER) candidates[nb_candidates++] = (Action) {UPGRADE_ACTION, 0, collumn, row, 0};
+    }
+    BuildSearch search;
+    search.game = game;
+    search.nb_waves = nb_waves;
+    search.table = table;
+    search.deadline = getTimeMs() + time_budget;
+    search.plans = malloc(AUTO_BUILD_BEAM_WIDTH * nb_candidates * sizeof(BuildPlan) + sizeof(BuildPlan));
+    atomic_init(&search.nb_rollouts, 0);
+    nb_threads = max(nb_threads, 1);
+    pthread_t *threads = malloc(nb_threads * sizeof(pthread_t));
+    /* Doing nothing is the first plan */
+    BuildPlan beam[AUTO_BUILD_BEAM_WIDTH], best;
+    best.nb_actions = 0;
+    best.value = evaluateBuildPlan(game, &best, nb_waves, table);
+    beam[0] = best;
+    int beam_size = 1;
+    for (int depth = 0; depth < MAX_BUILD_PLAN_ACTIONS && beam_size && getTimeMs() < search.deadline; depth++) {
+        /* Extend every plan of the beam with each candidate action on a tile it does not use yet */
+        search.nb_plans = 0;
+        for (int i = 0; i < beam_size; i++) for (int j = 0; j < nb_candidates; j++) {
+            if (isTileInBuildPlan(&beam[i], candidates[j].collumn, candidates[j].row)) continue;
+            BuildPlan *plan = &search.plans[search.nb_plans++];
+            *plan = beam[i];
+            plan->actions[plan->nb_actions++] = candidates[j];
+            plan->value = INVALID_PLAN_VALUE;
+        }
+        /* Evaluate new plans on every thread */
+        atomic_init(&search.next_plan, 0);
+        for (int i = 0; i < nb_threads; i++) pthread_create(&threads[i], NULL, buildSearchWorker, &search);
+        for (int i = 0; i < nb_threads; i++) pthread_join(threads[i], NULL);
+        /* Keep the best ones (an action may only pay off once others are added, so the search goes on until nothing can be afforded) */
+        qsort(search.plans, search.nb_plans, sizeof(BuildPlan), compareBuildPlans);
+        beam_size = 0;
+        for (int i = 0; i < search.nb_plans && beam_size < AUTO_BUILD_BEAM_WIDTH && search.plans[i].value > INVALID_PLAN_VALUE; i++) {
+            /* The same actions done in another order make the same plan */
+            bool duplicate = false;
+            for (int j = 0; j < beam_size && !duplicate; j++) duplicate = areBuildPlansEqual(&beam[j], &search.plans[i]);
+            if (!duplicate) beam[beam_size++] = search.plans[i];
+        }
+        if (beam_size && beam[0].value > best.value) best = beam[0];
+    }
+    if (nb_rollouts) *nb_rollouts = atomic_load(&search.nb_rollouts) + 1;
+    free(threads);
+    free(search.plans);
+    free(candidates);
+    return best;
+}
+
+
+
+
+/* Allocate the entity fields of consecutive boards, laid out [slot][board] for stride boards (stride >= nb_boards) */
+/* The fields are owned by the first board, the others pointing inside them */
+void allocateBoardEntities(Board *boards, int nb_boards, int stride) {
+    Board *board = &boards[0];
+    board->stride = stride;
+    board->enemy_type = malloc(MAX_BOARD_ENEMIES * stride * sizeof(char));
+    board->enemy_collumn = malloc(MAX_BOARD_ENEMIES * stride * sizeof(signed char));
+    board->enemy_row = malloc(MAX_BOARD_ENEMIES * stride * sizeof(signed char));
+    board->enemy_speed = malloc(MAX_BOARD_ENEMIES * stride * sizeof(signed char));
+    board->enemy_life_points = malloc(MAX_BOARD_ENEMIES * stride * sizeof(short));
+    board->enemy_id = malloc(MAX_BOARD_ENEMIES * stride * sizeof(int));
+    board->tower_type = malloc(MAX_BOARD_TOWERS * stride * sizeof(char));
+    board->tower_collumn = malloc(MAX_BOARD_TOWERS * stride * sizeof(signed char));
+    board->tower_row = malloc(MAX_BOARD_TOWERS * stride * sizeof(signed char));
+    board->tower_attack_cooldown = malloc(MAX_BOARD_TOWERS * stride * sizeof(int));
+    board->tower_life_points = malloc(MAX_BOARD_TOWERS * stride * sizeof(short));
+    board->tower_id = malloc(MAX_BOARD_TOWERS * stride * sizeof(int));
+    for (int i = 1; i < nb_boards; i++) {
+        boards[i].stride = stride;
+        boards[i].enemy_type = board->enemy_type + i;
+        boards[i].enemy_collumn = board->enemy_collumn + i;
+        boards[i].enemy_row = board->enemy_row + i;
+        boards[i].enemy_speed = board->enemy_speed + i;
+        boards[i].enemy_life_points = board->enemy_life_points + i;
+        boards[i].enemy_id = board->enemy_id + i;
+        boards[i].tower_type = board->tower_type + i;
+        boards[i].tower_collumn = board->tower_collumn + i;
+        boards[i].tower_row = board->tower_row + i;
+        boards[i].tower_attack_cooldown = board->tower_attack_cooldown + i;
+        boards[i].tower_life_points = board->tower_life_points + i;
+        boards[i].tower_id = board->tower_id + i;
+    }
+}
+
+/* Free the entity fields allocated for the boards following this one (included) */
+void freeBoardEntities(Board *board) {
+    free(board->enemy_type);
+    free(board->enemy_collumn);
+    free(board->enemy_row);
+    free(board->enemy_speed);
+    free(board->enemy_life_points);
+    free(board->enemy_id);
+    free(board->tower_type);
+    free(board->tower_collumn);
+    free(board->tower_row);
+    free(board->tower_attack_cooldown);
+    free(board->tower_life_points);
+    free(board->tower_id);
+}
+
+/* Create a board of its own (not part of a batch), to load a game on */
+Board *newBoard() {
+    Board *board = malloc(sizeof(Board));
+    allocateBoardEntities(board, 1, 1);
+    return board;
+}
+
+/* Destroy a board created with newBoard and free its allocated memory */
+void destroyBoard(Board *board) {
+    if (!board) return;
+    freeBoardEntities(board);
+    free(board);
+}
+
+/* Copy the gameplay state of a game in the wave phase into a board, return false if the game does not fit in a board */
+/* Combat statistics are not gathered on boards */
+bool loadBoard(Board *board, Game *game) {
+    int max_life_points, base_speed, score_on_kill, cost, base_attack_cooldown, last_id = -1, i;
+    memset(board->enemy_mask, 0, sizeof(board->enemy_mask));
+    memset(board->tower_mask, 0, sizeof(board->tower_mask));
+    board->flow_field = *game->flow_field;
+    for (int row = 1; row <= NB_ROWS; row++) {
+        board->blocked_mask[row-1] = board->flow_tower_mask[row-1] = 0;
+        for (int collumn = 1; collumn <= NB_COLLUMNS; collumn++) {
+            if (board->flow_field.blocked[row-1][collumn-1]) board->blocked_mask[row-1] |= 1u << collumn;
+            if (board->flow_field.tower[row-1][collumn-1]) board->flow_tower_mask[row-1] |= 1u << collumn;
+        }
+    }
+    /* Enemies, in order of creation (their identifiers must be increasing to be found back) */
+    board->nb_enemy_slots = 0;
+    for (Enemy *enemy = game->enemy_list; enemy; enemy = enemy->next) {
+        if (board->nb_enemy_slots >= MAX_BOARD_ENEMIES || enemy->id <= last_id || enemy->collumn < 0 || enemy->collumn > NB_COLLUMNS || enemy->row < 1 || enemy->row > NB_ROWS) return false;
+        if (!getEnemyStats(enemy->type, &max_life_points, &base_speed, &score_on_kill) || getBoardEnemyAt(board, enemy->collumn, enemy->row) >= 0) return false;
+        i = board->nb_enemy_slots++;
+        board->enemy_type[i * board->stride] = enemy->type;
+        board->enemy_collumn[i * board->stride] = enemy->collumn;
+        board->enemy_row[i * board->stride] = enemy->row;
+        board->enemy_speed[i * board->stride] = enemy->speed;
+        board->enemy_life_points[i * board->stride] = enemy->life_points;
+        board->enemy_id[i * board->stride] = last_id = enemy->id;
+        board->enemy_mask[enemy->row-1] |= 1u << enemy->collumn;
+        board->enemy_slot[enemy->row-1][enemy->collumn] = i;
+    }
+    /* Towers, in order of creation */
+    board->nb_tower_slots = 0;
+    for (Tower *tower = game->tower_list; tower; tower = tower->next) {
+        if (board->nb_tower_slots >= MAX_BOARD_TOWERS || tower->collumn < 1 || tower->collumn > NB_COLLUMNS-1 || tower->row < 1 || tower->row > NB_ROWS) return false;
+        if (!getTowerStats(tower->type, &max_life_points, &cost, &base_attack_cooldown) || board->tower_mask[tower->row-1] & (1u << tower->collumn)) return false;
+        i = board->nb_tower_slots++;
+        board->tower_type[i * board->stride] = tower->type;
+        board->tower_collumn[i * board->stride] = tower->collumn;
+        board->tower_row[i * board->stride] = tower->row;
+        board->tower_attack_cooldown[i * board->stride] = tower->attack_cooldown;
+        board->tower_life_points[i * board->stride] = tower->life_points;
+        board->tower_id[i * board->stride] = tower->id;
+        board->tower_mask[tower->row-1] |= 1u << tower->collumn;
+        board->tower_slot[tower->row-1][tower->collumn] = i;
+    }
+    /* Enemies waiting to enter the map */
+    SpawnQueue *spawn_queue = game->spawn_queue;
+    board->spawn_head = 0;
+    board->nb_spawns = spawn_queue->nb_entries - spawn_queue->head;
+    if (board->nb_spawns > MAX_BOARD_SPAWNS) return false;
+    for (i = 0; i < board->nb_spawns; i++) {
+        SpawnEntry *entry = &spawn_queue->entries[spawn_queue->head + i];
+        if (!getEnemyStats(entry->type, &max_life_points, &base_speed, &score_on_kill) || entry->row < 1 || entry->row > NB_ROWS || entry->turn < -32768 || entry->turn > 32767) return false;
+        board->spawn_type[i] = entry->type;
+        board->spawn_row[i] = entry->row;
+        board->spawn_turn[i] = entry->turn;
+    }
+    board->score = game->score;
+    board->turn_nb = game->turn_nb;
+    board->total_turns = game->total_turns;
+    board->next_id = NEXT_ENTITY_ID;
+    board->hash = game->hash;
+    /* Towers built before the wave are taken into account once, instead of at the first turn of every copy of the board */
+    updateBoardFlowField(board);
+    return true;
+}
+
+/* Write the gameplay state of a board back into the game it was loaded from */
+void storeBoard(Board *board, Game *game) {
+    int next_id = NEXT_ENTITY_ID;
+    Enemy *enemy; Tower *tower;
+    while (game->enemy_list) destroyEnemy(game->enemy_list, &game->enemy_list, NULL);
+    for (int i = 0; i < board->nb_enemy_slots; i++) if (board->enemy_type[i * board->stride] && (enemy = addEnemy(&game->enemy_list, board->enemy_type[i * board->stride], board->enemy_collumn[i * board->stride], board->enemy_row[i * board->stride], -1, NULL))) {
+        enemy->life_points = board->enemy_life_points[i * board->stride];
+        enemy->speed = board->enemy_speed[i * board->stride];
+        enemy->id = board->enemy_id[i * board->stride];
+    }
+    while (game->tower_list) destroyTower(game->tower_list, &game->tower_list, NULL);
+    for (int i = 0; i < board->nb_tower_slots; i++) if (board->tower_type[i * board->stride] && (tower = addTower(&game->tower_list, NULL, board->tower_type[i * board->stride], board->tower_collumn[i * board->stride], board->tower_row[i * board->stride], -1, NULL))) {
+        tower->life_points = board->tower_life_points[i * board->stride];
+        tower->attack_cooldown = board->tower_attack_cooldown[i * board->stride];
+        tower->id = board->tower_id[i * board->stride];
+    }
+    /* Spawn queue */
+    SpawnQueue *spawn_queue = game->spawn_queue;
+    int nb_entries = board->nb_spawns - board->spawn_head;
+    if (spawn_queue->capacity < nb_entries) {
+        spawn_queue->capacity = nb_entries;
+        spawn_queue->entries = realloc(spawn_queue->entries, spawn_queue->capacity * sizeof(SpawnEntry));
+    }
+    for (int i = 0; i < nb_entries; i++) spawn_queue->entries[i] = (SpawnEntry) {board->spawn_type[board->spawn_head + i], board->spawn_row[board->spawn_head + i], board->spawn_turn[board->spawn_head + i]};
+    spawn_queue->head = 0;
+    spawn_queue->nb_entries = nb_entries;
+    game->score = board->score;
+    game->turn_nb = board->turn_nb;
+    game->total_turns = board->total_turns;
+    /* Both hashes have the same definition, the one kept by the board is taken as is */
+    game->hash = board->hash;
+    *game->flow_field = board->flow_field;
+    NEXT_ENTITY_ID = max(next_id, board->next_id);
+}
+
+/* Check that a board holds exactly the gameplay state of a game, print the first difference if verbose */
+bool compareBoardToGame(Board *board, Game *game, bool verbose) {
+    int i = 0;
+    Enemy *enemy = game->enemy_list;
+    for (; i < board->nb_enemy_slots || enemy; i++) {
+        if (i < board->nb_enemy_slots && !board->enemy_type[i * board->stride]) continue;
+        if (i >= board->nb_enemy_slots || !enemy || board->enemy_type[i * board->stride] != enemy->type || board->enemy_collumn[i * board->stride] != enemy->collumn || board->enemy_row[i * board->stride] != enemy->row
+            || board->enemy_life_points[i * board->stride] != enemy->life_points || board->enemy_speed[i * board->stride] != enemy->speed || board->enemy_id[i * board->stride] != enemy->id) {
+            if (verbose) printf("[ERROR]    Turn %d: enemy %d differs (%s)\n", game->total_turns, enemy ? enemy->id : -1, (i < board->nb_enemy_slots && enemy) ? "state" : "missing");
+            return false;
+        }
+        enemy = enemy->next;
+    }
+    Tower *tower = game->tower_list;
+    for (i = 0; i < board->nb_tower_slots || tower; i++) {
+        if (i < board->nb_tower_slots && !board->tower_type[i * board->stride]) continue;
+        if (i >= board->nb_tower_slots || !tower || board->tower_type[i * board->stride] != tower->type || board->tower_collumn[i * board->stride] != tower->collumn || board->tower_row[i * board->stride] != tower->row
+            || board->tower_life_points[i * board->stride] != tower->life_points || board->tower_attack_cooldown[i * board->stride] != tower->attack_cooldown || board->tower_id[i * board->stride] != tower->id) {
+            if (verbose) printf("[ERROR]    Turn %d: tower %d differs (%s)\n", game->total_turns, tower ? tower->id : -1, (i < board->nb_tower_slots && tower) ? "state" : "missing");
+            return false;
+        }
+        tower = tower->next;
+    }
+    SpawnQueue *spawn_queue = game->spawn_queue;
+    bool same = (board->nb_spawns - board->spawn_head == spawn_queue->nb_entries - spawn_queue->head);
+    for (i = 0; same && i < board->nb_spawns - board->spawn_head; i++) {
+        SpawnEntry *entry = &spawn_queue->entries[spawn_queue->head + i];
+        same = (board->spawn_type[board->spawn_head + i] == entry->type && board->spawn_row[board->spawn_head + i] == entry->row && board->spawn_turn[board->spawn_head + i] == entry->turn);
+    }
+    if (!same) {
+        if (verbose) printf("[ERROR]    Turn %d: spawn queues differ\n", game->total_turns);
+        return false;
+    }
+    if (board->score != game->score || board->turn_nb != game->turn_nb || board->total_turns != game->total_turns) {
+        if (verbose) printf("[ERROR]    Turn %d: score or turn differs (%d/%d, %d/%d)\n", game->total_turns, board->score, game->score, board->turn_nb, game->turn_nb);
+        return false;
+    }
+    /* The hashes kept up to date by the board and by the game must match the one computed from scratch */
+    if (board->hash != hashWaveState(game) || game->hash != hashWaveState(game)) {
+        if (verbose) printf("[ERROR]    Turn %d: hash differs (%016llx/%016llx/%016llx)\n", game->total_turns, (unsigned long long) board->hash, (unsigned long long) game->hash, (unsigned long long) hashWaveState(game));
+        return false;
+    }
+    return true;
+}
+
+/* Return the slot of the enemy on a tile (the castle collumn included), -1 if there is none */
+int getBoardEnemyAt(Board *board, int collumn, int row) {
+    if (row < 1 || row > NB_ROWS || collumn < 0 || collumn > NB_COLLUMNS || !(board->enemy_mask[row-1] & (1u << collumn))) return -1;
+    return board->enemy_slot[row-1][collumn];
+}
+
+/* Return if there is neither an enemy nor a tower on a tile (tiles outside of the map are empty) */
+bool isBoardTileEmpty(Board *board, int collumn, int row) {
+    if (row < 1 || row > NB_ROWS || collumn < 0 || collumn > NB_COLLUMNS) return true;
+    return !((board->enemy_mask[row-1] | board->tower_mask[row-1]) & (1u << collumn));
+}
+
+/* Return if something can be summoned on a tile: in the map, not blocked by the terrain and empty */
+bool isBoardTileFree(Board *board, int collumn, int row) {
+    return doesTileExist(collumn, row) && !((board->enemy_mask[row-1] | board->tower_mask[row-1] | board->blocked_mask[row-1]) & (1u << collumn));
+}
+
+/* Return the slot of the enemy with this identifier, -1 if it was destroyed (slots are sorted by identifier) */
+int findBoardEnemyById(Board *board, int id) {
+    int a = 0, b = board->nb_enemy_slots, c;
+    while (a < b) {
+        c = (a + b) / 2;
+        if (board->enemy_id[c * board->stride] < id) a = c + 1;
+        else b = c;
+    }
+    return (a < board->nb_enemy_slots && board->enemy_id[a * board->stride] == id && board->enemy_type[a * board->stride]) ? a : -1;
+}
+
+/* Move enemies down to fill the slots of destroyed ones (order of creation is kept) */
+void compactBoardEnemies(Board *board) {
+    int nb_slots = 0;
+    for (int i = 0; i < board->nb_enemy_slots; i++) if (board->enemy_type[i * board->stride]) {
+        board->enemy_type[nb_slots * board->stride] = board->enemy_type[i * board->stride];
+        board->enemy_collumn[nb_slots * board->stride] = board->enemy_collumn[i * board->stride];
+        board->enemy_row[nb_slots * board->stride] = board->enemy_row[i * board->stride];
+        board->enemy_speed[nb_slots * board->stride] = board->enemy_speed[i * board->stride];
+        board->enemy_life_points[nb_slots * board->stride] = board->enemy_life_points[i * board->stride];
+        board->enemy_id[nb_slots * board->stride] = board->enemy_id[i * board->stride];
+        board->enemy_slot[board->enemy_row[i * board->stride]-1][board->enemy_collumn[i * board->stride]] = nb_slots;
+        nb_slots++;
+    }
+    board->nb_enemy_slots = nb_slots;
+}
+
+/* Move towers down to fill the slots of destroyed ones (order of creation is kept) */
+void compactBoardTowers(Board *board) {
+    int nb_slots = 0;
+    for (int i = 0; i < board->nb_tower_slots; i++) if (board->tower_type[i * board->stride]) {
+        board->tower_type[nb_slots * board->stride] = board->tower_type[i * board->stride];
+        board->tower_collumn[nb_slots * board->stride] = board->tower_collumn[i * board->stride];
+        board->tower_row[nb_slots * board->stride] = board->tower_row[i * board->stride];
+        board->tower_attack_cooldown[nb_slots * board->stride] = board->tower_attack_cooldown[i * board->stride];
+        board->tower_life_points[nb_slots * board->stride] = board->tower_life_points[i * board->stride];
+        board->tower_id[nb_slots * board->stride] = board->tower_id[i * board->stride];
+        board->tower_slot[board->tower_row[i * board->stride]-1][board->tower_collumn[i * board->stride]] = nb_slots;
+        nb_slots++;
+    }
+    board->nb_tower_slots = nb_slots;
+}
+
+/* Add an enemy on a tile with no enemy, return its slot (-1 if it could not be added) */
+int addBoardEnemy(Board *board, char enemy_type, int collumn, int row, int life_points) {
+    int max_life_points, base_speed, score_on_kill;
+    if (getBoardEnemyAt(board, collumn, row) >= 0 || row < 1 || row > NB_ROWS || collumn < 0 || collumn > NB_COLLUMNS) return -1;
+    if (!getEnemyStats(enemy_type, &max_life_points, &base_speed, &score_on_kill)) return -1;
+    if (board->nb_enemy_slots >= MAX_BOARD_ENEMIES) compactBoardEnemies(board);
+    int i = board->nb_enemy_slots++;
+    board->enemy_type[i * board->stride] = enemy_type;
+    board->enemy_collumn[i * board->stride] = collumn;
+    board->enemy_row[i * board->stride] = row;
+    board->enemy_speed[i * board->stride] = base_speed;
+    board->enemy_life_points[i * board->stride] = (life_points != -1) ? life_points : max_life_points;
+    board->enemy_id[i * board->stride] = board->next_id++;
+    board->enemy_mask[row-1] |= 1u << collumn;
+    board->enemy_slot[row-1][collumn] = i;
+    board->hash ^= hashBoardEnemy(board, i);
+    return i;
+}
+
+/* Remove an enemy from the board */
+void removeBoardEnemy(Board *board, int slot) {
+    board->hash ^= hashBoardEnemy(board, slot);
+    board->enemy_mask[board->enemy_row[slot * board->stride]-1] &= ~(1u << board->enemy_collumn[slot * board->stride]);
+    board->enemy_type[slot * board->stride] = '\0';
+}
+
+/* Add a tower on a tile with no tower (the last collumn excluded), return its slot (-1 if it could not be added) */
+int addBoardTower(Board *board, char tower_type, int collumn, int row) {
+    int max_life_points, cost, base_attack_cooldown;
+    if (row < 1 || row > NB_ROWS || collumn < 1 || collumn > NB_COLLUMNS-1 || board->tower_mask[row-1] & (1u << collumn)) return -1;
+    if (!getTowerStats(tower_type, &max_life_points, &cost, &base_attack_cooldown)) return -1;
+    if (board->nb_tower_slots >= MAX_BOARD_TOWERS) compactBoardTowers(board);
+    int i = board->nb_tower_slots++;
+    board->tower_type[i * board->stride] = tower_type;
+    board->tower_collumn[i * board->stride] = collumn;
+    board->tower_row[i * board->stride] = row;
+    board->tower_attack_cooldown[i * board->stride] = 1;
+    board->tower_life_points[i * board->stride] = max_life_points;
+    board->tower_id[i * board->stride] = board->next_id++;
+    board->tower_mask[row-1] |= 1u << collumn;
+    board->tower_slot[row-1][collumn] = i;
+    board->hash ^= hashBoardTower(board, i);
+    return i;
+}
+
+/* Remove a tower from the board */
+void removeBoardTower(Board *board, int slot) {
+    board->hash ^= hashBoardTower(board, slot);
+    board->tower_mask[board->tower_row[slot * board->stride]-1] &= ~(1u << board->tower_collumn[slot * board->stride]);
+    board->tower_type[slot * board->stride] = '\0';
+}
+
+/* Move an enemy by one tile (on a single axis), return false if the tile is blocked or occupied */
+bool moveBoardEnemy(Board *board, int slot, int dx, int dy) {
+    int collumn = board->enemy_collumn[slot * board->stride] + dx, row = board->enemy_row[slot * board->stride] + dy;
+    /* Enemies may leave the map toward the castle, but never change row outside of it */
+    if (dy && !doesTileExist(collumn, row)) return false;
+    if (doesTileExist(collumn, row) && (board->blocked_mask[row-1] & (1u << collumn))) return false;
+    if (!isBoardTileEmpty(board, collumn, row)) return false;
+    board->hash ^= hashBoardEnemy(board, slot);
+    board->enemy_mask[board->enemy_row[slot * board->stride]-1] &= ~(1u << board->enemy_collumn[slot * board->stride]);
+    board->enemy_collumn[slot * board->stride] = collumn;
+    board->enemy_row[slot * board->stride] = row;
+    board->enemy_mask[row-1] |= 1u << collumn;
+    board->enemy_slot[row-1][collumn] = slot;
+    board->hash ^= hashBoardEnemy(board, slot);
+    return true;
+}
+
+/* Repair the flow field where towers were built or destroyed since the last update (in the same order as updateFlowField) */
+void updateBoardFlowField(Board *board) {
+    for (int row = 1; row <= NB_ROWS; row++) {
+        for (uint16_t changed = board->tower_mask[row-1] ^ board->flow_tower_mask[row-1]; changed; changed &= changed - 1)
+            repairFlowField(&board->flow_field, __builtin_ctz(changed), row, board->tower_mask[row-1] & (changed & -changed));
+        board->flow_tower_mask[row-1] = board->tower_mask[row-1];
+    }
+}
+
+/* Make an enemy attack the tower in front of it (see enemyAttack) */
+void boardEnemyAttack(Board *board, int slot) {
+    int collumn = board->enemy_collumn[slot * board->stride], row = board->enemy_row[slot * board->stride], dx, dy, damage = 0, e, n, max_life_points, base_speed, score_on_kill;
+    if (!getFlowStep(&board->flow_field, collumn, row, &dx, &dy)) dx = -1;
+    switch (board->enemy_type[slot * board->stride]) {
+        case SLIME_ENEMY:       damage = 2; break;
+        case GELLY_ENEMY:       damage = 2; break;
+        case GOBLIN_ENEMY:      damage = 3; break;
+        case ORC_ENEMY:         damage = 5; break;
+        case NECROMANCER_ENEMY: damage = 4; break;
+        case SKELETON_ENEMY:    damage = 2; break;
+        case WITCH_ENEMY:       damage = 2; break;
+    }
+    bool attacked = doesTileExist(collumn + dx, row + dy) && (board->tower_mask[row+dy-1] & (1u << (collumn + dx)));
+    if (attacked) damageBoardTower(board, board->tower_slot[row+dy-1][collumn+dx], damage);
+    /* Area heal and speed boost (except for self) */
+    if (board->enemy_type[slot * board->stride] == WITCH_ENEMY) for (int y = -1; y <= 1; y++) for (int x = -1; x <= 1; x++) if ((x || y) && (e = getBoardEnemyAt(board, collumn + x, row + y)) >= 0) {
+        getEnemyStats(board->enemy_type[e * board->stride], &max_life_points, &base_speed, &score_on_kill);
+        board->hash ^= hashBoardEnemy(board, e);
+        if (max_life_points != board->enemy_life_points[e * board->stride]) {
+            n = min(3, max_life_points - board->enemy_life_points[e * board->stride]);
+            board->enemy_life_points[e * board->stride] += n;
+        }
+        board->enemy_speed[e * board->stride] += 1;
+        board->hash ^= hashBoardEnemy(board, e);
+    }
+    if (attacked) {
+        board->hash ^= hashBoardEnemy(board, slot);
+        board->enemy_speed[slot * board->stride] = 0;
+        board->hash ^= hashBoardEnemy(board, slot);
+    }
+}
+
+/* Damage an enemy, killing it or triggering its on-hit ability (see damageEnemy), return false if nothing was damaged */
+bool damageBoardEnemy(Board *board, int slot, int amount) {
+    if (slot < 0 || !amount) return false;
+    int collumn = board->enemy_collumn[slot * board->stride], row = board->enemy_row[slot * board->stride], type = board->enemy_type[slot * board->stride], n, max_life_points, base_speed, score_on_kill;
+    board->hash ^= hashBoardEnemy(board, slot);
+    board->enemy_life_points[slot * board->stride] -= amount;
+    board->hash ^= hashBoardEnemy(board, slot);
+    /* Kill enemy if health reaches 0 or less */
+    if (board->enemy_life_points[slot * board->stride] <= 0) {
+        getEnemyStats(type, &max_life_points, &base_speed, &score_on_kill);
+        board->hash ^= hashValue(SCORE_FEATURE, board->score) ^ hashValue(SCORE_FEATURE, board->score + score_on_kill);
+        board->score += score_on_kill;
+        removeBoardEnemy(board, slot);
+        /* Gelly splits into 2 slimes on death: above, bellow, behind, then at its position */
+        if (type == GELLY_ENEMY) {
+            n = 2;
+            if (n && isBoardTileFree(board, collumn, row - 1) && addBoardEnemy(board, SLIME_ENEMY, collumn, row - 1, -1) >= 0) n--;
+            if (n && isBoardTileFree(board, collumn, row + 1) && addBoardEnemy(board, SLIME_ENEMY, collumn, row + 1, -1) >= 0) n--;
+            if (n && isBoardTileFree(board, collumn + 1, row) && addBoardEnemy(board, SLIME_ENEMY, collumn + 1, row, -1) >= 0) n--;
+            if (n && isBoardTileFree(board, collumn, row) && addBoardEnemy(board, SLIME_ENEMY, collumn, row, -1) >= 0) n--;
+        }
+        return true;
+    }
+    /* Goblin changes row on hit, depending on its hp left */
+    if (type == GOBLIN_ENEMY) {
+        n = (board->enemy_life_points[slot * board->stride] % 2) ? 1 : -1;
+        if (!moveBoardEnemy(board, slot, 0, n)) moveBoardEnemy(board, slot, 0, -n);
+    }
+    /* Necromancer summons a skeleton nearby on hit */
+    else if (type == NECROMANCER_ENEMY) {
+        if (isBoardTileFree(board, collumn - 1, row)) addBoardEnemy(board, SKELETON_ENEMY, collumn - 1, row, -1);
+        else if (isBoardTileFree(board, collumn, row - 1)) addBoardEnemy(board, SKELETON_ENEMY, collumn, row - 1, -1);
+        else if (isBoardTileFree(board, collumn, row + 1)) addBoardEnemy(board, SKELETON_ENEMY, collumn, row + 1, -1);
+        else if (isBoardTileFree(board, collumn + 1, row)) addBoardEnemy(board, SKELETON_ENEMY, collumn + 1, row, -1);
+    }
+    return true;
+}
+
+/* Damage a tower, destroying it if its life points reach 0 */
+void damageBoardTower(Board *board, int slot, int amount) {
+    board->hash ^= hashBoardTower(board, slot);
+    board->tower_life_points[slot * board->stride] -= amount;
+    board->hash ^= hashBoardTower(board, slot);
+    if (board->tower_life_points[slot * board->stride] <= 0) removeBoardTower(board, slot);
+}
+
+/* Move an enemy up to its speed along the flow field, stopping at the first tile it cannot enter */
+void advanceBoardEnemy(Board *board, int slot) {
+    int dx, dy;
+    for (int j = 0; j < board->enemy_speed[slot * board->stride] && getFlowStep(&board->flow_field, board->enemy_collumn[slot * board->stride], board->enemy_row[slot * board->stride], &dx, &dy); j++)
+        if (!moveBoardEnemy(board, slot, dx, dy)) break;
+}
+
+/* Make all enemies move following the flow field, from top to bottom then from left to right (see makeAllEnemiesMove) */
+void moveAllBoardEnemies(Board *board) {
+    int order[NB_ROWS * (NB_COLLUMNS + 1)], nb_enemies = 0, slot, max_life_points, base_speed, score_on_kill;
+    updateBoardFlowField(board);
+    /* Order is fixed before moving as enemies may change row */
+    for (int row = 1; row <= NB_ROWS; row++) for (uint16_t mask = board->enemy_mask[row-1]; mask; mask &= mask - 1) order[nb_enemies++] = board->enemy_slot[row-1][__builtin_ctz(mask)];
+    for (int i = 0; i < nb_enemies; i++) {
+        slot = order[i];
+        advanceBoardEnemy(board, slot);
+        getEnemyStats(board->enemy_type[slot * board->stride], &max_life_points, &base_speed, &score_on_kill);
+        board->hash ^= hashBoardEnemy(board, slot);
+        board->enemy_speed[slot * board->stride] = base_speed;
+        board->hash ^= hashBoardEnemy(board, slot);
+    }
+}
+
+/* Make waiting enemies enter the map once their turn has come and their spawn tile is free (see spawnQueuedEnemies) */
+void spawnBoardEnemies(Board *board) {
+    int last = board->spawn_head, kept;
+    while (last < board->nb_spawns && board->spawn_turn[last] <= board->turn_nb) last++;
+    for (int i = board->spawn_head; i < last; i++) {
+        if (!isBoardTileEmpty(board, NB_COLLUMNS, board->spawn_row[i])) continue;
+        addBoardEnemy(board, board->spawn_type[i], NB_COLLUMNS, board->spawn_row[i], -1);
+        board->hash ^= hashSpawn(board->spawn_type[i], board->spawn_row[i], board->spawn_turn[i]);
+        board->spawn_type[i] = '\0';
+    }
+    /* Keep entries still waiting right before the entries whose turn has not come yet */
+    kept = last;
+    for (int i = last - 1; i >= board->spawn_head; i--) if (board->spawn_type[i]) {
+        kept--;
+        board->spawn_type[kept] = board->spawn_type[i];
+        board->spawn_row[kept] = board->spawn_row[i];
+        board->spawn_turn[kept] = board->spawn_turn[i];
+    }
+    board->spawn_head = kept;
+}
+
+/* Return the slot of the closest enemy on a row at most range tiles in front of a collumn, -1 if there is none */
+int getFirstBoardEnemyInRange(Board *board, int collumn, int row, int range) {
+    if (row < 1 || row > NB_ROWS) return -1;
+    unsigned int mask = (board->enemy_mask[row-1] >> (collumn + 1)) & ((1u << range) - 1);
+    return mask ? board->enemy_slot[row-1][collumn + 1 + __builtin_ctz(mask)] : -1;
+}
+
+/* Make a tower whose attack cooldown has run out act (see towerAct), the caller updates the hash for the new attack cooldown */
+void boardTowerAct(Board *board, int slot) {
+    int collumn = board->tower_collumn[slot * board->stride], row = board->tower_row[slot * board->stride], target = -1, target_ids[3], target_rows[3] = {0, -1, +1}, max_life_points, cost, base_attack_cooldown;
+    getTowerStats(board->tower_type[slot * board->stride], &max_life_points, &cost, &base_attack_cooldown);
+    switch (board->tower_type[slot * board->stride]) {
+        case ARCHER_TOWER:
+            target = getFirstBoardEnemyInRange(board, collumn, row, 9);
+            break;
+        case WALL_TOWER:
+            board->tower_attack_cooldown[slot * board->stride] = base_attack_cooldown;
+            break;
+        case BARRACK_TOWER:
+            board->tower_attack_cooldown[slot * board->stride] = base_attack_cooldown;
+            if (isBoardTileFree(board, collumn, row - 1) && addBoardTower(board, SOLIDER_TOWER, collumn, row - 1) >= 0);
+            else if (isBoardTileFree(board, collumn, row + 1) && addBoardTower(board, SOLIDER_TOWER, collumn, row + 1) >= 0);
+            else if (isBoardTileFree(board, collumn + 1, row) && addBoardTower(board, SOLIDER_TOWER, collumn + 1, row) >= 0);
+            else if (isBoardTileFree(board, collumn - 1, row) && addBoardTower(board, SOLIDER_TOWER, collumn - 1, row) >= 0);
+            else board->tower_attack_cooldown[slot * board->stride] = 1;
+            break;
+        case SOLIDER_TOWER:
+            /* Same or adjacent rows, closest collumn first */
+            for (int i = 1; i <= 2 && target < 0; i++) for (int j = 0; j < 3 && target < 0; j++)
+                if (doesTileExist(collumn + i, row + target_rows[j])) target = getBoardEnemyAt(board, collumn + i, row + target_rows[j]);
+            break;
+        case CANON_TOWER:
+            target = getFirstBoardEnemyInRange(board, collumn, row, 3);
+            break;
+        case DESTROYER_TOWER:
+            target = getFirstBoardEnemyInRange(board, collumn, row, 4);
+            break;
+        case SORCERER_TOWER:
+            target = getFirstBoardEnemyInRange(board, collumn, row, 7);
+            break;
+        case MAGE_TOWER:
+            /* Targets are all chosen before shooting, and may have been killed by the previous shots */
+            for (int j = 0; j < 3; j++) {
+                target_ids[j] = -1;
+                if ((target = getFirstBoardEnemyInRange(board, collumn, row + target_rows[j], 7)) >= 0) {
+                    board->tower_attack_cooldown[slot * board->stride] = base_attack_cooldown;
+                    target_ids[j] = board->enemy_id[target * board->stride];
+                }
+            }
+            for (int j = 0; j < 3; j++) if (target_ids[j] >= 0 && (target = findBoardEnemyById(board, target_ids[j])) >= 0) boardShootEnemy(board, slot, target);
+            return;
+    }
+    if (target >= 0) {
+        board->tower_attack_cooldown[slot * board->stride] = base_attack_cooldown;
+        boardShootEnemy(board, slot, target);
+    }
+}
+
+/* Make a tower shoot an enemy (see shootEnemy) */
+void boardShootEnemy(Board *board, int tower_slot, int slot) {
+    int collumn = board->enemy_collumn[slot * board->stride], row = board->enemy_row[slot * board->stride], id = board->enemy_id[slot * board->stride];
+    switch (board->tower_type[tower_slot * board->stride]) {
+        case ARCHER_TOWER:
+            damageBoardEnemy(board, slot, 2);
+            break;
+        case SOLIDER_TOWER:
+            damageBoardEnemy(board, slot, 2);
+            break;
+        case CANON_TOWER:
+            damageBoardEnemy(board, slot, 9);
+            break;
+        case DESTROYER_TOWER:
+            damageBoardEnemy(board, slot, 10);
+            /* Area damage */
+            for (int dy = -1; dy <= 1; dy++) for (int dx = -1; dx <= 1; dx++) if ((dx || dy) && doesTileExist(collumn + dx, row + dy))
+                damageBoardEnemy(board, getBoardEnemyAt(board, collumn + dx, row + dy), 4);
+            break;
+        case SORCERER_TOWER:
+        case MAGE_TOWER:
+            /* Enemy slowdown on hit */
+            if (damageBoardEnemy(board, slot, 3) && (slot = findBoardEnemyById(board, id)) >= 0) {
+                board->hash ^= hashBoardEnemy(board, slot);
+                board->enemy_speed[slot * board->stride] = min(max(board->enemy_speed[slot * board->stride] - 1, 1), board->enemy_speed[slot * board->stride]);
+                board->hash ^= hashBoardEnemy(board, slot);
+            }
+            break;
+    }
+}
+
+/* Resolve a whole turn on a board, exactly as resolveTurn does on the game it was loaded from */
+void resolveBoardTurn(Board *board) {
+    /* Enemies attack */
+    updateBoardFlowField(board);
+    for (int i = 0; i < board->nb_enemy_slots; i++) if (board->enemy_type[i * board->stride]) boardEnemyAttack(board, i);
+    /* Enemies move, then waiting enemies enter the map */
+    board->hash ^= hashValue(TURN_FEATURE, board->turn_nb) ^ hashValue(TURN_FEATURE, board->turn_nb + 1);
+    board->turn_nb++;
+    board->total_turns++;
+    moveAllBoardEnemies(board);
+    spawnBoardEnemies(board);
+    /* Towers do not act if an enemy has reached the castle */
+    if (hasBoardEnemyReachedCastle(board)) return;
+    /* Towers act, soldiers summoned this turn included (slots are made so that none of them moves during the loop) */
+    if (board->nb_tower_slots > MAX_BOARD_TOWERS - NB_ROWS*(NB_COLLUMNS-1)) compactBoardTowers(board);
+    for (int i = 0; i < board->nb_tower_slots; i++) if (board->tower_type[i * board->stride]) {
+        board->hash ^= hashBoardTower(board, i);
+        if (--board->tower_attack_cooldown[i * board->stride] <= 0) boardTowerAct(board, i);
+        board->hash ^= hashBoardTower(board, i);
+    }
+}
+
+/* Return if every enemy of the wave has been defeated */
+bool isBoardWaveOver(Board *board) {
+    for (int row = 1; row <= NB_ROWS; row++) if (board->enemy_mask[row-1]) return false;
+    return board->spawn_head >= board->nb_spawns;
+}
+
+/* Return if an enemy has reached the castle */
+bool hasBoardEnemyReachedCastle(Board *board) {
+    for (int row = 1; row <= NB_ROWS; row++) if (board->enemy_mask[row-1] & 1u) return true;
+    return false;
+}
+
+
+
+
+/* Create a batch of empty boards (every wave is over until loaded), stepped by nb_threads threads created once and for all */
+BoardBatch *newBoardBatch(int nb_boards, int nb_threads) {
+    BoardBatch *batch = malloc(sizeof(BoardBatch));
+    batch->nb_boards = nb_boards;
+    batch->boards = malloc(max(nb_boards, 1) * sizeof(Board));
+    batch->stride = max((nb_boards + BOARD_BATCH_CHUNK - 1) / BOARD_BATCH_CHUNK, 1) * BOARD_BATCH_CHUNK;
+    allocateBoardEntities(batch->boards, max(nb_boards, 1), batch->stride);
+    batch->running = calloc(max(nb_boards, 1), sizeof(unsigned char));
+    batch->defeat = calloc(max(nb_boards, 1), sizeof(unsigned char));
+    batch->score = calloc(max(nb_boards, 1), sizeof(int));
+    batch->nb_turns = calloc(max(nb_boards, 1), sizeof(int));
+    batch->nb_running = 0;
+    atomic_init(&batch->next_board, 0);
+    /* No more threads than chunks of boards, the calling thread being one of them */
+    batch->nb_threads = min(max(nb_threads, 1), max((nb_boards + BOARD_BATCH_CHUNK - 1) / BOARD_BATCH_CHUNK, 1));
+    pthread_mutex_init(&batch->mutex, NULL);
+    pthread_cond_init(&batch->start, NULL);
+    pthread_cond_init(&batch->done, NULL);
+    batch->nb_steps = 0;
+    batch->nb_busy = 0;
+    batch->stopping = false;
+    batch->threads = malloc(max(batch->nb_threads - 1, 1) * sizeof(pthread_t));
+    for (int i = 0; i < batch->nb_threads - 1; i++) pthread_create(&batch->threads[i], NULL, boardBatchThread, batch);
+    return batch;
+}
+
+/* Stop the threads of a batch and free its allocated memory */
+void destroyBoardBatch(BoardBatch *batch) {
+    if (!batch) return;
+    pthread_mutex_lock(&batch->mutex);
+    batch->stopping = true;
+    pthread_cond_broadcast(&batch->start);
+    pthread_mutex_unlock(&batch->mutex);
+    for (int i = 0; i < batch->nb_threads - 1; i++) pthread_join(batch->threads[i], NULL);
+    free(batch->threads);
+    pthread_mutex_destroy(&batch->mutex);
+    pthread_cond_destroy(&batch->start);
+    pthread_cond_destroy(&batch->done);
+    freeBoardEntities(&batch->boards[0]);
+    free(batch->boards);
+    free(batch->running);
+    free(batch->defeat);
+    free(batch->score);
+    free(batch->nb_turns);
+    free(batch);
+}
+
+/* Load the wave of a game in the wave phase on a board of a batch, return false if it does not fit (the board is then left over) */
+bool loadBoardBatch(BoardBatch *batch, int i, Game *game) {
+    bool loaded = loadBoard(&batch->boards[i], game);
+    batch->nb_running -= batch->running[i];
+    batch->running[i] = loaded;
+    batch->nb_running += loaded;
+    batch->defeat[i] = false;
+    batch->nb_turns[i] = 0;
+    batch->score[i] = game->score;
+    if (loaded) updateBoardBatchStatus(batch, i, i + 1);
+    return loaded;
+}
+
+/* Refresh the status of the boards first to last-1 (a wave stops once over, lost, or stuck like in predictWave) */
+void updateBoardBatchStatus(BoardBatch *batch, int first, int last) {
+    for (int i = first; i < last; i++) if (batch->running[i]) {
+        Board *board = &batch->boards[i];
+        batch->score[i] = board->score;
+        batch->defeat[i] = hasBoardEnemyReachedCastle(board);
+        batch->running[i] = !batch->defeat[i] && !isBoardWaveOver(board) && batch->nb_turns[i] < MAX_PREDICTED_TURNS;
+    }
+}
+
+/* Resolve a whole turn on the running boards first to last-1 (at most a chunk), exactly as resolveBoardTurn does on each of them */
+/* Passes over entities go slot by slot across the boards, the same field of neighbouring boards being contiguous */
+void resolveBoardBatchTurn(BoardBatch *batch, int first, int last) {
+    Board *boards = batch->boards;
+    int stride = batch->stride, nb_slots = 0, nb_orders = 0, slot, max_life_points, base_speed, score_on_kill;
+    unsigned char order[NB_ROWS * (NB_COLLUMNS + 1)][BOARD_BATCH_CHUNK], nb_enemies[BOARD_BATCH_CHUNK], nb_towers[BOARD_BATCH_CHUNK], acting[BOARD_BATCH_CHUNK];
+    unsigned char *running = &batch->running[first];
+    char *enemy_type, *tower_type;
+    signed char *enemy_speed;
+    int *attack_cooldown;
+    boards += first;
+    last -= first;
+    /* Enemies attack (none of them is added or removed) */
+    for (int i = 0; i < last; i++) if (running[i]) {
+        updateBoardFlowField(&boards[i]);
+        nb_slots = max(nb_slots, boards[i].nb_enemy_slots);
+    }
+    for (slot = 0; slot < nb_slots; slot++) {
+        enemy_type = &boards[0].enemy_type[slot * stride];
+        for (int i = 0; i < last; i++) if (running[i] && slot < boards[i].nb_enemy_slots && enemy_type[i]) boardEnemyAttack(&boards[i], slot);
+    }
+    /* Enemies move, the order of each board being fixed before moving as enemies may change row */
+    for (int i = 0; i < last; i++) {
+        nb_enemies[i] = 0;
+        if (!running[i]) continue;
+        boards[i].hash ^= hashValue(TURN_FEATURE, boards[i].turn_nb) ^ hashValue(TURN_FEATURE, boards[i].turn_nb + 1);
+        boards[i].turn_nb++;
+        boards[i].total_turns++;
+        updateBoardFlowField(&boards[i]);
+        for (int row = 1; row <= NB_ROWS; row++) for (uint16_t mask = boards[i].enemy_mask[row-1]; mask; mask &= mask - 1)
+            order[nb_enemies[i]++][i] = boards[i].enemy_slot[row-1][__builtin_ctz(mask)];
+        nb_orders = max(nb_orders, nb_enemies[i]);
+    }
+    for (int k = 0; k < nb_orders; k++) for (int i = 0; i < last; i++) if (k < nb_enemies[i]) advanceBoardEnemy(&boards[i], order[k][i]);
+    /* Moving enemies get their base speed back (moving does not depend on the speed of the others) */
+    nb_slots = 0;
+    for (int i = 0; i < last; i++) if (running[i]) nb_slots = max(nb_slots, boards[i].nb_enemy_slots);
+    for (slot = 0; slot < nb_slots; slot++) {
+        enemy_type = &boards[0].enemy_type[slot * stride];
+        enemy_speed = &boards[0].enemy_speed[slot * stride];
+        for (int i = 0; i < last; i++) if (running[i] && slot < boards[i].nb_enemy_slots && enemy_type[i]) {
+            getEnemyStats(enemy_type[i], &max_life_points, &base_speed, &score_on_kill);
+            boards[i].hash ^= hashBoardEnemy(&boards[i], slot);
+            enemy_speed[i] = base_speed;
+            boards[i].hash ^= hashBoardEnemy(&boards[i], slot);
+        }
+    }
+    /* Waiting enemies enter the map, towers do not act on boards where an enemy has reached the castle */
+    nb_slots = 0;
+    for (int i = 0; i < last; i++) {
+        acting[i] = false;
+        nb_towers[i] = 0;
+        if (!running[i]) continue;
+        spawnBoardEnemies(&boards[i]);
+        if (hasBoardEnemyReachedCastle(&boards[i])) continue;
+        if (boards[i].nb_tower_slots > MAX_BOARD_TOWERS - NB_ROWS*(NB_COLLUMNS-1)) compactBoardTowers(&boards[i]);
+        acting[i] = true;
+        nb_towers[i] = boards[i].nb_tower_slots;
+        nb_slots = max(nb_slots, nb_towers[i]);
+    }
+    /* Attack cooldowns of the towers already there run down (towers act on nothing but enemies and the towers they summon) */
+    for (slot = 0; slot < nb_slots; slot++) {
+        tower_type = &boards[0].tower_type[slot * stride];
+        attack_cooldown = &boards[0].tower_attack_cooldown[slot * stride];
+        for (int i = 0; i < last; i++) if (slot < nb_towers[i] && tower_type[i]) {
+            boards[i].hash ^= hashBoardTower(&boards[i], slot);
+            attack_cooldown[i]--;
+            boards[i].hash ^= hashBoardTower(&boards[i], slot);
+        }
+    }
+    /* Towers act, soldiers summoned this turn included (their cooldown runs down once they are reached) */
+    for (slot = 0; nb_slots; slot++) {
+        nb_slots = 0;
+        tower_type = &boards[0].tower_type[slot * stride];
+        attack_cooldown = &boards[0].tower_attack_cooldown[slot * stride];
+        for (int i = 0; i < last; i++) if (acting[i] && slot < boards[i].nb_tower_slots) {
+            nb_slots += slot + 1 < boards[i].nb_tower_slots;
+            if (!tower_type[i] || (slot < nb_towers[i] && attack_cooldown[i] > 0)) continue;
+            boards[i].hash ^= hashBoardTower(&boards[i], slot);
+            if (slot >= nb_towers[i]) attack_cooldown[i]--;
+            if (attack_cooldown[i] <= 0) boardTowerAct(&boards[i], slot);
+            boards[i].hash ^= hashBoardTower(&boards[i], slot);
+        }
+    }
+}
+
+/* Share of a batch step, resolve a turn on chunks of neighbouring boards until every chunk has been taken */
+void boardBatchWorker(BoardBatch *batch) {
+    int first, last;
+    while ((first = atomic_fetch_add(&batch->next_board, BOARD_BATCH_CHUNK)) < batch->nb_boards) {
+        last = min(first + BOARD_BATCH_CHUNK, batch->nb_boards);
+        resolveBoardBatchTurn(batch, first, last);
+        for (int i = first; i < last; i++) if (batch->running[i]) batch->nb_turns[i]++;
+        updateBoardBatchStatus(batch, first, last);
+    }
+}
+
+/* Thread of a batch, waiting for each step to take its share of it until the batch is destroyed */
+void *boardBatchThread(void *data) {
+    BoardBatch *batch = data;
+    int nb_steps = 0;
+    pthread_mutex_lock(&batch->mutex);
+    while (true) {
+        while (batch->nb_steps == nb_steps && !batch->stopping) pthread_cond_wait(&batch->start, &batch->mutex);
+        if (batch->stopping) break;
+        nb_steps = batch->nb_steps;
+        pthread_mutex_unlock(&batch->mutex);
+        boardBatchWorker(batch);
+        pthread_mutex_lock(&batch->mutex);
+        if (--batch->nb_busy == 0) pthread_cond_signal(&batch->done);
+    }
+    pthread_mutex_unlock(&batch->mutex);
+    return NULL;
+}
+
+/* Resolve one turn on every wave of a batch still going, on the threads of the batch, return the number of waves still going */
+int stepBoardBatch(BoardBatch *batch) {
+    atomic_store(&batch->next_board, 0);
+    if (batch->nb_threads > 1) {
+        pthread_mutex_lock(&batch->mutex);
+        batch->nb_steps++;
+        batch->nb_busy = batch->nb_threads - 1;
+        pthread_cond_broadcast(&batch->start);
+        pthread_mutex_unlock(&batch->mutex);
+    }
+    boardBatchWorker(batch);
+    /* Wait for the other threads to be done with the boards they took */
+    pthread_mutex_lock(&batch->mutex);
+    while (batch->nb_busy) pthread_cond_wait(&batch->done, &batch->mutex);
+    pthread_mutex_unlock(&batch->mutex);
+    batch->nb_running = 0;
+    for (int i = 0; i < batch->nb_boards; i++) batch->nb_running += batch->running[i];
+    return batch->nb_running;
+}
+
+
+
+/* Mix a feature into a 64 bits key (SplitMix64 finalizer), which stands for the table of random keys of a Zobrist hash */
+/* Keys are the same on every run and platform, so that hashes can be compared between builds */
+uint64_t zobristKey(uint64_t feature) {
+    feature += 0x9e3779b97f4a7c15ull;
+    feature = (feature ^ (feature >> 30)) * 0xbf58476d1ce4e5b9ull;
+    feature = (feature ^ (feature >> 27)) * 0x94d049bb133111ebull;
+    return feature ^ (feature >> 31);
+}
+
+/* Return the key of a value of the game (score, turn number, funds...) */
+uint64_t hashValue(int feature, long long value) {
+    return zobristKey((uint64_t) feature << 56 ^ ((uint64_t) value & 0x00ffffffffffffffull));
+}
+
+/* Return the key of an enemy (its identifier is left out, so that the same position reached by another path has the same hash) */
+uint64_t hashEnemy(char type, int collumn, int row, int speed, int life_points) {
+    return zobristKey((uint64_t) ENEMY_FEATURE << 56 | (uint64_t) (unsigned char) type << 48 | (uint64_t) (unsigned char) collumn << 40 | (uint64_t) (unsigned char) row << 32
+        | (uint64_t) (unsigned char) speed << 24 | ((uint64_t) life_points & 0xffffff));
+}
+
+/* Return the key of a tower */
+uint64_t hashTower(char type, int collumn, int row, int attack_cooldown, int life_points) {
+    return zobristKey((uint64_t) TOWER_FEATURE << 56 | (uint64_t) (unsigned char) type << 48 | (uint64_t) (unsigned char) collumn << 40 | (uint64_t) (unsigned char) row << 32
+        | ((uint64_t) attack_cooldown & 0xffff) << 16 | ((uint64_t) life_points & 0xffff));
+}
+
+/* Return the key of an enemy waiting to enter the map */
+uint64_t hashSpawn(char type, int row, int turn) {
+    return zobristKey((uint64_t) SPAWN_FEATURE << 56 | (uint64_t) (unsigned char) type << 48 | (uint64_t) (unsigned char) row << 32 | ((uint64_t) turn & 0xffffffff));
+}
+
+/* Return the key of the enemy in a slot of a board */
+uint64_t hashBoardEnemy(Board *board, int slot) {
+    return hashEnemy(board->enemy_type[slot * board->stride], board->enemy_collumn[slot * board->stride], board->enemy_row[slot * board->stride], board->enemy_speed[slot * board->stride], board->enemy_life_points[slot * board->stride]);
+}
+
+/* Return the key of the tower in a slot of a board */
+uint64_t hashBoardTower(Board *board, int slot) {
+    return hashTower(board->tower_type[slot * board->stride], board->tower_collumn[slot * board->stride], board->tower_row[slot * board->stride], board->tower_attack_cooldown[slot * board->stride], board->tower_life_points[slot * board->stride]);
+}
+
+/* Xor the key of an enemy into a hash, to add it or remove it (nothing is done without a hash) */
+void toggleEnemyHash(uint64_t *hash, Enemy *enemy) {
+    if (hash) *hash ^= hashEnemy(enemy->type, enemy->collumn, enemy->row, enemy->speed, enemy->life_points);
+}
+
+/* Xor the key of a tower into a hash, to add it or remove it (nothing is done without a hash) */
+void toggleTowerHash(uint64_t *hash, Tower *tower) {
+    if (hash) *hash ^= hashTower(tower->type, tower->collumn, tower->row, tower->attack_cooldown, tower->life_points);
+}
+
+/* Xor the keys of every enemy waiting in a spawn queue into a hash (before the queue is cleared, then once it is filled again) */
+void toggleSpawnQueueHash(uint64_t *hash, SpawnQueue *spawn_queue) {
+    if (!hash) return;
+    for (int i = spawn_queue->head; i < spawn_queue->nb_entries; i++) *hash ^= hashSpawn(spawn_queue->entries[i].type, spawn_queue->entries[i].row, spawn_queue->entries[i].turn);
+}
+
+/* Compute from scratch the Zobrist hash of what turns change: enemies, towers, waiting enemies, score and turn number */
+/* Games and boards keep it up to date by xoring out the key of an entity before changing it, then xoring in its new key, this is only used to check them */
+uint64_t hashWaveState(Game *game) {
+    uint64_t hash = hashValue(SCORE_FEATURE, game->score) ^ hashValue(TURN_FEATURE, game->turn_nb);
+    for (Enemy *enemy = game->enemy_list; enemy; enemy = enemy->next) hash ^= hashEnemy(enemy->type, enemy->collumn, enemy->row, enemy->speed, enemy->life_points);
+    for (Tower *tower = game->tower_list; tower; tower = tower->next) hash ^= hashTower(tower->type, tower->collumn, tower->row, tower->attack_cooldown, tower->life_points);
+    SpawnQueue *spawn_queue = game->spawn_queue;
+    for (int i = spawn_queue->head; i < spawn_queue->nb_entries; i++) hash ^= hashSpawn(spawn_queue->entries[i].type, spawn_queue->entries[i].row, spawn_queue->entries[i].turn);
+    return hash;
+}
+
+/* Return the Zobrist hash of the whole gameplay state of a game (the level, terrain and random generator included) */
+uint64_t hashGame(Game *game) {
+    uint64_t hash = game->hash ^ hashValue(FUNDS_FEATURE, game->funds) ^ hashValue(WAVE_FEATURE, game->current_wave_nb) ^ hashValue(PHASE_FEATURE, game->game_phase);
+    hash ^= zobristKey(game->rng.state ^ zobristKey(game->rng.inc ^ (uint64_t) RNG_FEATURE << 56));
+    uint64_t name_hash = 0xcbf29ce484222325ull;
+    for (const char *c = game->level_name; *c; c++) name_hash = (name_hash ^ (unsigned char) *c) * 0x100000001b3ull;
+    hash ^= hashValue(LEVEL_FEATURE, name_hash);
+    for (int row = 1; row <= NB_ROWS; row++) for (int collumn = 1; collumn <= NB_COLLUMNS; collumn++)
+        if (game->flow_field->blocked[row-1][collumn-1]) hash ^= hashValue(TERRAIN_FEATURE, row * (NB_COLLUMNS + 1) + collumn);
+    return hash;
+}
+
+/* Create an empty transposition table of 2^bits entries */
+TranspositionTable *newTranspositionTable(int bits) {
+    TranspositionTable *table = malloc(sizeof(TranspositionTable));
+    table->mask = (1ull << bits) - 1;
+    table->entries = malloc(2 * (table->mask + 1) * sizeof(_Atomic uint64_t));
+    for (uint64_t i = 0; i < 2 * (table->mask + 1); i++) atomic_init(&table->entries[i], 0);
+    atomic_init(&table->nb_hits, 0);
+    return table;
+}
+
+/* Destroy a transposition table and free its allocated memory */
+void destroyTranspositionTable(TranspositionTable *table) {
+    if (!table) return;
+    free(table->entries);
+    free(table);
+}
+
+/* Look a position up, return false if it was never stored (or has been overwritten since) */
+bool probeTranspositionTable(TranspositionTable *table, uint64_t key, double *value) {
+    if (!table) return false;
+    /* Empty entries (all zeros) never match as keys always have their lowest bit set */
+    key |= 1;
+    _Atomic uint64_t *entry = &table->entries[2 * ((key >> 1) & table->mask)];
+    uint64_t check = atomic_load_explicit(&entry[0], memory_order_relaxed), data = atomic_load_explicit(&entry[1], memory_order_relaxed);
+    if ((check ^ data) != key) return false;
+    memcpy(value, &data, sizeof(double));
+    atomic_fetch_add_explicit(&table->nb_hits, 1, memory_order_relaxed);
+    return true;
+}
+
+/* Store the value of a position, replacing whatever was in its entry */
+void storeTranspositionTable(TranspositionTable *table, uint64_t key, double value) {
+    if (!table) return;
+    key |= 1;
+    _Atomic uint64_t *entry = &table->entries[2 * ((key >> 1) & table->mask)];
+    uint64_t data;
+    memcpy(&data, &value, sizeof(double));
+    atomic_store_explicit(&entry[0], key ^ data, memory_order_relaxed);
+    atomic_store_explicit(&entry[1], data, memory_order_relaxed);
+}
@@ -0,0 +1,639 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+
+#define CONCURRENT_TURNS false  // Set if all towers (then all enemies) should act at once each turn (V to toggle on/off)
+#define NB_ROWS 7               // Number of rows for the map
+#define NB_COLLUMNS 15          // Number of collumns for the map
+
+#define KEYFRAME_INTERVAL 100  // Number of turns between two keyframes of a replay
+#define REWIND_TURNS 64           // Number of past turns the game keeps to rewind to (backspace)
+#define REWIND_BUFFER_SIZE 65536  // Bytes of game states kept to rewind, the oldest turns are dropped first once full
+#define MAX_PREDICTED_TURNS 1000  // Wave predictions stop after this many turns (the wave is considered stuck)
+#define AUTO_BUILD_BEAM_WIDTH 4    // Number of build plans kept at each step of the auto-build search
+#define AUTO_BUILD_WAVES 1         // Number of upcoming waves simulated to evaluate a build plan
+#define AUTO_BUILD_TIME_BUDGET 1000  // Time (in ms) the auto-build search may spend before each wave
+#define MAX_BUILD_PLAN_ACTIONS 16  // Maximum number of towers built or upgraded by a build plan
+#define WAVE_CLEARED_VALUE 100000  // Value of clearing a wave when evaluating a build plan
+#define TOWER_LOST_VALUE 50        // Value lost for each tower destroyed when evaluating a build plan
+#define DEFEAT_TURN_VALUE 100      // Value of each turn the defences hold when the wave is lost
+#define INVALID_PLAN_VALUE -1e18   // Value of a build plan that cannot be done (not enough funds or occupied tile)
+#define MAX_BOARD_ENEMIES 128      // Enemy slots of a board (destroyed enemies leave holes until the slots run out)
+#define MAX_BOARD_TOWERS 128       // Tower slots of a board (same)
+#define MAX_BOARD_SPAWNS 512       // Maximum number of enemies waiting to enter the map on a board
+#define BOARD_BATCH_CHUNK 64        // Number of boards of a batch a thread takes at once (a cache line of each byte-sized entity field)
+#define TRANSPOSITION_TABLE_BITS 16  // The auto-build transposition table holds 2^TRANSPOSITION_TABLE_BITS entries
+
+#define MAX_LENGTH_NICKNAME 32
+#define MAX_SIZE_SCORE_FILE 100
+
+
+
+
+/* Enemy types */
+#define SLIME_ENEMY 'S'
+#define GELLY_ENEMY 'G'
+#define GOBLIN_ENEMY 'g'
+#define ORC_ENEMY 'O'
+#define NECROMANCER_ENEMY 'N'
+#define SKELETON_ENEMY 's'
+#define WITCH_ENEMY 'W'
+/* Tower types */
+#define ARCHER_TOWER 'A'
+#define WALL_TOWER 'W'
+#define BARRACK_TOWER 'B'
+#define SOLIDER_TOWER 's'
+#define CANON_TOWER 'C'
+#define DESTROYER_TOWER 'D'
+#define SORCERER_TOWER 'S'
+#define MAGE_TOWER 'M'
+/* Game phases */
+#define WAITING_FOR_USER_PHASE -1
+#define PRE_WAVE_PHASE 0
+#define WAVE_PHASE 1
+#define VICTORY_PHASE 4
+#define DEFEAT_PHASE 5
+#define SCORE_PHASE 6
+/* Zobrist hash features */
+#define ENEMY_FEATURE 1
+#define TOWER_FEATURE 2
+#define SPAWN_FEATURE 3
+#define SCORE_FEATURE 4
+#define TURN_FEATURE 5
+#define FUNDS_FEATURE 6
+#define WAVE_FEATURE 7
+#define PHASE_FEATURE 8
+#define TERRAIN_FEATURE 9
+#define RNG_FEATURE 10
+#define LEVEL_FEATURE 11
+#define ROLLOUT_FEATURE 12
+/* Event types (logged by the turn resolver, then animated on screen) */
+#define WAIT_EVENT 'W'
+#define PROJECTILE_EVENT 'P'
+#define DAMAGE_EVENT 'D'
+#define DEATH_EVENT 'K'
+#define ENEMY_SPAWN_EVENT 'E'
+#define TOWER_SPAWN_EVENT 'T'
+#define MOVE_EVENT 'M'
+#define ATTACK_EVENT 'A'
+/* Player action types (recorded in replays) */
+#define BUY_ACTION 'B'
+#define UPGRADE_ACTION 'U'
+#define SELL_ACTION 'S'
+#define START_WAVE_ACTION 'W'
+/* Terrain types */
+#define BLOCKED_TILE 'X'
+/* Path costs used by the flow field, changing lane costs more than crossing every tower of a lane so enemies keep fighting through towers */
+#define STEP_PATH_COST 1
+#define LANE_CHANGE_PATH_COST NB_COLLUMNS
+#define TOWER_PATH_COST 1
+#define UNREACHABLE_PATH_COST 1000000
+
+
+
+/* Random number streams, visual randomness uses its own stream so that it never changes the game outcome */
+#define GAMEPLAY_STREAM 1
+#define COSMETIC_STREAM 2
+
+
+
+/* Survival mode level name */
+#define SURVIVAL_MODE "$urv1v@lM0d3"
+/* Survival mode difficulty file (written by td-calibrate) */
+#define SURVIVAL_CURVE_PATH "../assets/survival.txt"
+/* First bytes of replay files */
+#define REPLAY_MAGIC "TDR1"
+
+
+
+
+/* Identifier given to the next enemy or tower created (one counter per thread, so that games can be simulated in parallel) */
+extern _Thread_local int NEXT_ENTITY_ID;
+
+
+
+
+/* Random number generator (PCG32) */
+typedef struct {
+    uint64_t state;  // Current state, advanced each time a number is generated
+    uint64_t inc;    // Stream selector (always odd)
+} Rng;
+
+/* Towers */
+typedef struct tower {
+    int type;                  // Tower type, determine it's abilities, look and upgrades
+    int max_life_points;       // Maximum life points of the tower
+    int life_points;           // Life points of the tower, when it reaches 0 or bellow the tower is destroyed
+    int row;                   // Row number of the tower, 0 being the topmost row
+    int collumn;               // Collumn number of the tower, 0 being the leftmost collumn
+    int cost;                  // Placement cost of the tower
+    int base_attack_cooldown;  // Cooldown between each attack (1 or less being none)
+    int attack_cooldown;       // Current cooldown before the next attack
+    struct tower* next;        // Pointer to the next tower placed
+    int id;                    // Unique identifier of the tower (shared with enemies)
+} Tower;
+
+/* Enemies */
+typedef struct enemy {
+    int type;                   // Enemy type, determine it's abilities and look
+    int max_life_points;        // Maximum life points of the enemy
+    int life_points;            // Life points of the enemy, when it reaches 0 or bellow the enemy is defeated
+    int row;                    // Row number of the enemy, 0 being the topmost row
+    int collumn;                // Collumn number of the enemy, 0 being the leftmost collumn
+    int base_speed;             // Base number of collumn travelled per turn
+    int speed;                  // Number of collumn travelled per turn, reseted to base_speed after moving
+    struct enemy* next;         // Next enemy (in order of apparition)
+    struct enemy* next_on_row;  // Next enemy on the same row (behind this)
+    struct enemy* prev_on_row;  // Previous enemy on the same row (in front of this)
+    int score_on_kill;          // Score given when killing the enemy
+    int id;                     // Unique identifier of the enemy (its address may be reused once it is destroyed)
+} Enemy;
+
+/* Flow field leading enemies toward the castle, all arrays are indexed by [row-1][collumn-1] */
+typedef struct {
+    bool blocked[NB_ROWS][NB_COLLUMNS];         // Terrain tiles that cannot be walked on nor built on
+    bool tower[NB_ROWS][NB_COLLUMNS];           // Tiles occupied by a tower when the flow field was last repaired
+    int cost[NB_ROWS][NB_COLLUMNS];             // Path cost from the tile to the castle
+    signed char step_x[NB_ROWS][NB_COLLUMNS];  // Collumn delta of the next step toward the castle
+    signed char step_y[NB_ROWS][NB_COLLUMNS];  // Row delta of the next step toward the castle
+} FlowField;
+
+/* Enemy waiting to enter the map */
+typedef struct {
+    char type;  // Enemy type
+    int row;    // Row on which the enemy enters the map
+    int turn;   // Turn on which the enemy enters the map (if its spawn tile is free)
+} SpawnEntry;
+
+/* Enemies waiting to enter the map, in order of apparition */
+typedef struct {
+    SpawnEntry *entries;  // Entries sorted by turn then by row
+    int head;             // Index of the first entry still waiting, previous ones have entered the map
+    int nb_entries;       // Number of entries (including those that have entered the map)
+    int capacity;         // Number of entries that can be stored before reallocating memory
+} SpawnQueue;
+
+/* Something that happened during a turn, to be animated on screen */
+typedef struct {
+    char type;               // Event type
+    char entity_type;        // Type of the enemy or tower concerned (of the tower shooting for projectiles)
+    signed char collumn;     // Collumn of the entity once the event is played (where projectiles are shot from)
+    signed char row;         // Row of the entity once the event is played
+    signed char dx;          // Movement, attack side or projectile travel (in tiles)
+    signed char dy;          // Movement or projectile travel (in tiles)
+    short life_points;       // Life points of the entity once the event is played
+    short max_life_points;   // Maximum life points of the entity
+    short amount;            // Damage received (negative for heals)
+    int id;                  // Identifier of the entity concerned
+} Event;
+
+/* Events of a turn, in the order they must be played */
+typedef struct {
+    Event *events;  // Events logged
+    int head;       // Index of the next event to play
+    int nb_events;  // Number of events logged
+    int capacity;   // Number of events that can be stored before reallocating memory
+} EventLog;
+
+/* Action of the player */
+typedef struct {
+    char type;        // Action type
+    char tower_type;  // Type of the tower bought
+    int collumn;      // Collumn of the tower concerned
+    int row;          // Row of the tower concerned
+    int wave_nb;      // Wave before which the action was done
+} Action;
+
+/* State of a game at some turn, enough to resume it from there */
+typedef struct {
+    int total_turns;       // Turn of the game the keyframe was taken at
+    int action_index;      // Number of actions done before that turn
+    unsigned char *data;   // Compact encoding of the game state
+    int size;              // Size of the encoded game state in bytes
+} Keyframe;
+
+/* Seed and actions of the player during a game, enough to play it again exactly the same way */
+typedef struct {
+    char *level_name;          // Name of the played level
+    unsigned long long seed;   // Seed the game was created with
+    Action *actions;           // Actions, in the order they were done
+    int head;                  // Index of the next action to replay
+    int nb_actions;            // Number of actions recorded
+    int capacity;              // Number of actions that can be stored before reallocating memory
+    Keyframe *keyframes;       // Keyframes taken every KEYFRAME_INTERVAL turns, to seek without replaying everything
+    int nb_keyframes;          // Number of keyframes
+    int keyframe_capacity;     // Number of keyframes that can be stored before reallocating memory
+} Replay;
+
+/* Growable array of bytes, written and read using a compact encoding */
+typedef struct {
+    unsigned char *bytes;  // Content
+    int size;              // Number of bytes written
+    int capacity;          // Number of bytes that can be written before reallocating memory
+    int pos;               // Position of the next byte to read
+} ByteBuffer;
+
+/* Game state kept to rewind to, stored in the bytes of a rewind buffer */
+typedef struct {
+    int total_turns;   // Turn of the game the state was taken at
+    int action_index;  // Number of actions recorded in the replay of the game at that time
+    int start;         // Position of the first byte of the state in the bytes of the buffer
+    int size;          // Size of the encoded state in bytes
+} RewindEntry;
+
+/* Last states of a game, kept in preallocated rings (oldest states overwritten first) so that nothing is allocated per turn */
+typedef struct {
+    RewindEntry *entries;  // Ring of states, from the oldest to the newest
+    int capacity;          // Maximum number of states
+    int first;             // Index of the oldest state
+    int nb_entries;        // Number of states kept
+    unsigned char *bytes;  // Ring of bytes holding the encoded states
+    int nb_bytes;          // Size of the ring of bytes
+    int used_bytes;        // Number of bytes used by the states kept
+    ByteBuffer scratch;    // States are encoded and decoded there (only grows up to the largest state)
+} RewindBuffer;
+
+/* Towers to build before each wave, a scripted strategy for headless games */
+typedef struct {
+    int wave_nb;     // Wave before which the tower is built
+    char type;       // Tower type (upgrade the tower already there if the tile is not empty)
+    int collumn;     // Collumn of the tower
+    int row;         // Row of the tower
+} BuildStep;
+
+/* Damage statistics of a game, indexed by unit type (towers and enemies are kept apart as their types overlap) */
+typedef struct {
+    long long tower_damage_dealt[128];  // Life points removed from enemies by each tower type
+    long long tower_damage_taken[128];  // Life points lost by each tower type
+    int nb_towers_destroyed[128];       // Number of towers of each type destroyed
+    long long enemy_damage_dealt[128];  // Life points removed from towers by each enemy type
+    long long enemy_damage_taken[128];  // Life points lost by each enemy type
+    int nb_enemies_killed[128];         // Number of enemies of each type killed
+    char attacker_type;                 // Type of the unit whose attack is being resolved
+} CombatStats;
+
+/* Outcome of the upcoming wave, simulated ahead of time with the current defences */
+typedef struct {
+    bool defeat;                            // Would an enemy reach the castle
+    int nb_leaks;                           // Number of enemies reaching the castle
+    bool leak[NB_ROWS];                     // Rows on which an enemy reaches the castle
+    int nb_towers_lost;                     // Number of towers destroyed during the wave (soldiers excluded)
+    bool tower_lost[NB_ROWS][NB_COLLUMNS];  // Tiles whose tower is destroyed, indexed by [row-1][collumn-1]
+    int score;                              // Score earned during the wave
+    int nb_turns;                           // Number of turns the wave lasts
+} WavePrediction;
+
+/* Towers to build or upgrade before a wave, as proposed by the auto-build */
+typedef struct {
+    Action actions[MAX_BUILD_PLAN_ACTIONS];  // Actions to do, in order
+    int nb_actions;                          // Number of actions
+    double value;                            // Value of the defences once the plan is done, the higher the better
+} BuildPlan;
+
+/* Difficulty of the survival mode waves, loaded from a data file so that it can be calibrated */
+typedef struct {
+    int base_power;       // Wave power of the first waves
+    int power_per_wave;   // Wave power added per squared wave number
+    int necromancer;      // The higher the wave power is compared to this, the more likely necromancers are
+    int orc;              // Same for orcs (when no necromancer is chosen)
+    int witch;            // Same for witches
+    int goblin;           // Same for goblins
+    int gelly;            // Same for gellies (slimes otherwise)
+} SurvivalCurve;
+
+/* Waves */
+typedef struct {
+    SpawnQueue *spawn_queue;  // Enemies of the wave, only instantiated once the wave is loaded (spawn turn is their delay)
+    int income;               // Funds gain before the wave to build towers
+} Wave;
+
+/* Game structure, composed of multiple waves */
+typedef struct {
+    Wave **waves;                    // Array of waves
+    int nb_waves;                    // Number of waves
+    int current_wave_nb;             // Current wave
+    Tower *tower_list;               // Towers
+    Enemy *enemy_list;               // Enemies
+    SpawnQueue *spawn_queue;         // Enemies that have not entered the map yet
+    int funds;                       // Availible funds to build tower
+    int score;                       // Player score
+    int turn_nb;                     // Turn number
+    int total_turns;                 // Number of turns resolved since the game started (all waves included)
+    int game_phase;                  // Current game phase, determine what type of actions to handle next
+    char *level_name;                // Name of the played level
+    FlowField *flow_field;           // Terrain of the map and path followed by enemies
+    bool concurrent_turns;           // Should all towers (then all enemies) be animated at once instead of one after the other
+    EventLog *event_log;             // Events of the last turn resolved, waiting to be animated (NULL if not needed)
+    unsigned long long seed;         // Seed the game was created with
+    Rng rng;                         // Gameplay random number generator, saved with the game
+    SurvivalCurve survival_curve;    // Difficulty of the survival mode waves
+    Replay *replay;                  // Actions of the player are recorded in it (NULL if not recorded)
+    CombatStats *combat_stats;       // Damage statistics of the game (NULL if not gathered)
+    RewindBuffer *rewind_buffer;     // Last turns of the game, to rewind to (NULL if not kept)
+    uint64_t hash;                   // Zobrist hash of the wave state (see hashWaveState), updated at each change
+} Game;
+
+/* Predicted outcome of the remaining waves of a level being edited, played with the defences of the game and no tower built in between */
+/* The state of the game before each wave is kept, so that an edit only re-simulates the waves from the first one it changes */
+typedef struct {
+    Wave **waves;                 // Waves being edited (the whole level, the game keeps its own waves until the edits are applied)
+    int nb_waves;                 // Number of waves
+    int first_wave;               // Index of the first wave previewed (the current wave of the game)
+    Game *game;                   // Game the waves are played on
+    ByteBuffer *checkpoints;      // State of the game before each wave is loaded, indexed by wave (valid up to next_wave)
+    WavePrediction *predictions;  // Outcome of each wave, indexed by wave (valid before next_wave)
+    int next_wave;                // Index of the next wave to simulate
+    bool up_to_date;              // Have every wave been simulated since the last edit (until the level ends or is lost)
+    int lost_wave;                // Index of the wave lost (-1 on victory)
+    int score;                    // Score at the end of the level (funds left included on victory)
+    long long nb_waves_simulated; // Number of waves simulated since the preview was created
+} LevelPreview;
+
+/* Values of positions already evaluated, shared without lock by every thread of a search (entries are overwritten on collision) */
+/* Each entry is two words: the key xored with the data, then the data, so that an entry torn by concurrent writes is never matched */
+typedef struct {
+    _Atomic uint64_t *entries;  // Two words per entry
+    uint64_t mask;              // Number of entries minus one (a power of two)
+    atomic_llong nb_hits;       // Number of probes that found their position
+} TranspositionTable;
+
+/* Build plans evaluated in parallel by the threads of an auto-build search */
+typedef struct {
+    Game *game;                 // Game the defences are built for (never modified by the search)
+    int nb_waves;               // Number of upcoming waves simulated to evaluate a plan
+    BuildPlan *plans;           // Plans to evaluate
+    int nb_plans;               // Number of plans to evaluate
+    atomic_int next_plan;       // Index of the next plan to evaluate
+    atomic_llong nb_rollouts;   // Number of plans evaluated so far
+    double deadline;            // Time (in ms) after which plans are not evaluated anymore
+    TranspositionTable *table;  // Values of the positions already evaluated (NULL if not kept)
+} BuildSearch;
+
+/* Compact copy of the gameplay state of a wave, resolved by its own turn resolver without any allocation (for rollouts) */
+/* Tiles are stored as one bit per collumn in row masks (bit 0 being the castle), entities in packed slots in order of creation */
+/* Entity fields are arrays shared with other boards, slot i being at i * stride: a board of its own has a stride of 1, */
+/* the boards of a batch share arrays laid out [slot][board] so that a field of the same slot is contiguous across boards */
+typedef struct {
+    uint16_t enemy_mask[NB_ROWS];                            // Collumns occupied by an enemy on each row
+    uint16_t tower_mask[NB_ROWS];                            // Collumns occupied by a tower on each row
+    uint16_t blocked_mask[NB_ROWS];                          // Collumns blocked by the terrain on each row
+    uint16_t flow_tower_mask[NB_ROWS];                       // Collumns occupied by a tower when the flow field was last repaired
+    unsigned char enemy_slot[NB_ROWS][NB_COLLUMNS + 1];      // Slot of the enemy on each tile (indexed by [row-1][collumn])
+    unsigned char tower_slot[NB_ROWS][NB_COLLUMNS + 1];      // Slot of the tower on each tile
+    char *enemy_type;                                        // Type of each enemy ('\0' for empty slots), MAX_BOARD_ENEMIES slots
+    signed char *enemy_collumn;                              // Collumn of each enemy
+    signed char *enemy_row;                                  // Row of each enemy
+    signed char *enemy_speed;                                // Number of collumns each enemy travels next move
+    short *enemy_life_points;                                // Life points of each enemy
+    int *enemy_id;                                           // Identifier of each enemy
+    int nb_enemy_slots;                                      // Number of enemy slots used (including empty ones)
+    char *tower_type;                                        // Type of each tower ('\0' for empty slots), MAX_BOARD_TOWERS slots
+    signed char *tower_collumn;                              // Collumn of each tower
+    signed char *tower_row;                                  // Row of each tower
+    int *tower_attack_cooldown;                              // Cooldown of each tower before its next attack (keeps decreasing while idle)
+    short *tower_life_points;                                // Life points of each tower
+    int *tower_id;                                           // Identifier of each tower
+    int nb_tower_slots;                                      // Number of tower slots used (including empty ones)
+    int stride;                                              // Distance between two slots in the entity fields
+    char spawn_type[MAX_BOARD_SPAWNS];                       // Enemies waiting to enter the map, in the order of the spawn queue
+    signed char spawn_row[MAX_BOARD_SPAWNS];                 // Row on which each of them enters the map
+    short spawn_turn[MAX_BOARD_SPAWNS];                      // Turn on which each of them enters the map
+    int spawn_head;                                          // Index of the first enemy still waiting
+    int nb_spawns;                                           // Number of spawn entries
+    int score;                                               // Player score
+    int turn_nb;                                             // Turn number
+    int total_turns;                                         // Number of turns resolved since the game started
+    int next_id;                                             // Identifier given to the next enemy or tower created
+    FlowField flow_field;                                    // Terrain of the map and path followed by enemies
+    uint64_t hash;                                           // Zobrist hash of the wave state (see hashWaveState), updated at each change
+} Board;
+
+/* Independent waves resolved together, every one of them advancing by one turn per step (see stepBoardBatch) */
+/* Entity fields are laid out [slot][board] (see Board), each part of a turn being done slot after slot on every board at once, */
+/* and what callers poll after each step is kept apart in one array per field */
+typedef struct {
+    Board *boards;           // Board of each wave, their entity fields being those of the first board shifted by the index of the board
+    int nb_boards;           // Number of boards
+    int stride;              // Number of boards the entity fields are laid out for (nb_boards rounded up to whole chunks)
+    unsigned char *running;  // Is each wave still going (neither over, lost nor stuck)
+    unsigned char *defeat;   // Has an enemy reached the castle on each board
+    int *score;              // Score on each board
+    int *nb_turns;           // Number of turns resolved on each board since it was loaded
+    int nb_running;          // Number of waves still going
+    atomic_int next_board;   // Index of the next chunk of boards to step (shared by the threads of a step)
+    int nb_threads;          // Number of threads stepping the boards, the thread calling stepBoardBatch included
+    pthread_t *threads;      // Other threads, kept waiting between steps for the whole life of the batch
+    pthread_mutex_t mutex;   // Protects the fields below
+    pthread_cond_t start;    // Signaled when a step starts, or when the batch is destroyed
+    pthread_cond_t done;     // Signaled when the last waiting thread is done with its share of a step
+    int nb_steps;            // Number of steps started
+    int nb_busy;             // Number of waiting threads still stepping boards
+    bool stopping;           // Set when the batch is destroyed, its threads then exit
+} BoardBatch;
+
+typedef struct {
+    char *nickname;  // Nickname of the player
+    int score;       // Score of the player
+} Scoreboard;
+
+
+/* Header */
+void seedRng(Rng *rng, unsigned long long seed, unsigned long long stream);
+uint32_t nextRandom(Rng *rng);
+int randrange(Rng *rng, int a, int b);
+bool roll(Rng *rng, double p);
+int sign(double x);
+double min(double x, double y);
+double max(double x, double y);
+double power(double x, int n);
+char *concatString(const char *a, const char *b);
+char *duplicateString(const char *a);
+int stringToInt(const char *str);
+int positive_div(int i, int n);
+int positive_mod(int i, int n);
+bool getEnemyAndTowerAt(Enemy *enemy_list, Tower *tower_list, int collumn, int row, Enemy **enemy, Tower **tower);
+bool isTileEmpty(Enemy *enemy_list, Tower *tower_list, int collumn, int row);
+bool doesTileExist(int collumn, int row);
+FlowField *newFlowField();
+void destroyFlowField(FlowField *flow_field);
+bool isTileBlocked(FlowField *flow_field, int collumn, int row);
+int getPathCost(FlowField *flow_field, int collumn, int row);
+int getStepCost(FlowField *flow_field, int from_collumn, int to_collumn, int to_row);
+void propagateFlowField(FlowField *flow_field, bool open[NB_ROWS][NB_COLLUMNS], bool touched[NB_ROWS][NB_COLLUMNS]);
+void refreshFlowSteps(FlowField *flow_field, bool touched[NB_ROWS][NB_COLLUMNS]);
+void computeFlowField(FlowField *flow_field);
+void repairFlowField(FlowField *flow_field, int collumn, int row, bool tower);
+void updateFlowField(FlowField *flow_field, Tower *tower_list);
+bool getFlowStep(FlowField *flow_field, int collumn, int row, int *dx, int *dy);
+bool getEnemyStats(char enemy_type, int *max_life_points, int *base_speed, int *score_on_kill);
+Enemy *addEnemy(Enemy **enemy_list, char enemy_type, int spawn_collumn, int spawn_row, int life_points, uint64_t *hash);
+void destroyEnemy(Enemy *enemy, Enemy **enemy_list, uint64_t *hash);
+bool doesEnemyExist(Enemy *enemy_list, Enemy *enemy, int id);
+Enemy **getFirstEnemyOfAllRows(Enemy *enemy_list);
+Enemy *getFirstEnemyInRow(Enemy *enemy_list, int row);
+int moveEnemy(Enemy *enemy, Enemy *enemy_list, Tower *tower_list, FlowField *flow_field, int delta, char axis, uint64_t *hash);
+void makeAllEnemiesMove(Enemy *enemy_list, Tower *tower_list, FlowField *flow_field, EventLog *event_log, uint64_t *hash);
+void enemyAttack(Enemy *enemy, Tower **tower_list, Enemy **enemy_list, FlowField *flow_field, EventLog *event_log, CombatStats *stats, uint64_t *hash);
+bool damageEnemy(Enemy *enemy, int amount, Enemy **enemy_list, Tower *tower_list, FlowField *flow_field, EventLog *event_log, int *score, CombatStats *stats, uint64_t *hash);
+SpawnQueue *newSpawnQueue();
+void destroySpawnQueue(SpawnQueue *spawn_queue);
+SpawnQueue *cloneSpawnQueue(SpawnQueue *spawn_queue);
+void clearSpawnQueue(SpawnQueue *spawn_queue);
+bool isSpawnQueueEmpty(SpawnQueue *spawn_queue);
+int findSpawnEntry(SpawnQueue *spawn_queue, int turn, int row);
+bool isSpawnQueued(SpawnQueue *spawn_queue, int turn, int row);
+bool queueEnemy(SpawnQueue *spawn_queue, char enemy_type, int row, int turn);
+bool unqueueEnemy(SpawnQueue *spawn_queue, int row, int turn);
+int getLastSpawnTurn(SpawnQueue *spawn_queue);
+int spawnQueuedEnemies(SpawnQueue *spawn_queue, int turn_nb, Enemy **enemy_list, Tower *tower_list, EventLog *event_log, uint64_t *hash);
+bool getTowerStats(char tower_type, int *max_life_points, int *cost, int *base_attack_cooldown);
+Tower *addTower(Tower **tower_list, Enemy *enemy_list, char tower_type, int placement_row, int placement_collumn, int life_points, uint64_t *hash);
+Tower *buyTower(Tower **tower_list, Enemy *enemy_list, FlowField *flow_field, char tower_type, int placement_row, int placement_collumn, int *funds, uint64_t *hash);
+void destroyTower(Tower *tower, Tower **tower_list, uint64_t *hash);
+void sellTower(Tower *tower, Tower **tower_list, int *funds, uint64_t *hash);
+void towerAct(Tower *tower, Tower **tower_list, Enemy **enemy_list, FlowField *flow_field, EventLog *event_log, int *score, CombatStats *stats, uint64_t *hash);
+void shootEnemy(Tower *tower, Enemy *target, Enemy **enemy_list, Tower *tower_list, FlowField *flow_field, EventLog *event_log, int *score, CombatStats *stats, uint64_t *hash);
+bool damageTower(Tower *tower, int amount, Tower **tower_list, EventLog *event_log, CombatStats *stats, uint64_t *hash);
+EventLog *newEventLog();
+void destroyEventLog(EventLog *event_log);
+void clearEventLog(EventLog *event_log);
+bool isEventLogDone(EventLog *event_log);
+void logEvent(EventLog *event_log, Event event);
+void logEnemyEvent(EventLog *event_log, char type, Enemy *enemy, int dx, int dy, int amount);
+void logTowerEvent(EventLog *event_log, char type, Tower *tower, int dx, int dy, int amount);
+void separateVolley(EventLog *event_log, int start);
+Game *createNewGame(char *level_name, unsigned long long seed);
+Game *createGameFromWaves(char *level_name, Wave **waves, int nb_waves, FlowField *terrain, unsigned long long seed);
+Game *newEmptyGame(char *level_name, unsigned long long seed);
+Game *loadGameFromSave(char *save_file);
+bool loadNextWave(Game *game);
+void startNextWave(Game *game);
+void resolveTurn(Game *game);
+void updateGame(Game *game, const char *nickname);
+void destroyGame(Game *game);
+Game *cloneGame(Game *game);
+Enemy *findEnemyById(Enemy **enemies, int nb_enemies, int id);
+void syncEntityIds(Game *game);
+bool predictWave(Game *game, WavePrediction *prediction, atomic_int *generation, int expected_generation);
+void beguinNewSurvivalWave(Game *game);
+SurvivalCurve defaultSurvivalCurve();
+bool loadSurvivalCurve(const char *path, SurvivalCurve *curve);
+bool saveSurvivalCurve(const char *path, SurvivalCurve *curve);
+Wave *newWave(int income);
+void destroyWaveList(Wave **wave_list, int nb_wave);
+bool isWhitespace(char c);
+bool readValue(char **line, char **value);
+bool readLine(FILE *file, char ***values, int *nb_values);
+bool loadLevel(const char *path, Wave ***waves, int *nb_waves, FlowField *flow_field);
+bool saveLevel(const char *path, Wave **waves, int nb_waves, FlowField *terrain);
+bool saveGame(const char *save_name, Game *game);
+bool deleteSaveFile(const char *name);
+Tower *upgradeTower(Tower **tower_list, Enemy *enemy_list, char tower_type, int placement_collumn, int placement_row, int *funds, uint64_t *hash);
+Replay *newReplay(const char *level_name, unsigned long long seed);
+void destroyReplay(Replay *replay);
+void recordAction(Replay *replay, Action action);
+bool applyAction(Game *game, Action action);
+Game *createReplayGame(Replay *replay);
+int playReplay(Game *game, Replay *replay);
+bool isReplayOver(Replay *replay);
+bool saveReplay(Replay *replay, const char *name);
+Replay *loadReplay(const char *name);
+void writeByte(ByteBuffer *buffer, unsigned char byte);
+void writeVarint(ByteBuffer *buffer, uint64_t value);
+void writeSignedVarint(ByteBuffer *buffer, int64_t value);
+unsigned char readByte(ByteBuffer *buffer);
+uint64_t readVarint(ByteBuffer *buffer);
+int64_t readSignedVarint(ByteBuffer *buffer);
+void encodeGameState(ByteBuffer *buffer, Game *game);
+void decodeGameState(ByteBuffer *buffer, Game *game);
+void recordKeyframe(Replay *replay, Game *game);
+Game *seekReplay(Replay *replay, int total_turns);
+RewindBuffer *newRewindBuffer(int nb_turns, int nb_bytes);
+void destroyRewindBuffer(RewindBuffer *rewind_buffer);
+void clearRewindBuffer(RewindBuffer *rewind_buffer);
+void recordRewindTurn(RewindBuffer *rewind_buffer, Game *game);
+int rewindGame(Game *game, int nb_turns);
+size_t getRewindBufferMemory(RewindBuffer *rewind_buffer);
+LevelPreview *newLevelPreview(Game *game);
+void destroyLevelPreview(LevelPreview *preview);
+void resetLevelPreview(LevelPreview *preview, Game *game);
+void invalidateLevelPreview(LevelPreview *preview, int wave_index);
+bool editLevelPreviewEnemy(LevelPreview *preview, int wave_index, char enemy_type, int row, int turn);
+bool updateLevelPreview(LevelPreview *preview, double time_budget);
+void applyLevelPreview(LevelPreview *preview, Game *game);
+BuildStep *loadBuildOrder(const char *path, int *nb_steps);
+int applyBuildOrder(Game *game, BuildStep *build_order, int nb_steps, bool verbose);
+double getTimeMs();
+double evaluateBuildPlan(Game *game, BuildPlan *plan, int nb_waves, TranspositionTable *table);
+void *buildSearchWorker(void *data);
+bool isTileInBuildPlan(BuildPlan *plan, int collumn, int row);
+bool areBuildPlansEqual(BuildPlan *a, BuildPlan *b);
+int compareBuildPlans(const void *a, const void *b);
+BuildPlan autoBuild(Game *game, TranspositionTable *table, int nb_waves, double time_budget, int nb_threads, long long *nb_rollouts);
+void allocateBoardEntities(Board *boards, int nb_boards, int stride);
+void freeBoardEntities(Board *board);
+Board *newBoard();
+void destroyBoard(Board *board);
+bool loadBoard(Board *board, Game *game);
+void storeBoard(Board *board, Game *game);
+bool compareBoardToGame(Board *board, Game *game, bool verbose);
+int getBoardEnemyAt(Board *board, int collumn, int row);
+bool isBoardTileEmpty(Board *board, int collumn, int row);
+bool isBoardTileFree(Board *board, int collumn, int row);
+int findBoardEnemyById(Board *board, int id);
+void compactBoardEnemies(Board *board);
+void compactBoardTowers(Board *board);
+int addBoardEnemy(Board *board, char enemy_type, int collumn, int row, int life_points);
+void removeBoardEnemy(Board *board, int slot);
+int addBoardTower(Board *board, char tower_type, int collumn, int row);
+void removeBoardTower(Board *board, int slot);
+bool moveBoardEnemy(Board *board, int slot, int dx, int dy);
+void advanceBoardEnemy(Board *board, int slot);
+void updateBoardFlowField(Board *board);
+void boardEnemyAttack(Board *board, int slot);
+bool damageBoardEnemy(Board *board, int slot, int amount);
+void damageBoardTower(Board *board, int slot, int amount);
+void moveAllBoardEnemies(Board *board);
+void spawnBoardEnemies(Board *board);
+int getFirstBoardEnemyInRange(Board *board, int collumn, int row, int range);
+void boardTowerAct(Board *board, int slot);
+void boardShootEnemy(Board *board, int tower_slot, int slot);
+void resolveBoardTurn(Board *board);
+bool isBoardWaveOver(Board *board);
+bool hasBoardEnemyReachedCastle(Board *board);
+BoardBatch *newBoardBatch(int nb_boards, int nb_threads);
+void destroyBoardBatch(BoardBatch *batch);
+bool loadBoardBatch(BoardBatch *batch, int i, Game *game);
+void updateBoardBatchStatus(BoardBatch *batch, int first, int last);
+void resolveBoardBatchTurn(BoardBatch *batch, int first, int last);
+void boardBatchWorker(BoardBatch *batch);
+void *boardBatchThread(void *data);
+int stepBoardBatch(BoardBatch *batch);
+uint64_t zobristKey(uint64_t feature);
+uint64_t hashValue(int feature, long long value);
+uint64_t hashEnemy(char type, int collumn, int row, int speed, int life_points);
+uint64_t hashTower(char type, int collumn, int row, int attack_cooldown, int life_points);
+uint64_t hashSpawn(char type, int row, int turn);
+uint64_t hashBoardEnemy(Board *board, int slot);
+uint64_t hashBoardTower(Board *board, int slot);
+void toggleEnemyHash(uint64_t *hash, Enemy *enemy);
+void toggleTowerHash(uint64_t *hash, Tower *tower);
+void toggleSpawnQueueHash(uint64_t *hash, SpawnQueue *spawn_queue);
+uint64_t hashWaveState(Game *game);
+uint64_t hashGame(Game *game);
+TranspositionTable *newTranspositionTable(int bits);
+void destroyTranspositionTable(TranspositionTable *table);
+bool probeTranspositionTable(TranspositionTable *table, uint64_t key, double *value);
+void storeTranspositionTable(TranspositionTable *table, uint64_t key, double value);
+void saveScore(const char *current_nickname,int current_score,char *level_name);
+
+#endif